@@ -0,0 +1,84 @@
+import { WebSocket } from "ws";
+import { AppData } from "./types/AppData";
+import { FoodServo, WaterPump, DeviceData } from "./types/iot";
+import { BINARY_PUSH_COMMAND, EncodeBinaryResponse } from "./binary_protocol";
+import { CurrentLogTimestamp } from "./utility";
+
+export const PUSH_COMMAND_ENDPOINT = "/iot/push_command";
+export const PUSH_COMMAND_VERSION = 1;
+export const ACTUATOR_MAX_COUNT = 32;
+
+export type ActuatorCommand = {
+	/** Bit 0 of pumps and feeders, for devices that only have one of each */
+	shouldEnableWaterPump: boolean;
+	shouldDispenseFood: boolean;
+
+	/** Bit per actuator ID */
+	pumps: number;
+	feeders: number;
+};
+
+/** Reads the remote triggers of a device and resets them, they are handed to the device exactly once */
+export function TakeActuatorCommand(device: DeviceData): ActuatorCommand {
+	let Pumps = 0;
+	let Feeders = 0;
+
+	for (const d of device.live) {
+		if (d.type === "WaterPump") {
+			const WaterPump = d as WaterPump;
+			if (WaterPump.triggerEnableWaterPump) {
+				Pumps |= 1 << (WaterPump.id ?? 0);
+			}
+
+			WaterPump.triggerEnableWaterPump = false; // Reset the trigger after getting the data
+		}
+		else if (d.type === "Servo") {
+			const Servo = d as FoodServo;
+			if (Servo.triggerDispenseFood) {
+				Feeders |= 1 << (Servo.id ?? 0);
+			}
+
+			Servo.triggerDispenseFood = false; // Reset the trigger after getting the data
+		}
+	}
+
+	return {
+		shouldEnableWaterPump: (Pumps & 1) !== 0,
+		shouldDispenseFood: (Feeders & 1) !== 0,
+		pumps: Pumps >>> 0,
+		feeders: Feeders >>> 0
+	};
+}
+
+/**
+ * Sends the pending triggers of a device over its own socket without waiting for /iot/get_data
+ * Returns false and leaves the triggers for the next poll if the device is offline or didn't offer push at /login
+ */
+export function PushActuatorCommand(db: AppData, hwid: string): boolean {
+	const session = db.device_sessions.get(hwid);
+	const device = db.devices.get(hwid);
+
+	if (!session || !session.push_commands || !device || session.socket.readyState !== WebSocket.OPEN) {
+		return false;
+	}
+
+	const Command = TakeActuatorCommand(device);
+
+	// Nothing to do, the device keeps its current state
+	if (Command.pumps === 0 && Command.feeders === 0) {
+		return true;
+	}
+
+	const Message = { status: "success" as const, code: 200, data: Command };
+
+	if (session.binary_protocol) {
+		session.socket.send(EncodeBinaryResponse(BINARY_PUSH_COMMAND, Message), { binary: true });
+	}
+	else {
+		session.socket.send(JSON.stringify({ ...Message, endpoint: PUSH_COMMAND_ENDPOINT }));
+		session.socket.send("\r"); // The used IoT library waits a while for "\r", this avoids the unnecessary delay
+	}
+
+	console.log(`[${CurrentLogTimestamp()}] [${session.public_ip}:${session.port}] PUSH: ${JSON.stringify(Command)}`);
+	return true;
+}
\ No newline at end of file
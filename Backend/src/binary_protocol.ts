@@ -0,0 +1,207 @@
+import { RouteHandlerReturnType } from "./types/route";
+
+/**
+ * Fixed-layout frames for /iot/post_data and /iot/get_data, mirrors Hardware/include/BinaryProtocol.h
+ * Multi-byte fields are little-endian. JSON frames always start with "{", so the first byte tells both apart
+ */
+export const BINARY_PROTOCOL_MAGIC = 0xB1;
+export const BINARY_PROTOCOL_VERSION = 3;
+
+const BINARY_POST_DATA = 0x01;
+const BINARY_GET_DATA = 0x02;
+export const BINARY_PUSH_COMMAND = 0x03;
+const BINARY_POST_DELTA = 0x04;
+const BINARY_POST_HISTORY = 0x05;
+
+/** Requests start with magic, type and a uint16 request ID, replies echo the ID before the code */
+const BINARY_REQUEST_HEADER_SIZE = 4;
+const BINARY_READINGS_SIZE = 6;
+const BINARY_POST_DATA_FRAME_SIZE = 18;
+const BINARY_POST_DELTA_HEADER_SIZE = 7;
+const BINARY_POST_HISTORY_HEADER_SIZE = 5;
+const BINARY_HISTORY_SAMPLE_SIZE = 11;
+const BINARY_REPLY_HEADER_SIZE = 7;
+const BINARY_REPLY_MAX_PAYLOAD = 255;
+const BINARY_ACTUATOR_COMMAND_SIZE = 8;
+
+/** Sent for a reading the device doesn't have, stored as null like the JSON path */
+const BINARY_NULL_VALUE = -32768;
+
+/** Bits of the delta field mask, see TelemetryDelta.h */
+const TELEMETRY_FIELD_TEMPERATURE = 0x01;
+const TELEMETRY_FIELD_HUMIDITY = 0x02;
+const TELEMETRY_FIELD_WATER_LEVEL = 0x04;
+const TELEMETRY_FIELD_PUMP = 0x08;
+const TELEMETRY_FIELD_FOOD = 0x10;
+const BINARY_DELTA_KEYFRAME = 0x80;
+
+export type BinaryRequest = {
+	type: number;
+
+	/** Echoed in the reply, 0 if the device didn't set one */
+	id: number;
+
+	/** Route the frame is dispatched to, same as the JSON "key" */
+	key: string;
+	data: { [K: string]: any };
+};
+
+export function IsBinaryFrame(message: Buffer): boolean {
+	return message.length > 0 && message[0] === BINARY_PROTOCOL_MAGIC;
+}
+
+/** Decodes a request into the same key and data the JSON path would hand to the route, undefined if it is malformed */
+export function DecodeBinaryRequest(message: Buffer): BinaryRequest | undefined {
+	if (message.length < BINARY_REQUEST_HEADER_SIZE || message[0] !== BINARY_PROTOCOL_MAGIC) {
+		return undefined;
+	}
+
+	const type = message[1];
+	const id = message.readUInt16LE(2);
+
+	if (type === BINARY_GET_DATA) {
+		return { type, id, key: "/iot/get_data", data: {} };
+	}
+
+	if (type === BINARY_POST_DELTA) {
+		return DecodeBinaryDelta(message, id);
+	}
+
+	if (type === BINARY_POST_HISTORY) {
+		return DecodeBinaryHistory(message, id);
+	}
+
+	if (type !== BINARY_POST_DATA || message.length < BINARY_POST_DATA_FRAME_SIZE) {
+		return undefined;
+	}
+
+	const Temperature = message.readInt16LE(4);
+	const Humidity = message.readInt16LE(6);
+	const WaterLevel = message.readInt16LE(8);
+
+	return {
+		type,
+		id,
+		key: "/iot/post_data",
+		data: {
+			te: Temperature === BINARY_NULL_VALUE ? null : Temperature / 100,
+			hu: Humidity === BINARY_NULL_VALUE ? null : Humidity / 100,
+			wa: WaterLevel === BINARY_NULL_VALUE ? null : WaterLevel,
+			PuEn: message.readUInt32LE(BINARY_REQUEST_HEADER_SIZE + BINARY_READINGS_SIZE),
+			DiFo: message.readUInt32LE(BINARY_REQUEST_HEADER_SIZE + BINARY_READINGS_SIZE + 4)
+		}
+	};
+}
+
+/** Same data as a JSON delta, the fields that aren't in the mask are left out */
+function DecodeBinaryDelta(message: Buffer, id: number): BinaryRequest | undefined {
+	if (message.length < BINARY_POST_DELTA_HEADER_SIZE) {
+		return undefined;
+	}
+
+	const Fields = message[BINARY_REQUEST_HEADER_SIZE + 2];
+	const data: { [K: string]: any } = {
+		sq: message.readUInt16LE(BINARY_REQUEST_HEADER_SIZE)
+	};
+
+	if (Fields & BINARY_DELTA_KEYFRAME) {
+		data.kf = 1;
+	}
+
+	let Offset = BINARY_POST_DELTA_HEADER_SIZE;
+	const Int16Fields: [number, string, number][] = [
+		[TELEMETRY_FIELD_TEMPERATURE, "te", 100],
+		[TELEMETRY_FIELD_HUMIDITY, "hu", 100],
+		[TELEMETRY_FIELD_WATER_LEVEL, "wa", 1]
+	];
+
+	for (const [Bit, Key, Divisor] of Int16Fields) {
+		if (!(Fields & Bit)) {
+			continue;
+		}
+
+		if (message.length < Offset + 2) {
+			return undefined;
+		}
+
+		const Value = message.readInt16LE(Offset);
+		Offset += 2;
+
+		data[Key] = Value === BINARY_NULL_VALUE ? null : Value / Divisor;
+	}
+
+	// Masks by actuator ID
+	const MaskFields: [number, string][] = [
+		[TELEMETRY_FIELD_PUMP, "PuEn"],
+		[TELEMETRY_FIELD_FOOD, "DiFo"]
+	];
+
+	for (const [Bit, Key] of MaskFields) {
+		if (!(Fields & Bit)) {
+			continue;
+		}
+
+		if (message.length < Offset + 4) {
+			return undefined;
+		}
+
+		data[Key] = message.readUInt32LE(Offset);
+		Offset += 4;
+	}
+
+	return { type: BINARY_POST_DELTA, id, key: "/iot/post_data", data };
+}
+
+/** Rows of a uint32 unix time, the readings of /iot/post_data and a flags byte for any pump and any feeder, same as the JSON "s" array */
+function DecodeBinaryHistory(message: Buffer, id: number): BinaryRequest | undefined {
+	if (message.length < BINARY_POST_HISTORY_HEADER_SIZE) {
+		return undefined;
+	}
+
+	const Count = message[BINARY_REQUEST_HEADER_SIZE];
+	if (message.length < BINARY_POST_HISTORY_HEADER_SIZE + Count * BINARY_HISTORY_SAMPLE_SIZE) {
+		return undefined;
+	}
+
+	const Rows: any[] = [];
+	for (let i = 0; i < Count; i++) {
+		const Offset = BINARY_POST_HISTORY_HEADER_SIZE + i * BINARY_HISTORY_SAMPLE_SIZE;
+		const Temperature = message.readInt16LE(Offset + 4);
+		const Humidity = message.readInt16LE(Offset + 6);
+		const WaterLevel = message.readInt16LE(Offset + 8);
+
+		Rows.push([
+			message.readUInt32LE(Offset),
+			Temperature === BINARY_NULL_VALUE ? null : Temperature / 100,
+			Humidity === BINARY_NULL_VALUE ? null : Humidity / 100,
+			WaterLevel === BINARY_NULL_VALUE ? null : WaterLevel,
+			message[Offset + 10]
+		]);
+	}
+
+	return { type: BINARY_POST_HISTORY, id, key: "/iot/post_history", data: { s: Rows } };
+}
+
+/** Encodes a route response for a binary request, error responses carry their message as payload. Pushes have request ID 0 */
+export function EncodeBinaryResponse(type: number, response: Exclude<RouteHandlerReturnType, undefined>, id: number = 0): Buffer {
+	let Payload: Buffer = Buffer.alloc(0);
+
+	if (response.status === "error") {
+		Payload = Buffer.from(response.error_message, "utf8").subarray(0, BINARY_REPLY_MAX_PAYLOAD);
+	}
+	else if (type === BINARY_GET_DATA || type === BINARY_PUSH_COMMAND) {
+		const data = response.data as { pumps?: number, feeders?: number };
+		Payload = Buffer.alloc(BINARY_ACTUATOR_COMMAND_SIZE);
+		Payload.writeUInt32LE((data.pumps ?? 0) >>> 0, 0);
+		Payload.writeUInt32LE((data.feeders ?? 0) >>> 0, 4);
+	}
+
+	const Header = Buffer.alloc(BINARY_REPLY_HEADER_SIZE);
+	Header[0] = BINARY_PROTOCOL_MAGIC;
+	Header[1] = type;
+	Header.writeUInt16LE(id, 2);
+	Header.writeUInt16LE(response.code, 4);
+	Header[6] = Payload.length;
+
+	return Buffer.concat([Header, Payload]);
+}
\ No newline at end of file
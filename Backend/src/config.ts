@@ -11,7 +11,8 @@ export class Config {
 			"config": {},
 			"app_data": {
 				version: "1.0.0",
-				devices: new Map()
+				devices: new Map(),
+				device_sessions: new Map()
 			}
 		};
 	}
@@ -0,0 +1,56 @@
+import { DeviceData } from "./types/iot/DeviceData";
+
+/**
+ * Latency histograms a device reports at /iot/metrics, mirrors Hardware/include/Metrics.h
+ * Rows are [name, count, p50, p90, p99, max] in microseconds, "p" for timed code paths and "l" for how late scheduler tasks started
+ * A report is spread over a few frames, each row replaces the one of the same name
+ */
+export type MetricsSummary = {
+	count: number;
+	p50: number;
+	p90: number;
+	p99: number;
+	max: number;
+};
+
+export type DeviceMetrics = {
+	/** Device uptime in seconds at the last frame */
+	uptime: number;
+	updated_at: number;
+	probes: { [name: string]: MetricsSummary };
+	lateness: { [name: string]: MetricsSummary };
+};
+
+function ParseRows(rows: any, target: { [name: string]: MetricsSummary }): number {
+	if (!Array.isArray(rows)) {
+		return 0;
+	}
+
+	let Stored = 0;
+	for (const Row of rows) {
+		if (!Array.isArray(Row) || Row.length < 6 || typeof Row[0] !== "string" || !Row.slice(1, 6).every(value => typeof value === "number")) {
+			continue;
+		}
+
+		target[Row[0]] = { count: Row[1], p50: Row[2], p90: Row[3], p99: Row[4], max: Row[5] };
+		Stored++;
+	}
+
+	return Stored;
+}
+
+/** Merges one frame into the device metrics, returns how many rows were stored */
+export function MergeMetrics(device: DeviceData, data: { [K: string]: any }): number {
+	if (!device.metrics) {
+		device.metrics = { uptime: 0, updated_at: 0, probes: {}, lateness: {} };
+	}
+
+	const Stored = ParseRows(data.p, device.metrics.probes) + ParseRows(data.l, device.metrics.lateness);
+
+	if (typeof data.up === "number") {
+		device.metrics.uptime = data.up;
+	}
+	device.metrics.updated_at = Date.now();
+
+	return Stored;
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+import { WebSocket } from "ws";
+import { AppData } from "./types/AppData";
+import { CurrentLogTimestamp } from "./utility";
+
+/**
+ * Feeding times a device keeps in flash and runs on its own clock, mirrors Hardware/include/FeedingSchedule.h
+ * The device offers the revision it has at /login, a different one is pushed whole on /iot/push_schedule
+ */
+export const FEEDING_SCHEDULE_VERSION = 1;
+export const PUSH_SCHEDULE_ENDPOINT = "/iot/push_schedule";
+export const SCHEDULE_MAX_ENTRIES = 24;
+export const SCHEDULE_EVERY_DAY = 0x7F;
+
+export type ScheduleEntry = {
+	/** Local minute of the day, 0 - 1439 */
+	minute: number;
+
+	/** Bit per day, bit 0 is Sunday */
+	weekdays: number;
+
+	feeder: number;
+
+	/** Portion, how long the feeder stays open */
+	open_ms: number;
+};
+
+export type FeedingSchedule = {
+	/** Goes up with every change, 0 until the dashboard sets one */
+	rev: number;
+
+	/** Minutes east of UTC the entries are in */
+	tz: number;
+
+	entries: ScheduleEntry[];
+};
+
+/** Checks the entries a dashboard sends, returns them sorted like the device keeps them or an error message */
+export function ParseScheduleEntries(value: any, feederCount: number): ScheduleEntry[] | string {
+	if (!Array.isArray(value) || value.length > SCHEDULE_MAX_ENTRIES) {
+		return `Expected an array of at most ${SCHEDULE_MAX_ENTRIES} entries`;
+	}
+
+	const Entries: ScheduleEntry[] = [];
+	for (const Entry of value) {
+		if (typeof Entry !== "object" || Entry === null) {
+			return "Expected every entry to be an object";
+		}
+
+		const Weekdays = typeof Entry.weekdays === "undefined" ? SCHEDULE_EVERY_DAY : Entry.weekdays;
+		const Feeder = typeof Entry.feeder === "undefined" ? 0 : Entry.feeder;
+
+		if (!Number.isInteger(Entry.minute) || Entry.minute < 0 || Entry.minute >= 1440) {
+			return "Invalid minute, expected 0 - 1439";
+		}
+
+		if (!Number.isInteger(Weekdays) || Weekdays < 1 || Weekdays > SCHEDULE_EVERY_DAY) {
+			return "Invalid weekdays, expected a bit per day with bit 0 for Sunday";
+		}
+
+		if (!Number.isInteger(Feeder) || Feeder < 0 || Feeder >= feederCount) {
+			return "Invalid feeder, the device doesn't have it";
+		}
+
+		if (!Number.isInteger(Entry.open_ms) || Entry.open_ms < 1 || Entry.open_ms > 0xFFFF) {
+			return "Invalid open_ms, expected 1 - 65535";
+		}
+
+		Entries.push({ minute: Entry.minute, weekdays: Weekdays, feeder: Feeder, open_ms: Entry.open_ms });
+	}
+
+	return Entries.sort((a, b) => a.minute - b.minute || a.feeder - b.feeder);
+}
+
+/** 12 hex characters per entry: minute, weekdays, feeder and open_ms, little endian like FeedingSchedule_decodeEntries() */
+export function EncodeScheduleEntries(entries: ScheduleEntry[]): string {
+	const Bytes = Buffer.alloc(entries.length * 6);
+
+	entries.forEach((Entry, i) => {
+		Bytes.writeUInt16LE(Entry.minute, i * 6);
+		Bytes.writeUInt8(Entry.weekdays, i * 6 + 2);
+		Bytes.writeUInt8(Entry.feeder, i * 6 + 3);
+		Bytes.writeUInt16LE(Entry.open_ms, i * 6 + 4);
+	});
+
+	return Bytes.toString("hex");
+}
+
+/**
+ * Sends the whole schedule of a device over its own socket, always as JSON
+ * Returns false if the device is offline or didn't offer the schedule at /login, it gets the table at its next /login
+ */
+export function PushFeedingSchedule(db: AppData, hwid: string): boolean {
+	const session = db.device_sessions.get(hwid);
+	const device = db.devices.get(hwid);
+
+	if (!session || !session.feeding_schedule || !device || session.socket.readyState !== WebSocket.OPEN) {
+		return false;
+	}
+
+	const Data = {
+		rev: device.schedule.rev,
+		tz: device.schedule.tz,
+		e: EncodeScheduleEntries(device.schedule.entries)
+	};
+
+	session.socket.send(JSON.stringify({ status: "success", code: 200, data: Data, endpoint: PUSH_SCHEDULE_ENDPOINT }));
+	session.socket.send("\r"); // The used IoT library waits a while for "\r", this avoids the unnecessary delay
+
+	console.log(`[${CurrentLogTimestamp()}] [${session.public_ip}:${session.port}] PUSH SCHEDULE: rev ${Data.rev}, ${device.schedule.entries.length} entries`);
+	return true;
+}
\ No newline at end of file
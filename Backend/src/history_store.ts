@@ -0,0 +1,421 @@
+/**
+ * Telemetry history of one device, column by column in typed arrays instead of an object per sample
+ * Raw samples go into fixed-size chunks kept in time order, the oldest chunk is dropped once there are too many
+ * Every sample is also added to per-minute and per-hour buckets, each a ring indexed by time, for ranges too long to send raw
+ */
+
+/** One telemetry sample, null for a reading the device didn't have */
+export type HistorySample = {
+	/** Unix time in milliseconds */
+	timestamp: number;
+	te: number | null;
+	hu: number | null;
+	wa: number | null;
+	PuEn: boolean;
+	DiFo: boolean;
+};
+
+export type HistoryResolution = "raw" | "1m" | "1h";
+
+/** Columnar reply of HistoryStore.Query(), one entry per sample or bucket in every array */
+export type HistoryRange = {
+	resolution: HistoryResolution;
+	t: number[];
+	te: (number | null)[];
+	hu: (number | null)[];
+	wa: (number | null)[];
+
+	/** 0 or 1 for raw samples, the share of samples with the pump or servo on for a bucket */
+	PuEn: number[];
+	DiFo: number[];
+
+	/** Buckets only, samples in each and the range of every reading */
+	n?: number[];
+	te_min?: (number | null)[];
+	te_max?: (number | null)[];
+	hu_min?: (number | null)[];
+	hu_max?: (number | null)[];
+	wa_min?: (number | null)[];
+	wa_max?: (number | null)[];
+
+	/** More points were in range than HISTORY_MAX_POINTS, the newest are left out */
+	truncated: boolean;
+};
+
+export const HISTORY_CHUNK_SIZE = 1024;
+
+/** Raw samples kept per device, about two days at the rate of change-driven reports */
+export const HISTORY_MAX_CHUNKS = 64;
+
+/** Points in one reply, a longer range falls back to a coarser resolution unless one is asked for */
+export const HISTORY_MAX_POINTS = 2000;
+
+const HISTORY_FLAG_PUMP = 0x01;
+const HISTORY_FLAG_FOOD = 0x02;
+
+/** Readings are stored as float32, sent with the two decimals the device reports */
+function Round(value: number): number {
+	return Math.round(value * 100) / 100;
+}
+
+class HistoryChunk {
+	length: number = 0;
+	timestamps = new Float64Array(HISTORY_CHUNK_SIZE);
+
+	/** NaN where the reading was null */
+	te = new Float32Array(HISTORY_CHUNK_SIZE);
+	hu = new Float32Array(HISTORY_CHUNK_SIZE);
+	wa = new Float32Array(HISTORY_CHUNK_SIZE);
+	flags = new Uint8Array(HISTORY_CHUNK_SIZE);
+
+	first(): number {
+		return this.timestamps[0];
+	}
+
+	/** Index of the first sample at or after timestamp, or after it if isAfter is set */
+	lowerBound(timestamp: number, isAfter: boolean = false): number {
+		let Low = 0;
+		let High = this.length;
+
+		while (Low < High) {
+			const Middle = (Low + High) >>> 1;
+			if (this.timestamps[Middle] < timestamp || (isAfter && this.timestamps[Middle] === timestamp)) {
+				Low = Middle + 1;
+			}
+			else {
+				High = Middle;
+			}
+		}
+
+		return Low;
+	}
+
+	insert(index: number, sample: HistorySample) {
+		if (index < this.length) {
+			this.timestamps.copyWithin(index + 1, index, this.length);
+			this.te.copyWithin(index + 1, index, this.length);
+			this.hu.copyWithin(index + 1, index, this.length);
+			this.wa.copyWithin(index + 1, index, this.length);
+			this.flags.copyWithin(index + 1, index, this.length);
+		}
+
+		this.timestamps[index] = sample.timestamp;
+		this.te[index] = sample.te ?? NaN;
+		this.hu[index] = sample.hu ?? NaN;
+		this.wa[index] = sample.wa ?? NaN;
+		this.flags[index] = (sample.PuEn ? HISTORY_FLAG_PUMP : 0) | (sample.DiFo ? HISTORY_FLAG_FOOD : 0);
+		this.length++;
+	}
+
+	/** Moves the upper half into a new chunk that goes right after this one */
+	split(): HistoryChunk {
+		const Half = this.length >>> 1;
+		const Upper = new HistoryChunk();
+
+		Upper.timestamps.set(this.timestamps.subarray(Half, this.length));
+		Upper.te.set(this.te.subarray(Half, this.length));
+		Upper.hu.set(this.hu.subarray(Half, this.length));
+		Upper.wa.set(this.wa.subarray(Half, this.length));
+		Upper.flags.set(this.flags.subarray(Half, this.length));
+		Upper.length = this.length - Half;
+
+		this.length = Half;
+		return Upper;
+	}
+}
+
+/** Aggregates of every sample that fell into the same bucket, bucket i of time t sits at slot (t / resolution) % capacity */
+class HistoryTier {
+	resolution: number;
+	capacity: number;
+
+	/** Bucket number held by each slot, -1 if empty */
+	buckets: Float64Array;
+	counts: Uint32Array;
+	pumpCounts: Uint32Array;
+	foodCounts: Uint32Array;
+
+	/** Sum, non-null count, min and max of te, hu and wa in that order */
+	sums: Float64Array[];
+	valueCounts: Uint32Array[];
+	mins: Float32Array[];
+	maxs: Float32Array[];
+
+	constructor(resolution: number, capacity: number) {
+		this.resolution = resolution;
+		this.capacity = capacity;
+		this.buckets = new Float64Array(capacity).fill(-1);
+		this.counts = new Uint32Array(capacity);
+		this.pumpCounts = new Uint32Array(capacity);
+		this.foodCounts = new Uint32Array(capacity);
+		this.sums = [0, 1, 2].map(() => new Float64Array(capacity));
+		this.valueCounts = [0, 1, 2].map(() => new Uint32Array(capacity));
+		this.mins = [0, 1, 2].map(() => new Float32Array(capacity));
+		this.maxs = [0, 1, 2].map(() => new Float32Array(capacity));
+	}
+
+	/** False if the sample is older than the oldest bucket this tier still holds at its slot */
+	add(sample: HistorySample): boolean {
+		const Bucket = Math.floor(sample.timestamp / this.resolution);
+		const Slot = Bucket % this.capacity;
+
+		if (this.buckets[Slot] > Bucket) {
+			return false;
+		}
+
+		if (this.buckets[Slot] !== Bucket) {
+			this.buckets[Slot] = Bucket;
+			this.counts[Slot] = 0;
+			this.pumpCounts[Slot] = 0;
+			this.foodCounts[Slot] = 0;
+
+			for (let i = 0; i < 3; i++) {
+				this.sums[i][Slot] = 0;
+				this.valueCounts[i][Slot] = 0;
+				this.mins[i][Slot] = Infinity;
+				this.maxs[i][Slot] = -Infinity;
+			}
+		}
+
+		this.counts[Slot]++;
+		this.pumpCounts[Slot] += sample.PuEn ? 1 : 0;
+		this.foodCounts[Slot] += sample.DiFo ? 1 : 0;
+
+		const Values = [sample.te, sample.hu, sample.wa];
+		for (let i = 0; i < 3; i++) {
+			const Value = Values[i];
+			if (Value === null || !Number.isFinite(Value)) {
+				continue;
+			}
+
+			this.sums[i][Slot] += Value;
+			this.valueCounts[i][Slot]++;
+			if (Value < this.mins[i][Slot]) this.mins[i][Slot] = Value;
+			if (Value > this.maxs[i][Slot]) this.maxs[i][Slot] = Value;
+		}
+
+		return true;
+	}
+
+	/** Buckets that start in [from, to], oldest first */
+	query(from: number, to: number, range: HistoryRange) {
+		const First = Math.max(Math.floor(from / this.resolution), 0);
+		const Last = Math.floor(to / this.resolution);
+
+		// Anything older than capacity buckets before the last one was overwritten already
+		const Start = Math.max(First, Last - this.capacity + 1);
+		const Columns = [
+			[range.te, range.te_min!, range.te_max!],
+			[range.hu, range.hu_min!, range.hu_max!],
+			[range.wa, range.wa_min!, range.wa_max!]
+		];
+
+		for (let Bucket = Start; Bucket <= Last; Bucket++) {
+			const Slot = Bucket % this.capacity;
+			if (this.buckets[Slot] !== Bucket || this.counts[Slot] === 0) {
+				continue;
+			}
+
+			if (range.t.length >= HISTORY_MAX_POINTS) {
+				range.truncated = true;
+				return;
+			}
+
+			range.t.push(Bucket * this.resolution);
+			range.n!.push(this.counts[Slot]);
+			range.PuEn.push(this.pumpCounts[Slot] / this.counts[Slot]);
+			range.DiFo.push(this.foodCounts[Slot] / this.counts[Slot]);
+
+			for (let i = 0; i < 3; i++) {
+				const HasValue = this.valueCounts[i][Slot] > 0;
+				Columns[i][0].push(HasValue ? Round(this.sums[i][Slot] / this.valueCounts[i][Slot]) : null);
+				Columns[i][1].push(HasValue ? Round(this.mins[i][Slot]) : null);
+				Columns[i][2].push(HasValue ? Round(this.maxs[i][Slot]) : null);
+			}
+		}
+	}
+
+	/** Buckets that would be returned for [from, to] */
+	count(from: number, to: number): number {
+		return Math.min(Math.floor(to / this.resolution) - Math.floor(from / this.resolution) + 1, this.capacity);
+	}
+}
+
+export class HistoryStore {
+	private chunks: HistoryChunk[] = [];
+	private minutes = new HistoryTier(60 * 1000, 7 * 24 * 60);
+	private hours = new HistoryTier(60 * 60 * 1000, 366 * 24);
+
+	/** Samples dropped with their chunk to make room, and samples given again that were already stored */
+	evicted: number = 0;
+	duplicates: number = 0;
+
+	/**
+	 * Adds a sample where its timestamp belongs, samples journaled offline arrive after newer live ones
+	 * False for a timestamp that is already stored, e.g. a batch sent again after its reply was lost
+	 */
+	Append(sample: HistorySample): boolean {
+		if (!this.insertRaw(sample)) {
+			return false;
+		}
+
+		this.minutes.add(sample);
+		this.hours.add(sample);
+		return true;
+	}
+
+	/** Samples in [from, to] at the given resolution, or the finest one that fits HISTORY_MAX_POINTS */
+	Query(from: number, to: number, resolution?: HistoryResolution): HistoryRange {
+		if (typeof resolution === "undefined") {
+			if (this.countRaw(from, to) <= HISTORY_MAX_POINTS) {
+				resolution = "raw";
+			}
+			else if (this.minutes.count(from, to) <= HISTORY_MAX_POINTS) {
+				resolution = "1m";
+			}
+			else {
+				resolution = "1h";
+			}
+		}
+
+		const Range: HistoryRange = { resolution, t: [], te: [], hu: [], wa: [], PuEn: [], DiFo: [], truncated: false };
+		if (resolution === "raw") {
+			this.queryRaw(from, to, Range);
+			return Range;
+		}
+
+		Range.n = [];
+		Range.te_min = [];
+		Range.te_max = [];
+		Range.hu_min = [];
+		Range.hu_max = [];
+		Range.wa_min = [];
+		Range.wa_max = [];
+
+		(resolution === "1m" ? this.minutes : this.hours).query(from, to, Range);
+		return Range;
+	}
+
+	/** Raw samples currently held */
+	get size(): number {
+		return this.chunks.reduce((Total, Chunk) => Total + Chunk.length, 0);
+	}
+
+	/** /client/get_data sends the whole DeviceData, only a summary of the history goes with it */
+	toJSON() {
+		const Last = this.chunks[this.chunks.length - 1];
+		return {
+			samples: this.size,
+			first: this.chunks.length > 0 ? this.chunks[0].first() : null,
+			last: Last ? Last.timestamps[Last.length - 1] : null
+		};
+	}
+
+	private insertRaw(sample: HistorySample): boolean {
+		if (!Number.isFinite(sample.timestamp)) {
+			return false;
+		}
+
+		if (this.chunks.length === 0) {
+			this.chunks.push(new HistoryChunk());
+		}
+
+		// Once the store is full nothing older than what it holds is kept
+		if (this.chunks.length >= HISTORY_MAX_CHUNKS && sample.timestamp < this.chunks[0].first()) {
+			this.evicted++;
+			return false;
+		}
+
+		const ChunkIndex = this.findChunk(sample.timestamp);
+		let Chunk = this.chunks[ChunkIndex];
+		let Index = Chunk.lowerBound(sample.timestamp);
+
+		if (Index < Chunk.length && Chunk.timestamps[Index] === sample.timestamp) {
+			this.duplicates++;
+			return false;
+		}
+
+		if (Chunk.length >= HISTORY_CHUNK_SIZE) {
+			if (Index === Chunk.length && ChunkIndex === this.chunks.length - 1) {
+				// Appending in order, the common case, starts a new chunk without copying
+				Chunk = new HistoryChunk();
+				Index = 0;
+				this.chunks.push(Chunk);
+			}
+			else {
+				const Upper = Chunk.split();
+				this.chunks.splice(ChunkIndex + 1, 0, Upper);
+
+				if (Index > Chunk.length) {
+					Index -= Chunk.length;
+					Chunk = Upper;
+				}
+			}
+		}
+
+		Chunk.insert(Index, sample);
+
+		while (this.chunks.length > HISTORY_MAX_CHUNKS) {
+			this.evicted += this.chunks.shift()!.length;
+		}
+
+		return true;
+	}
+
+	/** Last chunk that starts at or before timestamp, the first chunk for anything older */
+	private findChunk(timestamp: number): number {
+		let Low = 0;
+		let High = this.chunks.length - 1;
+
+		while (Low < High) {
+			const Middle = (Low + High + 1) >>> 1;
+			if (this.chunks[Middle].first() <= timestamp) {
+				Low = Middle;
+			}
+			else {
+				High = Middle - 1;
+			}
+		}
+
+		return Low;
+	}
+
+	private countRaw(from: number, to: number): number {
+		let Count = 0;
+
+		for (let i = this.findChunk(from); i < this.chunks.length; i++) {
+			const Chunk = this.chunks[i];
+			if (Chunk.length === 0 || Chunk.first() > to) {
+				break;
+			}
+
+			Count += Chunk.lowerBound(to, true) - Chunk.lowerBound(from);
+		}
+
+		return Count;
+	}
+
+	private queryRaw(from: number, to: number, range: HistoryRange) {
+		for (let i = this.findChunk(from); i < this.chunks.length; i++) {
+			const Chunk = this.chunks[i];
+			if (Chunk.length === 0 || Chunk.first() > to) {
+				return;
+			}
+
+			const End = Chunk.lowerBound(to, true);
+			for (let j = Chunk.lowerBound(from); j < End; j++) {
+				if (range.t.length >= HISTORY_MAX_POINTS) {
+					range.truncated = true;
+					return;
+				}
+
+				range.t.push(Chunk.timestamps[j]);
+				range.te.push(Number.isNaN(Chunk.te[j]) ? null : Round(Chunk.te[j]));
+				range.hu.push(Number.isNaN(Chunk.hu[j]) ? null : Round(Chunk.hu[j]));
+				range.wa.push(Number.isNaN(Chunk.wa[j]) ? null : Round(Chunk.wa[j]));
+				range.PuEn.push(Chunk.flags[j] & HISTORY_FLAG_PUMP ? 1 : 0);
+				range.DiFo.push(Chunk.flags[j] & HISTORY_FLAG_FOOD ? 1 : 0);
+			}
+		}
+	}
+}
\ No newline at end of file
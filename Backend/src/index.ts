@@ -6,6 +6,10 @@ import { ClientSession } from "./types/client_session";
 import Routes from "./routes";
 import { RouteHandler, RouteHandlerReturnType } from "./types/route";
 import { CurrentLogTimestamp } from "./utility";
+import { DecodeBinaryRequest, EncodeBinaryResponse, IsBinaryFrame } from "./binary_protocol";
+
+/** Replies kept per session for retransmitted requests, has to cover the request window of the device */
+const REPLY_CACHE_SIZE = 16;
 
 class PetFeederBackend {
 	private PORT: number | undefined = undefined;
@@ -146,15 +150,13 @@ class PetFeederBackend {
 			ws.on("error", (error) => {
 				console.error("WebSocket error:", error);
 
-				if (this.WebSocketClientSessions.has(SessionKey))
-					this.WebSocketClientSessions.delete(SessionKey);
+				this.RemoveClientSession(SessionKey);
 			});
 
 			ws.on("close", () => {
 				console.log(`[${CurrentLogTimestamp()}] [${ClientAddr}:${ClientPort}] Client disconnected`);
 
-				if (this.WebSocketClientSessions.has(SessionKey)) 
-					this.WebSocketClientSessions.delete(SessionKey);
+				this.RemoveClientSession(SessionKey);
 			});
 
 			ws.on("message", (message, isBinary) => {
@@ -164,6 +166,32 @@ class PetFeederBackend {
 					return;
 				}
 
+				// Binary frames are decoded into the same key and data, then go through the same route handlers
+				if (IsBinaryFrame(message)) {
+					const session = this.WebSocketClientSessions.get(SessionKey);
+					if (!session) {
+						console.error("No session found for client:", SessionKey);
+						ws.close(1003, "Session not found");
+						return;
+					}
+
+					if (!session.binary_protocol) {
+						console.error("Received a binary frame that wasn't negotiated at /login");
+						ws.close(1003, "Binary frames must be negotiated at /login");
+						return;
+					}
+
+					const request = DecodeBinaryRequest(message);
+					if (!request) {
+						console.error("Received malformed binary frame:", message);
+						ws.close(1003, "Invalid binary frame");
+						return;
+					}
+
+					this.onClientMessage(ws, session, request.key, request.data, request.type, request.id);
+					return;
+				}
+
 				// Convert the buffer to string
 				const messageString = message.toString("utf8");
 				if (!messageString) {
@@ -210,7 +238,10 @@ class PetFeederBackend {
 					return;
 				}
 
-				this.onClientMessage(ws, session, key, route_data);
+				// Devices tag their requests with an "id" to match the replies, echoed back as is
+				const request_id = Number.isInteger(data["id"]) ? data["id"] : undefined;
+
+				this.onClientMessage(ws, session, key, route_data, undefined, request_id);
 			});
 		});
 
@@ -236,6 +267,20 @@ class PetFeederBackend {
 		}, 3000); // Ping every 30 seconds
 	}
 
+	private RemoveClientSession(SessionKey: string) {
+		const session = this.WebSocketClientSessions.get(SessionKey);
+		if (!session)
+			return;
+
+		this.WebSocketClientSessions.delete(SessionKey);
+
+		// Pushes go nowhere once the device is gone, a reconnect registers it again at /login
+		const hwid = session.auth_data?.iot_hwid;
+		const device_sessions = this.db.data.app_data.device_sessions;
+		if (hwid && device_sessions.get(hwid) === session)
+			device_sessions.delete(hwid);
+	}
+
 	private PingClients() {
 		this.WebSocketServer.clients.forEach((client: WebSocket) => {
 			if (client.readyState === WebSocket.OPEN) {
@@ -244,11 +289,23 @@ class PetFeederBackend {
 		});
 	}
 
-	private onClientMessage(ws: WebSocket, session: ClientSession, key: string, data: any) {
+	/**
+	 * binaryType is set if the request came as a binary frame, the response is then sent as one too
+	 * requestId is echoed in the response, 0 or undefined if the client didn't set one
+	 */
+	private onClientMessage(ws: WebSocket, session: ClientSession, key: string, data: any, binaryType?: number, requestId?: number) {
 		let response: RouteHandlerReturnType;
 
 		console.log(`[${CurrentLogTimestamp()}] [${session.public_ip}:${session.port}] REQUEST: ${key}`);
 
+		// The device sends a request again when its reply is late, it gets the same reply without running the route twice
+		const CachedReply = requestId ? session.reply_cache?.get(requestId) : undefined;
+		if (CachedReply) {
+			this.SendReply(ws, CachedReply);
+			console.log(`[${CurrentLogTimestamp()}] [${session.public_ip}:${session.port}] RESPONSE (cached, request ${requestId})`);
+			return;
+		}
+
 		// Get the route function
 		const routeFunction = Routes.get(key);
 
@@ -291,13 +348,51 @@ class PetFeederBackend {
 			};
 		}
 
-		let EncodedResponse = JSON.stringify({ ...response, endpoint: key });
-		ws.send(EncodedResponse);
-		ws.send("\r"); // The used IoT library waits a while for "\r", this avoids the unnecessary delay
+		let EncodedResponse = JSON.stringify(requestId ? { ...response, endpoint: key, id: requestId } : { ...response, endpoint: key });
+
+		if (typeof binaryType !== "undefined") {
+			// Binary replies carry their own length, so no "\r" frame is needed
+			const BinaryResponse = EncodeBinaryResponse(binaryType, response, requestId);
+			this.CacheReply(session, requestId, BinaryResponse);
+			this.SendReply(ws, BinaryResponse);
+
+			console.log(`[${CurrentLogTimestamp()}] [${session.public_ip}:${session.port}] RESPONSE (binary, ${BinaryResponse.length} bytes): ${EncodedResponse}`);
+			return;
+		}
+
+		this.CacheReply(session, requestId, EncodedResponse);
+		this.SendReply(ws, EncodedResponse);
 
 		console.log(`[${CurrentLogTimestamp()}] [${session.public_ip}:${session.port}] RESPONSE: ${EncodedResponse}`);
 	}
 
+	private CacheReply(session: ClientSession, requestId: number | undefined, reply: Buffer | string) {
+		if (!requestId) {
+			return;
+		}
+
+		if (!session.reply_cache) {
+			session.reply_cache = new Map();
+		}
+
+		session.reply_cache.set(requestId, reply);
+
+		// Maps keep insertion order, the first key is the oldest reply
+		if (session.reply_cache.size > REPLY_CACHE_SIZE) {
+			session.reply_cache.delete(session.reply_cache.keys().next().value as number);
+		}
+	}
+
+	private SendReply(ws: WebSocket, reply: Buffer | string) {
+		if (typeof reply !== "string") {
+			ws.send(reply, { binary: true });
+			return;
+		}
+
+		ws.send(reply);
+		ws.send("\r"); // The used IoT library waits a while for "\r", this avoids the unnecessary delay
+	}
+
 	private ProcessRequest(handler_name: string, handler: RouteHandler, client: WebSocket, session: ClientSession, data: object): Exclude<RouteHandlerReturnType, undefined> {
 		let RouteResponse = handler(client, this.db.data.app_data, session, data);
 
@@ -3,9 +3,13 @@ import hello from "./routes/hello";
 import login from "./routes/login";
 import iot_get_data from "./routes/iot/get_data";
 import iot_post_state_data from "./routes/iot/post_state_data";
+import iot_post_history from "./routes/iot/post_history";
+import iot_post_metrics from "./routes/iot/post_metrics";
 import client_get_data from "./routes/client/get_data";
+import client_get_history from "./routes/client/get_history";
 import client_food_control from "./routes/client/food_control";
 import client_pump_control from "./routes/client/pump_control";
+import client_set_schedule from "./routes/client/set_schedule";
 
 const RouteMap = new Map<string, RouteHandler>();
 
@@ -13,8 +17,12 @@ RouteMap.set("/hello", hello);
 RouteMap.set("/login", login);
 RouteMap.set("/iot/get_data", iot_get_data);
 RouteMap.set("/iot/post_data", iot_post_state_data);
+RouteMap.set("/iot/post_history", iot_post_history);
+RouteMap.set("/iot/metrics", iot_post_metrics);
 RouteMap.set("/client/get_data", client_get_data);
+RouteMap.set("/client/get_history", client_get_history);
 RouteMap.set("/client/food_control", client_food_control);
 RouteMap.set("/client/pump_control", client_pump_control);
+RouteMap.set("/client/set_schedule", client_set_schedule);
 
 export default RouteMap;
\ No newline at end of file
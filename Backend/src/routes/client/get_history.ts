@@ -0,0 +1,75 @@
+import { RouteHandler } from "../../types/route";
+import { HistoryResolution } from "../../history_store";
+
+const RESOLUTIONS: HistoryResolution[] = ["raw", "1m", "1h"];
+
+/** Last 24 hours unless "from" and "to" are given */
+const DEFAULT_RANGE = 24 * 60 * 60 * 1000;
+
+const handler: RouteHandler = (client, db, session, data) => {
+	if (typeof session.auth_data === "undefined") {
+		return {
+			status: "error",
+			code: 401,
+			error_message: "You must be authenticated to get history"
+		};
+	}
+
+	if (session.auth_data.kind !== "client") {
+		return {
+			status: "error",
+			code: 403,
+			error_message: "This endpoint is only accessible by client devices"
+		};
+	}
+
+	if (typeof data !== "object" || typeof data.iot_hwid !== "string") {
+		return {
+			status: "error",
+			code: 400,
+			error_message: "Invalid iot_hwid format, expected a string"
+		};
+	}
+
+	// Unix time in milliseconds, both ends included
+	const To = typeof data.to === "number" ? data.to : Date.now();
+	const From = typeof data.from === "number" ? data.from : To - DEFAULT_RANGE;
+
+	if (!Number.isFinite(From) || !Number.isFinite(To) || From > To) {
+		return {
+			status: "error",
+			code: 400,
+			error_message: "Invalid range, expected \"from\" and \"to\" in milliseconds with from <= to"
+		};
+	}
+
+	if (typeof data.resolution !== "undefined" && !RESOLUTIONS.includes(data.resolution)) {
+		return {
+			status: "error",
+			code: 400,
+			error_message: "Invalid resolution, expected \"raw\", \"1m\" or \"1h\""
+		};
+	}
+
+	const Device = db.devices.get(data.iot_hwid);
+	if (!Device) {
+		return {
+			status: "error",
+			code: 404,
+			error_message: "This IoT device data is not found"
+		};
+	}
+
+	return {
+		status: "success",
+		code: 200,
+		data: {
+			iot_hwid: data.iot_hwid,
+			from: From,
+			to: To,
+			...Device.history.Query(From, To, data.resolution)
+		}
+	};
+}
+
+export default handler;
\ No newline at end of file
@@ -1,5 +1,6 @@
 import { WaterPump } from "../../types/iot";
 import { RouteHandler } from "../../types/route";
+import { ACTUATOR_MAX_COUNT, PushActuatorCommand } from "../../actuator_command";
 
 const handler: RouteHandler = (client, db, session, data) =>{
 	if (typeof session.auth_data === "undefined") {
@@ -54,7 +55,17 @@ const handler: RouteHandler = (client, db, session, data) =>{
 		};
 	}
 
-	const servo = a.live.find((item) => item.type === "WaterPump") as WaterPump | undefined;
+	// Actuator 0 unless the dashboard picks one
+	const id = typeof data.id === "undefined" ? 0 : data.id;
+	if (!Number.isInteger(id) || id < 0 || id >= ACTUATOR_MAX_COUNT) {
+		return {
+			status: "error",
+			code: 400,
+			error_message: "Invalid id format, expected an actuator ID",
+		};
+	}
+
+	const servo = a.live.find((item) => item.type === "WaterPump" && ((item as WaterPump).id ?? 0) === id) as WaterPump | undefined;
 	if (!servo) {
 		return {
 			status: "error",
@@ -66,6 +77,9 @@ const handler: RouteHandler = (client, db, session, data) =>{
 	servo.triggerEnableWaterPump = data.enable;
 
 	db.devices.set(data.iot_hwid, a);
+
+	// Devices that can't take a push pick the trigger up with their next /iot/get_data
+	PushActuatorCommand(db, data.iot_hwid);
 }
 
 export default handler;
\ No newline at end of file
@@ -0,0 +1,86 @@
+import { RouteHandler } from "../../types/route";
+import { ACTUATOR_MAX_COUNT } from "../../actuator_command";
+import { ParseScheduleEntries, PushFeedingSchedule } from "../../feeding_schedule";
+
+const handler: RouteHandler = (client, db, session, data) =>{
+	if (typeof session.auth_data === "undefined") {
+		return {
+			status: "error",
+			code: 401,
+			error_message: "You must be authenticated to post data"
+		};
+	}
+
+	// If client isn't iot device, return error
+	if (session.auth_data.kind !== "client") {
+		return {
+			status: "error",
+			code: 403,
+			error_message: "This endpoint is only accessible by client devices"
+		};
+	}
+
+	if (typeof data !== "object") {
+		return {
+			status: "error",
+			code: 400,
+			error_message: "You should send \"iot_hwid\" in the data",
+		};
+	}
+
+	if (typeof data.iot_hwid !== "string") {
+		return {
+			status: "error",
+			code: 400,
+			error_message: "Invalid iot_hwid format, expected a string",
+		};
+	}
+
+	let a = db.devices.get(data.iot_hwid);
+
+	// Check if this device exist on the db
+	if (!a) {
+		return {
+			status: "error",
+			code: 404,
+			error_message: "This IoT device data is not found"
+		};
+	}
+
+	// Minutes east of UTC, the time zone stays as it was unless the dashboard sends one
+	const tz = typeof data.tz === "undefined" ? a.schedule.tz : data.tz;
+	if (!Number.isInteger(tz) || tz < -720 || tz > 840) {
+		return {
+			status: "error",
+			code: 400,
+			error_message: "Invalid tz format, expected minutes from -720 to 840",
+		};
+	}
+
+	// A device that never logged in may have any number of feeders, it drops a table with one it doesn't have
+	const FeederCount = db.device_sessions.get(data.iot_hwid)?.feeder_count ?? ACTUATOR_MAX_COUNT;
+	const Entries = ParseScheduleEntries(data.entries, FeederCount);
+	if (typeof Entries === "string") {
+		return {
+			status: "error",
+			code: 400,
+			error_message: Entries,
+		};
+	}
+
+	// The whole table is replaced, the device only keeps the newest revision
+	a.schedule = { rev: a.schedule.rev + 1, tz: tz, entries: Entries };
+
+	db.devices.set(data.iot_hwid, a);
+
+	// Devices that are offline get the table at their next /login
+	PushFeedingSchedule(db, data.iot_hwid);
+
+	return {
+		status: "success",
+		code: 200,
+		data: { rev: a.schedule.rev }
+	};
+}
+
+export default handler;
\ No newline at end of file
@@ -1,5 +1,5 @@
-import { FoodServo, WaterPump } from "../../types/iot";
 import { RouteHandler } from "../../types/route";
+import { TakeActuatorCommand } from "../../actuator_command";
 
 const handler: RouteHandler = (client, db, session, data) =>{
 	if (typeof session.auth_data === "undefined") {
@@ -48,22 +48,7 @@ const handler: RouteHandler = (client, db, session, data) =>{
 		};
 	}
 
-	const ResultData = {
-		shouldEnableWaterPump: false,
-		shouldDispenseFood: false
-	};
-
-	let WaterPump = a.live.find((d) => d.type === "WaterPump") as WaterPump | undefined;
-	if (WaterPump) {
-		ResultData.shouldEnableWaterPump = WaterPump.triggerEnableWaterPump;
-		WaterPump.triggerEnableWaterPump = false; // Reset the trigger after getting the data
-	}
-
-	let Servo = a.live.find((d) => d.type === "Servo") as FoodServo | undefined;
-	if (Servo) {
-		ResultData.shouldDispenseFood = Servo.triggerDispenseFood;
-		Servo.triggerDispenseFood = false; // Reset the trigger after getting the data
-	}
+	const ResultData = TakeActuatorCommand(a);
 
 	return {
 		status: "success",
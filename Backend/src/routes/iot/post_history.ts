@@ -0,0 +1,57 @@
+import { RouteHandler } from "../../types/route";
+import { AppendHistory } from "../../telemetry_history";
+
+const handler: RouteHandler = (client, db, session, data) => {
+	if (typeof session.auth_data === "undefined") {
+		return {
+			status: "error",
+			code: 401,
+			error_message: "You must be authenticated to post history"
+		};
+	}
+
+	if (!session.auth_data.iot_hwid) {
+		return {
+			status: "error",
+			code: 403,
+			error_message: "IoT device HWID is not set in session",
+		};
+	}
+
+	if (!session.telemetry_history) {
+		return {
+			status: "error",
+			code: 400,
+			error_message: "History upload must be negotiated at /login"
+		};
+	}
+
+	if (typeof data !== "object" || !Array.isArray(data.s)) {
+		return {
+			status: "error",
+			code: 400,
+			error_message: "Invalid data format. Expected an array of samples in \"s\""
+		};
+	}
+
+	const Device = db.devices.get(session.auth_data.iot_hwid);
+	if (!Device) {
+		return {
+			status: "error",
+			code: 404,
+			error_message: "This IoT device data is not found"
+		};
+	}
+
+	AppendHistory(Device, data.s);
+
+	return {
+		code: 200,
+		status: "success",
+		data: {
+			message: "History received successfully"
+		}
+	};
+}
+
+export default handler;
\ No newline at end of file
@@ -0,0 +1,49 @@
+import { RouteHandler } from "../../types/route";
+import { MergeMetrics } from "../../device_metrics";
+
+const handler: RouteHandler = (client, db, session, data) => {
+	if (typeof session.auth_data === "undefined") {
+		return {
+			status: "error",
+			code: 401,
+			error_message: "You must be authenticated to post metrics"
+		};
+	}
+
+	if (!session.auth_data.iot_hwid) {
+		return {
+			status: "error",
+			code: 403,
+			error_message: "IoT device HWID is not set in session",
+		};
+	}
+
+	if (typeof data !== "object" || (!Array.isArray(data.p) && !Array.isArray(data.l))) {
+		return {
+			status: "error",
+			code: 400,
+			error_message: "Invalid data format. Expected rows in \"p\" or \"l\""
+		};
+	}
+
+	const Device = db.devices.get(session.auth_data.iot_hwid);
+	if (!Device) {
+		return {
+			status: "error",
+			code: 404,
+			error_message: "This IoT device data is not found"
+		};
+	}
+
+	MergeMetrics(Device, data);
+
+	return {
+		code: 200,
+		status: "success",
+		data: {
+			message: "Metrics received successfully"
+		}
+	};
+}
+
+export default handler;
\ No newline at end of file
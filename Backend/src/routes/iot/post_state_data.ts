@@ -1,5 +1,7 @@
 import * as IoT_Types from "../../types/iot";
 import { RouteHandler } from "../../types/route";
+import { CheckTelemetrySequence } from "../../telemetry_delta";
+import { AppendLiveSample } from "../../telemetry_history";
 
 const handler: RouteHandler = (client, db, session, data) => {
 	if (typeof session.auth_data === "undefined") {
@@ -38,10 +40,18 @@ const handler: RouteHandler = (client, db, session, data) => {
 		};
 	}
 
-	if (typeof data.te !== "undefined" && typeof data.hu !== "undefined") {
+	const SequenceReply = CheckTelemetrySequence(session, data);
+	if (SequenceReply) {
+		return SequenceReply;
+	}
+
+	if (typeof data.te !== "undefined" || typeof data.hu !== "undefined") {
+		// A delta may carry only one of them, the other keeps its last value
+		const Current = a.live.find(item => item.type === "DHT") as IoT_Types.DHT | undefined;
+
 		let b = new IoT_Types.DHT();
-		b.temperature = data.te;
-		b.humidity = data.hu;
+		b.temperature = typeof data.te !== "undefined" ? data.te : (Current ? Current.temperature : b.temperature);
+		b.humidity = typeof data.hu !== "undefined" ? data.hu : (Current ? Current.humidity : b.humidity);
 
 		a.live = pushOrMergeDeviceData(a.live, b);
 	}
@@ -53,20 +63,25 @@ const handler: RouteHandler = (client, db, session, data) => {
 		a.live = pushOrMergeDeviceData(a.live, b);
 	}
 
+	// Masks by actuator ID, a device with one of each sends 0 or 1 like before
 	if (typeof data.PuEn !== "undefined") {
-		let b = new IoT_Types.WaterPump();
-		b.powered_on = (data.PuEn > 0) ? true : false;
+		for (let id = 0; id < (session.pump_count ?? 1); id++) {
+			let b = new IoT_Types.WaterPump(((data.PuEn >>> id) & 1) === 1, id);
 
-		a.live = pushOrMergeDeviceData(a.live, b);
+			a.live = pushOrMergeDeviceData(a.live, b);
+		}
 	}
 
 	if (typeof data.DiFo !== "undefined") {
-		let b = new IoT_Types.FoodServo();
-		b.isDispensing = (data.DiFo > 0) ? true : false;
+		for (let id = 0; id < (session.feeder_count ?? 1); id++) {
+			let b = new IoT_Types.FoodServo(((data.DiFo >>> id) & 1) === 1, id);
 
-		a.live = pushOrMergeDeviceData(a.live, b);
+			a.live = pushOrMergeDeviceData(a.live, b);
+		}
 	}
 
+	AppendLiveSample(a, Date.now());
+
 	db.devices.set(session.auth_data.iot_hwid, a);
 
 	return {
@@ -81,8 +96,9 @@ const handler: RouteHandler = (client, db, session, data) => {
 export default handler;
 
 function pushOrMergeDeviceData<T extends IoT_Types.BaseDeviceData>(collection: IoT_Types.BaseDeviceData[], newData: T): IoT_Types.BaseDeviceData[] {
-	// Find whether the exact same pair of kind and type already exists
-	const existingIndex = collection.findIndex(item => item.kind === newData.kind && item.type === newData.type);
+	// Find whether the exact same kind, type and actuator ID already exists
+	const Id = (newData as any).id ?? 0;
+	const existingIndex = collection.findIndex(item => item.kind === newData.kind && item.type === newData.type && ((item as any).id ?? 0) === Id);
 	
 	if (existingIndex === -1) {
 		// If not found, push the new data
@@ -1,5 +1,10 @@
 import { RouteHandler } from "../types/route";
 import * as IoT_Types from "../types/iot";
+import { BINARY_PROTOCOL_VERSION } from "../binary_protocol";
+import { ACTUATOR_MAX_COUNT, PushActuatorCommand, PUSH_COMMAND_VERSION } from "../actuator_command";
+import { TELEMETRY_DELTA_VERSION } from "../telemetry_delta";
+import { TELEMETRY_HISTORY_VERSION } from "../telemetry_history";
+import { FEEDING_SCHEDULE_VERSION, PushFeedingSchedule } from "../feeding_schedule";
 
 const handler: RouteHandler = (client, db, session, data) =>{
 	if (typeof session.auth_data !== "undefined") {
@@ -58,12 +63,61 @@ const handler: RouteHandler = (client, db, session, data) =>{
 			db.devices.set(data.iot_hwid, new IoT_Types.DeviceData(data.iot_hwid));
 		}
 
+		db.device_sessions.set(data.iot_hwid, session);
+
+		// Older devices have one of each and don't send the counts
+		session.feeder_count = ActuatorCount(data.feeders);
+		session.pump_count = ActuatorCount(data.pumps);
+
+		const ReplyData: { [K: string]: any } = {
+			message: `Connected as IoT device with HWID: ${data.iot_hwid}`
+		};
+
+		// Devices that offer the binary protocol get a "binary" field back, older ones keep talking JSON
+		if (data.binary === BINARY_PROTOCOL_VERSION) {
+			session.binary_protocol = true;
+			ReplyData.binary = BINARY_PROTOCOL_VERSION;
+		}
+
+		// Same for command push, older devices keep polling /iot/get_data
+		if (data.push === PUSH_COMMAND_VERSION) {
+			session.push_commands = true;
+			ReplyData.push = PUSH_COMMAND_VERSION;
+
+			// Triggers set while the device was offline, sent once this reply is out
+			const hwid = data.iot_hwid;
+			setImmediate(() => PushActuatorCommand(db, hwid));
+		}
+
+		// Same for telemetry deltas, older devices keep sending every field
+		if (data.delta === TELEMETRY_DELTA_VERSION) {
+			session.telemetry_delta = true;
+			ReplyData.delta = TELEMETRY_DELTA_VERSION;
+		}
+
+		// Same for history upload, the server clock lets the device time stamp what it journals from now on
+		if (data.history === TELEMETRY_HISTORY_VERSION) {
+			session.telemetry_history = true;
+			ReplyData.history = TELEMETRY_HISTORY_VERSION;
+			ReplyData.time = Math.floor(Date.now() / 1000);
+		}
+
+		// Same for the feeding schedule, which runs on the server clock. A table the device doesn't have yet follows this reply
+		if (data.schedule === FEEDING_SCHEDULE_VERSION) {
+			session.feeding_schedule = true;
+			ReplyData.schedule = FEEDING_SCHEDULE_VERSION;
+			ReplyData.time = Math.floor(Date.now() / 1000);
+
+			const hwid = data.iot_hwid;
+			if (data.schedule_rev !== db.devices.get(hwid)?.schedule.rev) {
+				setImmediate(() => PushFeedingSchedule(db, hwid));
+			}
+		}
+
 		return {
 			status: "success",
 			code: 200,
-			data: {
-				message: `Connected as IoT device with HWID: ${data.iot_hwid}`
-			}
+			data: ReplyData
 		}
 	}
 
@@ -76,4 +130,9 @@ const handler: RouteHandler = (client, db, session, data) =>{
 	};
 }
 
+/** Actuators travel as uint32 masks, so a device has 1 to 32 of each */
+function ActuatorCount(value: any): number {
+	return Number.isInteger(value) && value >= 1 && value <= ACTUATOR_MAX_COUNT ? value : 1;
+}
+
 export default handler;
\ No newline at end of file
@@ -0,0 +1,56 @@
+import { ClientSession } from "./types/client_session";
+import { RouteHandlerReturnType } from "./types/route";
+
+/**
+ * Change-driven /iot/post_data, mirrors Hardware/include/TelemetryDelta.h
+ * Every report carries a sequence number "sq" and only the fields that changed, "kf" marks a full keyframe
+ */
+export const TELEMETRY_DELTA_VERSION = 1;
+
+/** Success code of a delta that doesn't follow the last accepted one, the device sends a keyframe with its next report */
+export const TELEMETRY_KEYFRAME_REQUEST_CODE = 205;
+
+const TELEMETRY_SEQUENCE_MASK = 0xFFFF;
+
+/**
+ * A delta is only meaningful on top of the report before it, so it has to follow the last accepted one
+ * Returns a response to send back instead of storing the report: an error, or a keyframe request for a delta out of sequence
+ */
+export function CheckTelemetrySequence(session: ClientSession, data: { [K: string]: any }): RouteHandlerReturnType {
+	if (typeof data.sq === "undefined") {
+		return undefined;
+	}
+
+	if (!session.telemetry_delta) {
+		return {
+			status: "error",
+			code: 400,
+			error_message: "Telemetry deltas must be negotiated at /login"
+		};
+	}
+
+	if (typeof data.sq !== "number" || !Number.isInteger(data.sq) || data.sq < 0 || data.sq > TELEMETRY_SEQUENCE_MASK) {
+		return {
+			status: "error",
+			code: 400,
+			error_message: "Invalid sequence number"
+		};
+	}
+
+	const IsKeyframe = data.kf === 1;
+	const Expected = typeof session.telemetry_seq === "number" ? (session.telemetry_seq + 1) & TELEMETRY_SEQUENCE_MASK : undefined;
+
+	// Dropped without the connection, a lost or reordered frame only costs the reports until the keyframe
+	if (!IsKeyframe && data.sq !== Expected) {
+		return {
+			status: "success",
+			code: TELEMETRY_KEYFRAME_REQUEST_CODE,
+			data: {
+				message: "Telemetry delta out of sequence, send a keyframe"
+			}
+		};
+	}
+
+	session.telemetry_seq = data.sq;
+	return undefined;
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+import { DeviceData, BaseDeviceData } from "./types/iot/DeviceData";
+import { DHT, FoodServo, WaterLevel, WaterPump } from "./types/iot";
+import { HistorySample } from "./history_store";
+
+/**
+ * Samples a device journaled to flash while it was offline, mirrors Hardware/include/TelemetryJournal.h
+ * /iot/post_history carries them oldest first as rows of [unix time, te, hu, wa, flags]
+ */
+export const TELEMETRY_HISTORY_VERSION = 1;
+
+const HISTORY_FLAG_PUMP = 0x01;
+const HISTORY_FLAG_FOOD = 0x02;
+
+function Reading(value: any): number | null {
+	return typeof value === "number" && Number.isFinite(value) ? value : null;
+}
+
+/**
+ * Adds a whole batch to the device history
+ * A batch sent again after its reply was lost only has rows that are stored already, those are skipped
+ */
+export function AppendHistory(device: DeviceData, rows: any[]): { stored: number, skipped: number } {
+	let stored = 0;
+	let skipped = 0;
+
+	for (const Row of rows) {
+		if (!Array.isArray(Row) || typeof Row[0] !== "number") {
+			skipped++;
+			continue;
+		}
+
+		const Flags = typeof Row[4] === "number" ? Row[4] : 0;
+		const Sample: HistorySample = {
+			timestamp: Row[0] * 1000,
+			te: Reading(Row[1]),
+			hu: Reading(Row[2]),
+			wa: Reading(Row[3]),
+			PuEn: (Flags & HISTORY_FLAG_PUMP) !== 0,
+			DiFo: (Flags & HISTORY_FLAG_FOOD) !== 0
+		};
+
+		if (device.history.Append(Sample)) {
+			stored++;
+		}
+		else {
+			skipped++;
+		}
+	}
+
+	return { stored, skipped };
+}
+
+/** Adds the live state after a /iot/post_data was merged into it, a delta only carries what changed */
+export function AppendLiveSample(device: DeviceData, timestamp: number) {
+	const Find = <T extends BaseDeviceData>(type: string) => device.live.find(item => item.type === type) as T | undefined;
+	const Dht = Find<DHT>("DHT");
+	const Level = Find<WaterLevel>("WaterLevel");
+
+	device.history.Append({
+		timestamp,
+		te: Dht ? Reading(Dht.temperature) : null,
+		hu: Dht ? Reading(Dht.humidity) : null,
+		wa: Level ? Reading(Level.waterLevel) : null,
+		PuEn: device.live.some(item => item.type === "WaterPump" && (item as WaterPump).powered_on), // Any pump
+		DiFo: device.live.some(item => item.type === "Servo" && (item as FoodServo).isDispensing) // Any feeder
+	});
+}
\ No newline at end of file
@@ -1,7 +1,11 @@
 import { DeviceData } from "./iot/DeviceData";
+import { ClientSession } from "./client_session";
 
 export type AppData = {
 	version: string;
 
 	devices: Map<string, DeviceData>;
+
+	/** Connected IoT devices by HWID, kept apart from devices so it is never serialized */
+	device_sessions: Map<string, ClientSession>;
 };
\ No newline at end of file
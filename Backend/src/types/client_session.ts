@@ -10,4 +10,29 @@ export type ClientSession = {
 		
 		iot_hwid?: string;
 	}
+
+	/** The device offered the binary protocol at /login, its /iot/post_data and /iot/get_data may come as binary frames */
+	binary_protocol?: boolean;
+
+	/** The device offered command push at /login, triggers are sent to it as soon as they are set */
+	push_commands?: boolean;
+
+	/** The device offered telemetry deltas at /login, its /iot/post_data may only carry the fields that changed */
+	telemetry_delta?: boolean;
+
+	/** The device offered history upload at /login, it sends samples journaled while offline to /iot/post_history */
+	telemetry_history?: boolean;
+
+	/** The device offered the feeding schedule at /login, a changed table is pushed to it on /iot/push_schedule */
+	feeding_schedule?: boolean;
+
+	/** Feeders and pumps the device announced at /login, the bits of DiFo and PuEn by ID. 1 each if it didn't */
+	feeder_count?: number;
+	pump_count?: number;
+
+	/** Sequence number of the last accepted /iot/post_data delta */
+	telemetry_seq?: number;
+
+	/** Last replies by request ID, a retransmitted request is answered from here instead of running its route twice */
+	reply_cache?: Map<number, Buffer | string>;
 };
\ No newline at end of file
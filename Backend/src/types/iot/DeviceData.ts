@@ -1,27 +1,34 @@
+import { HistoryStore } from "../../history_store";
+import { DeviceMetrics } from "../../device_metrics";
+import { FeedingSchedule } from "../../feeding_schedule";
+
 export class DeviceData {
 	hwid: string;
 	name: string;
 	online: boolean;
 	last_seen: number;
 
-	history: TimeBasedData[];
+	/** Live reports and samples journaled offline, queried by range through /client/get_history */
+	history: HistoryStore;
 	live: BaseDeviceData[];
 
+	/** Latest /iot/metrics report, undefined until the device sends one */
+	metrics?: DeviceMetrics;
+
+	/** Run by the device on its own, set through /client/set_schedule */
+	schedule: FeedingSchedule;
+
 	constructor(hwid: string, name?: string) {
 		this.hwid = hwid;
 		this.name = name || hwid;
 		this.online = true;
 		this.last_seen = Date.now();
-		this.history = [];
+		this.history = new HistoryStore();
 		this.live = [];
+		this.schedule = { rev: 0, tz: 0, entries: [] };
 	}
 }
 
-export type TimeBasedData = {
-	timestamp: number;
-	data: BaseDeviceData[];
-}
-
 export type BaseDeviceData = {
 	kind: "actuator" | "sensor";
 	type: string;
@@ -5,9 +5,13 @@ export class FoodServo implements BaseActuatorData {
 	type: "Servo" = "Servo";
 	isDispensing: boolean;
 
+	/** Position in FEEDER_PINS of the device */
+	id: number;
+
 	triggerDispenseFood: boolean = false;
 
-	constructor(isDispensing?: boolean) {
+	constructor(isDispensing?: boolean, id?: number) {
 		this.isDispensing = isDispensing || false;
+		this.id = id || 0;
 	}
 }
\ No newline at end of file
@@ -5,10 +5,14 @@ export class WaterPump implements BaseActuatorData {
 	type: "WaterPump" = "WaterPump";
 	powered_on: boolean;
 
+	/** Position in WATER_PUMP_PINS of the device */
+	id: number;
+
 	/** Whether the water pump should be enabled by remote trigger */
 	triggerEnableWaterPump: boolean = false;
 
-	constructor(powered_on?: boolean) {
+	constructor(powered_on?: boolean, id?: number) {
 		this.powered_on = powered_on || false;
+		this.id = id || 0;
 	}
 }
\ No newline at end of file
@@ -0,0 +1,263 @@
+import { test } from "node:test";
+import assert from "node:assert/strict";
+import { HistoryStore, HistorySample, HISTORY_CHUNK_SIZE, HISTORY_MAX_CHUNKS, HISTORY_MAX_POINTS } from "../src/history_store";
+
+const MINUTE = 60 * 1000;
+const HOUR = 60 * MINUTE;
+
+/** Some hour in the past, on a whole hour so minute and hour buckets start with it */
+const START = 1760000000 * 1000 - (1760000000 * 1000) % HOUR;
+
+/** A sample whose readings can be told apart by its index */
+function Sample(index: number, timestamp: number = START + index * 1000): HistorySample {
+	return {
+		timestamp,
+		te: 20 + (index % 100) / 4,
+		hu: 50 + (index % 40),
+		wa: index % 101,
+		PuEn: index % 3 === 0,
+		DiFo: index % 7 === 0
+	};
+}
+
+/** Every raw sample in the store, oldest first */
+function AllRaw(store: HistoryStore) {
+	return store.Query(0, Number.MAX_SAFE_INTEGER, "raw");
+}
+
+test("in-order appends fill chunks and start new ones", () => {
+	const Store = new HistoryStore();
+	const Count = HISTORY_CHUNK_SIZE * 3 + 5;
+
+	for (let i = 0; i < Count; i++) {
+		assert.equal(Store.Append(Sample(i)), true);
+	}
+
+	assert.equal(Store.size, Count);
+	assert.deepEqual(Store.toJSON(), { samples: Count, first: START, last: START + (Count - 1) * 1000 });
+});
+
+test("a raw range across chunk boundaries has every sample in it once, bounds included", () => {
+	const Store = new HistoryStore();
+	for (let i = 0; i < HISTORY_CHUNK_SIZE * 3; i++) {
+		Store.Append(Sample(i));
+	}
+
+	// Three samples on either side of the first boundary, then a range covering a whole chunk and part of two others
+	const Ranges = [[HISTORY_CHUNK_SIZE - 3, HISTORY_CHUNK_SIZE + 2], [HISTORY_CHUNK_SIZE - 10, HISTORY_CHUNK_SIZE * 2 + 10]];
+	for (const [First, Last] of Ranges) {
+		const Range = Store.Query(START + First * 1000, START + Last * 1000, "raw");
+
+		assert.equal(Range.resolution, "raw");
+		assert.equal(Range.truncated, false);
+		assert.equal(Range.t.length, Last - First + 1);
+
+		for (let i = 0; i < Range.t.length; i++) {
+			const Expected = Sample(First + i);
+			assert.equal(Range.t[i], Expected.timestamp);
+			assert.equal(Range.te[i], Expected.te);
+			assert.equal(Range.hu[i], Expected.hu);
+			assert.equal(Range.wa[i], Expected.wa);
+			assert.equal(Range.PuEn[i], Expected.PuEn ? 1 : 0);
+			assert.equal(Range.DiFo[i], Expected.DiFo ? 1 : 0);
+		}
+	}
+
+	// Between two samples and before the first one
+	assert.equal(Store.Query(START + 1500, START + 1600, "raw").t.length, 0);
+	assert.equal(Store.Query(0, START - 1, "raw").t.length, 0);
+});
+
+test("out-of-order appends, e.g. a journal uploaded after live reports, come back sorted", () => {
+	const Store = new HistoryStore();
+	const Count = HISTORY_CHUNK_SIZE * 2 + 100;
+
+	// Live reports every other second first, then the journal fills the gaps in reverse, splitting full chunks
+	for (let i = 0; i < Count; i += 2) {
+		Store.Append(Sample(i));
+	}
+
+	for (let i = Count - 1; i > 0; i -= 2) {
+		assert.equal(Store.Append(Sample(i)), true);
+	}
+
+	const Range = AllRaw(Store);
+	assert.equal(Store.size, Count);
+	assert.equal(Range.t.length, HISTORY_MAX_POINTS);
+	assert.equal(Range.truncated, true);
+
+	for (let i = 0; i < Range.t.length; i++) {
+		assert.equal(Range.t[i], Sample(i).timestamp);
+		assert.equal(Range.te[i], Sample(i).te);
+	}
+
+	// The rest after the cut
+	const Rest = Store.Query(START + HISTORY_MAX_POINTS * 1000, START + Count * 1000, "raw");
+	assert.equal(Rest.t.length, Count - HISTORY_MAX_POINTS);
+	assert.equal(Rest.t[0], Sample(HISTORY_MAX_POINTS).timestamp);
+});
+
+test("a sample into a full chunk splits it, on either side of the middle", () => {
+	const Half = HISTORY_CHUNK_SIZE >>> 1;
+
+	for (const Position of [0, Half - 1, Half, Half + 1, HISTORY_CHUNK_SIZE - 1]) {
+		const Store = new HistoryStore();
+
+		// One full chunk every other second, then one in a gap
+		for (let i = 0; i < HISTORY_CHUNK_SIZE; i++) {
+			Store.Append(Sample(2 * i));
+		}
+
+		assert.equal(Store.Append(Sample(2 * Position + 1)), true);
+		assert.equal(Store.Append(Sample(2 * HISTORY_CHUNK_SIZE)), true);
+
+		const Range = Store.Query(START, START + 2 * HISTORY_CHUNK_SIZE * 1000, "raw");
+		const Expected = [...Array.from({ length: HISTORY_CHUNK_SIZE + 1 }, (_, i) => 2 * i), 2 * Position + 1].sort((a, b) => a - b);
+
+		assert.equal(Store.size, HISTORY_CHUNK_SIZE + 2);
+		assert.deepEqual(Range.t, Expected.map(Index => Sample(Index).timestamp));
+		assert.deepEqual(Range.wa, Expected.map(Index => Sample(Index).wa));
+	}
+});
+
+test("a timestamp stored already is skipped, whichever chunk holds it", () => {
+	const Store = new HistoryStore();
+	for (let i = 0; i < HISTORY_CHUNK_SIZE * 2; i++) {
+		Store.Append(Sample(i));
+	}
+
+	// A batch sent again after its reply was lost, the readings of the first one stay
+	for (const Index of [0, HISTORY_CHUNK_SIZE - 1, HISTORY_CHUNK_SIZE, HISTORY_CHUNK_SIZE * 2 - 1]) {
+		assert.equal(Store.Append({ ...Sample(Index), te: -40 }), false);
+	}
+
+	assert.equal(Store.duplicates, 4);
+	assert.equal(Store.size, HISTORY_CHUNK_SIZE * 2);
+
+	const Range = Store.Query(START + (HISTORY_CHUNK_SIZE - 1) * 1000, START + HISTORY_CHUNK_SIZE * 1000, "raw");
+	assert.deepEqual(Range.te, [Sample(HISTORY_CHUNK_SIZE - 1).te, Sample(HISTORY_CHUNK_SIZE).te]);
+
+	// Duplicates aren't counted twice in the tiers either
+	const Minute = Store.Query(START, START, "1m");
+	assert.equal(Minute.n![0], 60);
+});
+
+test("minute buckets hold mean, min, max and the share of samples with an actuator on", () => {
+	const Store = new HistoryStore();
+	const Readings = [
+		{ te: 20, hu: 40, wa: 10, PuEn: true, DiFo: false },
+		{ te: 22, hu: null, wa: 20, PuEn: true, DiFo: false },
+		{ te: null, hu: 60, wa: 30, PuEn: false, DiFo: true },
+		{ te: 27, hu: 50, wa: 40, PuEn: false, DiFo: false }
+	];
+
+	// Out of order on purpose, the first one on the bucket start and the last one on its end
+	const Offsets = [0, 30 * 1000, 15 * 1000, MINUTE - 1];
+	for (const i of [3, 1, 0, 2]) {
+		Store.Append({ timestamp: START + Offsets[i], ...Readings[i] });
+	}
+
+	// The next minute starts a bucket of its own
+	Store.Append({ timestamp: START + MINUTE, te: 30, hu: 30, wa: 50, PuEn: false, DiFo: false });
+
+	const Range = Store.Query(START, START + MINUTE, "1m");
+	assert.equal(Range.resolution, "1m");
+	assert.deepEqual(Range.t, [START, START + MINUTE]);
+	assert.deepEqual(Range.n, [4, 1]);
+	assert.deepEqual(Range.te, [23, 30]);
+	assert.deepEqual(Range.te_min, [20, 30]);
+	assert.deepEqual(Range.te_max, [27, 30]);
+	assert.deepEqual(Range.hu, [50, 30]);
+	assert.deepEqual(Range.wa, [25, 50]);
+	assert.deepEqual(Range.wa_min, [10, 50]);
+	assert.deepEqual(Range.wa_max, [40, 50]);
+	assert.deepEqual(Range.PuEn, [0.5, 0]);
+	assert.deepEqual(Range.DiFo, [0.25, 0]);
+
+	// A bucket without a single reading of a field has null for it
+	Store.Append({ timestamp: START + 2 * MINUTE, te: null, hu: null, wa: null, PuEn: false, DiFo: false });
+	const Empty = Store.Query(START + 2 * MINUTE, START + 2 * MINUTE, "1m");
+	assert.deepEqual([Empty.te, Empty.te_min, Empty.te_max, Empty.n], [[null], [null], [null], [1]]);
+});
+
+test("hour buckets roll up every sample of their hour, and agree with the minute buckets", () => {
+	const Store = new HistoryStore();
+
+	// One sample every 10 s for three hours, 360 an hour
+	for (let i = 0; i < 3 * 360; i++) {
+		Store.Append(Sample(i, START + i * 10 * 1000));
+	}
+
+	const Hours = Store.Query(START, START + 3 * HOUR - 1, "1h");
+	assert.equal(Hours.resolution, "1h");
+	assert.deepEqual(Hours.t, [START, START + HOUR, START + 2 * HOUR]);
+	assert.deepEqual(Hours.n, [360, 360, 360]);
+
+	for (let Hour = 0; Hour < 3; Hour++) {
+		const Samples = Array.from({ length: 360 }, (_, i) => Sample(Hour * 360 + i));
+		const Mean = Samples.reduce((Total, Item) => Total + Item.wa!, 0) / Samples.length;
+
+		assert.equal(Hours.wa[Hour], Math.round(Mean * 100) / 100);
+		assert.equal(Hours.wa_min![Hour], Math.min(...Samples.map(Item => Item.wa!)));
+		assert.equal(Hours.wa_max![Hour], Math.max(...Samples.map(Item => Item.wa!)));
+		assert.equal(Hours.PuEn[Hour], Samples.filter(Item => Item.PuEn).length / 360);
+
+		// Sixty minutes of six samples each
+		const Minutes = Store.Query(START + Hour * HOUR, START + (Hour + 1) * HOUR - 1, "1m");
+		assert.equal(Minutes.t.length, 60);
+		assert.equal(Minutes.n!.reduce((Total, Count) => Total + Count, 0), 360);
+	}
+});
+
+test("a tier only keeps its capacity of buckets, a sample older than the bucket in its slot only goes into the raw samples", () => {
+	const Store = new HistoryStore();
+	const Week = 7 * 24 * HOUR;
+
+	// A week of minutes later the same slot holds the new bucket
+	Store.Append(Sample(0, START));
+	Store.Append(Sample(1, START + Week));
+	Store.Append(Sample(2, START + 30 * 1000));
+
+	const Minutes = Store.Query(START, START + Week, "1m");
+	assert.deepEqual(Minutes.t, [START + Week]);
+	assert.deepEqual(Minutes.n, [1]);
+
+	// Hours go back further
+	assert.deepEqual(Store.Query(START, START + Week, "1h").n, [2, 1]);
+	assert.equal(Store.Query(START, START + Week, "raw").t.length, 3);
+});
+
+test("without a resolution the finest one that fits HISTORY_MAX_POINTS is picked", () => {
+	const Store = new HistoryStore();
+
+	// One sample a second for a bit over two hours
+	const Count = 2 * 3600 + 600;
+	for (let i = 0; i < Count; i++) {
+		Store.Append(Sample(i));
+	}
+
+	assert.equal(Store.Query(START, START + (HISTORY_MAX_POINTS - 1) * 1000).resolution, "raw");
+	assert.equal(Store.Query(START, START + HISTORY_MAX_POINTS * 1000).resolution, "1m");
+
+	// More minutes than points only fits hours
+	const Long = Store.Query(START, START + (HISTORY_MAX_POINTS + 1) * MINUTE);
+	assert.equal(Long.resolution, "1h");
+	assert.deepEqual(Long.n, [3600, 3600, 600]);
+});
+
+test("once the store is full the oldest chunk goes, and nothing older than what is left is taken", () => {
+	const Store = new HistoryStore();
+	const Count = HISTORY_CHUNK_SIZE * (HISTORY_MAX_CHUNKS + 1);
+
+	for (let i = 0; i < Count; i++) {
+		Store.Append(Sample(i));
+	}
+
+	assert.equal(Store.size, HISTORY_CHUNK_SIZE * HISTORY_MAX_CHUNKS);
+	assert.equal(Store.evicted, HISTORY_CHUNK_SIZE);
+	assert.equal(Store.toJSON().first, Sample(HISTORY_CHUNK_SIZE).timestamp);
+
+	assert.equal(Store.Append(Sample(0)), false);
+	assert.equal(Store.evicted, HISTORY_CHUNK_SIZE + 1);
+	assert.equal(Store.Query(START, START + (HISTORY_CHUNK_SIZE - 1) * 1000, "raw").t.length, 0);
+});
\ No newline at end of file
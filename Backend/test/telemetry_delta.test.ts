@@ -0,0 +1,59 @@
+import { test } from "node:test";
+import assert from "node:assert/strict";
+import { ClientSession } from "../src/types/client_session";
+import { CheckTelemetrySequence, TELEMETRY_KEYFRAME_REQUEST_CODE } from "../src/telemetry_delta";
+
+/** Only what CheckTelemetrySequence() looks at */
+function Session(isNegotiated: boolean = true): ClientSession {
+	return { telemetry_delta: isNegotiated } as ClientSession;
+}
+
+test("full reports and keyframes are taken, deltas have to follow them", () => {
+	const Client = Session();
+
+	assert.equal(CheckTelemetrySequence(Client, { te: 21 }), undefined);
+	assert.equal(Client.telemetry_seq, undefined);
+
+	// Nothing to build on before the first keyframe
+	assert.equal(CheckTelemetrySequence(Client, { sq: 4, te: 21 })?.code, TELEMETRY_KEYFRAME_REQUEST_CODE);
+
+	assert.equal(CheckTelemetrySequence(Client, { sq: 5, kf: 1, te: 21 }), undefined);
+	assert.equal(CheckTelemetrySequence(Client, { sq: 6, te: 22 }), undefined);
+	assert.equal(Client.telemetry_seq, 6);
+});
+
+test("a gap asks for a keyframe without an error, and the keyframe resyncs", () => {
+	const Client = Session();
+	CheckTelemetrySequence(Client, { sq: 10, kf: 1 });
+
+	// 11 was lost, 12 and 13 were already on the way
+	for (const Sequence of [12, 13]) {
+		const Reply = CheckTelemetrySequence(Client, { sq: Sequence, wa: 40 });
+		assert.equal(Reply?.status, "success");
+		assert.equal(Reply?.code, TELEMETRY_KEYFRAME_REQUEST_CODE);
+		assert.equal(Client.telemetry_seq, 10);
+	}
+
+	// Reordered, 11 turning up late doesn't count either once it is out of turn
+	assert.equal(CheckTelemetrySequence(Client, { sq: 14, kf: 1 }), undefined);
+	assert.equal(CheckTelemetrySequence(Client, { sq: 11 })?.code, TELEMETRY_KEYFRAME_REQUEST_CODE);
+	assert.equal(CheckTelemetrySequence(Client, { sq: 15 }), undefined);
+});
+
+test("the sequence wraps at 16 bits", () => {
+	const Client = Session();
+	CheckTelemetrySequence(Client, { sq: 0xFFFF, kf: 1 });
+
+	assert.equal(CheckTelemetrySequence(Client, { sq: 0 }), undefined);
+	assert.equal(Client.telemetry_seq, 0);
+});
+
+test("deltas that weren't negotiated or carry a bad sequence are errors", () => {
+	assert.equal(CheckTelemetrySequence(Session(false), { sq: 1, kf: 1 })?.code, 400);
+
+	for (const Sequence of [-1, 0x10000, 1.5, "1"]) {
+		const Reply = CheckTelemetrySequence(Session(), { sq: Sequence, kf: 1 });
+		assert.equal(Reply?.status, "error");
+		assert.equal(Reply?.code, 400);
+	}
+});
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#include <hal/gpio_types.h>
+#include <sys/types.h>
+#include <stdint.h>
+#include "config.h"
+
+static_assert(ACTUATOR_MAX_COUNT >= 1 && ACTUATOR_MAX_COUNT <= 32, "ACTUATOR_MAX_COUNT must fit a uint32 bitmask");
+
+// Food servos by feeder ID, one array per field so the control loop walks each of them in one pass
+struct FeederTable {
+	uint8_t count;
+	uint8_t pins[ACTUATOR_MAX_COUNT];
+	int16_t degrees[ACTUATOR_MAX_COUNT]; // Target angle
+	int16_t positions[ACTUATOR_MAX_COUNT]; // Angle the servo is driven to now, ramped towards degrees at SERVO_VELOCITY
+	uint16_t pulses[ACTUATOR_MAX_COUNT]; // Microseconds, what the servo backend drives
+	ulong openTimes[ACTUATOR_MAX_COUNT]; // millis() when opened, 0 while closed
+	ulong openTimeouts[ACTUATOR_MAX_COUNT];
+	ulong openDurations[ACTUATOR_MAX_COUNT]; // Of the current or next opening, a scheduled portion or else the timeout
+	uint32_t openMask; // Bit per feeder ID, set while its target is past the middle of SERVO_CLOSE_ANGLE and SERVO_OPEN_ANGLE
+	uint32_t movingMask; // Bit per feeder ID, set while its position hasn't reached the target
+};
+
+// Water pumps by pump ID, each behind an active-low relay
+struct PumpTable {
+	uint8_t count;
+	uint8_t pins[ACTUATOR_MAX_COUNT];
+	ulong enableTimes[ACTUATOR_MAX_COUNT]; // millis() when enabled, 0 while off
+	ulong enableTimeouts[ACTUATOR_MAX_COUNT];
+	uint32_t enabledMask; // Bit per pump ID, what was last written to the relays
+};
+
+class ActuatorRegistry {
+	public:
+		ActuatorRegistry();
+
+		// Both return the new ID, -1 if ACTUATOR_MAX_COUNT are registered already
+		int addFeeder(gpio_num_t pin, ulong openTimeout);
+		int addPump(gpio_num_t pin, ulong enableTimeout); // Sets up the pin with the relay off
+
+		FeederTable feeders;
+		PumpTable pumps;
+};
\ No newline at end of file
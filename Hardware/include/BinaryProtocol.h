@@ -0,0 +1,78 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+#include "TaskMessages.h"
+#include "TelemetryDelta.h"
+#include "TelemetryJournal.h"
+
+// Fixed-layout frames for /iot/post_data and /iot/get_data, offered at /login and mirrored in Backend/src/binary_protocol.ts
+// Multi-byte fields are little-endian. JSON frames always start with '{', so the magic byte tells both apart
+
+#define BINARY_PROTOCOL_MAGIC 0xB1
+#define BINARY_PROTOCOL_VERSION 3
+
+// Request: magic, type, uint16 request ID, payload. The ID is left 0 by the encoders and stamped by WiFiNetwork::commitRequest()
+#define BINARY_REQUEST_HEADER_SIZE 4
+#define BINARY_REQUEST_ID_OFFSET 2
+#define BINARY_READINGS_SIZE 6 // int16 centi-degrees, int16 centi-percent, int16 water level
+#define BINARY_POST_DATA_PAYLOAD_SIZE (BINARY_READINGS_SIZE + 8) // Readings, uint32 mask of pumps on, uint32 mask of feeders open
+#define BINARY_POST_DATA_FRAME_SIZE (BINARY_REQUEST_HEADER_SIZE + BINARY_POST_DATA_PAYLOAD_SIZE)
+#define BINARY_GET_DATA_FRAME_SIZE BINARY_REQUEST_HEADER_SIZE
+
+// Delta request: header, uint16 sequence, uint8 TELEMETRY_FIELD_* mask, then only the fields in the mask in the POST_DATA order
+// Temperature, humidity and water level are int16 like above, TELEMETRY_FIELD_PUMP and TELEMETRY_FIELD_FOOD are a uint32 mask each
+#define BINARY_POST_DELTA_HEADER_SIZE (BINARY_REQUEST_HEADER_SIZE + 3)
+#define BINARY_POST_DELTA_MAX_FRAME_SIZE (BINARY_POST_DELTA_HEADER_SIZE + BINARY_POST_DATA_PAYLOAD_SIZE)
+#define BINARY_DELTA_KEYFRAME 0x80 // Set in the mask of a keyframe
+
+// History request: header, uint8 sample count, then per sample uint32 unix seconds, the readings and uint8 flags
+#define BINARY_POST_HISTORY_HEADER_SIZE (BINARY_REQUEST_HEADER_SIZE + 1)
+#define BINARY_HISTORY_SAMPLE_SIZE (4 + BINARY_READINGS_SIZE + 1)
+#define BINARY_POST_HISTORY_MAX_SAMPLES ((WS_TX_FRAME_SIZE - BINARY_POST_HISTORY_HEADER_SIZE) / BINARY_HISTORY_SAMPLE_SIZE)
+
+// Reply: magic, type, uint16 request ID, uint16 code, uint8 payload length, payload. Error replies carry the error message as payload
+// Pushed commands have request ID 0, they and /iot/get_data replies carry a uint32 mask of pumps to enable and one of feeders to dispense from
+#define BINARY_REPLY_HEADER_SIZE 7
+#define BINARY_REPLY_MAX_PAYLOAD 255
+#define BINARY_ACTUATOR_COMMAND_SIZE 8
+
+#define BINARY_NULL_VALUE INT16_MIN // Sent for a non-finite reading, the backend stores null like the JSON path
+
+#define BINARY_FLAG_PUMP 0x01 // History: any water pump on
+#define BINARY_FLAG_FOOD 0x02 // History: any food dispenser open
+
+enum BinaryMessageType : uint8_t {
+	BINARY_POST_DATA = 0x01,
+	BINARY_GET_DATA = 0x02,
+	BINARY_PUSH_COMMAND = 0x03, // Reply-shaped, sent by the server unasked with the same payload as BINARY_GET_DATA
+	BINARY_POST_DELTA = 0x04, // Answered like BINARY_POST_DATA
+	BINARY_POST_HISTORY = 0x05 // Answered like BINARY_POST_DATA
+};
+
+static_assert(BINARY_POST_DATA_FRAME_SIZE <= WS_TX_FRAME_SIZE, "WS_TX_FRAME_SIZE is too small for a binary frame");
+static_assert(BINARY_POST_DELTA_MAX_FRAME_SIZE <= WS_TX_FRAME_SIZE, "WS_TX_FRAME_SIZE is too small for a binary delta frame");
+static_assert(BINARY_POST_HISTORY_MAX_SAMPLES >= 1 && BINARY_POST_HISTORY_MAX_SAMPLES <= 255, "WS_TX_FRAME_SIZE doesn't fit a binary history frame");
+static_assert((TELEMETRY_FIELD_ALL & BINARY_DELTA_KEYFRAME) == 0, "BINARY_DELTA_KEYFRAME overlaps a telemetry field");
+
+struct BinaryReply {
+	uint8_t type;
+	uint16_t requestId;
+	uint16_t code;
+	uint8_t length;
+	const uint8_t* payload;
+};
+
+// All return the frame length, 0 if capacity is too small
+size_t BinaryProtocol_encodeTelemetry(const TelemetrySample& sample, uint8_t* buffer, size_t capacity);
+size_t BinaryProtocol_encodeTelemetryDelta(const TelemetrySample& sample, uint8_t fields, uint16_t sequence, bool keyframe, uint8_t* buffer, size_t capacity);
+size_t BinaryProtocol_encodeGetData(uint8_t* buffer, size_t capacity);
+
+// As many of the samples as fit, encoded is set to how many
+size_t BinaryProtocol_encodeHistory(const JournalSample* samples, size_t count, size_t& encoded, uint8_t* buffer, size_t capacity);
+
+// Splits a reply header, false if it isn't a binary reply
+bool BinaryProtocol_decodeReplyHeader(const uint8_t* header, BinaryReply& reply);
+
+// False if the payload is too short to be a /iot/get_data reply or a pushed command
+bool BinaryProtocol_decodeActuatorCommand(const BinaryReply& reply, ActuatorCommand& command);
\ No newline at end of file
@@ -1,57 +1,101 @@
 #pragma once
-#include "TickTimer.h"
+#include <sys/types.h>
 #include "config.h"
-#include "ServoManager.h"
+#include "ActuatorRegistry.h"
+#include "SPSCQueue.h"
+#include "TaskMessages.h"
 
 #if ENABLE_WIFI == true
 	#include "WiFiNetwork.h"
 #endif
 
+#if ENABLE_FEEDING_SCHEDULE == true
+	#include "FeedingSchedule.h"
+#endif
+
+#if ENABLE_WATER_LEVEL_SENSOR == true && WATER_PUMP_CLOSED_LOOP == true
+	#include "PumpController.h"
+#endif
+
 class BusinessLogic {
 	public:
 		BusinessLogic();
 		void setup();
-		bool should_loop_tick();
-		void pre_sensor_read_loop();
-		void pre_actuator_loop();
-		void pre_hardware_report_loop();
+		void pre_actuator_loop(); // Run by the scheduler every 0.1 second
 
 		float temperature; // \*C
 		float humidity; // %
 		int waterLevel; // 0 - 100
-		bool waterPumpEnabled;
+		float filteredWaterLevel; // waterLevel before rounding, what the pump controller fits the fill rate to
+		bool isWaterFull; // waterLevel reached WATER_LEVEL_FULL_PERCENT and hasn't dropped WATER_LEVEL_FULL_HYSTERESIS below since
 
-		bool shouldEnableWaterPump;
-		bool shouldDispenseFood;
+		// Feeders and pumps driven by pre_actuator_loop(), by ID
+		void setActuatorRegistry(ActuatorRegistry* actuators);
 
-		#if ENABLE_WIFI == true
-			bool isWaitingForServerActuatorData;
-			bool isWaitingForServerReportACK;
+		// Network side only, applied by pre_actuator_loop(). Returns false if the queue is full
+		bool postActuatorCommand(const ActuatorCommand& command);
+
+		#if ENABLE_FEEDING_SCHEDULE == true
+			// Network side only, taken over by pre_actuator_loop(). Return false if the queue is full
+			bool postFeedingSchedule(const FeedingScheduleTable& table);
+			bool postScheduleClock(uint32_t unixTime);
 
-			// True if the WebSocket should push, false if it should pull
+			FeedingSchedule& getFeedingSchedule(); // Control side only
+		#endif
+
+		#if ENABLE_WATER_LEVEL_SENSOR == true && WATER_PUMP_CLOSED_LOOP == true
+			PumpController& getPumpController(); // Control side only
+		#endif
+
+		#if ENABLE_WIFI == true
+			// True if pushing goes first when the request window only has room for one of push and pull
 			bool shouldPushOrPull;
 			void setWiFiNetworkInstance(WiFiNetwork* wifiNetwork);
-		#endif
 
-		#if ENABLE_SERVO == true
-			void setServoManagerInstance(ServoManager* pServoManager);
+			// Push and pull as far as the request window allows, run by the scheduler every getInteractionIntervalMicros()
+			void interaction_loop();
+			ulong getInteractionIntervalMicros();
 		#endif
 
 	private:
 		void handleWaterPumpLogic();
 		void handleServoLogic();
+		void publishTelemetry();
+
+		#if ENABLE_FEEDING_SCHEDULE == true
+			void pollFeedingSchedule();
+		#endif
 
-		ulong waterPumpEnableTime;
-		ulong servoOpenTime;
+		// Each has a single producer and a single consumer, so the network can run in its own task
+		SPSCQueue<ActuatorCommand, TASK_QUEUE_SIZE> commandQueue;
+		SPSCQueue<TelemetrySample, TASK_QUEUE_SIZE> telemetryQueue;
+
+		#if ENABLE_FEEDING_SCHEDULE == true
+			SPSCQueue<FeedingScheduleTable, 2> scheduleQueue; // Whole tables, only the newest one is loaded
+			SPSCQueue<ScheduleClock, 2> clockQueue;
+			FeedingSchedule feedingSchedule;
+		#endif
+
+		#if ENABLE_WATER_LEVEL_SENSOR == true && WATER_PUMP_CLOSED_LOOP == true
+			PumpController pumpController;
+		#endif
+
+		ActuatorRegistry* actuators;
+
+		// Bit per actuator ID, requested by commands until the actuator logic consumes them
+		uint32_t pumpRequestMask;
+		uint32_t feederRequestMask;
 
-		TickTimer businessLogicTimer;
 		#if ENABLE_WIFI == true
+			TelemetrySample reportedTelemetry; // Latest sample taken off telemetryQueue
+			TelemetrySample serverTelemetry; // What the server holds, deltas are taken against it
+			uint16_t reportSequence;
+			ulong lastKeyframeTime;
+			uint32_t keyframeLoginCount; // WiFiNetwork::getLoginCount() at the last keyframe
+			uint32_t keyframeRequestCount; // WiFiNetwork::getKeyframeRequestCount() at the last keyframe
+			ulong lastJournalTime; // Last sample journaled or reported live
 			WiFiNetwork* wifiNetwork;
+			void RequestActuatorData();
 			void ReportData();
-			TickTimer wsInteractionTimer;
-		#endif
-
-		#if ENABLE_SERVO == true
-			ServoManager* pServoManager;
 		#endif
 };
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// The 40-bit DHT11 frame as seen by an edge interrupt: timestamps of every level change on the data line
+// After the start signal the sensor answers with 80 us low and 80 us high, then each bit is 50 us low followed by 26-28 us high for 0 or 70 us high for 1
+
+#define DHT_FRAME_BITS 40
+#define DHT_FRAME_MAX_EDGES 96 // Release of the start signal, response, 40 bits and end, with room to spare
+#define DHT_FRAME_BIT_THRESHOLD 48 // us, longer highs are a 1
+#define DHT_FRAME_MIN_HIGH 10 // us, anything shorter or longer is a glitch
+#define DHT_FRAME_MAX_HIGH 100
+
+#define DHT_START_SIGNAL_MICROS 20000 // Low time that wakes the sensor up, at least 18 ms
+#define DHT_CAPTURE_MICROS 8000 // The whole answer takes at most 5.4 ms after the release
+
+enum DHTFrameStatus : uint8_t {
+	DHT_FRAME_OK,
+	DHT_FRAME_TOO_FEW_EDGES, // The sensor didn't answer or edges were missed
+	DHT_FRAME_BAD_PULSE,
+	DHT_FRAME_BAD_CHECKSUM
+};
+
+struct DHTReading {
+	float temperature; // \*C
+	float humidity; // %
+};
+
+// Decodes the last 81 edges, the ones before may be the start signal and the response in any shape
+// The frame ends with the rising edge of the sensor letting go of the line
+DHTFrameStatus DHTFrame_decode(const uint32_t* edges, size_t count, DHTReading& reading);
\ No newline at end of file
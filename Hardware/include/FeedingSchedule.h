@@ -0,0 +1,100 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "config.h"
+
+// Feeds at set minutes of the week without the server, e.g. while WiFi is down
+// The entries are expanded into one slot per weekday, sorted by minute of the week, so the next feed is a binary search away
+// Between feeds poll() only compares the time against the cached next one
+
+#define FEEDING_SCHEDULE_VERSION 1 // Offered at /login as "schedule", mirrored in Backend/src/feeding_schedule.ts
+
+#define SCHEDULE_MINUTES_PER_DAY 1440
+#define SCHEDULE_MINUTES_PER_WEEK (7 * SCHEDULE_MINUTES_PER_DAY)
+#define SCHEDULE_EVERY_DAY 0x7F
+#define SCHEDULE_ENTRY_HEX_SIZE 12 // Characters of one entry in the "e" field of /iot/push_schedule
+#define SCHEDULE_MAX_SLOTS (SCHEDULE_MAX_ENTRIES * 7)
+#define SCHEDULE_SECTOR_SIZE 4096
+#define SCHEDULE_SECTOR_OFFSET (JOURNAL_SECTOR_COUNT * SCHEDULE_SECTOR_SIZE) // Two sectors right after the journal ring, written in turn
+#define SCHEDULE_FORMAT_VERSION 1 // Stored with the table, a different layout starts without one
+
+static_assert(SCHEDULE_MAX_ENTRIES >= 1 && SCHEDULE_MAX_ENTRIES <= 255, "FeedingScheduleTable keeps the entry count in a byte");
+
+struct ScheduleEntry {
+	uint16_t minute; // Local minute of the day, 0 - 1439
+	uint8_t weekdays; // Bit per day, bit 0 is Sunday
+	uint8_t feeder; // Feeder ID
+	uint16_t openMillis; // Portion, how long the feeder stays open
+};
+
+// Whole-table update from the server, also what is kept in flash
+struct FeedingScheduleTable {
+	uint32_t revision; // Set by the server, offered at /login so an unchanged table isn't sent again
+	int16_t utcOffset; // Minutes, local time is what the entries are in
+	uint8_t entryCount;
+	uint8_t reserved;
+	ScheduleEntry entries[SCHEDULE_MAX_ENTRIES];
+};
+
+struct ScheduleSlot {
+	uint16_t weekMinute; // Local minute of the week, 0 is Sunday midnight
+	uint16_t entry; // Index into the entries
+};
+
+// Orders the entries by minute of the day, then by feeder. Insertion sort, the table arrives mostly sorted
+void FeedingSchedule_sort(ScheduleEntry* entries, size_t count);
+
+// One slot per weekday of every entry, sorted by weekMinute if the entries are. Returns the slot count, at most capacity
+size_t FeedingSchedule_expand(const ScheduleEntry* entries, size_t count, ScheduleSlot* slots, size_t capacity);
+
+// Index of the first slot after weekMinute, wrapping around to the next week. count if there are no slots
+size_t FeedingSchedule_findNext(const ScheduleSlot* slots, size_t count, uint16_t weekMinute);
+
+// Local minute of the week at a unix time
+uint16_t FeedingSchedule_weekMinute(uint32_t unixTime, int16_t utcOffset);
+
+// Entries from 12 hex characters each: minute, weekdays, feeder and openMillis, little endian. -1 if malformed or too many
+int FeedingSchedule_decodeEntries(const char* hex, ScheduleEntry* entries, size_t capacity);
+
+// Newest table kept in flash, false if there is none
+bool FeedingSchedule_loadTable(FeedingScheduleTable& table);
+bool FeedingSchedule_saveTable(const FeedingScheduleTable& table); // Erases the older of the two sectors, takes tens of milliseconds
+
+// Only touched by the control loop
+class FeedingSchedule {
+	public:
+		FeedingSchedule();
+
+		void load(const FeedingScheduleTable& table); // Sorts a copy of the entries, feeds due in the current minute are skipped
+
+		// Wall clock from the server, nothing is fed before the first one
+		void setClock(uint32_t unixTime, ulong clockMillis);
+		bool hasClock();
+		uint32_t getTime(ulong nowMillis);
+
+		// Feeder IDs whose feed time passed since the last call. A feed late by more than SCHEDULE_LATE_LIMIT seconds is skipped
+		uint32_t poll(uint32_t unixTime);
+
+		uint16_t getOpenMillis(uint8_t feeder); // Portion of the latest feed of that feeder
+		uint32_t getRevision();
+		uint32_t getSkippedCount();
+
+	private:
+		void anchor(uint32_t unixTime); // Next slot after the current minute
+
+		FeedingScheduleTable table;
+		ScheduleSlot slots[SCHEDULE_MAX_SLOTS];
+		size_t slotCount;
+
+		size_t nextSlot;
+		uint32_t nextTime; // Unix time nextSlot is due at
+		bool isAnchored;
+
+		bool isClockSet;
+		uint32_t clockUnixTime;
+		ulong clockMillis;
+
+		uint16_t openMillis[ACTUATOR_MAX_COUNT];
+		uint32_t skippedCount;
+};
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "config.h"
+
+static_assert(WS_TX_RING_SLOTS >= 2 && (WS_TX_RING_SLOTS & (WS_TX_RING_SLOTS - 1)) == 0, "WS_TX_RING_SLOTS must be a power of two");
+
+enum FrameRingPolicy {
+	FRAME_RING_DROP_NEWEST, // A full ring rejects the new frame
+	FRAME_RING_OVERWRITE_OLDEST // A full ring drops its oldest frame that isn't being sent
+};
+
+struct FrameRingSlot {
+	size_t size;
+	char data[WS_TX_FRAME_SIZE];
+};
+
+// Preallocated ring of outbound frames, one producer task serializes into it and one consumer task sends from it
+// One slot always stays empty, so it holds WS_TX_RING_SLOTS - 1 frames
+class FrameRing {
+	public:
+		FrameRing(FrameRingPolicy policy);
+
+		#pragma region Producer
+
+		// Slot of WS_TX_FRAME_SIZE bytes to write the next frame into, nullptr if the frame has to be dropped
+		char* beginWrite();
+		void commitWrite(size_t size);
+		void abortWrite(); // The frame didn't fit, counted as dropped
+
+		#pragma endregion
+
+		#pragma region Consumer
+
+		// Oldest frame, stays valid until release(). nullptr if the ring is empty
+		const char* peek(size_t& size);
+		void release(bool wasSent);
+		void clear(); // Drop everything queued, e.g. after a reconnect
+
+		#pragma endregion
+
+		size_t size();
+		uint32_t getEnqueuedCount();
+		uint32_t getSentCount();
+		uint32_t getDroppedCount();
+
+	private:
+		FrameRingPolicy policy;
+		FrameRingSlot slots[WS_TX_RING_SLOTS];
+
+		std::atomic<uint32_t> head; // Next frame to send, moved by the consumer, or by the producer when overwriting
+		std::atomic<uint32_t> tail; // Next frame to write, only moved by the producer
+		std::atomic<uint32_t> readingSlot; // Slot the consumer is sending from, WS_TX_RING_SLOTS if none
+		uint32_t readingIndex;
+
+		std::atomic<uint32_t> enqueuedCount;
+		std::atomic<uint32_t> sentCount;
+		std::atomic<uint32_t> droppedCount;
+};
\ No newline at end of file
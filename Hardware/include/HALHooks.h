@@ -0,0 +1,14 @@
+#pragma once
+#include <sys/types.h>
+
+// Points a host driver can hook into, left unset on target so each costs a compare
+// The firmware never names the host HAL, the driver sets what it needs before setup()
+
+// Earliest micros() a polled TickTimer or a scheduler fires next, lets a driver stepping a simulated clock skip the idle time
+typedef void (*HALWakeupHint)(ulong micros);
+extern HALWakeupHint HAL_wakeupHint;
+
+inline void HAL_hintWakeup(ulong micros) {
+	if (HAL_wakeupHint != nullptr)
+		HAL_wakeupHint(micros);
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include "config.h"
+#include "SPSCQueue.h"
+
+#define I2C_TRANSACTION_MAX_DATA 4 // Kept short, a drain() can only stop between transactions
+
+// One exchange with a device, carried out by run() on the side that drains the bus
+struct I2CTransaction {
+	void (*run)(void* context, const uint8_t* data, uint8_t size);
+	void* context;
+	uint8_t size;
+	uint8_t data[I2C_TRANSACTION_MAX_DATA];
+};
+
+// Bus transactions queued up and carried out in slices, so waiting on the bus holds up no other task for long
+// With ENABLE_DUAL_CORE the i2c task drains it on the network core, otherwise between the control tasks of loop()
+class I2CBus {
+	public:
+		I2CBus();
+
+		// Producer only, false if the queue is full. The caller keeps what it couldn't send and tries again later
+		bool submit(void (*run)(void* context, const uint8_t* data, uint8_t size), void* context, const uint8_t* data, uint8_t size);
+		size_t getQueuedCount(); // May be stale by a transaction on the other side
+
+		// Consumer only, runs the transactions that should end within budgetMicros going by the longest one so far
+		// A budget below getMaxTransactionMicros() runs nothing. Returns the micros it took
+		ulong drain(ulong budgetMicros);
+		void drainAll(); // Blocks until the queue is empty, for setup(). Also learns how long transactions take
+
+		uint32_t getSubmittedCount();
+		uint32_t getRejectedCount(); // Turned away by a full queue
+		uint32_t getCompletedCount();
+		ulong getMaxDrainMicros(); // Longest drain() so far
+		ulong getMaxTransactionMicros(); // Longest transaction so far
+
+	private:
+		void runTransaction(I2CTransaction& transaction);
+
+		SPSCQueue<I2CTransaction, I2C_QUEUE_SIZE> queue;
+
+		uint32_t submittedCount;
+		uint32_t rejectedCount;
+		uint32_t completedCount;
+		ulong maxDrainMicros;
+		ulong maxTransactionMicros;
+};
\ No newline at end of file
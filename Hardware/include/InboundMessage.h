@@ -0,0 +1,76 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#define INBOUND_MAX_DATA_FIELDS 8 // Members of "data" kept per reply, the rest are skipped
+
+// FNV-1a, evaluated at compile time for the endpoints and keys the firmware dispatches on
+constexpr uint32_t InboundMessage_hash(const char* text, uint32_t hash = 2166136261u) {
+	return *text == '\0' ? hash : InboundMessage_hash(text + 1, (hash ^ (uint8_t)*text) * 16777619u);
+}
+
+constexpr uint32_t INBOUND_ENDPOINT_LOGIN = InboundMessage_hash("/login");
+constexpr uint32_t INBOUND_ENDPOINT_GET_DATA = InboundMessage_hash("/iot/get_data");
+constexpr uint32_t INBOUND_ENDPOINT_POST_DATA = InboundMessage_hash("/iot/post_data");
+constexpr uint32_t INBOUND_ENDPOINT_POST_HISTORY = InboundMessage_hash("/iot/post_history");
+constexpr uint32_t INBOUND_ENDPOINT_METRICS = InboundMessage_hash("/iot/metrics");
+constexpr uint32_t INBOUND_ENDPOINT_PUSH_COMMAND = InboundMessage_hash("/iot/push_command"); // Sent by the server unasked
+constexpr uint32_t INBOUND_ENDPOINT_PUSH_SCHEDULE = InboundMessage_hash("/iot/push_schedule"); // Same, a whole feeding schedule table
+
+constexpr uint32_t INBOUND_STATUS_SUCCESS = InboundMessage_hash("success");
+constexpr uint32_t INBOUND_STATUS_ERROR = InboundMessage_hash("error");
+
+constexpr uint32_t INBOUND_KEY_BINARY = InboundMessage_hash("binary");
+constexpr uint32_t INBOUND_KEY_PUSH = InboundMessage_hash("push");
+constexpr uint32_t INBOUND_KEY_DELTA = InboundMessage_hash("delta");
+constexpr uint32_t INBOUND_KEY_HISTORY = InboundMessage_hash("history");
+constexpr uint32_t INBOUND_KEY_TIME = InboundMessage_hash("time");
+constexpr uint32_t INBOUND_KEY_SCHEDULE = InboundMessage_hash("schedule");
+constexpr uint32_t INBOUND_KEY_REVISION = InboundMessage_hash("rev");
+constexpr uint32_t INBOUND_KEY_UTC_OFFSET = InboundMessage_hash("tz"); // Minutes
+constexpr uint32_t INBOUND_KEY_ENTRIES = InboundMessage_hash("e"); // SCHEDULE_ENTRY_HEX_SIZE characters per entry
+constexpr uint32_t INBOUND_KEY_SHOULD_ENABLE_WATER_PUMP = InboundMessage_hash("shouldEnableWaterPump");
+constexpr uint32_t INBOUND_KEY_SHOULD_DISPENSE_FOOD = InboundMessage_hash("shouldDispenseFood");
+constexpr uint32_t INBOUND_KEY_PUMPS = InboundMessage_hash("pumps"); // Mask by pump ID, shouldEnableWaterPump is bit 0
+constexpr uint32_t INBOUND_KEY_FEEDERS = InboundMessage_hash("feeders"); // Mask by feeder ID, shouldDispenseFood is bit 0
+
+enum InboundValueType : uint8_t {
+	INBOUND_NULL,
+	INBOUND_BOOL,
+	INBOUND_NUMBER,
+	INBOUND_STRING,
+	INBOUND_NESTED // Object or array, skipped
+};
+
+struct InboundField {
+	uint32_t keyHash;
+	InboundValueType type;
+	bool boolean;
+	float number;
+	uint32_t integer; // Exact value of a whole number from 0 to UINT32_MAX, number keeps only 24 bits of it
+	const char* string; // Points into the parsed text
+	uint32_t stringHash;
+};
+
+// A backend reply, {"status", "code", "endpoint", "id", "error_message", "data": {...}}, without any copies
+struct InboundMessage {
+	uint32_t statusHash;
+	int code;
+	uint32_t endpointHash;
+	const char* endpoint;
+	const char* errorMessage; // nullptr if the reply has none
+	uint16_t requestId; // "id" echoed by the server, 0 if the reply has none
+	bool hasData; // "data" is an object
+
+	InboundField fields[INBOUND_MAX_DATA_FIELDS];
+	uint8_t fieldCount;
+
+	const InboundField* find(uint32_t keyHash) const; // nullptr if "data" doesn't have it
+	bool getBool(uint32_t keyHash) const; // True for true or a non-zero number
+	int getInt(uint32_t keyHash) const;
+	uint32_t getUnsigned(uint32_t keyHash) const; // 0 unless it is a whole number from 0 to UINT32_MAX
+};
+
+// Parses in place: strings are unescaped and NUL terminated inside text, so it has to outlive the message
+// text[size] has to be writable. Returns false if the text isn't a JSON object
+bool InboundMessage_parse(char* text, size_t size, InboundMessage& message);
\ No newline at end of file
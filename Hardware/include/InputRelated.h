@@ -1,16 +1,21 @@
 #pragma once
 #include "config.h"
-#include "TickTimer.h"
 #include <hal/gpio_types.h>
 #include <sys/types.h>
 #include <sys/config.h>
 
-#if ENABLE_DHT == true
+#if ENABLE_DHT == true && DHT_EDGE_CAPTURE == true
+	#include "DHTFrame.h"
+#elif ENABLE_DHT == true
 	#include <Adafruit_Sensor.h>
 	#include <DHT.h>
 	#include <DHT_U.h>
 #endif
 
+#if ENABLE_WATER_LEVEL_SENSOR == true
+	#include "WaterLevelFilter.h"
+#endif
+
 class Input {
 	public:
 		#if ENABLE_DHT == true
@@ -18,16 +23,32 @@ class Input {
 				public:
 					DHT11Sensor(gpio_num_t pin);
 					void setup();
+					ulong update(); // Read the sensor, run by the scheduler every 5 seconds. Returns the micros until the next step, 0 to keep the period
 					float readTemperature();
 					float readHumidity();
 
+					uint32_t getReadCount();
+					uint32_t getErrorCount(); // Reads that gave no value
+
 				private:
 					gpio_num_t pin;
-					DHT_Unified* dht;
 					float temperature;
 					float humidity;
-					TickTimer dhtTimer;
-					void readSensor();
+					uint32_t readCount;
+					uint32_t errorCount;
+
+					#if DHT_EDGE_CAPTURE == true
+						enum CaptureState : uint8_t { IDLE, START_SIGNAL, CAPTURING };
+
+						static void onEdge(void* arg);
+
+						CaptureState state;
+						ulong stateMicros; // When the current state was entered
+						volatile uint32_t edges[DHT_FRAME_MAX_EDGES]; // Written by onEdge() only while CAPTURING
+						volatile uint8_t edgeCount;
+					#else
+						DHT_Unified* dht;
+					#endif
 			};
 		#endif
 
@@ -36,13 +57,17 @@ class Input {
 				public:
 					WaterLevel(gpio_num_t pin);
 					void setup();
+					void update(); // Take a burst of readings, run by the scheduler every WATER_LEVEL_SAMPLE_INTERVAL
 					ushort readPercent();
+					float readFilteredPercent(); // Before rounding
+					bool isFull(); // See WaterLevelFilter::isFull()
+
+					uint32_t getRejectedCount(); // Readings out of the ADC range
 
 				private:
 					gpio_num_t pin;
-					uint16_t rawValue = 0;
-					TickTimer waterLevelSensorTimer;
-					void readSensor();
+					WaterLevelFilter filter;
+					uint32_t rejectedCount;
 			};
 		#endif
 };
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <LiquidCrystal_I2C.h>
+#include "config.h"
+#include "I2CBus.h"
+
+// Screens are composed into a frame in memory, flush() only sends the characters that differ from what the display shows
+// Every character and cursor move is an I2C transaction of its own, so unchanged cells are the cheapest ones
+// Composing and sending are split so the bus can be driven from another task than the one drawing the screens
+class LCDRenderer {
+	public:
+		LCDRenderer(LiquidCrystal_I2C& lcd, I2CBus& bus);
+
+		void clear(); // Blank the frame, the display keeps its content until flush()
+		void print(uint8_t column, uint8_t row, const char* text); // Clipped to the row
+		void printRight(uint8_t row, const char* text); // Ending in the last column
+
+		// Hand the composed frame to flush(), which runs right away without I2C_ASYNC
+		// Skipped while flush() hasn't taken the last one, the next call catches up
+		void present();
+
+		// One other task, e.g. the network one: a line that covers a row of every presented frame until clearOverlay()
+		// Handed over like present(), false while flush() hasn't taken the last change, the caller tries again later
+		// Never flushes on its own, without I2C_ASYNC it goes out with the next present()
+		bool setOverlay(uint8_t row, const char* text);
+		bool clearOverlay();
+
+		// Bus side, queues the characters that differ from the display until the bus is full. Returns the characters queued
+		// What didn't fit goes out with the next call
+		size_t flush();
+
+		// Bus side, the display content is unknown, e.g. after a reset, the next flush() clears it first
+		void invalidate();
+
+		uint32_t getFlushCount(); // Frames taken from present()
+		uint32_t getWrittenCount(); // Characters queued in total
+		uint32_t getCursorMoveCount();
+
+	private:
+		static void RunClear(void* context, const uint8_t* data, uint8_t size);
+		static void RunWrite(void* context, const uint8_t* data, uint8_t size);
+
+		LiquidCrystal_I2C* lcd;
+		I2CBus* bus;
+		char frame[LCD_ROWS_SIZE][LCD_COLUMNS_SIZE]; // Being composed
+		char presented[LCD_ROWS_SIZE][LCD_COLUMNS_SIZE]; // Handed over by present()
+		std::atomic<bool> isPresentedPending;
+		char presentedOverlay[LCD_COLUMNS_SIZE]; // Handed over by setOverlay()
+		uint8_t presentedOverlayRow; // LCD_ROWS_SIZE for none
+		std::atomic<bool> isOverlayPending;
+		char overlay[LCD_COLUMNS_SIZE]; // Latest overlay taken by flush()
+		uint8_t overlayRow;
+		char target[LCD_ROWS_SIZE][LCD_COLUMNS_SIZE]; // Latest frame taken by flush()
+		char shown[LCD_ROWS_SIZE][LCD_COLUMNS_SIZE]; // What the display has once the queued transactions ran
+		bool isShownValid;
+
+		uint32_t flushCount;
+		uint32_t writtenCount;
+		uint32_t cursorMoveCount;
+};
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+
+#define METRICS_SUB_BUCKETS (1 << METRICS_SUB_BUCKET_BITS)
+#define METRICS_BUCKET_COUNT ((METRICS_MAX_VALUE_BITS - METRICS_SUB_BUCKET_BITS + 1) * METRICS_SUB_BUCKETS)
+
+// Rows of [name, count, p50, p90, p99, max] in micros, "p" for the probes and "l" for how late the scheduler tasks started
+#define METRICS_FRAME_PREFIX "{\"key\":\"/iot/metrics\",\"data\":{\"up\":"
+#define METRICS_FRAME_SUFFIX "]}}"
+
+class Scheduler;
+
+// Log-linear like HdrHistogram: values below 2 * METRICS_SUB_BUCKETS each have a bucket,
+// every power of two above is split into METRICS_SUB_BUCKETS of the same width
+// Fixed size, record() is a count of leading zeros, two shifts and an increment
+// A seqlock lets other tasks copy it whole: the sequence is odd while a record is in flight. Fields go through
+// the __atomic builtins rather than std::atomic so the tasks holding one can still be assigned
+class LatencyHistogram {
+	public:
+		LatencyHistogram();
+
+		// By the task that owns it only
+		void record(uint32_t micros) {
+			uint16_t Bucket = bucketOf(micros);
+
+			this->beginWrite();
+			__atomic_store_n(&this->counts[Bucket], this->counts[Bucket] + 1, __ATOMIC_RELAXED);
+			__atomic_store_n(&this->count, this->count + 1, __ATOMIC_RELAXED);
+			if (micros > this->max)
+				__atomic_store_n(&this->max, micros, __ATOMIC_RELAXED);
+			this->endWrite();
+		}
+
+		void reset(); // By the owning task too
+
+		// A consistent copy from any task, retried while the owner records. Read the getters of the copy
+		void snapshotTo(LatencyHistogram& snapshot) const;
+
+		uint32_t getCount() const;
+		uint32_t getMax() const;
+		uint32_t getPercentile(uint8_t percentile) const; // Highest value of the bucket it falls in, 0 if nothing was recorded
+
+		static uint16_t bucketOf(uint32_t value) {
+			if (value < 2 * METRICS_SUB_BUCKETS)
+				return value;
+
+			if (value >= (1UL << METRICS_MAX_VALUE_BITS))
+				return METRICS_BUCKET_COUNT - 1;
+
+			int Shift = 31 - __builtin_clz(value) - METRICS_SUB_BUCKET_BITS;
+			return (Shift + 1) * METRICS_SUB_BUCKETS + (value >> Shift) - METRICS_SUB_BUCKETS;
+		}
+
+		static uint32_t highestOf(uint16_t bucket);
+
+	private:
+		uint32_t counts[METRICS_BUCKET_COUNT];
+		uint32_t count;
+		uint32_t max;
+		uint32_t sequence;
+
+		void beginWrite() {
+			__atomic_store_n(&this->sequence, this->sequence + 1, __ATOMIC_RELAXED);
+			__atomic_thread_fence(__ATOMIC_RELEASE);
+		}
+
+		void endWrite() {
+			__atomic_store_n(&this->sequence, this->sequence + 1, __ATOMIC_RELEASE);
+		}
+};
+
+// Each is recorded by one task only
+enum MetricsProbe : uint8_t {
+	METRICS_LOOP, // One loop() iteration without the delay() at its end
+	METRICS_NETWORK, // WiFiNetwork::loop()
+	METRICS_WEBSOCKET, // WiFiNetwork::handleWebSocket()
+	METRICS_SERVO_PWM, // ServoManager_WritePWM()
+	METRICS_PROBE_COUNT
+};
+
+extern LatencyHistogram Metrics_histograms[METRICS_PROBE_COUNT];
+extern uint32_t Metrics_cyclesPerMicro;
+
+void Metrics_setup(); // Reads the CPU clock the cycle counter runs at
+const char* Metrics_probeName(MetricsProbe probe);
+void Metrics_print(); // The probes to Serial
+
+// Histograms in a report, the probes then the tasks of every scheduler
+int Metrics_getRowCount(Scheduler* const* schedulers, int schedulerCount);
+
+// /iot/metrics with the non-empty rows from cursor on as far as they fit, cursor is moved past them. 0 if not even one does
+size_t Metrics_encodeReport(Scheduler* const* schedulers, int schedulerCount, int& cursor, char* buffer, size_t capacity);
+
+// Times the scope with the CPU cycle counter, a register read where micros() goes through the system timer
+class MetricsTimer {
+	public:
+		MetricsTimer(MetricsProbe probe) {
+			this->probe = probe;
+			this->isStopped = false;
+			this->startCycles = ESP.getCycleCount();
+		}
+
+		~MetricsTimer() {
+			this->stop();
+		}
+
+		// Ends the measurement before the scope does, e.g. ahead of a delay()
+		void stop() {
+			if (this->isStopped)
+				return;
+
+			this->isStopped = true;
+			Metrics_histograms[this->probe].record((ESP.getCycleCount() - this->startCycles) / Metrics_cyclesPerMicro);
+		}
+
+	private:
+		MetricsProbe probe;
+		bool isStopped;
+		uint32_t startCycles;
+};
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include <stdint.h>
+#include <sys/types.h>
+#include "config.h"
+
+static_assert(WATER_PUMP_RATE_SAMPLES >= 3 && WATER_PUMP_RATE_SAMPLES <= 255, "WATER_PUMP_RATE_SAMPLES must fit a line and fit in 255");
+
+// Fill rate of the bowl while a pump runs, fitted to the filtered level by least squares over the last samples
+// The hose keeps draining and the sensor lags after a stop, so the pump stops once level + rate * coast reaches the target
+// How far the level coasts is learned from the peak after every stop
+// The one level sensor covers every pump, so the controller sees the pumps as one
+
+enum PumpDecision : uint8_t {
+	PUMP_KEEP, // Nothing against running
+	PUMP_STOP_FULL, // The water still coming reaches WATER_LEVEL_FULL_PERCENT
+	PUMP_STOP_DRY_RUN, // The level doesn't rise, e.g. the reservoir is empty
+	PUMP_STOP_SENSOR_STUCK // The level doesn't move at all, not even by noise
+};
+
+class PumpController {
+	public:
+		PumpController();
+
+		// Once per control loop with the filtered level, isRunning is whether any pump was on since the last call
+		PumpDecision update(ulong nowMillis, float level, bool isRunning);
+
+		bool isLockedOut(ulong nowMillis); // For WATER_PUMP_FAULT_HOLDOFF after a dry run, after a stuck sensor until the level moves
+
+		float getRate(); // % per second, 0 until fitted
+		float getCoastSeconds();
+		uint32_t getEarlyStopCount();
+		uint32_t getDryRunCount();
+		uint32_t getStuckCount();
+
+	private:
+		void learnCoast(ulong nowMillis, float level);
+		bool fitRate(); // false if there aren't enough samples yet
+
+		bool isRunning;
+		ulong startMillis;
+
+		// Ring of samples since the dead time, times relative to startMillis
+		ulong sampleMillis[WATER_PUMP_RATE_SAMPLES];
+		float sampleLevels[WATER_PUMP_RATE_SAMPLES];
+		uint8_t sampleHead;
+		uint8_t sampleCount;
+		ulong lastSampleMillis;
+
+		float rate;
+		float spread; // Highest minus lowest sample level
+		float coastSeconds;
+
+		// Watching for the peak after a stop
+		bool isSettling;
+		ulong stopMillis;
+		float stopLevel;
+		float stopRate;
+		float peakLevel;
+
+		bool isHoldingOff;
+		ulong holdoffMillis;
+		bool isStuck;
+		float stuckLevel;
+
+		uint32_t earlyStopCount;
+		uint32_t dryRunCount;
+		uint32_t stuckCount;
+};
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "config.h"
+
+static_assert(WS_REQUEST_WINDOW >= 1 && WS_REQUEST_WINDOW <= 255, "WS_REQUEST_WINDOW must be between 1 and 255");
+
+#define REQUEST_ID_NONE 0 // Server pushes and replies of a server that doesn't echo IDs
+#define REQUEST_ID_JSON_SUFFIX ",\"id\":"
+#define REQUEST_ID_MAX_LENGTH 5 // 65535
+
+// Room for a JSON request in an outbound frame, WiFiNetwork::commitRequest() adds the ID
+#define REQUEST_JSON_CAPACITY (WS_TX_FRAME_SIZE - (sizeof(REQUEST_ID_JSON_SUFFIX) - 1 + REQUEST_ID_MAX_LENGTH))
+
+struct RequestSlot {
+	bool isUsed;
+	uint16_t id;
+	uint32_t endpointHash;
+	uint32_t order; // Lower was sent first
+	ulong sentTime; // millis() of the last transmission
+	uint8_t retransmits;
+	size_t size;
+	char frame[WS_TX_FRAME_SIZE]; // Kept to send the same bytes again on timeout
+};
+
+// Requests sent and not answered yet, only touched by the network side
+class RequestWindow {
+	public:
+		RequestWindow();
+
+		void setLimit(uint8_t limit); // Requests allowed in flight, 1 to WS_REQUEST_WINDOW
+		uint8_t getLimit();
+		uint8_t size();
+		bool isFull();
+		bool isPending(uint32_t endpointHash);
+
+		uint16_t nextId(); // Never REQUEST_ID_NONE
+		bool add(uint16_t id, uint32_t endpointHash, const char* frame, size_t size, ulong now);
+
+		// Frees the request the reply belongs to, false if none is waiting for it, e.g. a second reply after a retransmit
+		// A reply without ID is matched to the oldest request on its endpoint
+		bool complete(uint16_t id, uint32_t endpointHash);
+
+		// Oldest request without reply for WS_REQUEST_TIMEOUT, nullptr if none
+		RequestSlot* nextExpired(ulong now);
+		void markRetransmitted(RequestSlot* slot, ulong now);
+
+		void clear(); // Nothing will be answered after a reconnect
+
+		uint32_t getCompletedCount();
+		uint32_t getRetransmitCount();
+
+	private:
+		RequestSlot slots[WS_REQUEST_WINDOW];
+		uint8_t limit;
+		uint8_t count;
+		uint16_t lastId;
+		uint32_t nextOrder;
+
+		uint32_t completedCount;
+		uint32_t retransmitCount;
+};
\ No newline at end of file
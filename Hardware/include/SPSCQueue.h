@@ -0,0 +1,56 @@
+#pragma once
+#include <stddef.h>
+#include <atomic>
+
+// Lock-free queue between exactly one producer task and one consumer task
+// Head and tail only ever grow, so they wrap together and Capacity has to be a power of two
+template <typename T, size_t Capacity>
+class SPSCQueue {
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SPSCQueue capacity must be a power of two");
+
+	public:
+		SPSCQueue() : head(0), tail(0) {}
+
+		// Producer only, returns false if the queue is full
+		bool push(const T& item) {
+			size_t Tail = this->tail.load(std::memory_order_relaxed);
+
+			if (Tail - this->head.load(std::memory_order_acquire) >= Capacity)
+				return false;
+
+			this->items[Tail & (Capacity - 1)] = item;
+			this->tail.store(Tail + 1, std::memory_order_release); // Publish the slot after it is written
+			return true;
+		}
+
+		// Consumer only, returns false if the queue is empty
+		bool pop(T& item) {
+			size_t Head = this->head.load(std::memory_order_relaxed);
+
+			if (Head == this->tail.load(std::memory_order_acquire))
+				return false;
+
+			item = this->items[Head & (Capacity - 1)];
+			this->head.store(Head + 1, std::memory_order_release); // Hand the slot back after it is read
+			return true;
+		}
+
+		// May be stale by the other side's in-flight operation
+		size_t size() const {
+			size_t Head = this->head.load(std::memory_order_acquire); // Head first so it can never pass the tail read after it
+			return this->tail.load(std::memory_order_acquire) - Head;
+		}
+
+		bool isEmpty() const {
+			return this->size() == 0;
+		}
+
+		static constexpr size_t capacity() {
+			return Capacity;
+		}
+
+	private:
+		T items[Capacity];
+		std::atomic<size_t> head; // Next slot to read, only written by the consumer
+		std::atomic<size_t> tail; // Next slot to write, only written by the producer
+};
\ No newline at end of file
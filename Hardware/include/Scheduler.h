@@ -0,0 +1,80 @@
+#pragma once
+#include <sys/types.h>
+#include <stdint.h>
+#include "config.h"
+#include "TickTimer.h"
+
+#if ENABLE_METRICS == true
+	#include "Metrics.h"
+#endif
+
+// Returns the new period of the task in micros, or 0 to keep its current period
+typedef ulong (*SchedulerCallback)();
+
+class Scheduler;
+struct SchedulerTask;
+
+// Every start of a task after its first, with the time since its previous start and the period it was due at
+typedef void (*SchedulerPeriodObserver)(const Scheduler* scheduler, const SchedulerTask& task, ulong intervalMicros, ulong periodMicros);
+
+struct SchedulerTask {
+	const char* name;
+	SchedulerCallback callback;
+	TickTimer timer; // Period, and the deadline of the last dispatch as lastMicros
+	uint32_t sequence; // Breaks deadline ties in registration order
+
+	uint32_t runs;
+	uint32_t overruns; // Dispatched a full period or more late, or ran longer than its period
+	ulong lastJitterMicros;
+	ulong maxJitterMicros;
+	ulong maxDurationMicros;
+	ulong lastStartMicros;
+	ulong maxPeriodMicros; // Worst time between two consecutive starts
+
+	#if ENABLE_METRICS == true
+		LatencyHistogram lateness; // Of every start against its deadline
+	#endif
+};
+
+// Cooperative scheduler, keeps tasks in a min-heap ordered by their next deadline
+class Scheduler {
+	public:
+		Scheduler();
+
+		// Returns the task id, or -1 if SCHEDULER_MAX_TASKS is reached. First run is immediate
+		int addTask(const char* name, SchedulerCallback callback, ulong periodMicros);
+		void setTaskPeriod(int id, ulong periodMicros);
+		void wakeTask(int id, ulong periodMicros); // Due right away, then every periodMicros. Safe from a task callback
+
+		// Dispatch every due task, returns the micros until the next deadline
+		ulong run();
+
+		// Micros until a task other than the running one is due, for work that can't be cut short, e.g. a bus transaction
+		ulong getSlackMicros();
+
+		int getTaskCount();
+		const SchedulerTask* getTask(int id);
+		ulong getBusyMicros();
+		ulong getElapsedMicros();
+		void printStats();
+
+		// For a host driver watching every scheduler, e.g. for tasks held up by another one. Unset on target
+		static void setPeriodObserver(SchedulerPeriodObserver observer);
+
+	private:
+		bool isBefore(int a, int b);
+		void siftUp(int index);
+		void siftDown(int index);
+		void resift(int id); // After the deadline of a task changed
+		ulong getDeadline(int id);
+
+		SchedulerTask tasks[SCHEDULER_MAX_TASKS];
+		int heap[SCHEDULER_MAX_TASKS];
+		int taskCount;
+		int runningTask; // -1 outside of a callback
+
+		ulong startMicros;
+		ulong busyMicros;
+
+		static SchedulerPeriodObserver periodObserver;
+};
\ No newline at end of file
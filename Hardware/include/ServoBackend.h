@@ -0,0 +1,43 @@
+#pragma once
+#include <hal/gpio_types.h>
+#include <sys/types.h>
+#include "config.h"
+#include "ActuatorRegistry.h"
+
+// Output stage that turns the pulse width of a feeder into a pulse train on its pin, the feeder ID is its LEDC channel
+class ServoBackend {
+	public:
+		virtual ~ServoBackend() {}
+
+		// Configure the pin (and channel, if any) of a newly set up feeder
+		virtual void attach(const FeederTable& feeders, uint8_t id) = 0;
+
+		// Called by the servo manager whenever the pulse width changes
+		virtual void write(const FeederTable& feeders, uint8_t id) = 0;
+
+		// Called for every feeder on each servo tick, only if needsRefresh() is true
+		virtual void refresh(const FeederTable& feeders, uint8_t id) = 0;
+
+		// True if the pulses have to be generated by ServoManager_loop()
+		virtual bool needsRefresh() = 0;
+};
+
+// Hardware PWM through the ESP32 LEDC peripheral, the CPU only updates the duty register
+class ServoLEDCBackend : public ServoBackend {
+	public:
+		void attach(const FeederTable& feeders, uint8_t id) override;
+		void write(const FeederTable& feeders, uint8_t id) override;
+		void refresh(const FeederTable& feeders, uint8_t id) override;
+		bool needsRefresh() override;
+};
+
+// Fallback that bit-bangs each pulse with delayMicroseconds(), blocking up to ~2.6 ms per servo
+class ServoBitBangBackend : public ServoBackend {
+	public:
+		void attach(const FeederTable& feeders, uint8_t id) override;
+		void write(const FeederTable& feeders, uint8_t id) override;
+		void refresh(const FeederTable& feeders, uint8_t id) override;
+		bool needsRefresh() override;
+};
+
+ServoBackend* ServoBackend_getDefault();
\ No newline at end of file
@@ -1,29 +1,19 @@
 #pragma once
-#include <hal/gpio_types.h>
 #include "config.h"
-#include "TickTimer.h"
-#include <vector>
+#include "ActuatorRegistry.h"
+#include "ServoBackend.h"
+#include <stdint.h>
 
-struct ServoTarget {
-	int degrees;
+#define SERVO_TICK_INTERVAL 20000 // 20 ms (50 Hz), period of the servo task while it has work
 
-	gpio_num_t pin;
-};
+extern FeederTable* pFeeders;
+extern ServoBackend* pServoBackend;
 
-class ServoManager {
-	public:
-		ServoManager();
-		ServoManager(gpio_num_t pin);
-		void setup();
-		void Rotate(int degrees);
-		int getCurrentPosition();
+// Attaches every feeder registered so far to the backend
+void ServoManager_setup(FeederTable* feeders);
+void ServoManager_setBackend(ServoBackend* backend);
 
-	private:
-		ServoTarget target;
-};
+// Sets the target angle, the servo is ramped there at SERVO_VELOCITY by ServoManager_loop(), or written at once without it
+void ServoManager_rotate(uint8_t id, int degrees);
 
-extern std::vector<ServoTarget*> pServoTargets;
-extern TickTimer servoTickTimer; // 20 ms (50 Hz)
-
-void ServoManager_loop();
-static void ServoManager_WritePWM();
+void ServoManager_loop(); // Run by the scheduler every 20 ms (50 Hz) if the backend needs it or SERVO_VELOCITY ramps
\ No newline at end of file
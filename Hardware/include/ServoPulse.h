@@ -0,0 +1,76 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+// Pulse width by whole degree for every feeder, computed by the compiler from SERVO_CALIBRATIONS and kept in flash
+// Turning an angle into a pulse is a load from the table of the feeder, no floating point in the servo tick
+
+#define SERVO_MAX_DEGREES 180
+
+struct ServoCalibration {
+	uint16_t minMicros; // Pulse at 0 degrees
+	uint16_t maxMicros; // Pulse at SERVO_MAX_DEGREES
+	uint8_t deadbandMicros; // The servo doesn't follow a smaller change, ramp steps below it aren't written
+	bool isReversed; // Mounted the other way round, 0 degrees gets maxMicros
+};
+
+struct ServoPulseTable {
+	uint16_t micros[SERVO_MAX_DEGREES + 1];
+};
+
+constexpr ServoCalibration ServoCalibrations[] = SERVO_CALIBRATIONS;
+constexpr ServoCalibration ServoDefaultCalibration = SERVO_CALIBRATION;
+
+#define SERVO_CALIBRATION_COUNT (sizeof(ServoCalibrations) / sizeof(ServoCalibrations[0]))
+
+// Straight line between the two calibrated pulses, rounded down like the float formula it replaces. Degrees are clamped
+constexpr uint16_t ServoPulse_micros(const ServoCalibration& calibration, int degrees) {
+	return degrees < 0 ? ServoPulse_micros(calibration, 0)
+		: degrees > SERVO_MAX_DEGREES ? ServoPulse_micros(calibration, SERVO_MAX_DEGREES)
+		: (uint16_t)(calibration.minMicros + ((int32_t)calibration.maxMicros - calibration.minMicros) * (calibration.isReversed ? SERVO_MAX_DEGREES - degrees : degrees) / SERVO_MAX_DEGREES);
+}
+
+// 0 ... N - 1 as a parameter pack, the firmware is built as C++11 which has no std::make_integer_sequence
+template <int... Values> struct ServoPulseSequence {};
+template <int N, int... Values> struct ServoPulseMakeSequence : ServoPulseMakeSequence<N - 1, N - 1, Values...> {};
+template <int... Values> struct ServoPulseMakeSequence<0, Values...> { typedef ServoPulseSequence<Values...> type; };
+
+template <int... Degrees>
+constexpr ServoPulseTable ServoPulse_makeTable(const ServoCalibration& calibration, ServoPulseSequence<Degrees...>) {
+	return ServoPulseTable{ { ServoPulse_micros(calibration, Degrees)... } };
+}
+
+constexpr ServoPulseTable ServoPulse_makeTable(const ServoCalibration& calibration) {
+	return ServoPulse_makeTable(calibration, ServoPulseMakeSequence<SERVO_MAX_DEGREES + 1>::type());
+}
+
+// Feeder IDs past SERVO_CALIBRATIONS use SERVO_CALIBRATION
+constexpr const ServoCalibration& ServoPulse_getCalibration(size_t id) {
+	return id < SERVO_CALIBRATION_COUNT ? ServoCalibrations[id] : ServoDefaultCalibration;
+}
+
+// One table per entry of SERVO_CALIBRATIONS and one for SERVO_CALIBRATION after them
+template <typename Sequence> struct ServoPulseTableList;
+
+template <int... Ids>
+struct ServoPulseTableList<ServoPulseSequence<Ids...>> {
+	static constexpr ServoPulseTable tables[] = { ServoPulse_makeTable(ServoPulse_getCalibration(Ids))... };
+};
+
+template <int... Ids>
+constexpr ServoPulseTable ServoPulseTableList<ServoPulseSequence<Ids...>>::tables[];
+
+typedef ServoPulseTableList<ServoPulseMakeSequence<SERVO_CALIBRATION_COUNT + 1>::type> ServoPulseTables;
+
+static_assert(ServoPulseTables::tables[SERVO_CALIBRATION_COUNT].micros[ServoDefaultCalibration.isReversed ? SERVO_MAX_DEGREES : 0] == ServoDefaultCalibration.minMicros, "Pulse table doesn't start at the calibrated pulse");
+static_assert(ServoPulseTables::tables[SERVO_CALIBRATION_COUNT].micros[ServoDefaultCalibration.isReversed ? 0 : SERVO_MAX_DEGREES] == ServoDefaultCalibration.maxMicros, "Pulse table doesn't end at the calibrated pulse");
+
+inline const ServoPulseTable& ServoPulse_getTable(uint8_t id) {
+	return ServoPulseTables::tables[id < SERVO_CALIBRATION_COUNT ? id : SERVO_CALIBRATION_COUNT];
+}
+
+// Clamped to 0 - SERVO_MAX_DEGREES, inline so the servo tick is left with two compares and a load
+inline uint16_t ServoPulse_lookup(uint8_t id, int degrees) {
+	return ServoPulse_getTable(id).micros[degrees < 0 ? 0 : degrees > SERVO_MAX_DEGREES ? SERVO_MAX_DEGREES : degrees];
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+#include <stdint.h>
+#include <sys/types.h>
+
+// Sent from the network side to the control loop, one bit per actuator ID
+struct ActuatorCommand {
+	uint32_t pumpMask; // Pumps to enable
+	uint32_t feederMask; // Feeders to dispense from
+};
+
+// Snapshot of the control loop, sent to the network side for reporting
+struct TelemetrySample {
+	float temperature;
+	float humidity;
+	int waterLevel;
+	uint32_t pumpMask; // Pumps enabled
+	uint32_t feederMask; // Feeders open
+};
+
+// Server clock from the /login reply, sent from the network side to the feeding schedule
+struct ScheduleClock {
+	uint32_t unixTime;
+	ulong millis; // millis() when the reply arrived
+};
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+#include "config.h"
+#include "TaskMessages.h"
+
+// Change-driven /iot/post_data, offered at /login with WS_TELEMETRY_DELTA and mirrored in Backend/src/telemetry_delta.ts
+// Only fields that moved past their deadband since the last report are sent, with a full keyframe every TELEMETRY_KEYFRAME_INTERVAL
+
+#define TELEMETRY_DELTA_VERSION 1
+#define TELEMETRY_KEYFRAME_REQUEST_CODE 205 // Reply code of a delta out of sequence, dropped by the server until the next keyframe
+
+#define TELEMETRY_FIELD_TEMPERATURE 0x01
+#define TELEMETRY_FIELD_HUMIDITY 0x02
+#define TELEMETRY_FIELD_WATER_LEVEL 0x04
+#define TELEMETRY_FIELD_PUMP 0x08
+#define TELEMETRY_FIELD_FOOD 0x10
+#define TELEMETRY_FIELD_ALL 0x1F
+
+// Fields of sample that differ from reported by at least their deadband, actuator masks on any change
+uint8_t TelemetryDelta_changedFields(const TelemetrySample& reported, const TelemetrySample& sample);
+
+// Copies the given fields of sample into reported, which then holds what the server has
+void TelemetryDelta_apply(TelemetrySample& reported, const TelemetrySample& sample, uint8_t fields);
\ No newline at end of file
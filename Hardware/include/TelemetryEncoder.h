@@ -0,0 +1,62 @@
+#pragma once
+#include <stddef.h>
+#include "config.h"
+#include "TaskMessages.h"
+#include "TelemetryDelta.h"
+#include "TelemetryJournal.h"
+
+// Fixed parts of the /iot/post_data frame, the values go in between
+#define TELEMETRY_FRAME_PREFIX "{\"key\":\"/iot/post_data\",\"data\":{\"te\":"
+#define TELEMETRY_FRAME_HUMIDITY ",\"hu\":"
+#define TELEMETRY_FRAME_WATER_LEVEL ",\"wa\":"
+#define TELEMETRY_FRAME_PUMP ",\"PuEn\":" // Bit per pump ID that is on
+#define TELEMETRY_FRAME_FOOD ",\"DiFo\":" // Bit per feeder ID that is open
+#define TELEMETRY_FRAME_SUFFIX "}}"
+
+#define TELEMETRY_FLOAT_MAX_LENGTH 10 // -999999.99, anything larger is written as null
+#define TELEMETRY_INT_MAX_LENGTH 11 // -2147483648
+
+// Longest frame TelemetryEncoder_encode() can write, known at compile time
+#define TELEMETRY_FRAME_MAX_SIZE ( \
+	sizeof(TELEMETRY_FRAME_PREFIX) - 1 + TELEMETRY_FLOAT_MAX_LENGTH + \
+	sizeof(TELEMETRY_FRAME_HUMIDITY) - 1 + TELEMETRY_FLOAT_MAX_LENGTH + \
+	sizeof(TELEMETRY_FRAME_WATER_LEVEL) - 1 + TELEMETRY_INT_MAX_LENGTH + \
+	sizeof(TELEMETRY_FRAME_PUMP) - 1 + TELEMETRY_INT_MAX_LENGTH + \
+	sizeof(TELEMETRY_FRAME_FOOD) - 1 + TELEMETRY_INT_MAX_LENGTH + \
+	sizeof(TELEMETRY_FRAME_SUFFIX) - 1)
+
+// Delta frames start with the sequence number and only carry the fields that changed
+#define TELEMETRY_DELTA_FRAME_PREFIX "{\"key\":\"/iot/post_data\",\"data\":{\"sq\":"
+#define TELEMETRY_DELTA_FRAME_KEYFRAME ",\"kf\":1"
+#define TELEMETRY_DELTA_FRAME_TEMPERATURE ",\"te\":"
+#define TELEMETRY_SEQUENCE_MAX_LENGTH 5 // 65535
+
+#define TELEMETRY_DELTA_FRAME_MAX_SIZE ( \
+	sizeof(TELEMETRY_DELTA_FRAME_PREFIX) - 1 + TELEMETRY_SEQUENCE_MAX_LENGTH + \
+	sizeof(TELEMETRY_DELTA_FRAME_KEYFRAME) - 1 + \
+	sizeof(TELEMETRY_DELTA_FRAME_TEMPERATURE) - 1 + TELEMETRY_FLOAT_MAX_LENGTH + \
+	TELEMETRY_FRAME_MAX_SIZE - (sizeof(TELEMETRY_FRAME_PREFIX) - 1) - TELEMETRY_FLOAT_MAX_LENGTH)
+
+// Journaled samples as rows of [unix seconds, te, hu, wa, flags], flags 1 if any pump is on and 2 if any feeder is open
+#define TELEMETRY_HISTORY_FRAME_PREFIX "{\"key\":\"/iot/post_history\",\"data\":{\"s\":["
+#define TELEMETRY_HISTORY_FRAME_SUFFIX "]}}"
+#define TELEMETRY_HISTORY_ROW_MAX_SIZE (1 + 1 + TELEMETRY_INT_MAX_LENGTH + 1 + TELEMETRY_FLOAT_MAX_LENGTH + 1 + TELEMETRY_FLOAT_MAX_LENGTH + 1 + TELEMETRY_INT_MAX_LENGTH + 1 + 1 + 1)
+
+// The /iot/get_data poll has nothing but its key, the request ID is added when it is committed
+#define GET_DATA_FRAME "{\"key\":\"/iot/get_data\"}"
+
+static_assert(TELEMETRY_FRAME_MAX_SIZE <= WS_TX_FRAME_SIZE, "WS_TX_FRAME_SIZE is too small for a telemetry frame");
+static_assert(TELEMETRY_DELTA_FRAME_MAX_SIZE <= WS_TX_FRAME_SIZE, "WS_TX_FRAME_SIZE is too small for a telemetry delta frame");
+
+// Writes the same JSON as building a JsonDocument for /iot/post_data, without the heap
+// Floats get at most 2 decimals, non-finite ones become null. Returns the length, 0 if capacity is too small
+size_t TelemetryEncoder_encode(const TelemetrySample& sample, char* buffer, size_t capacity);
+
+// Same, but only the TELEMETRY_FIELD_* in fields, after "sq" and "kf" if it is a keyframe
+size_t TelemetryEncoder_encodeDelta(const TelemetrySample& sample, uint8_t fields, uint16_t sequence, bool keyframe, char* buffer, size_t capacity);
+
+// /iot/post_history with as many of the samples as fit, encoded is set to how many. 0 if not even one does
+size_t TelemetryEncoder_encodeHistory(const JournalSample* samples, size_t count, size_t& encoded, char* buffer, size_t capacity);
+
+// The /iot/get_data poll as serializing {"key":"/iot/get_data"} wrote it. Returns the length, 0 if capacity is too small
+size_t TelemetryEncoder_encodeGetData(char* buffer, size_t capacity);
\ No newline at end of file
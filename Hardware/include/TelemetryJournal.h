@@ -0,0 +1,113 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <esp_partition.h>
+#include "config.h"
+#include "TaskMessages.h"
+
+// Append-only ring of 16-byte records over JOURNAL_SECTOR_COUNT flash sectors, erased in turn so they wear evenly
+// Slot 0 of a sector is its header with an ever increasing sequence number, the highest one is where appending goes on
+// Uploaded samples are never rewritten, a cursor record appended after each batch marks how far the server has them
+
+#define TELEMETRY_JOURNAL_VERSION 1 // Offered at /login as "history", mirrored in Backend/src/telemetry_history.ts
+
+#define JOURNAL_SECTOR_SIZE 4096
+#define JOURNAL_RECORD_SIZE 16
+#define JOURNAL_SLOTS_PER_SECTOR (JOURNAL_SECTOR_SIZE / JOURNAL_RECORD_SIZE)
+#define JOURNAL_FORMAT_VERSION 1 // Stored in every record, a different layout starts over with an empty journal
+#define JOURNAL_NULL_VALUE INT16_MIN // A non-finite reading
+
+#define JOURNAL_FLAG_PUMP 0x01
+#define JOURNAL_FLAG_FOOD 0x02
+#define JOURNAL_FLAG_UPTIME 0x80 // Taken before the clock was known, the time is seconds since boot
+
+static_assert(JOURNAL_SECTOR_COUNT >= 2, "JOURNAL_SECTOR_COUNT needs one sector to erase while the others keep their records");
+
+enum JournalRecordType : uint8_t {
+	JOURNAL_RECORD_HEADER = 0x01,
+	JOURNAL_RECORD_SAMPLE = 0x02,
+	JOURNAL_RECORD_CURSOR = 0x03,
+	JOURNAL_RECORD_EMPTY = 0xFF // Erased flash
+};
+
+struct JournalRecord {
+	uint8_t type;
+	uint8_t flags; // Sample: JOURNAL_FLAG_*
+	uint16_t slot; // Cursor: slot of the first record not uploaded
+	uint32_t value; // Sample: time in seconds. Header: sector sequence. Cursor: sector sequence of the first record not uploaded
+	int16_t temperature; // Hundredths of \*C
+	int16_t humidity; // Hundredths of %
+	int16_t waterLevel;
+	uint8_t format;
+	uint8_t checksum; // CRC-8 of the bytes before it, a torn write doesn't match
+};
+
+static_assert(sizeof(JournalRecord) == JOURNAL_RECORD_SIZE, "JournalRecord must fill a slot exactly");
+
+struct JournalPosition {
+	uint32_t sequence;
+	uint16_t slot;
+};
+
+struct JournalSample {
+	uint32_t time; // Unix seconds
+	TelemetrySample sample;
+	JournalPosition end; // Right after the sample, where reading goes on once it is uploaded
+};
+
+// Only touched by the network side
+class TelemetryJournal {
+	public:
+		TelemetryJournal();
+
+		// Finds where appending and uploading left off, formats the partition if it holds no journal. False without flash
+		bool begin();
+		bool isMounted();
+
+		// Wall clock from the server, samples taken before carry their uptime and get converted on read
+		void setClock(uint32_t unixTime);
+		bool hasClock();
+
+		// False if the flash write failed
+		bool append(const TelemetrySample& sample);
+
+		bool hasPending(); // Samples that weren't uploaded yet
+
+		// Up to count of the oldest samples not uploaded yet, without moving past them
+		// Samples from an earlier boot that never learned the time are skipped and counted as dropped
+		size_t read(JournalSample* samples, size_t count);
+
+		// The server has the count samples before end, appends a cursor so it survives a reboot
+		bool commit(const JournalPosition& end, size_t count);
+
+		uint32_t getAppendedCount();
+		uint32_t getUploadedCount();
+		uint32_t getDroppedCount(); // Overwritten before upload or without a known time
+		uint32_t getEraseCount();
+
+	private:
+		bool readRecord(const JournalPosition& position, JournalRecord& record);
+		bool appendRecord(JournalRecord& record); // At the write position, starting the next sector if this one is full
+		bool startSector(uint32_t sequence);
+		void dropSector(uint32_t sequence); // Counts the samples lost when the oldest sector is erased
+		void advance(JournalPosition& position);
+		static bool isBefore(const JournalPosition& a, const JournalPosition& b);
+
+		const esp_partition_t* partition;
+		bool hasMounted;
+
+		JournalPosition writePosition;
+		JournalPosition readPosition; // First record not uploaded
+		JournalPosition bootPosition; // Write position at begin(), uptime samples before it are from an earlier boot
+		uint32_t oldestSequence; // Oldest sector still holding records
+
+		bool isClockSet;
+		uint32_t clockUnixTime;
+		ulong clockMillis;
+
+		uint32_t appendedCount;
+		uint32_t uploadedCount;
+		uint32_t droppedCount;
+		uint32_t eraseCount;
+};
\ No newline at end of file
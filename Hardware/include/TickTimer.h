@@ -10,6 +10,10 @@ class TickTimer {
 		ulong getTickMicros();
 		bool shouldTick();
 
+		ulong getLastTickMicros();
+		void setLastTickMicros(ulong last_micros);
+		ulong getNextTickMicros();
+
 	private:
 		ulong lastMicros;
 		ulong targetTickMicros;
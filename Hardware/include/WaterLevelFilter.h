@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+
+static_assert(WATER_LEVEL_WINDOW >= WATER_LEVEL_BURST && WATER_LEVEL_WINDOW <= 255, "WATER_LEVEL_WINDOW must hold a burst and fit in 255");
+
+// Raw ADC readings in, calibrated percent out: median of a ring of readings, then a moving average
+// Every call is bounded by WATER_LEVEL_WINDOW, nothing allocates
+class WaterLevelFilter {
+	public:
+		WaterLevelFilter();
+
+		void push(uint16_t raw); // One reading, 0 - 4095
+		void update(); // Feed the median of the ring to the moving average, once per burst
+
+		float getFiltered(); // Raw scale
+		float getPercent(); // 0 - 100
+		bool isFull(); // At WATER_LEVEL_FULL_PERCENT or above, until it drops WATER_LEVEL_FULL_HYSTERESIS below
+
+		// Piecewise linear through WATER_LEVEL_CALIBRATION
+		static float toPercent(float raw);
+
+	private:
+		uint16_t window[WATER_LEVEL_WINDOW];
+		uint8_t head;
+		uint8_t count;
+
+		float filtered;
+		bool hasFiltered;
+		float percent;
+		bool full;
+};
\ No newline at end of file
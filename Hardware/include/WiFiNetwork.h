@@ -3,40 +3,199 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <PicoWebsocket.h>
-#include <LiquidCrystal_I2C.h>
+#include <lwip/dns.h>
+#include <atomic>
+#include "LCDRenderer.h"
 #include <ArduinoJson.h>
 #include "config.h"
+#include "FrameRing.h"
+#include "BinaryProtocol.h"
+#include "InboundMessage.h"
+#include "TelemetryDelta.h"
+#include "RequestWindow.h"
+#include "TelemetryJournal.h"
+#include "FeedingSchedule.h"
+
+#if ENABLE_METRICS == true
+	#include "Metrics.h"
+#endif
+
+#define COMMAND_PUSH_VERSION 1 // Offered at /login with WS_COMMAND_PUSH, mirrored in Backend/src/actuator_command.ts
+
+static_assert(WS_RX_BUFFER_SIZE >= BINARY_REPLY_HEADER_SIZE + BINARY_REPLY_MAX_PAYLOAD, "WS_RX_BUFFER_SIZE is too small for a binary reply");
+static_assert(ENABLE_DUAL_CORE == true, "WiFiNetwork needs ENABLE_DUAL_CORE, the WebSocket upgrade waits up to WS_UPGRADE_TIMEOUT and would hold up the control loop");
+
+// Steps to a usable connection, each tick() only looks at the one in flight and moves on when it is done
+enum ConnectionState : uint8_t {
+	CONNECTION_BACKOFF, // Waiting out the delay after a failed attempt or a lost connection
+	CONNECTION_RESOLVE, // DNS lookup in flight
+	CONNECTION_CONNECT, // TCP handshake in flight on a non-blocking socket
+	CONNECTION_UPGRADE, // Socket connected, the WebSocket upgrade is next
+	CONNECTION_LOGIN, // WebSocket open, /login sent or about to be
+	CONNECTION_READY // Logged in
+};
+
+// Takes over a socket connected without blocking, so PicoWebsocket's connect() only does the upgrade on it
+class AdoptedClient : public WiFiClient {
+	public:
+		AdoptedClient();
+		void adopt(int fd);
+		int connect(const char* host, uint16_t port) override; // 1 once after adopt(), never connects on its own
+
+	private:
+		bool isAdopted;
+};
 
 class WiFiNetwork {
 	public:
 		WiFiNetwork(const char* ssid, const char* password);
 		void setup();
-		void loop();
+		ulong loop(); // Returns the micros between runs wanted from now on
 		bool isConnected();
 		bool isServerConnected();
+
+		// As of the end of the last loop(), the only connection state safe to read from a task on the other core
+		bool wasConnected();
+		bool wasServerConnected();
+
 		bool isLoggedIn();
+		bool isBinaryProtocol(); // The server accepted binary frames at /login
+		bool isCommandPush(); // The server accepted to push actuator commands at /login
+		bool isTelemetryDelta(); // The server accepted change-driven /iot/post_data at /login
+		bool isHistoryUpload(); // The server accepted journaled samples at /iot/post_history at /login
+		uint32_t getLoginCount(); // Goes up with every successful /login, e.g. to tell a reconnect
+		uint32_t getKeyframeRequestCount(); // Goes up with every delta the server dropped as out of sequence
+		ConnectionState getConnectionState();
+		uint32_t getConnectAttemptCount(); // Attempts since boot, each from DNS or the cached address on to /login
+		ulong getLastTimeToReady(); // Millis from finding the connection lost, or from the first attempt, to the /login reply
+		ulong getMaxTimeToReady();
 		bool sendJSON(JsonDocument& doc);
 		bool sendJSON(JsonDocument& doc, bool bypass_login_check);
-		void setOnMessageCallback(void (*callback)(const JsonDocument& doc));
+
+		// Write a frame straight into the outbound ring, WS_TX_FRAME_SIZE bytes. nullptr if it can't be sent now
+		char* beginFrame(bool bypass_login_check);
+		void commitFrame(size_t size);
+		void abortFrame();
+
+		// Same, for a request that expects a reply. The request ID is added to the frame, false if it was dropped
+		bool canSendRequest(); // The request window has room
+		bool isRequestPending(uint32_t endpointHash);
+		bool commitRequest(size_t size, uint32_t endpointHash);
+		void setOnMessageCallback(void (*callback)(const InboundMessage& message));
+		void setOnBinaryMessageCallback(void (*callback)(const BinaryReply& reply));
+		void setActuatorCounts(uint8_t feeders, uint8_t pumps); // Sent at /login, the server keeps a state per actuator ID
+		void setScheduleRevision(uint32_t revision); // Of the feeding schedule in flash, offered at /login so the server only pushes a newer one
+		FrameRing& getOutboundRing();
+		RequestWindow& getRequestWindow();
+
+		#if ENABLE_TELEMETRY_JOURNAL == true
+			// Samples taken while offline, uploaded after /login as far as the request window has room to spare
+			TelemetryJournal& getJournal();
+		#endif
+
+		#if ENABLE_LCD_OUTPUT == true
+			// Shared with the status screen, the connect animation covers its first row while WiFi is down
+			// The status screen is composed by the control loop, so the animation only goes through LCDRenderer::setOverlay()
+			void setLCDRenderer(LCDRenderer* lcdRenderer);
+		#endif
 		
 	private:
 		void tick();
+		void publishStatus(bool isWiFiConnected);
+
+		// Connection steps, none of them waits on the network except the upgrade, bounded by WS_UPGRADE_TIMEOUT, which is why ENABLE_WIFI needs ENABLE_DUAL_CORE
+		void startAttempt();
+		void pollResolve();
+		void beginConnect();
+		void pollConnect();
+		void upgrade();
+		void failAttempt(const char* reason);
+		void dropConnection(); // A connection that was ready is gone, the next attempt follows WS_BACKOFF_MIN
+		void closeSession();
+		void startBackoff();
+		void enterState(ConnectionState state);
+		static void startResolve(void* arg); // Run on the lwIP thread through tcpip_callback(), the raw API isn't safe from other tasks
+		static void onServerResolved(const char* name, const ip_addr_t* address, void* arg); // Called from the lwIP thread
+
 		void handleWebSocket();
+		void receiveAvailable();
+
+		// All of them return false if the connection was dropped
+		bool handleInboundMessage(size_t& consumed); // consumed is 0 until a whole message has arrived
+		bool handleJsonReply(char* text, size_t size);
+		bool handleBinaryReply(const BinaryReply& reply);
+		bool retransmitExpired();
+
+		#if ENABLE_TELEMETRY_JOURNAL == true
+			void backfillJournal();
+		#endif
+
+		// False for a reply whose request was answered already, e.g. after a retransmit
+		bool matchReply(uint16_t requestId, uint32_t endpointHash);
+
+		void (*messageCallback)(const InboundMessage& message);
+		void (*binaryMessageCallback)(const BinaryReply& reply);
 
-		void (*messageCallback)(const JsonDocument& doc);
+		FrameRing outboundRing;
+		char* writingFrame; // Returned by the last beginFrame()
+		RequestWindow requestWindow;
 
-		char* writeBuffer;
-		size_t writeBufferSize = 0;
+		// Inbound bytes until a whole reply is in, parsed where they are
+		char rxBuffer[WS_RX_BUFFER_SIZE + 1];
+		size_t rxLength;
 
 		const char* ssid;
 		const char* password;
-		WiFiClient wifiClient;
+		AdoptedClient wifiClient;
 		PicoWebsocket::Client ws;
 
-		bool hasLoggedIn;
+		ConnectionState state;
+		ulong stateMillis; // When the current state was entered
+		ulong backoffMillis;
+		uint8_t failureCount; // Attempts in a row that didn't get to /login
+		int socketFd; // While the TCP handshake is in flight, -1 otherwise
+
+		// Last DNS answer, reused for WS_DNS_CACHE_TIME
+		bool hasServerAddress;
+		uint32_t serverAddress; // IPv4, network byte order
+		ulong resolvedMillis;
+		std::atomic<uint8_t> resolveResult; // Published by the lwIP thread after resolvedAddress
+		std::atomic<uint32_t> resolvedAddress;
+
+		bool isReconnecting; // Counting the time to ready
+		ulong lostMillis;
+
+		// Also read by the status report on the control core
+		std::atomic<ulong> lastTimeToReady;
+		std::atomic<ulong> maxTimeToReady;
+		std::atomic<uint32_t> connectAttemptCount;
+		std::atomic<bool> publishedWiFiConnected;
+		std::atomic<bool> publishedServerConnected;
+
 		bool hasSentLoginRequest;
+		bool useBinaryProtocol;
+		bool useCommandPush;
+		bool useTelemetryDelta;
+		bool useHistoryUpload;
+		uint32_t loginCount;
+		uint32_t keyframeRequestCount;
+		uint8_t feederCount;
+		uint8_t pumpCount;
+		uint32_t scheduleRevision;
+
+		#if ENABLE_TELEMETRY_JOURNAL == true
+			TelemetryJournal journal;
+			JournalPosition backfillEnd; // Of the batch in flight
+			size_t backfillCount;
+			ulong lastBackfillTime;
+		#endif
+
+		ulong tickIntervalMicros;
+
+		uint8_t connectAnimationFrame; // Dots after WIFI_CONNECT_TEXT
 
 		#if ENABLE_LCD_OUTPUT == true
-			LiquidCrystal_I2C lcd;
+			LCDRenderer* lcdRenderer;
+			bool isOverlayShown; // Until the renderer took clearOverlay()
 		#endif
 };
\ No newline at end of file
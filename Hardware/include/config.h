@@ -1,21 +1,74 @@
+#define SCHEDULER_MAX_TASKS 10
+#define SCHEDULER_SERIAL_STATS false // Print per-task period, jitter and overruns with the status report
+
+#define ENABLE_METRICS true // Latency histograms of loop(), the network, the WebSocket and the servo PWM, and of how late every scheduler task starts
+#define METRICS_SUB_BUCKET_BITS 3 // 8 buckets per power of two, a value is kept within 12.5 %
+#define METRICS_MAX_VALUE_BITS 22 // Up to 4.2 seconds in micros, anything longer counts in the last bucket
+#define METRICS_REPORT_INTERVAL 1800000000 // 30 minutes between /iot/metrics reports, sent one frame per second. Below 35 minutes, deadlines are signed 32-bit micros
+#define METRICS_SERIAL_STATS false // Print the histograms with the status report
+
+#define ENABLE_DUAL_CORE true // Run WiFiNetwork in its own task, the control loop keeps the Arduino loop() core to itself. Required by ENABLE_WIFI, see WS_UPGRADE_TIMEOUT
+#define NETWORK_TASK_CORE 0 // PRO_CPU, shared with the WiFi driver
+#define NETWORK_TASK_STACK_SIZE 8192
+#define NETWORK_TASK_PRIORITY 1
+#define TASK_QUEUE_SIZE 8 // Slots in each queue between the network side and the control loop, power of two
+
+#define ACTUATOR_MAX_COUNT 32 // Feeders and pumps each, their states travel as bitmasks of actuator IDs
+
 #define ENABLE_SERVO true
 #define SERVO1_PIN GPIO_NUM_23
+#define FEEDER_PINS { SERVO1_PIN } // One food servo per bowl, the position in the list is the feeder ID
 #define SERVO_SERIAL_DEBUG false
+#define SERVO_HARDWARE_PWM true // Generate pulses with the LEDC peripheral, false to bit-bang them in the loop
+#define SERVO_PWM_FREQUENCY 50 // Hz
+#define SERVO_PWM_RESOLUTION 16 // bits
 #define SERVO_OPEN_TIMEOUT 300 // 0.3 second
 #define SERVO_OPEN_ANGLE 135
 #define SERVO_CLOSE_ANGLE 180
+#define SERVO_CALIBRATION { 470, 2540, 4, false } // Pulse at 0 and at 180 degrees and deadband in microseconds, whether the servo is mounted reversed
+#define SERVO_CALIBRATIONS { SERVO_CALIBRATION } // By feeder ID like FEEDER_PINS, feeders past the list use SERVO_CALIBRATION
+#define SERVO_VELOCITY 450 // Degrees per second the servo is ramped at towards a new angle, 0 jumps straight there
+
+#define ENABLE_FEEDING_SCHEDULE true // Feed at set times of the week from a table kept in flash, also while the server is unreachable
+#define SCHEDULE_MAX_ENTRIES 24 // Feeding times in the table, it is pushed whole at 12 characters each so it has to fit WS_RX_BUFFER_SIZE
+#define SCHEDULE_LATE_LIMIT 120 // Seconds a feed may run late, e.g. after a stall or a clock jump, before it is skipped instead
+#define SCHEDULE_PARTITION_LABEL JOURNAL_PARTITION_LABEL // Two sectors right after the journal ring
 
 #define ENABLE_DHT true
 #define DHT_PIN GPIO_NUM_19
+#define DHT_READ_INTERVAL 5000000 // 5 seconds
+#define DHT_EDGE_CAPTURE true // Time the frame edges from a pin interrupt while the loop goes on, instead of the blocking library read
 
 #define ENABLE_WATER_LEVEL_SENSOR true
 #define WATER_LEVEL_SENSOR_PIN GPIO_NUM_36
+#define WATER_LEVEL_SAMPLE_INTERVAL 200000 // 0.2 second between bursts
+#define WATER_LEVEL_BURST 5 // ADC readings per burst
+#define WATER_LEVEL_WINDOW 15 // Last readings the median is taken over, 3 bursts
+#define WATER_LEVEL_EMA_ALPHA 0.25f // Weight of each new median in the moving average
+#define WATER_LEVEL_CALIBRATION { 0, 1030, 1559, 1988, 2363, 2702, 3014, 3306, 3582, 3844, 4095 } // Raw reading at 0, 10, ... 100 %, the sensor saturates early
+#define WATER_LEVEL_FULL_PERCENT 50 // The pump won't start at or above this level
+#define WATER_LEVEL_FULL_HYSTERESIS 5 // % below WATER_LEVEL_FULL_PERCENT the level has to drop before the bowl stops counting as full
 
 #define ENABLE_WATER_PUMP true
 #define WATER_PUMP_PIN GPIO_NUM_18
+#define WATER_PUMP_PINS { WATER_PUMP_PIN } // The position in the list is the pump ID. All pumps fill the one reservoir WATER_LEVEL_SENSOR_PIN measures, so one PumpController fits the level to whichever run and its stop, fault or holdoff applies to all of them
 #define WATER_PUMP_ENABLE_TIMEOUT 45000 // 45 seconds
+#define WATER_PUMP_CLOSED_LOOP true // Stop early by the fill rate fitted to the level, so the water still coming lands on WATER_LEVEL_FULL_PERCENT, and stop on a dry run or a stuck sensor. false stops once the level reads full
+#define WATER_PUMP_DEAD_TIME 2000 // ms after starting before the level is expected to rise, the hose fills and the sensor lags
+#define WATER_PUMP_RATE_SAMPLES 8 // Level samples the fill rate is fitted to
+#define WATER_PUMP_RATE_SAMPLE_INTERVAL 500 // ms between them
+#define WATER_PUMP_MIN_RATE 0.2f // % per second, pumping any slower is a dry run
+#define WATER_PUMP_COAST_INITIAL 2.0f // Seconds of fill rate the level still rises by after a stop, learned from every stop after
+#define WATER_PUMP_COAST_MAX 10.0f
+#define WATER_PUMP_SETTLE_TIME 8000 // ms after a stop the level is watched for its peak
+#define WATER_PUMP_FAULT_HOLDOFF 600000 // 10 minutes requests are ignored for after a dry run. After a stuck sensor they are until the level moves
 
 #define ENABLE_LCD_OUTPUT true
+#define I2C_ASYNC true // Queue LCD transactions and carry them out in the i2c task, false runs them from the caller like the library does
+#define I2C_QUEUE_SIZE 32 // Transactions waiting for the bus, power of two
+#define I2C_DRAIN_INTERVAL 10000 // 10 ms between runs of the i2c task while transactions are waiting
+#define I2C_IDLE_INTERVAL 100000 // 0.1 s once the queue is empty, the longest a presented screen waits
+#define I2C_DRAIN_BUDGET 5000 // 5 ms of bus time per run of the i2c task, less if the next control task is due sooner
 #define LCD_COLUMNS_SIZE 16
 #define LCD_ROWS_SIZE 2
 #define LCD_TEMP_FORMAT "T %.1f\xDF""C"
@@ -30,4 +83,32 @@
 #define WS_SERVER_HW_ID "petfeeder-esp32dev-example"
 #define WS_SERVER_ADDRESS "example.com"
 #define WS_SERVER_PORT 8080
-#define WS_RTX_ON true // Enable WebSocket Real-Time Exchange (RTX) mode
\ No newline at end of file
+#define WS_RTX_ON true // Enable WebSocket Real-Time Exchange (RTX) mode
+#define WS_TX_RING_SLOTS 8 // Outbound frame slots, power of two, one always stays empty
+#define WS_TX_FRAME_SIZE 256 // Largest outbound frame in bytes
+#define WS_TX_OVERWRITE_OLDEST false // When the ring is full drop the oldest queued frame instead of the new one
+#define WS_BINARY_PROTOCOL true // Offer fixed-layout frames for /iot/post_data and /iot/get_data at /login, JSON stays in use if the server declines
+#define WS_COMMAND_PUSH true // Offer to take actuator commands pushed by the server at /login, /iot/get_data is polled if the server declines
+#define WS_RX_BUFFER_SIZE 512 // Largest inbound reply in bytes, a larger one drops the connection
+#define WS_TELEMETRY_DELTA true // Offer change-driven /iot/post_data at /login, every report is a full frame if the server declines
+#define TELEMETRY_TEMPERATURE_DEADBAND 0.5f // \*C
+#define TELEMETRY_HUMIDITY_DEADBAND 2.0f // %
+#define TELEMETRY_WATER_LEVEL_DEADBAND 2 // %
+#define TELEMETRY_KEYFRAME_INTERVAL 30000 // 30 seconds, every field is reported at least this often
+#define WS_REQUEST_WINDOW 4 // Requests in flight at once, each keeps a copy of its frame to send it again
+#define WS_REQUEST_TIMEOUT 2000 // 2 seconds without reply until a request is sent again
+#define WS_REQUEST_RETRIES 3 // Retransmissions of one request before the connection is dropped
+#define WS_DNS_CACHE_TIME 600000 // 10 minutes a resolved address is reused for, by reconnects and retries alike
+#define WS_RESOLVE_TIMEOUT 5000 // 5 seconds for the DNS answer
+#define WS_CONNECT_TIMEOUT 5000 // 5 seconds for the TCP handshake, polled without blocking
+#define WS_UPGRADE_TIMEOUT 1000 // 1 second for the reply to the WebSocket upgrade, the only step that waits. PicoWebsocket sends the request and reads the reply in one connect() call, so it only runs in the network task and ENABLE_WIFI won't build without ENABLE_DUAL_CORE
+#define WS_LOGIN_TIMEOUT 5000 // 5 seconds for the /login reply before the connection is dropped
+#define WS_CONNECT_POLL_INTERVAL 20000 // 20 ms between looks at a lookup or handshake in flight
+#define WS_BACKOFF_MIN 1000 // 1 second before the first retry, doubled with every failed attempt in a row
+#define WS_BACKOFF_MAX 60000 // 1 minute at most between attempts
+#define WS_BACKOFF_JITTER 50 // Up to this % is taken off every delay at random, so devices that lost the server together don't return together
+#define ENABLE_TELEMETRY_JOURNAL true // Keep samples taken while offline in flash and upload them after the next /login
+#define JOURNAL_PARTITION_LABEL "spiffs" // Data partition the journal writes to, the feeding schedule keeps its table after it
+#define JOURNAL_SECTOR_COUNT 16 // 4 KB flash sectors in the ring, 255 records each
+#define JOURNAL_SAMPLE_INTERVAL 60000 // 1 minute between samples kept while offline
+#define JOURNAL_BACKFILL_INTERVAL 500 // 0.5 second at least between uploaded batches, one at a time
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+// glibc's own entry points, so malloc() can be wrapped without dlsym()
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+extern "C" void __libc_free(void* pointer);
+
+namespace NativeBench {
+	std::atomic<uint64_t> AllocationCount(0);
+
+	uint64_t getAllocationCount() {
+		return AllocationCount.load(std::memory_order_relaxed);
+	}
+}
+
+extern "C" void* malloc(size_t size) {
+	NativeBench::AllocationCount.fetch_add(1, std::memory_order_relaxed);
+	return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+	NativeBench::AllocationCount.fetch_add(1, std::memory_order_relaxed);
+	return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) {
+	NativeBench::AllocationCount.fetch_add(1, std::memory_order_relaxed);
+	return __libc_realloc(pointer, size);
+}
+
+extern "C" void free(void* pointer) {
+	__libc_free(pointer);
+}
+
+// operator new goes through malloc() in libstdc++, but it is replaceable on its own too
+void* operator new(size_t size) {
+	void* pointer = malloc(size ? size : 1);
+	if (pointer == nullptr)
+		throw std::bad_alloc();
+
+	return pointer;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept {
+	free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	free(pointer);
+}
+
+void operator delete(void* pointer, size_t size) noexcept {
+	free(pointer);
+}
+
+void operator delete[](void* pointer, size_t size) noexcept {
+	free(pointer);
+}
\ No newline at end of file
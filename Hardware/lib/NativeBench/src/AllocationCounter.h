@@ -0,0 +1,7 @@
+#pragma once
+#include <stdint.h>
+
+namespace NativeBench {
+	// Counts every malloc() and operator new in the process, including the ones made by libraries
+	uint64_t getAllocationCount();
+}
\ No newline at end of file
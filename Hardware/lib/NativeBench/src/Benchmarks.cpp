@@ -0,0 +1,1353 @@
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include <ArduinoJson.h>
+#include <hal/gpio_types.h>
+#include <chrono>
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "config.h"
+#include "AllocationCounter.h"
+#include "TelemetryEncoder.h"
+#include "BinaryProtocol.h"
+#include "InboundMessage.h"
+#include "DHTFrame.h"
+#include "WaterLevelFilter.h"
+#include "Metrics.h"
+#include "Scheduler.h"
+#include "RequestWindow.h"
+#include "TickTimer.h"
+#include "InputRelated.h"
+#include "BusinessLogic.h"
+#include "ActuatorRegistry.h"
+
+#if ENABLE_FEEDING_SCHEDULE == true
+	#include "FeedingSchedule.h"
+#endif
+
+#if ENABLE_WATER_LEVEL_SENSOR == true && WATER_PUMP_CLOSED_LOOP == true
+	#include "PumpController.h"
+#endif
+
+#if ENABLE_WIFI == true
+	#include "WiFiNetwork.h"
+
+	extern WiFiNetwork wifiNetwork;
+#endif
+
+#if ENABLE_SERVO == true
+	#include "ServoManager.h"
+	#include "ServoPulse.h"
+#endif
+
+#if ENABLE_WATER_LEVEL_SENSOR == true
+	extern Input::WaterLevel waterLevel1;
+#endif
+
+#if ENABLE_LCD_OUTPUT == true
+	#include "LCDRenderer.h"
+
+	extern LiquidCrystal_I2C lcd;
+	extern LCDRenderer lcdRenderer;
+	extern I2CBus i2cBus;
+	void LCD_StatusReport();
+#endif
+
+void setup();
+void loop();
+
+extern BusinessLogic businessLogic;
+extern Scheduler scheduler;
+extern ActuatorRegistry actuators;
+
+#define BENCH_REGRESSION_PERCENT 25.0 // Slower than the baseline by more than this is a regression
+#define BENCH_NOISE_FLOOR_NANOS 5.0 // Differences below this are timer noise, whatever the percentage
+#define BENCH_ROUNDS 10
+#define BENCH_BASELINE_RUNS 5 // Processes the suite runs in when comparing with a baseline, the host slows down for seconds at a time
+#define BENCH_CONFIRM_ATTEMPTS 2 // Times as many runs again before a regression counts
+#define BENCH_CONFIRM_PAUSE 2 // Seconds before each of them
+
+namespace NativeBench {
+	struct Result {
+		const char* name;
+		uint64_t operations;
+		double nanosPerOperation;
+		double allocationsPerOperation;
+		double noisePercent; // How much slower the median run was, 0 for a single run
+		double ratio; // nanosPerOperation over the calibration of the same run, what a baseline is compared by
+	};
+
+	// Takes every frame without answering, except /login so the firmware starts sending
+	class SinkServer : public NativeHAL::WebSocketServer {
+		public:
+			uint64_t frames = 0;
+			uint64_t bytes = 0;
+
+			bool onConnect(NativeHAL::WebSocketConnection* connection, const char* host, uint16_t port) override {
+				this->connection = connection;
+				return true;
+			}
+
+			void onMessage(NativeHAL::WebSocketConnection* connection, const uint8_t* data, size_t size) override {
+				this->frames++;
+				this->bytes += size;
+
+				if (memmem(data, size, "\"/login\"", 8) == nullptr)
+					return;
+
+				static const char Reply[] = "{\"status\":\"success\",\"code\":200,\"endpoint\":\"/login\",\"data\":{}}";
+				connection->send((const uint8_t*)Reply, sizeof(Reply) - 1);
+				connection->send((const uint8_t*)"\r", 1);
+			}
+
+			void onDisconnect(NativeHAL::WebSocketConnection* connection) override {
+				if (connection == this->connection)
+					this->connection = nullptr;
+			}
+
+			// Unsolicited reply with the "\r" frame index.ts sends after it
+			void push(const char* text) {
+				if (this->connection == nullptr)
+					return;
+
+				this->connection->send((const uint8_t*)text, strlen(text));
+				this->connection->send((const uint8_t*)"\r", 1);
+			}
+
+			// Drop the connection without calling back into the firmware, before either side is destroyed
+			void shutdown() {
+				if (this->connection != nullptr)
+					this->connection->close();
+
+				this->connection = nullptr;
+			}
+
+		private:
+			NativeHAL::WebSocketConnection* connection = nullptr;
+	};
+
+	SinkServer sink;
+	std::vector<Result> Results; // Everything printed, for --json and --baseline
+
+	void PrintResult(const Result& result) {
+		fprintf(stderr, "[bench] %-24s %10llu ops %10.1f ns/op %8.2f allocs/op\n",
+			result.name,
+			(unsigned long long)result.operations,
+			result.nanosPerOperation,
+			result.allocationsPerOperation);
+
+		Results.push_back(result);
+	}
+
+	// The operations are split into rounds and the fastest one counts, the others were interrupted or ran before the CPU clocked up
+	template <typename Function>
+	Result Measure(const char* name, uint64_t operations, Function function) {
+		uint64_t AllocationsBefore = getAllocationCount();
+		double FastestNanos = 0.0;
+		uint64_t Done = 0;
+
+		for (uint64_t Round = 0; Round < BENCH_ROUNDS; Round++) {
+			uint64_t Count = operations / BENCH_ROUNDS + (Round < operations % BENCH_ROUNDS ? 1 : 0);
+			if (Count == 0)
+				continue;
+
+			auto Start = std::chrono::steady_clock::now();
+
+			for (uint64_t i = 0; i < Count; i++) {
+				function();
+			}
+
+			auto End = std::chrono::steady_clock::now();
+			double Nanos = std::chrono::duration<double, std::nano>(End - Start).count() / Count;
+			if (Done == 0 || Nanos < FastestNanos)
+				FastestNanos = Nanos;
+
+			Done += Count;
+		}
+
+		uint64_t Allocations = getAllocationCount() - AllocationsBefore;
+
+		Result result;
+		result.name = name;
+		result.operations = operations;
+		result.nanosPerOperation = FastestNanos;
+		result.allocationsPerOperation = Allocations / (double)operations;
+		result.noisePercent = 0.0;
+		result.ratio = 0.0;
+		return result;
+	}
+
+	// Boot the firmware on the simulated clock until it is logged in to the sink
+	bool StartFirmware() {
+		NativeHAL::setSerialQuiet(true);
+		NativeHAL::setWebSocketServer(&sink);
+		#if ENABLE_DHT == true
+			NativeHAL::setDHTPin(DHT_PIN);
+		#endif
+
+		setup();
+
+		#if ENABLE_WIFI == true
+			uint64_t TimeoutMicros = NativeHAL::nowMicros() + 60000000ULL;
+			while (!wifiNetwork.isLoggedIn() && NativeHAL::nowMicros() < TimeoutMicros) {
+				loop();
+				NativeHAL::advanceMicros(50);
+			}
+
+			return wifiNetwork.isLoggedIn();
+		#else
+			return false;
+		#endif
+	}
+
+	// The same report built as a JsonDocument and with the fixed-schema encoder, into a stack buffer
+	void BenchTelemetryEncode(uint64_t iterations) {
+		TelemetrySample Sample = { 27.5f, 61.0f, 42, 0, 0 };
+		char Buffer[WS_TX_FRAME_SIZE];
+		size_t JsonSize = 0;
+		size_t EncodedSize = 0;
+
+		PrintResult(Measure("telemetry_json", iterations, [&]() {
+			JsonDocument doc;
+			doc["key"] = "/iot/post_data";
+			doc["data"]["te"] = Sample.temperature;
+			doc["data"]["hu"] = Sample.humidity;
+			doc["data"]["wa"] = Sample.waterLevel;
+			doc["data"]["PuEn"] = Sample.pumpMask;
+			doc["data"]["DiFo"] = Sample.feederMask;
+			JsonSize = serializeJson(doc, Buffer, sizeof(Buffer));
+		}));
+
+		PrintResult(Measure("telemetry_encoder", iterations, [&]() {
+			EncodedSize = TelemetryEncoder_encode(Sample, Buffer, sizeof(Buffer));
+			asm volatile("" : : "r"(Buffer) : "memory"); // Keep the writes from being optimized away
+		}));
+
+		size_t BinarySize = 0;
+		PrintResult(Measure("telemetry_binary", iterations, [&]() {
+			BinarySize = BinaryProtocol_encodeTelemetry(Sample, (uint8_t*)Buffer, sizeof(Buffer));
+			asm volatile("" : : "r"(Buffer) : "memory");
+		}));
+
+		fprintf(stderr, "[bench]   frame: %zu bytes as JSON, %zu bytes encoded, at most %zu, %zu bytes binary\n",
+			JsonSize, EncodedSize, (size_t)TELEMETRY_FRAME_MAX_SIZE, BinarySize);
+	}
+
+	// A /iot/get_data reply as index.ts sends it in either protocol, down to an ActuatorCommand
+	void BenchReplyDecode(uint64_t iterations) {
+		static const char JsonReply[] = "{\"status\":\"success\",\"code\":200,\"data\":{\"shouldEnableWaterPump\":false,\"shouldDispenseFood\":true,\"pumps\":0,\"feeders\":1},\"endpoint\":\"/iot/get_data\"}";
+		static const uint8_t BinaryFrame[] = { BINARY_PROTOCOL_MAGIC, BINARY_GET_DATA, 0, 0, 200, 0, BINARY_ACTUATOR_COMMAND_SIZE, 0, 0, 0, 0, 1, 0, 0, 0 };
+		ActuatorCommand Command;
+
+		PrintResult(Measure("reply_json", iterations, [&]() {
+			JsonDocument doc;
+			deserializeJson(doc, JsonReply, sizeof(JsonReply) - 1);
+			Command.pumpMask = doc["data"]["pumps"].as<uint32_t>();
+			Command.feederMask = doc["data"]["feeders"].as<uint32_t>();
+			asm volatile("" : : "r"(&Command) : "memory");
+		}));
+
+		PrintResult(Measure("reply_binary", iterations, [&]() {
+			BinaryReply Reply;
+			BinaryProtocol_decodeReplyHeader(BinaryFrame, Reply);
+			Reply.payload = BinaryFrame + BINARY_REPLY_HEADER_SIZE;
+			BinaryProtocol_decodeActuatorCommand(Reply, Command);
+			asm volatile("" : : "r"(&Command) : "memory");
+		}));
+
+		// The JSON reply is followed by a "\r" frame, sizeof() counts it in place of the terminator
+		fprintf(stderr, "[bench]   reply: %zu bytes as JSON, %zu bytes binary\n", sizeof(JsonReply), sizeof(BinaryFrame));
+	}
+
+	// Replies as recorded from Backend/src/index.ts, test/test_inbound_message checks what they parse to
+	const char* const RecordedReplies[] = {
+		"{\"status\":\"success\",\"code\":200,\"data\":{\"message\":\"Connected as IoT device with HWID: petfeeder-esp32dev-example\"},\"endpoint\":\"/login\"}",
+		"{\"status\":\"success\",\"code\":200,\"data\":{\"shouldEnableWaterPump\":false,\"shouldDispenseFood\":true,\"pumps\":0,\"feeders\":1},\"endpoint\":\"/iot/get_data\"}",
+		"{\"code\":200,\"status\":\"success\",\"data\":{\"message\":\"Data received successfully\"},\"endpoint\":\"/iot/post_data\"}",
+		"{\"status\":\"error\",\"code\":404,\"error_message\":\"Route \\\"/iot/nope\\\" not found\",\"endpoint\":\"/iot/nope\"}"
+	};
+
+	#define RECORDED_REPLY_COUNT (sizeof(RecordedReplies) / sizeof(RecordedReplies[0]))
+
+	// Every recorded reply through InboundMessage_parse(), copied first since parsing writes over the text
+	void BenchReplyParse(uint64_t iterations) {
+		char Buffer[WS_RX_BUFFER_SIZE + 1];
+		size_t Lengths[RECORDED_REPLY_COUNT];
+
+		for (size_t i = 0; i < RECORDED_REPLY_COUNT; i++) {
+			Lengths[i] = strlen(RecordedReplies[i]);
+		}
+
+		size_t Index = 0;
+		PrintResult(Measure("reply_parse", iterations, [&]() {
+			memcpy(Buffer, RecordedReplies[Index], Lengths[Index]);
+
+			InboundMessage Message;
+			bool IsParsed = InboundMessage_parse(Buffer, Lengths[Index], Message);
+			asm volatile("" : : "r"(IsParsed), "r"(&Message) : "memory");
+
+			Index = (Index + 1) % RECORDED_REPLY_COUNT;
+		}));
+
+		// And through ArduinoJson as the previous receive path did, for comparison
+		Index = 0;
+		PrintResult(Measure("reply_parse_json", iterations, [&]() {
+			JsonDocument doc;
+			deserializeJson(doc, RecordedReplies[Index], Lengths[Index]);
+			if (strcmp(doc["status"].as<const char*>(), "success") == 0 && doc["endpoint"] == "/iot/get_data")
+				asm volatile("" : : "r"(&doc) : "memory");
+
+			Index = (Index + 1) % RECORDED_REPLY_COUNT;
+		}));
+	}
+
+	// DHT11 answers as the edge interrupt timestamps them, with the datasheet pulse widths: 0 is 26-28 us high, 1 is 70 us
+	struct DHTWaveform {
+		const char* name;
+		uint8_t bytes[5];
+		uint32_t startMicros; // Of the release of the start signal
+		uint32_t zeroHighMicros;
+		uint32_t oneHighMicros;
+		uint32_t jitterMicros; // Added to or taken from every pulse in turn
+		int missedEdge; // Index of an edge the interrupt didn't see, -1 for none
+		size_t edgeLimit; // Capture window closed after this many edges
+		DHTFrameStatus status;
+		float temperature;
+		float humidity;
+	};
+
+	const DHTWaveform DHTWaveforms[] = {
+		{ "typical", { 60, 0, 27, 0, 87 }, 1000000, 27, 70, 0, -1, DHT_FRAME_MAX_EDGES, DHT_FRAME_OK, 27.0f, 60.0f },
+		{ "slow sensor", { 45, 0, 23, 4, 72 }, 5000000, 28, 74, 3, -1, DHT_FRAME_MAX_EDGES, DHT_FRAME_OK, 23.4f, 45.0f },
+		{ "below zero", { 31, 0, 5, 0x83, 0xA7 }, 9000000, 26, 68, 2, -1, DHT_FRAME_MAX_EDGES, DHT_FRAME_OK, -5.3f, 31.0f },
+		{ "micros() wraps", { 72, 0, 30, 1, 103 }, 0xFFFFFE00, 27, 70, 1, -1, DHT_FRAME_MAX_EDGES, DHT_FRAME_OK, 30.1f, 72.0f },
+		{ "bad checksum", { 60, 0, 27, 0, 88 }, 1000000, 27, 70, 0, -1, DHT_FRAME_MAX_EDGES, DHT_FRAME_BAD_CHECKSUM, 0.0f, 0.0f },
+		{ "missed edge", { 60, 0, 27, 0, 87 }, 1000000, 27, 70, 0, 40, DHT_FRAME_MAX_EDGES, DHT_FRAME_BAD_CHECKSUM, 0.0f, 0.0f },
+		{ "truncated", { 60, 0, 27, 0, 87 }, 1000000, 27, 70, 0, -1, 60, DHT_FRAME_TOO_FEW_EDGES, 0.0f, 0.0f }
+	};
+
+	#define DHT_WAVEFORM_COUNT (sizeof(DHTWaveforms) / sizeof(DHTWaveforms[0]))
+
+	// Release, response, 40 bits and the end of the frame, the way DHT11Sensor::onEdge() stores them
+	size_t BuildDHTEdges(const DHTWaveform& waveform, uint32_t* edges) {
+		uint32_t Times[DHT_FRAME_MAX_EDGES];
+		size_t Count = 0;
+		uint32_t Time = waveform.startMicros;
+		int Jitter = waveform.jitterMicros;
+
+		Times[Count++] = Time;
+		Time += 30;
+		Times[Count++] = Time;
+		Time += 80;
+		Times[Count++] = Time;
+		Time += 80;
+		Times[Count++] = Time;
+
+		for (int i = 0; i < DHT_FRAME_BITS; i++) {
+			bool Bit = waveform.bytes[i / 8] & (0x80 >> (i % 8));
+			Jitter = -Jitter;
+			Time += 50 + Jitter;
+			Times[Count++] = Time;
+			Time += (Bit ? waveform.oneHighMicros : waveform.zeroHighMicros) - Jitter;
+			Times[Count++] = Time;
+		}
+
+		Time += 50;
+		Times[Count++] = Time;
+
+		size_t Stored = 0;
+		for (size_t i = 0; i < Count && Stored < waveform.edgeLimit; i++) {
+			if ((int)i != waveform.missedEdge)
+				edges[Stored++] = Times[i];
+		}
+
+		return Stored;
+	}
+
+	// Every waveform through DHTFrame_decode(), both values come out of the one pass over the edges. test/test_dht_frame checks the values
+	void BenchDHTDecode(uint64_t iterations) {
+		uint32_t Edges[DHT_WAVEFORM_COUNT][DHT_FRAME_MAX_EDGES];
+		size_t Counts[DHT_WAVEFORM_COUNT];
+
+		for (size_t i = 0; i < DHT_WAVEFORM_COUNT; i++) {
+			Counts[i] = BuildDHTEdges(DHTWaveforms[i], Edges[i]);
+		}
+
+		size_t Index = 0;
+		PrintResult(Measure("dht_decode", iterations, [&]() {
+			DHTReading Reading;
+			DHTFrameStatus Status = DHTFrame_decode(Edges[Index], Counts[Index], Reading);
+			asm volatile("" : : "r"(Status), "r"(&Reading) : "memory");
+
+			Index = (Index + 1) % DHT_WAVEFORM_COUNT;
+		}));
+	}
+
+	// Level sensor readings around the pump cut-off, on the saturating sensor curve with ADC noise and the odd spike
+	struct WaterLevelTrace {
+		const char* name;
+		float startPercent;
+		float endPercent;
+		float noise; // Standard deviation in raw counts
+		float spikeRate;
+	};
+
+	const WaterLevelTrace WaterLevelTraces[] = {
+		{ "steady at cut-off", WATER_LEVEL_FULL_PERCENT, WATER_LEVEL_FULL_PERCENT, 35.0f, 0.01f },
+		{ "filling past cut-off", 30.0f, 60.0f, 35.0f, 0.01f },
+		{ "noisy, near cut-off", WATER_LEVEL_FULL_PERCENT - 2.0f, WATER_LEVEL_FULL_PERCENT - 2.0f, 80.0f, 0.05f }
+	};
+
+	#define WATER_LEVEL_TRACE_BURSTS 3000 // 10 minutes of bursts
+
+	// Same numbers on every run
+	uint32_t BenchRandomState = 1;
+	float BenchUniform() {
+		BenchRandomState ^= BenchRandomState << 13;
+		BenchRandomState ^= BenchRandomState >> 17;
+		BenchRandomState ^= BenchRandomState << 5;
+		return (BenchRandomState >> 8) / 16777216.0f;
+	}
+
+	float BenchGaussian(float deviation) {
+		return deviation * sqrtf(-2.0f * logf(BenchUniform() + 1e-7f)) * cosf(2.0f * (float)M_PI * BenchUniform());
+	}
+
+	// Every trace through the filter, compared with taking single readings at face value like before
+	void BenchWaterLevelFilter(uint64_t iterations) {
+		static uint16_t Readings[WATER_LEVEL_TRACE_BURSTS * WATER_LEVEL_BURST];
+
+		for (const WaterLevelTrace& Trace : WaterLevelTraces) {
+			for (size_t i = 0; i < WATER_LEVEL_TRACE_BURSTS * WATER_LEVEL_BURST; i++) {
+				float Percent = Trace.startPercent + (Trace.endPercent - Trace.startPercent) * i / (WATER_LEVEL_TRACE_BURSTS * WATER_LEVEL_BURST);
+				float Raw = 4095.0f * powf(Percent / 100.0f, 0.6f) + BenchGaussian(Trace.noise);
+				if (BenchUniform() < Trace.spikeRate)
+					Raw += (BenchUniform() < 0.5f ? -1.0f : 1.0f) * (300.0f + BenchUniform() * 500.0f);
+
+				Readings[i] = Raw < 0.0f ? 0 : (Raw > 4095.0f ? 4095 : (uint16_t)Raw);
+			}
+
+			WaterLevelFilter Filter;
+			uint32_t FilteredChanges = 0;
+			uint32_t RawChanges = 0;
+			bool WasFull = false;
+			bool WasRawFull = false;
+			float ErrorMax = 0.0f;
+
+			for (size_t Burst = 0; Burst < WATER_LEVEL_TRACE_BURSTS; Burst++) {
+				for (size_t i = 0; i < WATER_LEVEL_BURST; i++) {
+					Filter.push(Readings[Burst * WATER_LEVEL_BURST + i]);
+				}
+
+				Filter.update();
+
+				float Percent = Trace.startPercent + (Trace.endPercent - Trace.startPercent) * Burst / WATER_LEVEL_TRACE_BURSTS;
+				if (fabsf(Filter.getPercent() - Percent) > ErrorMax && Burst >= WATER_LEVEL_WINDOW / WATER_LEVEL_BURST)
+					ErrorMax = fabsf(Filter.getPercent() - Percent);
+
+				if (Filter.isFull() != WasFull && Burst > 0)
+					FilteredChanges++;
+
+				bool IsRawFull = round(Readings[Burst * WATER_LEVEL_BURST] / 4095.0f * 100.0f) >= WATER_LEVEL_FULL_PERCENT;
+				if (IsRawFull != WasRawFull && Burst > 0)
+					RawChanges++;
+
+				WasFull = Filter.isFull();
+				WasRawFull = IsRawFull;
+			}
+
+			fprintf(stderr, "[bench]   water trace \"%s\": full flag changed %u times filtered, %u times from single linear readings, filtered level off by %.1f%% at most\n",
+				Trace.name, FilteredChanges, RawChanges, ErrorMax);
+		}
+
+		// One burst and filter update per operation, over the last trace
+		WaterLevelFilter Filter;
+		size_t Burst = 0;
+		Result Update = Measure("water_filter", iterations, [&]() {
+			for (size_t i = 0; i < WATER_LEVEL_BURST; i++) {
+				Filter.push(Readings[Burst * WATER_LEVEL_BURST + i]);
+			}
+
+			Filter.update();
+			asm volatile("" : : "r"(&Filter) : "memory");
+			Burst = (Burst + 1) % WATER_LEVEL_TRACE_BURSTS;
+		});
+
+		PrintResult(Update);
+		fprintf(stderr, "[bench]   %.1f ns per reading, %d readings per burst\n", Update.nanosPerOperation / WATER_LEVEL_BURST, WATER_LEVEL_BURST);
+	}
+
+	// Fixed work that only depends on the host, every result is stored and compared as a ratio to it
+	// Integer arithmetic, loads from a table that fits the L1 cache and branches on the data, like the paths measured
+	Result MeasureCalibration(uint64_t iterations) {
+		static uint8_t Table[4096];
+		uint32_t State = 1;
+		for (size_t i = 0; i < sizeof(Table); i++) {
+			State ^= State << 13;
+			State ^= State >> 17;
+			State ^= State << 5;
+			Table[i] = State;
+		}
+
+		uint32_t Sum = 0;
+		Result Calibration = Measure("calibration", iterations, [&]() {
+			for (int i = 0; i < 64; i++) {
+				State ^= State << 13;
+				State ^= State >> 17;
+				State ^= State << 5;
+
+				uint8_t Byte = Table[(State + Sum) & (sizeof(Table) - 1)];
+				if (Byte & 1)
+					Sum += Byte;
+				else
+					Sum ^= State;
+			}
+
+			asm volatile("" : : "r"(Sum));
+		});
+
+		return Calibration;
+	}
+
+	// A 1 ms timer polled every 100 us, so every 10th poll ticks. The clock stands still and the last tick is moved back
+	// instead, stepping the host clock isn't timed. No wakeup hook is set, the hint costs the compare it does on target
+	void BenchTickTimer(uint64_t iterations) {
+		TickTimer Timer(1000);
+		Timer.init();
+		uint64_t Ticks = 0;
+
+		PrintResult(Measure("tick_timer", iterations, [&]() {
+			Timer.setLastTickMicros(Timer.getLastTickMicros() - 100);
+			if (Timer.shouldTick())
+				Ticks++;
+		}));
+
+		fprintf(stderr, "[bench]   %llu ticks in %llu polls\n", (unsigned long long)Ticks, (unsigned long long)iterations);
+	}
+
+	#if ENABLE_WATER_LEVEL_SENSOR == true
+	// What Task_WaterLevel does: a burst of ADC readings through the filter, then the rounded level
+	void BenchWaterLevelRead(uint64_t iterations) {
+		uint16_t Step = 0;
+
+		PrintResult(Measure("water_level_read", iterations, [&]() {
+			NativeHAL::setAnalogValue(WATER_LEVEL_SENSOR_PIN, 2000 + (Step++ & 63));
+			waterLevel1.update();
+			ushort Percent = waterLevel1.readPercent();
+			asm volatile("" : : "r"(Percent));
+		}));
+	}
+	#endif
+
+	// Not used by the firmware
+	const gpio_num_t FreePins[] = {
+		GPIO_NUM_2, GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_12, GPIO_NUM_13, GPIO_NUM_14, GPIO_NUM_15, GPIO_NUM_16,
+		GPIO_NUM_17, GPIO_NUM_25, GPIO_NUM_26, GPIO_NUM_27, GPIO_NUM_32, GPIO_NUM_33, GPIO_NUM_0
+	};
+
+	#define FREE_PIN_COUNT (sizeof(FreePins) / sizeof(FreePins[0]))
+
+	#if ENABLE_SERVO == true
+	// ServoManager_loop() over 1 to 16 feeders on the bit-bang backend, the one that writes the pulses from the loop
+	void BenchServoPWM(uint64_t iterations) {
+		static const char* const Names[] = { "servo_pwm_1", "servo_pwm_2", "servo_pwm_4", "servo_pwm_8", "servo_pwm_16" };
+
+		static ServoBitBangBackend BitBang;
+		uint8_t Registered = actuators.feeders.count;
+		size_t Added = 0;
+		ServoManager_setBackend(&BitBang);
+
+		for (size_t i = 0; i < sizeof(Names) / sizeof(Names[0]); i++) {
+			size_t Count = (size_t)1 << i;
+			while (actuators.feeders.count < Count && Added < FREE_PIN_COUNT) {
+				int Id = actuators.addFeeder(FreePins[Added], SERVO_OPEN_TIMEOUT);
+				BitBang.attach(actuators.feeders, Id);
+				ServoManager_rotate(Id, SERVO_OPEN_ANGLE + (int)Added);
+				Added++;
+			}
+
+			if (actuators.feeders.count != Count)
+				continue;
+
+			uint64_t PulseMicrosBefore = NativeHAL::nowMicros();
+			Result Refresh = Measure(Names[i], iterations, []() {
+				ServoManager_loop();
+			});
+
+			PrintResult(Refresh);
+			fprintf(stderr, "[bench]   %zu feeder%s: %.2f ms of pulses per 20 ms servo tick, the loop is held up that long\n",
+				Count, Count == 1 ? "" : "s", (NativeHAL::nowMicros() - PulseMicrosBefore) / 1000.0 / iterations);
+		}
+
+		actuators.feeders.count = Registered;
+		ServoManager_setBackend(ServoBackend_getDefault());
+	}
+	#endif
+
+	#if ENABLE_SERVO == true
+	// How ServoBackend_DegreesToMicros() turned an angle into a pulse before the tables
+	ulong FloatPulseMicros(int degrees) {
+		float TargetuS = 470.0f + (degrees * 11.5f);
+		return (ulong)TargetuS;
+	}
+
+	// An angle to a pulse through the table and the way it was computed before; test/test_servo_pulse checks the tables and the ramp
+	void BenchServoPulse(uint64_t iterations) {
+		int Degrees = 0;
+		PrintResult(Measure("servo_pulse_float", iterations, [&]() {
+			ulong Pulse = FloatPulseMicros(Degrees);
+			asm volatile("" : : "r"(Pulse));
+			Degrees = Degrees == SERVO_MAX_DEGREES ? 0 : Degrees + 1;
+		}));
+
+		PrintResult(Measure("servo_pulse_lut", iterations, [&]() {
+			uint16_t Pulse = ServoPulse_lookup(0, Degrees);
+			asm volatile("" : : "r"(Pulse));
+			Degrees = Degrees == SERVO_MAX_DEGREES ? 0 : Degrees + 1;
+		}));
+	}
+	#endif
+
+	// pre_actuator_loop() with 1 to 32 feeders and as many pumps, all of them running
+	// A command for every actuator comes in each tick and the clock stands still, so no timeout ends a run
+	void BenchActuatorLoop(uint64_t iterations) {
+		static const char* const Names[] = { "actuator_loop_1", "actuator_loop_8", "actuator_loop_32" };
+		static const uint8_t Counts[] = { 1, 8, 32 };
+
+		#if ENABLE_SERVO == true
+			static ServoBitBangBackend BitBang; // write() only keeps the angle, the figure is the loop itself and the relay writes
+			ServoManager_setBackend(&BitBang);
+		#endif
+
+		bool WasWaterFull = businessLogic.isWaterFull;
+		businessLogic.isWaterFull = false;
+
+		for (size_t i = 0; i < sizeof(Names) / sizeof(Names[0]); i++) {
+			// More actuators than free pins share them, only the cost is of interest here
+			static ActuatorRegistry Registry;
+			Registry = ActuatorRegistry();
+			for (uint8_t Id = 0; Id < Counts[i]; Id++) {
+				Registry.addFeeder(FreePins[Id % FREE_PIN_COUNT], SERVO_OPEN_TIMEOUT);
+				Registry.addPump(FreePins[(Id + 7) % FREE_PIN_COUNT], WATER_PUMP_ENABLE_TIMEOUT);
+			}
+
+			businessLogic.setActuatorRegistry(&Registry);
+
+			#if ENABLE_SERVO == true
+				ServoManager_setup(&Registry.feeders);
+			#endif
+
+			ActuatorCommand Command;
+			Command.pumpMask = Counts[i] == 32 ? UINT32_MAX : (1UL << Counts[i]) - 1;
+			Command.feederMask = Command.pumpMask;
+
+			PrintResult(Measure(Names[i], iterations, [&]() {
+				businessLogic.postActuatorCommand(Command);
+				businessLogic.pre_actuator_loop();
+			}));
+
+			fprintf(stderr, "[bench]   %u pumps on of %u, %u feeders open of %u\n",
+				(unsigned)__builtin_popcount(Registry.pumps.enabledMask), (unsigned)Registry.pumps.count,
+				(unsigned)__builtin_popcount(Registry.feeders.openMask), (unsigned)Registry.feeders.count);
+		}
+
+		businessLogic.isWaterFull = WasWaterFull;
+		businessLogic.setActuatorRegistry(&actuators);
+
+		#if ENABLE_SERVO == true
+			ServoManager_setup(&actuators.feeders);
+			ServoManager_setBackend(ServoBackend_getDefault());
+		#endif
+	}
+
+	#if ENABLE_WATER_LEVEL_SENSOR == true && WATER_PUMP_CLOSED_LOOP == true
+	// One update per control loop during a long fill; test/test_pump_controller checks the stops and faults
+	void BenchPumpController(uint64_t iterations) {
+		static PumpController Controller;
+		Controller = PumpController();
+		ulong Now = 0;
+		PumpDecision Decision = PUMP_KEEP;
+
+		// A long fill, the fit runs every 5th update
+		PrintResult(Measure("pump_controller", iterations, [&]() {
+			Now += 100;
+			Decision = Controller.update(Now, 20.0f + (Now % 20000) / 1000.0f, true);
+			asm volatile("" : : "r"(Decision));
+		}));
+	}
+	#endif
+
+	#if ENABLE_FEEDING_SCHEDULE == true
+	#define SCHEDULE_BENCH_ENTRIES 4000
+
+	ScheduleEntry RandomScheduleEntry() {
+		ScheduleEntry Entry;
+		Entry.minute = (uint16_t)(BenchUniform() * SCHEDULE_MINUTES_PER_DAY);
+		Entry.weekdays = 1 + (uint8_t)(BenchUniform() * SCHEDULE_EVERY_DAY);
+		Entry.feeder = (uint8_t)(BenchUniform() * ACTUATOR_MAX_COUNT);
+		Entry.openMillis = 100 + (uint16_t)(BenchUniform() * 900);
+		return Entry;
+	}
+
+	// Thousands of entries searched for the next slot, then a full table polled every second; test/test_feeding_schedule checks the results
+	void BenchFeedingSchedule(uint64_t iterations) {
+		static ScheduleEntry Entries[SCHEDULE_BENCH_ENTRIES];
+		static ScheduleSlot Slots[SCHEDULE_BENCH_ENTRIES * 7];
+
+		for (size_t i = 0; i < SCHEDULE_BENCH_ENTRIES; i++) {
+			Entries[i] = RandomScheduleEntry();
+		}
+
+		FeedingSchedule_sort(Entries, SCHEDULE_BENCH_ENTRIES);
+		size_t SlotCount = FeedingSchedule_expand(Entries, SCHEDULE_BENCH_ENTRIES, Slots, SCHEDULE_BENCH_ENTRIES * 7);
+
+		uint16_t WeekMinute = 0;
+		PrintResult(Measure("schedule_next", iterations, [&]() {
+			size_t Next = FeedingSchedule_findNext(Slots, SlotCount, WeekMinute);
+			asm volatile("" : : "r"(Next) : "memory");
+
+			WeekMinute = (WeekMinute + 37) % SCHEDULE_MINUTES_PER_WEEK;
+		}));
+
+		// A full table polled every second, nearly always with nothing due
+		static FeedingScheduleTable Table;
+		static FeedingSchedule Schedule;
+		Table = {};
+		Table.entryCount = SCHEDULE_MAX_ENTRIES;
+		for (uint8_t i = 0; i < SCHEDULE_MAX_ENTRIES; i++) {
+			Table.entries[i] = RandomScheduleEntry();
+		}
+
+		Schedule = FeedingSchedule();
+		Schedule.load(Table);
+
+		uint32_t Time = 1760000000;
+		uint32_t Due = 0;
+		PrintResult(Measure("schedule_poll", iterations, [&]() {
+			Due |= Schedule.poll(Time++);
+		}));
+
+		fprintf(stderr, "[bench]   %zu slots from %d entries, feeders %08x due while polling\n", SlotCount, SCHEDULE_BENCH_ENTRIES, Due);
+	}
+	#endif
+
+	#if ENABLE_METRICS == true
+	// What a probe costs the code it times, and how far the histogram percentiles are from the exact ones
+	void BenchMetrics(uint64_t iterations) {
+		static uint32_t Values[4096];
+		for (size_t i = 0; i < 4096; i++) {
+			// Mostly short with a long tail, like loop() iterations
+			float Value = 200.0f * expf(BenchGaussian(1.0f));
+			Values[i] = Value > 4.0e6f ? 4000000 : (uint32_t)Value;
+		}
+
+		LatencyHistogram Histogram;
+		size_t Next = 0;
+		PrintResult(Measure("metrics_record", iterations, [&]() {
+			Histogram.record(Values[Next]);
+			Next = (Next + 1) & 4095;
+		}));
+
+		PrintResult(Measure("metrics_probe", iterations, [&]() {
+			MetricsTimer Timer(METRICS_SERVO_PWM);
+		}));
+
+		// Exact percentiles of the same values, the histogram rounds up to the end of a bucket
+		std::vector<uint32_t> Sorted(Values, Values + 4096);
+		std::sort(Sorted.begin(), Sorted.end());
+		Histogram.reset();
+		for (uint32_t Value : Sorted) {
+			Histogram.record(Value);
+		}
+
+		float ErrorMax = 0.0f;
+		for (uint8_t Percentile : { 50, 90, 99 }) {
+			uint32_t Exact = Sorted[(4096 * Percentile + 99) / 100 - 1];
+			float Error = Exact > 0 ? (Histogram.getPercentile(Percentile) - (float)Exact) / Exact : 0.0f;
+			if (Error > ErrorMax)
+				ErrorMax = Error;
+		}
+
+		fprintf(stderr, "[bench]   %d buckets, %zu B per histogram, p50/p90/p99 at most %.1f%% above the exact value\n",
+			METRICS_BUCKET_COUNT, sizeof(LatencyHistogram), ErrorMax * 100.0f);
+
+		// A whole report, frame after frame, over the tasks of the firmware
+		Scheduler* Schedulers[] = { &scheduler };
+		char Frame[WS_TX_FRAME_SIZE];
+		size_t Frames = 0;
+		size_t Bytes = 0;
+		PrintResult(Measure("metrics_report", iterations / 100, [&]() {
+			int Cursor = 0;
+			while (Cursor < Metrics_getRowCount(Schedulers, 1)) {
+				size_t Size = Metrics_encodeReport(Schedulers, 1, Cursor, Frame, REQUEST_JSON_CAPACITY);
+				if (Size == 0)
+					break;
+
+				Frames++;
+				Bytes += Size;
+			}
+		}));
+
+		fprintf(stderr, "[bench]   %d rows in %.1f frames of %.0f B on average\n",
+			Metrics_getRowCount(Schedulers, 1), Frames / (double)(iterations / 100), Frames ? Bytes / (double)Frames : 0.0);
+	}
+	#endif
+
+	#if ENABLE_LCD_OUTPUT == true
+	// The status screen as LCD_StatusReport() wrote it before LCDRenderer: both lines in full every time
+	void LegacyStatusReport() {
+		char TemperatureStr[LCD_COLUMNS_SIZE + 1];
+		char HumidityStr[LCD_COLUMNS_SIZE + 1];
+		char WaterLevelStr[LCD_COLUMNS_SIZE + 1];
+		int TemperatureStrlen = snprintf(TemperatureStr, sizeof(TemperatureStr), LCD_TEMP_FORMAT, businessLogic.temperature);
+		snprintf(HumidityStr, sizeof(HumidityStr), LCD_HUMIDITY_FORMAT, int(businessLogic.humidity));
+		snprintf(WaterLevelStr, sizeof(WaterLevelStr), LCD_WATER_LEVEL_FORMAT, businessLogic.waterLevel);
+
+		char firstLine[LCD_COLUMNS_SIZE + 1];
+		snprintf(firstLine, sizeof(firstLine), "%s%*s", TemperatureStr, LCD_COLUMNS_SIZE - TemperatureStrlen, HumidityStr);
+		lcd.setCursor(0, 0);
+		lcd.print(firstLine);
+
+		char secondLine[LCD_COLUMNS_SIZE + 1];
+		snprintf(secondLine, sizeof(secondLine), "%-*s", LCD_COLUMNS_SIZE, WaterLevelStr);
+		lcd.setCursor(0, 1);
+		lcd.print(secondLine);
+	}
+
+	// Readings as they move over a run of 1 second refreshes: the DHT11 every 5th, the water level now and then
+	void ChangeReadings(uint64_t refresh) {
+		if (refresh % 5 == 0) {
+			businessLogic.temperature = 26.0f + (refresh / 5 % 30) * 0.1f;
+			businessLogic.humidity = 60.0f + (refresh / 25 % 8);
+		}
+
+		if (refresh % 13 == 0)
+			businessLogic.waterLevel = 40 + (refresh / 13 % 10);
+	}
+
+	// One status screen refresh per operation, bus bytes and bus time come from the host LCD
+	// The caller is held up for the whole bus time unless I2C_ASYNC leaves the transactions to the i2c task
+	void BenchLCDRefresh(uint64_t iterations) {
+		char FullScreen[LCD_ROWS_SIZE][LiquidCrystal_I2C::MAX_COLUMNS + 1];
+
+		for (int IsRenderer = 0; IsRenderer < 2; IsRenderer++) {
+			lcdRenderer.invalidate(); // The legacy writes went around it
+			lcd.resetCounters();
+			uint64_t BusMicrosBefore = NativeHAL::nowMicros();
+			uint64_t CallerMicros = 0;
+			uint64_t Refresh = 0;
+
+			Result Refreshes = Measure(IsRenderer ? "lcd_refresh" : "lcd_refresh_full", iterations, [&]() {
+				ChangeReadings(Refresh++);
+				uint64_t CallerStart = NativeHAL::nowMicros();
+
+				if (IsRenderer) {
+					LCD_StatusReport();
+					CallerMicros += NativeHAL::nowMicros() - CallerStart;
+
+					#if I2C_ASYNC == true
+						lcdRenderer.flush();
+						i2cBus.drainAll();
+					#endif
+				}
+				else {
+					LegacyStatusReport();
+					CallerMicros += NativeHAL::nowMicros() - CallerStart;
+				}
+			});
+
+			PrintResult(Refreshes);
+			fprintf(stderr, "[bench]   %.1f I2C bytes and %.2f ms of bus time per refresh, %.2f commands, caller held up %.2f ms\n",
+				lcd.getBusBytes() / (double)iterations,
+				(NativeHAL::nowMicros() - BusMicrosBefore) / 1000.0 / iterations,
+				lcd.getCommandCount() / (double)iterations,
+				CallerMicros / 1000.0 / iterations);
+
+			// Both end on the same readings, so on the same screen
+			for (uint8_t row = 0; row < LCD_ROWS_SIZE; row++) {
+				if (!IsRenderer)
+					strcpy(FullScreen[row], lcd.getRow(row));
+				else if (strcmp(FullScreen[row], lcd.getRow(row)) != 0)
+					fprintf(stderr, "[bench]   row %u is \"%s\" instead of \"%s\"\n", row, lcd.getRow(row), FullScreen[row]);
+			}
+		}
+	}
+	#endif
+
+	#if ENABLE_TELEMETRY_JOURNAL == true
+	// Appending to the flash ring and draining it in /iot/post_history batches, on its own journal over the same partition
+	void BenchJournal(uint64_t iterations) {
+		TelemetryJournal Journal;
+		if (!Journal.begin()) {
+			fprintf(stderr, "[bench] journal did not mount\n");
+			return;
+		}
+
+		Journal.setClock(1760000000);
+		TelemetrySample Sample = { 27.5f, 61.0f, 42, 0, 0 };
+
+		// Erases and page writes advance the simulated clock by what they take on the chip
+		uint64_t FlashMicrosBefore = NativeHAL::nowMicros();
+		uint64_t BytesBefore = NativeHAL::getFlashBytesWritten();
+		PrintResult(Measure("journal_append", iterations, [&]() {
+			Journal.append(Sample);
+		}));
+
+		fprintf(stderr, "[bench]   flash: %.1f us/sample modeled, %.1f B written/sample, %u sector erases, %u dropped before upload\n",
+			(NativeHAL::nowMicros() - FlashMicrosBefore) / (double)iterations,
+			(NativeHAL::getFlashBytesWritten() - BytesBefore) / (double)iterations,
+			Journal.getEraseCount(), Journal.getDroppedCount());
+
+		// A backlog that fits the ring, drained one batch per operation
+		uint64_t Backlog = (JOURNAL_SECTOR_COUNT - 2) * JOURNAL_SLOTS_PER_SECTOR;
+		JournalSample Samples[BINARY_POST_HISTORY_MAX_SAMPLES];
+		char Buffer[WS_TX_FRAME_SIZE];
+
+		for (int IsJson = 0; IsJson < 2; IsJson++) {
+			while (Journal.hasPending()) {
+				size_t Count = Journal.read(Samples, BINARY_POST_HISTORY_MAX_SAMPLES);
+				if (Count > 0)
+					Journal.commit(Samples[Count - 1].end, Count);
+			}
+
+			for (uint64_t i = 0; i < Backlog; i++) {
+				Journal.append(Sample);
+			}
+
+			uint64_t Uploaded = 0;
+			uint64_t Bytes = 0;
+			Result Backfill = Measure(IsJson ? "journal_backfill_json" : "journal_backfill_binary", Backlog / BINARY_POST_HISTORY_MAX_SAMPLES, [&]() {
+				size_t Count = Journal.read(Samples, BINARY_POST_HISTORY_MAX_SAMPLES);
+				size_t Encoded = 0;
+				Bytes += IsJson
+					? TelemetryEncoder_encodeHistory(Samples, Count, Encoded, Buffer, sizeof(Buffer))
+					: BinaryProtocol_encodeHistory(Samples, Count, Encoded, (uint8_t*)Buffer, sizeof(Buffer));
+
+				if (Encoded > 0) {
+					Journal.commit(Samples[Encoded - 1].end, Encoded);
+					Uploaded += Encoded;
+				}
+			});
+
+			PrintResult(Backfill);
+			fprintf(stderr, "[bench]   %llu samples, %.0f samples/s host, %.1f B/sample, %.1f samples per batch\n",
+				(unsigned long long)Uploaded,
+				Uploaded * 1e9 / (Backfill.nanosPerOperation * Backfill.operations),
+				Bytes / (double)Uploaded,
+				Uploaded / (double)Backfill.operations);
+		}
+	}
+	#endif
+
+	#if ENABLE_WIFI == true
+	void FillReport(JsonDocument& doc) {
+		doc["key"] = "/iot/post_data";
+		doc["data"]["te"] = 27.5f;
+		doc["data"]["hu"] = 61.0f;
+		doc["data"]["wa"] = 42;
+		doc["data"]["PuEn"] = 0;
+		doc["data"]["DiFo"] = 0;
+	}
+
+	void BenchWebSocketSend(uint64_t iterations) {
+		JsonDocument doc;
+		FillReport(doc);
+
+		FrameRing& Ring = wifiNetwork.getOutboundRing();
+		uint64_t FramesBefore = sink.frames;
+
+		// sendJSON() queues, wifiNetwork.loop() drains it like the network task does
+		PrintResult(Measure("ws_send", iterations, [&]() {
+			wifiNetwork.sendJSON(doc);
+			wifiNetwork.loop();
+		}));
+
+		// More frames per tick than the ring holds, the policy decides which ones go out
+		uint32_t DroppedBefore = Ring.getDroppedCount();
+		uint64_t Bursts = iterations / WS_TX_RING_SLOTS;
+		PrintResult(Measure("ws_send_burst", Bursts, [&]() {
+			for (int i = 0; i < WS_TX_RING_SLOTS * 2; i++) {
+				wifiNetwork.sendJSON(doc);
+			}
+
+			wifiNetwork.loop();
+		}));
+
+		// The sink pushes the successful recorded replies, WiFiNetwork::loop() reads, parses and dispatches them
+		uint64_t TransportAllocations = 0;
+		Result Receive = Measure("ws_receive", iterations, [&]() {
+			uint64_t AllocationsBefore = getAllocationCount();
+			sink.push(RecordedReplies[1]);
+			sink.push(RecordedReplies[2]);
+			TransportAllocations += getAllocationCount() - AllocationsBefore;
+
+			wifiNetwork.loop();
+		});
+
+		// The in-process socket buffer of the host isn't part of the firmware
+		Receive.allocationsPerOperation -= TransportAllocations / (double)iterations;
+		PrintResult(Receive);
+
+		fprintf(stderr, "[bench]   ring: %u enqueued, %u sent, %u dropped (%u in bursts of %d), %llu frames reached the server\n",
+			Ring.getEnqueuedCount(),
+			Ring.getSentCount(),
+			Ring.getDroppedCount(),
+			Ring.getDroppedCount() - DroppedBefore,
+			WS_TX_RING_SLOTS * 2,
+			(unsigned long long)(sink.frames - FramesBefore));
+	}
+
+	// A control tick and an interaction: pre_actuator_loop() publishes a sample, interaction_loop() reports it and polls
+	// The sink never answers, so the request window is cleared for the next one
+	void BenchReportData(uint64_t iterations) {
+		uint64_t FramesBefore = sink.frames;
+		uint64_t BytesBefore = sink.bytes;
+		uint64_t Tick = 0;
+
+		PrintResult(Measure("report_data", iterations, [&]() {
+			businessLogic.temperature = 26.0f + (Tick++ % 30) * 0.1f;
+			businessLogic.pre_actuator_loop();
+			businessLogic.interaction_loop();
+			wifiNetwork.getRequestWindow().clear();
+			wifiNetwork.loop();
+		}));
+
+		fprintf(stderr, "[bench]   %.2f frames and %.1f B per interaction\n",
+			(sink.frames - FramesBefore) / (double)iterations,
+			(sink.bytes - BytesBefore) / (double)iterations);
+	}
+	#endif
+
+	// One result per line, so diffing two runs shows which paths moved
+	bool WriteResults(const char* path, uint64_t iterations) {
+		FILE* File = fopen(path, "w");
+		if (File == nullptr)
+			return false;
+
+		fprintf(File, "{\n\t\"iterations\": %llu,\n\t\"results\": [\n", (unsigned long long)iterations);
+		for (size_t i = 0; i < Results.size(); i++) {
+			fprintf(File, "\t\t{ \"name\": \"%s\", \"ratio\": %.5f, \"ns_per_op\": %.2f, \"allocs_per_op\": %.3f, \"noise_percent\": %.1f }%s\n",
+				Results[i].name,
+				Results[i].ratio,
+				Results[i].nanosPerOperation,
+				Results[i].allocationsPerOperation,
+				Results[i].noisePercent,
+				i + 1 < Results.size() ? "," : "");
+		}
+
+		fprintf(File, "\t]\n}\n");
+		fclose(File);
+		return true;
+	}
+
+	bool ReadResults(const char* path, JsonDocument& doc) {
+		FILE* File = fopen(path, "r");
+		if (File == nullptr)
+			return false;
+
+		std::string Text;
+		char Chunk[512];
+		size_t Read;
+		while ((Read = fread(Chunk, 1, sizeof(Chunk), File)) > 0) {
+			Text.append(Chunk, Read);
+		}
+
+		fclose(File);
+		return !deserializeJson(doc, Text);
+	}
+
+	JsonObjectConst FindBaseline(JsonDocument& baseline, const char* name) {
+		for (JsonObjectConst Entry : baseline["results"].as<JsonArrayConst>()) {
+			if (strcmp(Entry["name"] | "", name) == 0)
+				return Entry;
+		}
+
+		return JsonObjectConst();
+	}
+
+	// Ratio of a baseline entry to its calibration, baselines from before ratios were stored have only the timings
+	double BaselineRatio(JsonObjectConst entry, JsonObjectConst calibration) {
+		if (entry["ratio"].is<double>())
+			return entry["ratio"].as<double>();
+
+		double CalibrationNanos = calibration["ns_per_op"].as<double>();
+		return CalibrationNanos > 0.0 ? entry["ns_per_op"].as<double>() / CalibrationNanos : 0.0;
+	}
+
+	// Slower than the baseline by more than thresholdPercent and more than the noise of both, or allocating more, is a regression
+	// Timings are compared as ratios to the calibration of their own run, so a baseline recorded on another host still holds
+	// Returns the number of regressions, -1 if the baseline can't be read
+	int CompareBaseline(const char* path, double thresholdPercent) {
+		JsonDocument Baseline;
+		if (!ReadResults(path, Baseline)) {
+			fprintf(stderr, "[bench] Can't read baseline %s\n", path);
+			return -1;
+		}
+
+		JsonObjectConst Calibration = FindBaseline(Baseline, "calibration");
+		double CalibrationNanos = 0.0;
+		for (const Result& result : Results) {
+			if (strcmp(result.name, "calibration") == 0)
+				CalibrationNanos = result.nanosPerOperation;
+		}
+
+		fprintf(stderr, "[bench] against %s, calibration %.1f ns/op here and %.1f in the baseline, regression above +%.0f%% and the noise between runs, or any added allocation\n",
+			path, CalibrationNanos, Calibration["ns_per_op"].as<double>(), thresholdPercent);
+
+		int Regressions = 0;
+		for (const Result& result : Results) {
+			JsonObjectConst Entry = FindBaseline(Baseline, result.name);
+			if (Entry.isNull()) {
+				fprintf(stderr, "[bench] %-24s not in the baseline\n", result.name);
+				continue;
+			}
+
+			double Expected = BaselineRatio(Entry, Calibration);
+			double ExpectedAllocations = Entry["allocs_per_op"].as<double>();
+			double Change = Expected > 0.0 ? (result.ratio - Expected) / Expected * 100.0 : 0.0;
+
+			// Within how much slower the median run of either side was is no change at all
+			double Noise = result.noisePercent + Entry["noise_percent"].as<double>(); // Missing from older baselines, 0
+			double Threshold = Noise > thresholdPercent ? Noise : thresholdPercent;
+			bool IsSlower = Change > Threshold && (result.ratio - Expected) * CalibrationNanos > BENCH_NOISE_FLOOR_NANOS;
+			bool IsAllocating = result.allocationsPerOperation > ExpectedAllocations + 0.005;
+
+			fprintf(stderr, "[bench] %-24s %10.4f x calibration vs %10.4f %+7.1f%% (noise %5.1f%%) %8.2f allocs/op vs %8.2f%s\n",
+				result.name,
+				result.ratio,
+				Expected,
+				Change,
+				Noise,
+				result.allocationsPerOperation,
+				ExpectedAllocations,
+				IsSlower || IsAllocating ? "  REGRESSION" : "");
+
+			if (IsSlower || IsAllocating)
+				Regressions++;
+		}
+
+		fprintf(stderr, "[bench] %d regression%s\n", Regressions, Regressions == 1 ? "" : "s");
+		return Regressions;
+	}
+
+	// Every bench once, in this process
+	bool RunSuite(uint64_t iterations) {
+		if (!StartFirmware()) {
+			fprintf(stderr, "[bench] Firmware did not log in to the sink server\n");
+			return false;
+		}
+
+		Result Calibration = MeasureCalibration(iterations);
+		PrintResult(Calibration);
+		BenchTelemetryEncode(iterations);
+		BenchReplyDecode(iterations);
+		BenchReplyParse(iterations);
+		BenchDHTDecode(iterations);
+		BenchWaterLevelFilter(iterations);
+		BenchTickTimer(iterations);
+
+		#if ENABLE_WATER_LEVEL_SENSOR == true
+			BenchWaterLevelRead(iterations);
+		#endif
+
+		#if ENABLE_SERVO == true
+			BenchServoPulse(iterations);
+			BenchServoPWM(iterations);
+		#endif
+
+		BenchActuatorLoop(iterations);
+
+		#if ENABLE_WATER_LEVEL_SENSOR == true && WATER_PUMP_CLOSED_LOOP == true
+			BenchPumpController(iterations);
+		#endif
+
+		#if ENABLE_FEEDING_SCHEDULE == true
+			BenchFeedingSchedule(iterations);
+		#endif
+
+		#if ENABLE_METRICS == true
+			BenchMetrics(iterations);
+		#endif
+
+		#if ENABLE_LCD_OUTPUT == true
+			BenchLCDRefresh(iterations);
+		#endif
+
+		#if ENABLE_WIFI == true
+			BenchWebSocketSend(iterations);
+			BenchReportData(iterations);
+		#endif
+
+		// Last, it writes to the partition behind the back of the firmware journal
+		#if ENABLE_TELEMETRY_JOURNAL == true
+			BenchJournal(iterations);
+		#endif
+
+		sink.shutdown();
+		NativeHAL::setWebSocketServer(nullptr);
+
+		// Again at the end, a host that clocked up or down during the suite shows in the faster one
+		Result Again = MeasureCalibration(iterations);
+		if (Again.nanosPerOperation < Calibration.nanosPerOperation)
+			Calibration = Again;
+
+		for (Result& result : Results) {
+			if (strcmp(result.name, "calibration") == 0)
+				result = Calibration;
+
+			result.ratio = Calibration.nanosPerOperation > 0.0 ? result.nanosPerOperation / Calibration.nanosPerOperation : 0.0;
+		}
+
+		return true;
+	}
+
+	std::deque<JsonDocument> SeparateRuns; // Results of every run in a process of its own so far
+
+	// Each run in a new process of this program, with its own address layout and a fresh firmware. The host only ever slows
+	// a run down, so every result is the fastest of all runs so far, and its noise how much slower the median run was
+	bool RunSeparately(uint64_t iterations, int runs) {
+		char Path[] = "/tmp/native_bench_XXXXXX";
+		int Descriptor = mkstemp(Path);
+		if (Descriptor < 0) {
+			fprintf(stderr, "[bench] Can't create a file for the runs\n");
+			return false;
+		}
+
+		close(Descriptor);
+
+		for (int Run = 0; Run < runs; Run++) {
+			char Iterations[24];
+			snprintf(Iterations, sizeof(Iterations), "%llu", (unsigned long long)iterations);
+
+			fflush(nullptr);
+			pid_t Child = fork();
+			if (Child == 0) {
+				// The last run prints like a single one would
+				if (Run + 1 < runs)
+					freopen("/dev/null", "w", stderr);
+
+				execl("/proc/self/exe", "bench", "--iterations", Iterations, "--runs", "1", "--json", Path, (char*)nullptr);
+				_exit(1);
+			}
+
+			SeparateRuns.emplace_back();
+			int Status = 0;
+			if (Child < 0 || waitpid(Child, &Status, 0) != Child || !WIFEXITED(Status) || WEXITSTATUS(Status) != 0 || !ReadResults(Path, SeparateRuns.back())) {
+				fprintf(stderr, "[bench] Run %d of %d failed\n", Run + 1, runs);
+				unlink(Path);
+				return false;
+			}
+		}
+
+		unlink(Path);
+
+		// Results points at the names, which have to outlive the documents
+		static std::deque<std::string> Names;
+		Results.clear();
+
+		for (JsonObjectConst Entry : SeparateRuns.front()["results"].as<JsonArrayConst>()) {
+			Names.push_back(Entry["name"] | "");
+
+			std::vector<double> Nanos;
+			std::vector<double> Ratios;
+			std::vector<double> Allocations;
+			for (JsonDocument& Run : SeparateRuns) {
+				JsonObjectConst Same = FindBaseline(Run, Names.back().c_str());
+				if (!Same.isNull()) {
+					Nanos.push_back(Same["ns_per_op"].as<double>());
+					Ratios.push_back(Same["ratio"].as<double>());
+					Allocations.push_back(Same["allocs_per_op"].as<double>());
+				}
+			}
+
+			std::sort(Nanos.begin(), Nanos.end());
+			std::sort(Ratios.begin(), Ratios.end());
+			std::sort(Allocations.begin(), Allocations.end());
+
+			// The noise is of the ratios, what is compared
+			Result result;
+			result.name = Names.back().c_str();
+			result.operations = iterations;
+			result.nanosPerOperation = Nanos.front();
+			result.allocationsPerOperation = Allocations[Allocations.size() / 2];
+			result.ratio = Ratios.front();
+			result.noisePercent = Ratios.front() > 0.0 ? (Ratios[Ratios.size() / 2] - Ratios.front()) / Ratios.front() * 100.0 : 0.0;
+			Results.push_back(result);
+		}
+
+		fprintf(stderr, "[bench] fastest of %zu runs\n", SeparateRuns.size());
+		for (const Result& result : Results) {
+			fprintf(stderr, "[bench] %-24s %10.1f ns/op %10.4f x calibration %8.2f allocs/op, median run %.1f%% slower\n",
+				result.name, result.nanosPerOperation, result.ratio, result.allocationsPerOperation, result.noisePercent);
+		}
+
+		return true;
+	}
+}
+
+int main(int argc, char** argv) {
+	uint64_t Iterations = 100000;
+	const char* JsonPath = nullptr;
+	const char* BaselinePath = nullptr;
+	double Threshold = BENCH_REGRESSION_PERCENT;
+	int Runs = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+			Iterations = strtoull(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+			JsonPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+			BaselinePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+			Threshold = strtod(argv[++i], nullptr);
+		}
+		else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+			Runs = atoi(argv[++i]);
+		}
+		else {
+			fprintf(stderr, "Usage: %s [--iterations N] [--runs N] [--json results.json] [--baseline baseline.json] [--threshold percent]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	// One run can land on a slow moment of the host, a comparison takes the fastest of several
+	if (Runs <= 0)
+		Runs = BaselinePath != nullptr ? BENCH_BASELINE_RUNS : 1;
+
+	if (Runs > 1 ? !NativeBench::RunSeparately(Iterations, Runs) : !NativeBench::RunSuite(Iterations))
+		return 1;
+
+	if (JsonPath != nullptr && !NativeBench::WriteResults(JsonPath, Iterations)) {
+		fprintf(stderr, "[bench] Can't write %s\n", JsonPath);
+		return 1;
+	}
+
+	if (BaselinePath != nullptr) {
+		int Regressions = NativeBench::CompareBaseline(BaselinePath, Threshold);
+		if (Regressions < 0)
+			return 1;
+
+		// A slow spell of the host can outlast all the runs, a regression only counts if runs after a pause still show it
+		for (int Attempt = 0; Attempt < BENCH_CONFIRM_ATTEMPTS && Regressions > 0 && Runs > 1; Attempt++) {
+			fprintf(stderr, "[bench] measuring again in %d s\n", BENCH_CONFIRM_PAUSE);
+			sleep(BENCH_CONFIRM_PAUSE);
+
+			if (!NativeBench::RunSeparately(Iterations, Runs))
+				return 1;
+
+			Regressions = NativeBench::CompareBaseline(BaselinePath, Threshold);
+		}
+
+		if (Regressions > 0)
+			return 2;
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+#include <stdint.h>
+
+typedef struct {
+	int32_t version;
+	int32_t sensor_id;
+	int32_t type;
+	int32_t reserved0;
+	int32_t timestamp;
+	union {
+		float temperature;
+		float relative_humidity;
+		float data[4];
+	};
+} sensors_event_t;
+
+class Adafruit_Sensor {
+	public:
+		virtual ~Adafruit_Sensor() {}
+		virtual bool getEvent(sensors_event_t* event) = 0;
+};
@@ -0,0 +1,80 @@
+#pragma once
+// Host-side stand-in for the Arduino-ESP32 core, only covers what the firmware uses
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <sys/types.h>
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "NativeHAL.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define IRAM_ATTR
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+
+// Handlers run on whichever thread moves the clock past a scheduled edge, with micros() frozen at the edge
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+// Same sequence on every run, so simulations stay reproducible
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+double ledcSetup(uint8_t channel, double freq, uint8_t resolution_bits);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcWrite(uint8_t channel, uint32_t duty);
+uint32_t ledcRead(uint8_t channel);
+
+class HardwareSerial : public Stream {
+	public:
+		void begin(unsigned long baud);
+		void end();
+		int available() override;
+		int read() override;
+		int peek() override;
+		void flush() override;
+		size_t write(uint8_t c) override;
+		size_t write(const uint8_t* buffer, size_t size) override;
+		using Print::write;
+};
+
+class EspClass {
+	public:
+		uint32_t getFreeHeap();
+		uint32_t getCpuFreqMHz();
+		uint32_t getCycleCount(); // Runs with the clock, wraps like CCOUNT
+};
+
+extern HardwareSerial Serial;
+extern EspClass ESP;
\ No newline at end of file
@@ -0,0 +1,7 @@
+#pragma once
+#include <stdint.h>
+
+#define DHT11 11
+#define DHT12 12
+#define DHT22 22
+#define DHT21 21
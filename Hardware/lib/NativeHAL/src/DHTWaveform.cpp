@@ -0,0 +1,97 @@
+#include "Arduino.h"
+#include "NativeHAL.h"
+#include <math.h>
+
+// DHT11 datasheet timings, the answer to a start signal of at least 18 ms
+#define DHT11_MIN_START_SIGNAL_MICROS 18000
+#define DHT11_RESPONSE_DELAY_MICROS 30 // From the release of the line to the sensor pulling it low, 20-40 us
+#define DHT11_RESPONSE_MICROS 80 // Low, then as long high
+#define DHT11_BIT_LOW_MICROS 50
+#define DHT11_ZERO_HIGH_MICROS 27 // 26-28 us
+#define DHT11_ONE_HIGH_MICROS 70
+
+namespace NativeHAL {
+	extern float DHTTemperature;
+	extern float DHTHumidity;
+	extern uint8_t DigitalLevels[NATIVE_HAL_PIN_COUNT];
+	extern uint64_t LastWriteMicros[NATIVE_HAL_PIN_COUNT];
+
+	int DHTPin = -1;
+	uint32_t DHTFrameCount = 0;
+	uint32_t DHTJitterState = 1; // Same pulse widths on every run
+
+	void setDHTPin(uint8_t pin) {
+		DHTPin = pin;
+	}
+
+	uint32_t getDHTFrameCount() {
+		return DHTFrameCount;
+	}
+
+	// A microsecond either way, like the drift of the sensor's own oscillator
+	int DHTJitter() {
+		DHTJitterState = DHTJitterState * 1103515245 + 12345;
+		return (int)((DHTJitterState >> 16) % 3) - 1;
+	}
+
+	// Integral and decimal parts of humidity and temperature, then the checksum
+	void EncodeDHTFrame(uint8_t* bytes) {
+		float Humidity = DHTHumidity < 0.0f ? 0.0f : (DHTHumidity > 99.9f ? 99.9f : DHTHumidity);
+		float Temperature = fabsf(DHTTemperature) > 99.9f ? 99.9f : fabsf(DHTTemperature);
+		int HumidityTenths = (int)lroundf(Humidity * 10.0f);
+		int TemperatureTenths = (int)lroundf(Temperature * 10.0f);
+
+		bytes[0] = HumidityTenths / 10;
+		bytes[1] = HumidityTenths % 10;
+		bytes[2] = TemperatureTenths / 10;
+		bytes[3] = (TemperatureTenths % 10) | (DHTTemperature < 0.0f ? 0x80 : 0);
+		bytes[4] = bytes[0] + bytes[1] + bytes[2] + bytes[3];
+	}
+
+	// Time the line is driven by the sensor for a frame, without the jitter
+	uint64_t DHTFrameMicros(const uint8_t* bytes) {
+		uint64_t Micros = DHT11_RESPONSE_DELAY_MICROS + DHT11_RESPONSE_MICROS * 2 + DHT11_BIT_LOW_MICROS;
+
+		for (int i = 0; i < 40; i++) {
+			bool Bit = bytes[i / 8] & (0x80 >> (i % 8));
+			Micros += DHT11_BIT_LOW_MICROS + (Bit ? DHT11_ONE_HIGH_MICROS : DHT11_ZERO_HIGH_MICROS);
+		}
+
+		return Micros;
+	}
+
+	void OnDHTPinMode(uint8_t pin, uint8_t previousMode, uint8_t mode) {
+		if ((int)pin != DHTPin || previousMode != OUTPUT || (mode != INPUT && mode != INPUT_PULLUP) || DigitalLevels[pin] != LOW)
+			return;
+
+		// The pull-up lifts the released line, the sensor only answers if it was held low long enough
+		uint64_t Now = nowMicros();
+		scheduleEdge(pin, Now, HIGH);
+
+		if (Now - LastWriteMicros[pin] < DHT11_MIN_START_SIGNAL_MICROS)
+			return;
+
+		uint8_t Bytes[5];
+		EncodeDHTFrame(Bytes);
+		DHTFrameCount++;
+
+		uint64_t Time = Now + DHT11_RESPONSE_DELAY_MICROS;
+		scheduleEdge(pin, Time, LOW);
+		Time += DHT11_RESPONSE_MICROS;
+		scheduleEdge(pin, Time, HIGH);
+		Time += DHT11_RESPONSE_MICROS;
+		scheduleEdge(pin, Time, LOW);
+
+		for (int i = 0; i < 40; i++) {
+			bool Bit = Bytes[i / 8] & (0x80 >> (i % 8));
+			Time += DHT11_BIT_LOW_MICROS + DHTJitter();
+			scheduleEdge(pin, Time, HIGH);
+			Time += (Bit ? DHT11_ONE_HIGH_MICROS : DHT11_ZERO_HIGH_MICROS) + DHTJitter();
+			scheduleEdge(pin, Time, LOW);
+		}
+
+		// Lets go of the line after the last bit
+		Time += DHT11_BIT_LOW_MICROS;
+		scheduleEdge(pin, Time, HIGH);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "DHT_U.h"
+#include "Arduino.h"
+#include <string.h>
+
+// The library reads the sensor at most every 2 seconds and answers from the last frame in between
+#define DHT_MIN_INTERVAL_MICROS 2000000
+
+namespace NativeHAL {
+	extern float DHTTemperature;
+	extern float DHTHumidity;
+
+	void EncodeDHTFrame(uint8_t* bytes); // DHTWaveform.cpp
+	uint64_t DHTFrameMicros(const uint8_t* bytes);
+
+	bool HasDHTRead = false;
+	uint64_t LastDHTReadMicros = 0;
+
+	// Same cost as DHT::read(): 1 ms high and 20 ms low in delay(), then the frame is bit-banged with interrupts off
+	void BlockForDHTRead() {
+		if (HasDHTRead && nowMicros() - LastDHTReadMicros < DHT_MIN_INTERVAL_MICROS)
+			return;
+
+		uint8_t Bytes[5];
+		EncodeDHTFrame(Bytes);
+
+		delay(1);
+		delay(20);
+		delayMicroseconds(DHTFrameMicros(Bytes));
+
+		HasDHTRead = true;
+		LastDHTReadMicros = nowMicros();
+	}
+}
+
+DHT_Unified::DHT_Unified(uint8_t pin, uint8_t type) {
+	this->pin = pin;
+	this->type = type;
+}
+
+void DHT_Unified::begin() {
+	pinMode(this->pin, INPUT_PULLUP);
+}
+
+bool DHT_Unified::Temperature::getEvent(sensors_event_t* event) {
+	NativeHAL::BlockForDHTRead();
+	memset(event, 0, sizeof(sensors_event_t));
+	event->temperature = NativeHAL::DHTTemperature;
+	return true;
+}
+
+bool DHT_Unified::Humidity::getEvent(sensors_event_t* event) {
+	NativeHAL::BlockForDHTRead();
+	memset(event, 0, sizeof(sensors_event_t));
+	event->relative_humidity = NativeHAL::DHTHumidity;
+	return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "Adafruit_Sensor.h"
+#include "DHT.h"
+
+// Fake DHT_Unified, readings come from NativeHAL::setDHTReading()
+class DHT_Unified {
+	public:
+		DHT_Unified(uint8_t pin, uint8_t type);
+		void begin();
+
+		class Temperature : public Adafruit_Sensor {
+			public:
+				bool getEvent(sensors_event_t* event) override;
+		};
+
+		class Humidity : public Adafruit_Sensor {
+			public:
+				bool getEvent(sensors_event_t* event) override;
+		};
+
+		Temperature temperature() { return Temperature(); }
+		Humidity humidity() { return Humidity(); }
+
+	private:
+		uint8_t pin;
+		uint8_t type;
+};
@@ -0,0 +1,147 @@
+#include "esp_partition.h"
+#include "NativeHAL.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define NATIVE_HAL_FLASH_PARTITION_SIZE 0x160000 // "spiffs" of the default 4 MB esp32dev partition table
+#define NATIVE_HAL_FLASH_PAGE_SIZE 256
+#define NATIVE_HAL_FLASH_PAGE_PROGRAM_MICROS 400 // Per page a write touches
+#define NATIVE_HAL_FLASH_SECTOR_ERASE_MICROS 45000
+
+namespace NativeHAL {
+	const esp_partition_t FlashPartition = {
+		ESP_PARTITION_TYPE_DATA,
+		ESP_PARTITION_SUBTYPE_DATA_SPIFFS,
+		0x290000,
+		NATIVE_HAL_FLASH_PARTITION_SIZE,
+		SPI_FLASH_SEC_SIZE,
+		"spiffs",
+		false
+	};
+
+	std::vector<uint8_t> FlashContents(NATIVE_HAL_FLASH_PARTITION_SIZE, 0xFF);
+	std::vector<uint32_t> FlashSectorErases(NATIVE_HAL_FLASH_PARTITION_SIZE / SPI_FLASH_SEC_SIZE, 0);
+	FILE* FlashFile = nullptr;
+	uint64_t FlashBytesWritten = 0;
+	uint32_t FlashEraseCount = 0;
+
+	bool setFlashFile(const char* path) {
+		if (FlashFile != nullptr)
+			fclose(FlashFile);
+
+		FlashFile = fopen(path, "r+b");
+		if (FlashFile != nullptr) {
+			size_t Read = fread(FlashContents.data(), 1, FlashContents.size(), FlashFile);
+			memset(FlashContents.data() + Read, 0xFF, FlashContents.size() - Read);
+			return true;
+		}
+
+		// A new file starts erased
+		FlashFile = fopen(path, "w+b");
+		if (FlashFile == nullptr)
+			return false;
+
+		memset(FlashContents.data(), 0xFF, FlashContents.size());
+		fwrite(FlashContents.data(), 1, FlashContents.size(), FlashFile);
+		fflush(FlashFile);
+		return true;
+	}
+
+	void SyncFlashFile(size_t offset, size_t size) {
+		if (FlashFile == nullptr)
+			return;
+
+		fseek(FlashFile, offset, SEEK_SET);
+		fwrite(FlashContents.data() + offset, 1, size, FlashFile);
+		fflush(FlashFile);
+	}
+
+	uint64_t getFlashBytesWritten() {
+		return FlashBytesWritten;
+	}
+
+	uint32_t getFlashEraseCount() {
+		return FlashEraseCount;
+	}
+
+	uint32_t getFlashMaxSectorErases() {
+		uint32_t Max = 0;
+		for (uint32_t Erases : FlashSectorErases) {
+			if (Erases > Max)
+				Max = Erases;
+		}
+
+		return Max;
+	}
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label) {
+	if (type != ESP_PARTITION_TYPE_DATA && type != ESP_PARTITION_TYPE_ANY)
+		return nullptr;
+
+	if (subtype != ESP_PARTITION_SUBTYPE_DATA_SPIFFS && subtype != ESP_PARTITION_SUBTYPE_ANY)
+		return nullptr;
+
+	if (label != nullptr && strcmp(label, NativeHAL::FlashPartition.label) != 0)
+		return nullptr;
+
+	return &NativeHAL::FlashPartition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size) {
+	if (partition != &NativeHAL::FlashPartition || dst == nullptr)
+		return ESP_ERR_INVALID_ARG;
+
+	if (src_offset > partition->size || size > partition->size - src_offset)
+		return ESP_ERR_INVALID_SIZE;
+
+	memcpy(dst, NativeHAL::FlashContents.data() + src_offset, size);
+	return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size) {
+	if (partition != &NativeHAL::FlashPartition || src == nullptr)
+		return ESP_ERR_INVALID_ARG;
+
+	if (dst_offset > partition->size || size > partition->size - dst_offset)
+		return ESP_ERR_INVALID_SIZE;
+
+	// Programming can only clear bits, writing over data that wasn't erased leaves the AND of both
+	const uint8_t* Source = (const uint8_t*)src;
+	for (size_t i = 0; i < size; i++) {
+		NativeHAL::FlashContents[dst_offset + i] &= Source[i];
+	}
+
+	NativeHAL::SyncFlashFile(dst_offset, size);
+	NativeHAL::FlashBytesWritten += size;
+
+	if (size > 0) {
+		size_t Pages = (dst_offset + size - 1) / NATIVE_HAL_FLASH_PAGE_SIZE - dst_offset / NATIVE_HAL_FLASH_PAGE_SIZE + 1;
+		NativeHAL::advanceMicros(Pages * NATIVE_HAL_FLASH_PAGE_PROGRAM_MICROS);
+	}
+
+	return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+	if (partition != &NativeHAL::FlashPartition)
+		return ESP_ERR_INVALID_ARG;
+
+	if (offset % SPI_FLASH_SEC_SIZE != 0 || size % SPI_FLASH_SEC_SIZE != 0)
+		return ESP_ERR_INVALID_ARG;
+
+	if (offset > partition->size || size > partition->size - offset)
+		return ESP_ERR_INVALID_SIZE;
+
+	memset(NativeHAL::FlashContents.data() + offset, 0xFF, size);
+	NativeHAL::SyncFlashFile(offset, size);
+
+	for (size_t Sector = offset / SPI_FLASH_SEC_SIZE; Sector < (offset + size) / SPI_FLASH_SEC_SIZE; Sector++) {
+		NativeHAL::FlashSectorErases[Sector]++;
+		NativeHAL::FlashEraseCount++;
+		NativeHAL::advanceMicros(NATIVE_HAL_FLASH_SECTOR_ERASE_MICROS);
+	}
+
+	return ESP_OK;
+}
\ No newline at end of file
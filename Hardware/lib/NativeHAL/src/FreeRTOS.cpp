@@ -0,0 +1,139 @@
+#include "Arduino.h"
+#include "NativeHAL.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace NativeHAL {
+	struct TaskPeriod {
+		std::string name;
+		uint64_t worstMicros;
+		uint64_t periodMicros; // Due at for the worst one
+		bool isFromTask; // Reported by a FreeRTOS task rather than loop()
+	};
+
+	std::atomic<bool> AreTasksStopping(false);
+	std::atomic<int> RunningTaskCount(0);
+	thread_local bool IsTaskThread = false;
+	thread_local BaseType_t CurrentCoreID = 1; // Arduino runs setup() and loop() on the application core
+
+	std::mutex TaskPeriodMutex;
+	std::vector<TaskPeriod> TaskPeriods;
+
+	void ParkIfTasksStopping() {
+		if (!AreTasksStopping || !IsTaskThread)
+			return;
+
+		// Never return into the task, it may touch globals that are being destroyed
+		RunningTaskCount--;
+		for (;;) {
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+		}
+	}
+
+	void stopTasks() {
+		AreTasksStopping = true;
+
+		// Every task blocks in delay() within its period, give them a moment to get there
+		for (int i = 0; i < 1000 && RunningTaskCount > 0; i++) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+
+	void reportTaskPeriod(const char* name, uint64_t intervalMicros, uint64_t periodMicros) {
+		std::lock_guard<std::mutex> Lock(TaskPeriodMutex);
+
+		for (TaskPeriod& Entry : TaskPeriods) {
+			if (Entry.name != name)
+				continue;
+
+			if (intervalMicros > Entry.worstMicros) {
+				Entry.worstMicros = intervalMicros;
+				Entry.periodMicros = periodMicros;
+			}
+
+			return;
+		}
+
+		TaskPeriods.push_back({ name, intervalMicros, periodMicros, IsTaskThread });
+	}
+
+	TaskPeriod* FindTaskPeriod(const char* name) {
+		for (TaskPeriod& Entry : TaskPeriods) {
+			if (Entry.name == name)
+				return &Entry;
+		}
+
+		return nullptr;
+	}
+
+	uint64_t getWorstTaskPeriod(const char* name) {
+		std::lock_guard<std::mutex> Lock(TaskPeriodMutex);
+		TaskPeriod* Entry = FindTaskPeriod(name);
+		return Entry != nullptr ? Entry->worstMicros : 0;
+	}
+
+	uint64_t getWorstTaskDuePeriod(const char* name) {
+		std::lock_guard<std::mutex> Lock(TaskPeriodMutex);
+		TaskPeriod* Entry = FindTaskPeriod(name);
+		return Entry != nullptr ? Entry->periodMicros : 0;
+	}
+
+	bool isTaskPeriodFromLoop(const char* name) {
+		std::lock_guard<std::mutex> Lock(TaskPeriodMutex);
+		TaskPeriod* Entry = FindTaskPeriod(name);
+		return Entry != nullptr && !Entry->isFromTask;
+	}
+
+	int getTaskPeriodCount() {
+		std::lock_guard<std::mutex> Lock(TaskPeriodMutex);
+		return TaskPeriods.size();
+	}
+
+	const char* getTaskPeriodName(int index) {
+		std::lock_guard<std::mutex> Lock(TaskPeriodMutex);
+
+		if (index < 0 || index >= (int)TaskPeriods.size())
+			return nullptr;
+
+		return TaskPeriods[index].name.c_str();
+	}
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameter, UBaseType_t priority, TaskHandle_t* handle, BaseType_t coreID) {
+	// Threads racing on the simulated clock would make runs nondeterministic
+	if (!NativeHAL::isRealTime() || NativeHAL::AreTasksStopping)
+		return pdFAIL;
+
+	NativeHAL::RunningTaskCount++;
+
+	std::thread Thread([function, parameter, coreID]() {
+		NativeHAL::IsTaskThread = true;
+		NativeHAL::CurrentCoreID = coreID;
+		function(parameter);
+
+		// Returning from a task function is an error on FreeRTOS, just stop counting it here
+		NativeHAL::RunningTaskCount--;
+	});
+
+	if (handle != nullptr)
+		*handle = (TaskHandle_t)Thread.native_handle();
+
+	Thread.detach();
+	return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) {
+	delay(ticks * portTICK_PERIOD_MS);
+}
+
+TickType_t xTaskGetTickCount() {
+	return millis() / portTICK_PERIOD_MS;
+}
+
+BaseType_t xPortGetCoreID() {
+	return NativeHAL::CurrentCoreID;
+}
\ No newline at end of file
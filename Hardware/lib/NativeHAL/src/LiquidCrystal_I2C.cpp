@@ -0,0 +1,99 @@
+#include "LiquidCrystal_I2C.h"
+#include "Arduino.h"
+#include "NativeHAL.h"
+#include <string.h>
+
+TwoWire Wire;
+
+// Each HD44780 byte goes out as two nibbles, each strobed with EN high then low, in one I2C transaction
+#define LCD_I2C_BYTES_PER_TRANSFER 5
+
+// Execution time of "clear display" and "return home"
+#define LCD_SLOW_COMMAND_MICROS 1520
+#define LCD_COMMAND_MICROS 37
+
+LiquidCrystal_I2C::LiquidCrystal_I2C() {
+	this->resetRows();
+}
+
+LiquidCrystal_I2C::LiquidCrystal_I2C(PCF8574_address addr, uint8_t P0, uint8_t P1, uint8_t P2, uint8_t P3, uint8_t P4, uint8_t P5, uint8_t P6, uint8_t P7, backlightPolarity polarity) : LiquidCrystal_I2C() {}
+
+bool LiquidCrystal_I2C::begin(uint8_t columns, uint8_t rows, uint8_t charSize) {
+	if (columns > MAX_COLUMNS || rows > MAX_ROWS)
+		return false;
+
+	this->columnCount = columns;
+	this->rowCount = rows;
+	this->clear();
+	return true;
+}
+
+void LiquidCrystal_I2C::clear() {
+	this->resetRows();
+	this->sendCommand();
+	delayMicroseconds(LCD_SLOW_COMMAND_MICROS);
+}
+
+void LiquidCrystal_I2C::home() {
+	this->cursorColumn = 0;
+	this->cursorRow = 0;
+	this->sendCommand();
+	delayMicroseconds(LCD_SLOW_COMMAND_MICROS);
+}
+
+void LiquidCrystal_I2C::setCursor(uint8_t column, uint8_t row) {
+	this->cursorColumn = column;
+	this->cursorRow = row < this->rowCount ? row : this->rowCount - 1;
+	this->sendCommand();
+}
+
+void LiquidCrystal_I2C::noBacklight() {
+	this->busBytes += 2;
+}
+
+void LiquidCrystal_I2C::backlight() {
+	this->busBytes += 2;
+}
+
+size_t LiquidCrystal_I2C::write(uint8_t value) {
+	if (this->cursorColumn < MAX_COLUMNS)
+		this->rows[this->cursorRow][this->cursorColumn] = (char)value;
+
+	this->cursorColumn++;
+	this->busBytes += LCD_I2C_BYTES_PER_TRANSFER;
+	delayMicroseconds(LCD_I2C_BYTES_PER_TRANSFER * NativeHAL::getI2CByteMicros() + LCD_COMMAND_MICROS);
+	return 1;
+}
+
+const char* LiquidCrystal_I2C::getRow(uint8_t row) {
+	return row < MAX_ROWS ? this->rows[row] : "";
+}
+
+uint32_t LiquidCrystal_I2C::getBusBytes() {
+	return this->busBytes;
+}
+
+uint32_t LiquidCrystal_I2C::getCommandCount() {
+	return this->commandCount;
+}
+
+void LiquidCrystal_I2C::resetCounters() {
+	this->busBytes = 0;
+	this->commandCount = 0;
+}
+
+void LiquidCrystal_I2C::sendCommand() {
+	this->commandCount++;
+	this->busBytes += LCD_I2C_BYTES_PER_TRANSFER;
+	delayMicroseconds(LCD_I2C_BYTES_PER_TRANSFER * NativeHAL::getI2CByteMicros() + LCD_COMMAND_MICROS);
+}
+
+void LiquidCrystal_I2C::resetRows() {
+	for (uint8_t row = 0; row < MAX_ROWS; row++) {
+		memset(this->rows[row], ' ', MAX_COLUMNS);
+		this->rows[row][MAX_COLUMNS] = '\0';
+	}
+
+	this->cursorColumn = 0;
+	this->cursorRow = 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include "Print.h"
+#include "Wire.h"
+
+typedef enum {
+	PCF8574_ADDR_A21_A11_A01 = 0x27,
+	PCF8574A_ADDR_A21_A11_A01 = 0x3F,
+} PCF8574_address;
+
+typedef enum {
+	POSITIVE,
+	NEGATIVE,
+} backlightPolarity;
+
+#define LCD_5x8DOTS 0x00
+#define LCD_5x10DOTS 0x04
+
+// Fake HD44780 behind a PCF8574, keeps the visible characters and counts bus traffic
+class LiquidCrystal_I2C : public Print {
+	public:
+		LiquidCrystal_I2C();
+		LiquidCrystal_I2C(PCF8574_address addr, uint8_t P0, uint8_t P1, uint8_t P2, uint8_t P3, uint8_t P4, uint8_t P5, uint8_t P6, uint8_t P7, backlightPolarity polarity);
+
+		bool begin(uint8_t columns, uint8_t rows, uint8_t charSize);
+		void clear();
+		void home();
+		void setCursor(uint8_t column, uint8_t row);
+		void noBacklight();
+		void backlight();
+		size_t write(uint8_t value) override;
+		using Print::write;
+
+		// Visible characters of one row, LCD_MAX_COLUMNS wide and null terminated
+		const char* getRow(uint8_t row);
+
+		// I2C bytes sent to the PCF8574, 4 per HD44780 nibble pair plus the address byte
+		uint32_t getBusBytes();
+		uint32_t getCommandCount();
+		void resetCounters();
+
+		static const uint8_t MAX_COLUMNS = 20;
+		static const uint8_t MAX_ROWS = 4;
+
+	private:
+		void sendCommand();
+		void resetRows();
+
+		char rows[MAX_ROWS][MAX_COLUMNS + 1];
+		uint8_t columnCount = 16;
+		uint8_t rowCount = 2;
+		uint8_t cursorColumn = 0;
+		uint8_t cursorRow = 0;
+
+		uint32_t busBytes = 0;
+		uint32_t commandCount = 0;
+};
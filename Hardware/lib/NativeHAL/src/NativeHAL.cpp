@@ -0,0 +1,487 @@
+#include "Arduino.h"
+#include "NativeHAL.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+namespace NativeHAL {
+	uint64_t CurrentMicros = 0;
+	uint64_t WakeupMicros = UINT64_MAX;
+	thread_local uint64_t DelayedMicros = 0; // Per thread, so each task only sees its own idle time
+
+	bool IsRealTime = false;
+	std::chrono::steady_clock::time_point RealTimeEpoch;
+	uint64_t RealTimeBaseMicros = 0; // Clock value at RealTimeEpoch
+
+	void ParkIfTasksStopping(); // FreeRTOS.cpp
+
+	uint8_t PinModes[NATIVE_HAL_PIN_COUNT] = {};
+	uint8_t DigitalLevels[NATIVE_HAL_PIN_COUNT] = {};
+	uint16_t AnalogValues[NATIVE_HAL_PIN_COUNT] = {};
+	uint64_t LastWriteMicros[NATIVE_HAL_PIN_COUNT] = {};
+	void (*DigitalWriteHook)(uint8_t pin, uint8_t level) = nullptr;
+	uint16_t (*AnalogReadHook)(uint8_t pin, uint16_t value) = nullptr;
+
+	struct ScheduledEdge {
+		uint64_t micros;
+		uint8_t pin;
+		uint8_t level;
+	};
+
+	std::vector<ScheduledEdge> ScheduledEdges; // Sorted by time
+	std::atomic<uint64_t> NextEdgeMicros(UINT64_MAX); // Lets the clock skip the lock while nothing is scheduled
+	std::mutex EdgeMutex;
+	void (*InterruptHandlers[NATIVE_HAL_PIN_COUNT])(void*) = {};
+	void* InterruptArgs[NATIVE_HAL_PIN_COUNT] = {};
+	int InterruptModes[NATIVE_HAL_PIN_COUNT] = {};
+	thread_local bool IsInInterrupt = false;
+	thread_local uint64_t InterruptMicros = 0; // Edge time a running handler sees
+
+	struct ScheduledCall {
+		uint64_t micros;
+		void (*call)(void*);
+		void* arg;
+	};
+
+	std::vector<ScheduledCall> ScheduledCalls; // Sorted by time
+	std::atomic<uint64_t> NextCallMicros(UINT64_MAX);
+	std::mutex CallMutex;
+
+	void OnDHTPinMode(uint8_t pin, uint8_t previousMode, uint8_t mode); // DHTWaveform.cpp
+
+	int LEDCPins[NATIVE_HAL_LEDC_CHANNEL_COUNT] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };
+	uint32_t LEDCDuty[NATIVE_HAL_LEDC_CHANNEL_COUNT] = {};
+	double LEDCFrequency[NATIVE_HAL_LEDC_CHANNEL_COUNT] = {}; // 0 until ledcSetup()
+	uint8_t LEDCResolution[NATIVE_HAL_LEDC_CHANNEL_COUNT] = {};
+	uint32_t LEDCWriteCount = 0;
+
+	float DHTTemperature = 27.0f;
+	float DHTHumidity = 60.0f;
+
+	uint32_t I2CByteMicros = 90;
+
+	bool IsSerialQuiet = false;
+
+	uint32_t RandomState = 1;
+
+	// Apply the edges the clock has passed, in order, each handler seeing the time of its own edge
+	void DeliverEdges(uint64_t until) {
+		if (until < NextEdgeMicros.load())
+			return;
+
+		std::lock_guard<std::mutex> Lock(EdgeMutex);
+		size_t Delivered = 0;
+
+		while (Delivered < ScheduledEdges.size() && ScheduledEdges[Delivered].micros <= until) {
+			ScheduledEdge Edge = ScheduledEdges[Delivered++];
+			if (DigitalLevels[Edge.pin] == Edge.level)
+				continue;
+
+			DigitalLevels[Edge.pin] = Edge.level;
+
+			int Mode = InterruptModes[Edge.pin];
+			bool IsTriggered = Mode == CHANGE || (Mode == RISING && Edge.level == HIGH) || (Mode == FALLING && Edge.level == LOW);
+			if (InterruptHandlers[Edge.pin] == nullptr || !IsTriggered)
+				continue;
+
+			IsInInterrupt = true;
+			InterruptMicros = Edge.micros;
+			InterruptHandlers[Edge.pin](InterruptArgs[Edge.pin]);
+			IsInInterrupt = false;
+		}
+
+		ScheduledEdges.erase(ScheduledEdges.begin(), ScheduledEdges.begin() + Delivered);
+		NextEdgeMicros = ScheduledEdges.empty() ? UINT64_MAX : ScheduledEdges.front().micros;
+	}
+
+	// Run the calls the clock has passed, outside the lock so they may schedule more
+	void DeliverCalls(uint64_t until) {
+		while (until >= NextCallMicros.load()) {
+			ScheduledCall Call;
+			{
+				std::lock_guard<std::mutex> Lock(CallMutex);
+				if (ScheduledCalls.empty() || ScheduledCalls.front().micros > until)
+					return;
+
+				Call = ScheduledCalls.front();
+				ScheduledCalls.erase(ScheduledCalls.begin());
+				NextCallMicros = ScheduledCalls.empty() ? UINT64_MAX : ScheduledCalls.front().micros;
+			}
+
+			Call.call(Call.arg);
+		}
+	}
+
+	uint64_t nowMicros() {
+		if (IsInInterrupt)
+			return InterruptMicros;
+
+		if (!IsRealTime)
+			return CurrentMicros;
+
+		auto Elapsed = std::chrono::steady_clock::now() - RealTimeEpoch;
+		uint64_t Now = RealTimeBaseMicros + std::chrono::duration_cast<std::chrono::microseconds>(Elapsed).count();
+
+		// The wall clock moves without anyone stepping it, whoever looks at it first gets the edges it passed
+		DeliverEdges(Now);
+		DeliverCalls(Now);
+		return Now;
+	}
+
+	void setMicros(uint64_t micros) {
+		if (IsRealTime) {
+			RealTimeEpoch = std::chrono::steady_clock::now();
+			RealTimeBaseMicros = micros;
+		}
+		else {
+			CurrentMicros = micros;
+		}
+
+		DeliverEdges(micros);
+		DeliverCalls(micros);
+	}
+
+	void advanceMicros(uint64_t micros) {
+		if (IsRealTime) {
+			std::this_thread::sleep_for(std::chrono::microseconds(micros));
+			return;
+		}
+
+		CurrentMicros += micros;
+		DeliverEdges(CurrentMicros);
+		DeliverCalls(CurrentMicros);
+	}
+
+	void setRealTime(bool realTime) {
+		if (realTime == IsRealTime)
+			return;
+
+		if (realTime) {
+			RealTimeEpoch = std::chrono::steady_clock::now();
+			RealTimeBaseMicros = CurrentMicros;
+		}
+		else {
+			CurrentMicros = nowMicros();
+		}
+
+		IsRealTime = realTime;
+	}
+
+	bool isRealTime() {
+		return IsRealTime;
+	}
+
+	uint64_t getDelayedMicros() {
+		return DelayedMicros;
+	}
+
+	void hintWakeup(uint64_t micros) {
+		// Only meaningful to a driver stepping the simulated clock, and not thread safe
+		if (IsRealTime)
+			return;
+
+		if (micros < WakeupMicros)
+			WakeupMicros = micros;
+	}
+
+	uint64_t takeWakeup() {
+		uint64_t wakeup = WakeupMicros;
+		WakeupMicros = UINT64_MAX;
+
+		// Scheduled calls stay hinted until they ran
+		uint64_t NextCall = NextCallMicros.load();
+		return NextCall < wakeup ? NextCall : wakeup;
+	}
+
+	void scheduleCall(uint64_t micros, void (*call)(void*), void* arg) {
+		{
+			std::lock_guard<std::mutex> Lock(CallMutex);
+			ScheduledCall Call = { micros, call, arg };
+
+			auto Position = std::upper_bound(ScheduledCalls.begin(), ScheduledCalls.end(), Call, [](const ScheduledCall& a, const ScheduledCall& b) {
+				return a.micros < b.micros;
+			});
+			ScheduledCalls.insert(Position, Call);
+			NextCallMicros = ScheduledCalls.front().micros;
+		}
+	}
+
+	uint8_t getPinMode(uint8_t pin) {
+		return pin < NATIVE_HAL_PIN_COUNT ? PinModes[pin] : 0;
+	}
+
+	uint8_t getDigitalLevel(uint8_t pin) {
+		return pin < NATIVE_HAL_PIN_COUNT ? DigitalLevels[pin] : LOW;
+	}
+
+	void setDigitalLevel(uint8_t pin, uint8_t level) {
+		if (pin < NATIVE_HAL_PIN_COUNT)
+			DigitalLevels[pin] = level ? HIGH : LOW;
+	}
+
+	void setAnalogValue(uint8_t pin, uint16_t value) {
+		if (pin < NATIVE_HAL_PIN_COUNT)
+			AnalogValues[pin] = value > 4095 ? 4095 : value;
+	}
+
+	uint32_t getLEDCDuty(uint8_t channel) {
+		return channel < NATIVE_HAL_LEDC_CHANNEL_COUNT ? LEDCDuty[channel] : 0;
+	}
+
+	int getLEDCPin(uint8_t channel) {
+		return channel < NATIVE_HAL_LEDC_CHANNEL_COUNT ? LEDCPins[channel] : -1;
+	}
+
+	uint32_t getLEDCPulseMicros(uint8_t channel) {
+		if (channel >= NATIVE_HAL_LEDC_CHANNEL_COUNT || LEDCFrequency[channel] <= 0.0)
+			return 0;
+
+		double PeriodMicros = 1000000.0 / LEDCFrequency[channel];
+		return (uint32_t)(LEDCDuty[channel] * PeriodMicros / ((1UL << LEDCResolution[channel]) - 1) + 0.5);
+	}
+
+	uint32_t getLEDCWriteCount() {
+		return LEDCWriteCount;
+	}
+
+	uint64_t getLastWriteMicros(uint8_t pin) {
+		return pin < NATIVE_HAL_PIN_COUNT ? LastWriteMicros[pin] : 0;
+	}
+
+	void scheduleEdge(uint8_t pin, uint64_t micros, uint8_t level) {
+		if (pin >= NATIVE_HAL_PIN_COUNT)
+			return;
+
+		std::lock_guard<std::mutex> Lock(EdgeMutex);
+		ScheduledEdge Edge = { micros, pin, (uint8_t)(level ? HIGH : LOW) };
+
+		// After the edges already scheduled for the same time
+		auto Position = std::upper_bound(ScheduledEdges.begin(), ScheduledEdges.end(), Edge, [](const ScheduledEdge& a, const ScheduledEdge& b) {
+			return a.micros < b.micros;
+		});
+		ScheduledEdges.insert(Position, Edge);
+		NextEdgeMicros = ScheduledEdges.front().micros;
+	}
+
+	void setDigitalWriteHook(void (*hook)(uint8_t pin, uint8_t level)) {
+		DigitalWriteHook = hook;
+	}
+
+	void setAnalogReadHook(uint16_t (*hook)(uint8_t pin, uint16_t value)) {
+		AnalogReadHook = hook;
+	}
+
+	void setI2CClockHz(uint32_t hz) {
+		I2CByteMicros = (9 * 1000000 + hz - 1) / hz;
+	}
+
+	uint32_t getI2CByteMicros() {
+		return I2CByteMicros;
+	}
+
+	void setDHTReading(float temperature, float humidity) {
+		DHTTemperature = temperature;
+		DHTHumidity = humidity;
+	}
+
+	void setSerialQuiet(bool quiet) {
+		IsSerialQuiet = quiet;
+	}
+}
+
+#pragma region Arduino Core
+
+void pinMode(uint8_t pin, uint8_t mode) {
+	if (pin >= NATIVE_HAL_PIN_COUNT)
+		return;
+
+	uint8_t PreviousMode = NativeHAL::PinModes[pin];
+	NativeHAL::PinModes[pin] = mode;
+	NativeHAL::OnDHTPinMode(pin, PreviousMode, mode);
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+	NativeHAL::setDigitalLevel(pin, val);
+
+	if (pin < NATIVE_HAL_PIN_COUNT)
+		NativeHAL::LastWriteMicros[pin] = NativeHAL::nowMicros();
+
+	if (NativeHAL::DigitalWriteHook != nullptr)
+		NativeHAL::DigitalWriteHook(pin, val ? HIGH : LOW);
+}
+
+int digitalRead(uint8_t pin) {
+	return NativeHAL::getDigitalLevel(pin);
+}
+
+uint16_t analogRead(uint8_t pin) {
+	uint16_t Value = pin < NATIVE_HAL_PIN_COUNT ? NativeHAL::AnalogValues[pin] : 0;
+
+	if (NativeHAL::AnalogReadHook != nullptr)
+		Value = NativeHAL::AnalogReadHook(pin, Value);
+
+	return Value;
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode) {
+	if (pin >= NATIVE_HAL_PIN_COUNT)
+		return;
+
+	std::lock_guard<std::mutex> Lock(NativeHAL::EdgeMutex);
+	NativeHAL::InterruptHandlers[pin] = handler;
+	NativeHAL::InterruptArgs[pin] = arg;
+	NativeHAL::InterruptModes[pin] = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+	if (pin >= NATIVE_HAL_PIN_COUNT)
+		return;
+
+	std::lock_guard<std::mutex> Lock(NativeHAL::EdgeMutex);
+	NativeHAL::InterruptHandlers[pin] = nullptr;
+	NativeHAL::InterruptArgs[pin] = nullptr;
+	NativeHAL::InterruptModes[pin] = 0;
+}
+
+unsigned long millis() {
+	return NativeHAL::nowMicros() / 1000;
+}
+
+unsigned long micros() {
+	return NativeHAL::nowMicros();
+}
+
+void delay(uint32_t ms) {
+	NativeHAL::ParkIfTasksStopping();
+	NativeHAL::advanceMicros((uint64_t)ms * 1000);
+	NativeHAL::DelayedMicros += (uint64_t)ms * 1000;
+}
+
+void delayMicroseconds(uint32_t us) {
+	NativeHAL::advanceMicros(us);
+}
+
+void yield() {}
+
+long random(long howbig) {
+	if (howbig <= 0)
+		return 0;
+
+	// xorshift32, the target draws from the hardware RNG instead
+	uint32_t& State = NativeHAL::RandomState;
+	State ^= State << 13;
+	State ^= State >> 17;
+	State ^= State << 5;
+	return State % howbig;
+}
+
+long random(long howsmall, long howbig) {
+	if (howsmall >= howbig)
+		return howsmall;
+
+	return howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed) {
+	if (seed != 0)
+		NativeHAL::RandomState = seed;
+}
+
+double ledcSetup(uint8_t channel, double freq, uint8_t resolution_bits) {
+	// The timer is 20 bits wide at most, like on the ESP32
+	if (channel >= NATIVE_HAL_LEDC_CHANNEL_COUNT || resolution_bits < 1 || resolution_bits > 20)
+		return 0;
+
+	NativeHAL::LEDCDuty[channel] = 0;
+	NativeHAL::LEDCFrequency[channel] = freq;
+	NativeHAL::LEDCResolution[channel] = resolution_bits;
+	return freq;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel) {
+	if (channel >= NATIVE_HAL_LEDC_CHANNEL_COUNT)
+		return;
+
+	NativeHAL::LEDCPins[channel] = pin;
+	pinMode(pin, OUTPUT);
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty) {
+	if (channel >= NATIVE_HAL_LEDC_CHANNEL_COUNT)
+		return;
+
+	NativeHAL::LEDCDuty[channel] = duty;
+	NativeHAL::LEDCWriteCount++;
+
+	int pin = NativeHAL::LEDCPins[channel];
+	if (pin >= 0 && pin < NATIVE_HAL_PIN_COUNT)
+		NativeHAL::LastWriteMicros[pin] = NativeHAL::nowMicros();
+}
+
+uint32_t ledcRead(uint8_t channel) {
+	return NativeHAL::getLEDCDuty(channel);
+}
+
+#pragma endregion
+
+#pragma region Serial
+
+void HardwareSerial::begin(unsigned long baud) {}
+
+void HardwareSerial::end() {}
+
+int HardwareSerial::available() {
+	return 0;
+}
+
+int HardwareSerial::read() {
+	return -1;
+}
+
+int HardwareSerial::peek() {
+	return -1;
+}
+
+void HardwareSerial::flush() {
+	if (!NativeHAL::IsSerialQuiet)
+		fflush(stdout);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+	if (!NativeHAL::IsSerialQuiet && c != '\r')
+		fputc(c, stdout);
+
+	return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+	if (NativeHAL::IsSerialQuiet)
+		return size;
+
+	for (size_t i = 0; i < size; i++) {
+		if (buffer[i] != '\r')
+			fputc(buffer[i], stdout);
+	}
+
+	return size;
+}
+
+#pragma endregion
+
+uint32_t EspClass::getFreeHeap() {
+	return 256 * 1024;
+}
+
+uint32_t EspClass::getCpuFreqMHz() {
+	return 240;
+}
+
+uint32_t EspClass::getCycleCount() {
+	return (uint32_t)(NativeHAL::nowMicros() * this->getCpuFreqMHz());
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+#pragma once
+// Control surface of the host HAL: simulated clock, pin states and network stand-ins
+#include <stdint.h>
+#include <stddef.h>
+
+#define NATIVE_HAL_PIN_COUNT 40
+#define NATIVE_HAL_LEDC_CHANNEL_COUNT 16
+
+namespace NativeHAL {
+	// One side of an in-process WebSocket connection
+	class WebSocketConnection {
+		public:
+			virtual ~WebSocketConnection() {}
+
+			// Queue one complete frame for the other side to read
+			virtual void send(const uint8_t* data, size_t size) = 0;
+			virtual void close() = 0;
+
+			// Bytes sent by the server that the firmware has not read yet
+			virtual size_t receivePending() = 0;
+	};
+
+	// Stand-in for the backend, replaces DNS + TCP + WebSocket upgrade
+	class WebSocketServer {
+		public:
+			virtual ~WebSocketServer() {}
+
+			// False drops every SYN, a TCP connect then only ends by its timeout
+			virtual bool isListening() { return true; }
+
+			// Return false to refuse the connection
+			virtual bool onConnect(WebSocketConnection* connection, const char* host, uint16_t port) = 0;
+
+			// One complete frame written by the firmware
+			virtual void onMessage(WebSocketConnection* connection, const uint8_t* data, size_t size) = 0;
+
+			// The firmware consumed received bytes, receivePending() tells how many are left
+			virtual void onRead(WebSocketConnection* connection) {}
+
+			virtual void onDisconnect(WebSocketConnection* connection) {}
+	};
+
+	#pragma region Clock
+
+	uint64_t nowMicros();
+	void setMicros(uint64_t micros);
+	void advanceMicros(uint64_t micros);
+
+	// Follow the host's wall clock from now on, delay() and advanceMicros() really sleep. Required for FreeRTOS tasks
+	void setRealTime(bool realTime);
+	bool isRealTime();
+
+	// Total time the calling thread passed in delay(), which yields to FreeRTOS on target unlike delayMicroseconds()
+	uint64_t getDelayedMicros();
+
+	// Earliest time a polled TickTimer fires next, lets a driver skip idle time instead of spinning
+	void hintWakeup(uint64_t micros);
+	uint64_t takeWakeup(); // Returns UINT64_MAX if nothing was hinted since the last call
+
+	// Call once the clock reaches the given time, on whichever thread moves it there. takeWakeup() includes it until then
+	void scheduleCall(uint64_t micros, void (*call)(void*), void* arg);
+
+	#pragma endregion
+
+	#pragma region Tasks
+
+	// Make every task created by xTaskCreatePinnedToCore() park at its next delay(), call before returning from main()
+	void stopTasks();
+
+	// Time between two consecutive starts of a named periodic job and the period it was due at, the worst case is kept
+	void reportTaskPeriod(const char* name, uint64_t intervalMicros, uint64_t periodMicros);
+	uint64_t getWorstTaskPeriod(const char* name); // Longest interval, 0 if the name was never reported
+	uint64_t getWorstTaskDuePeriod(const char* name); // Period the task was due at for the longest interval
+	bool isTaskPeriodFromLoop(const char* name); // Reported from loop() rather than a FreeRTOS task, i.e. by a control task
+	int getTaskPeriodCount();
+	const char* getTaskPeriodName(int index);
+
+	#pragma endregion
+
+	#pragma region GPIO
+
+	uint8_t getPinMode(uint8_t pin);
+	uint8_t getDigitalLevel(uint8_t pin);
+	void setDigitalLevel(uint8_t pin, uint8_t level);
+	void setAnalogValue(uint8_t pin, uint16_t value);
+	uint32_t getLEDCDuty(uint8_t channel);
+	int getLEDCPin(uint8_t channel); // -1 if the channel is not attached
+	uint32_t getLEDCPulseMicros(uint8_t channel); // High time of every period the channel generates, from its duty, frequency and resolution
+	uint32_t getLEDCWriteCount(); // ledcWrite() calls since the start, the only CPU time LEDC pulses take
+	uint64_t getLastWriteMicros(uint8_t pin); // Time of the last digitalWrite() or ledcWrite() to the pin
+
+	// Drive an input to a level once the clock reaches the given time, calling the interrupt handler attached to the pin
+	void scheduleEdge(uint8_t pin, uint64_t micros, uint8_t level);
+
+	// Called after every digitalWrite(), e.g. to trace actuators
+	void setDigitalWriteHook(void (*hook)(uint8_t pin, uint8_t level));
+
+	// Called by every analogRead() with the value set for the pin, returns what the read gives, e.g. with noise of its own
+	void setAnalogReadHook(uint16_t (*hook)(uint8_t pin, uint16_t value));
+
+	#pragma endregion
+
+	#pragma region Sensors
+
+	void setDHTReading(float temperature, float humidity);
+
+	// The sensor on this pin answers a start signal with a frame of the setDHTReading() values, edge by edge on the clock
+	void setDHTPin(uint8_t pin);
+	uint32_t getDHTFrameCount(); // Frames sent since the start
+
+	#pragma endregion
+
+	#pragma region I2C
+
+	// Bus clock the LCD backpack is driven at, 100 kHz by default. Each byte takes 9 clocks
+	void setI2CClockHz(uint32_t hz);
+	uint32_t getI2CByteMicros();
+
+	#pragma endregion
+
+	#pragma region Network
+
+	void setWiFiAvailable(bool available);
+	void setWiFiConnectDelayMicros(uint64_t micros);
+	void setWebSocketServer(WebSocketServer* server);
+	WebSocketServer* getWebSocketServer();
+
+	// Time a DNS answer or a TCP handshake takes, a blocking WiFiClient::connect() adds both to the clock
+	void setNetworkDelayMicros(uint64_t micros);
+	uint32_t getDNSLookupCount();
+	uint32_t getTcpConnectCount(); // SYNs sent, by blocking and non-blocking connects alike
+	int getOpenSocketCount(); // Sockets not closed yet, e.g. to find a leak
+
+	#pragma endregion
+
+	#pragma region Flash
+
+	// The partition behind esp_partition_*() starts out erased and lives in memory, a file keeps it across runs
+	// Returns false if the file can't be opened or created
+	bool setFlashFile(const char* path);
+
+	// Program and erase times of typical SPI NOR flash are added to the clock, like the CPU stall they cause on target
+	uint64_t getFlashBytesWritten();
+	uint32_t getFlashEraseCount(); // Sectors erased in total
+	uint32_t getFlashMaxSectorErases(); // Erases of the most worn sector
+
+	#pragma endregion
+
+	#pragma region Serial
+
+	// When quiet, Serial output is discarded instead of written to stdout
+	void setSerialQuiet(bool quiet);
+
+	#pragma endregion
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "Arduino.h"
+#include "NativeHAL.h"
+#include <hal/gpio_types.h>
+#include "config.h"
+#include "Scheduler.h"
+#include <chrono>
+#include <string>
+
+#define TASK_PERIOD_TOLERANCE 20000 // What the host may add to a start on top of one period, threads and sleeps aren't exact
+
+void setup();
+void loop();
+
+namespace {
+	// Accepts every request with an empty success reply, optionally blocking the writer like a stalled TCP send would
+	class EchoServer : public NativeHAL::WebSocketServer {
+		public:
+			uint32_t stallMicros = 0;
+
+			bool onConnect(NativeHAL::WebSocketConnection* connection, const char* host, uint16_t port) override {
+				this->connection = connection;
+				return true;
+			}
+
+			void onDisconnect(NativeHAL::WebSocketConnection* connection) override {
+				if (connection == this->connection)
+					this->connection = nullptr;
+			}
+
+			// Drop the connection without calling back into the firmware, before either side is destroyed
+			void shutdown() {
+				if (this->connection != nullptr)
+					this->connection->close();
+
+				this->connection = nullptr;
+			}
+
+			void onMessage(NativeHAL::WebSocketConnection* connection, const uint8_t* data, size_t size) override {
+				if (this->stallMicros > 0)
+					delayMicroseconds(this->stallMicros);
+
+				std::string Request((const char*)data, size);
+				std::string Endpoint;
+
+				size_t KeyStart = Request.find("\"key\":\"");
+				if (KeyStart != std::string::npos) {
+					KeyStart += 7;
+					Endpoint = Request.substr(KeyStart, Request.find('"', KeyStart) - KeyStart);
+				}
+
+				std::string Reply = "{\"status\":\"success\",\"code\":200,\"endpoint\":\"" + Endpoint + "\",\"data\":{}}";
+				connection->send((const uint8_t*)Reply.data(), Reply.size());
+				connection->send((const uint8_t*)"\r", 1);
+			}
+
+		private:
+			NativeHAL::WebSocketConnection* connection = nullptr;
+	};
+}
+
+// Runs setup() and loop() against the simulated clock, defined weak so other host programs can bring their own main()
+__attribute__((weak)) int main(int argc, char** argv) {
+	double SimulatedSeconds = 60.0;
+	uint64_t LoopCostMicros = 50; // Time a loop() iteration takes on target besides any delay()
+	bool IsRealTime = false;
+	bool ShouldServeEcho = false;
+	EchoServer Server;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+			SimulatedSeconds = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--loop-cost-us") == 0 && i + 1 < argc) {
+			LoopCostMicros = strtoull(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "--quiet") == 0) {
+			NativeHAL::setSerialQuiet(true);
+		}
+		else if (strcmp(argv[i], "--realtime") == 0) {
+			IsRealTime = true;
+		}
+		else if (strcmp(argv[i], "--echo-server") == 0) {
+			ShouldServeEcho = true;
+		}
+		else if (strcmp(argv[i], "--network-stall-ms") == 0 && i + 1 < argc) {
+			Server.stallMicros = atoi(argv[++i]) * 1000;
+			ShouldServeEcho = true;
+			IsRealTime = true; // The network only gets a task of its own on the wall clock
+		}
+		else {
+			fprintf(stderr, "Usage: %s [--seconds N] [--loop-cost-us N] [--quiet] [--realtime] [--echo-server] [--network-stall-ms N]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	// FreeRTOS tasks only run as threads against the wall clock
+	NativeHAL::setRealTime(IsRealTime);
+
+	if (ShouldServeEcho)
+		NativeHAL::setWebSocketServer(&Server);
+
+	#if ENABLE_DHT == true
+		NativeHAL::setDHTPin(DHT_PIN);
+	#endif
+
+	// Every scheduler reports its starts, from loop() or from the network task
+	Scheduler::setPeriodObserver([](const Scheduler* scheduler, const SchedulerTask& task, ulong intervalMicros, ulong periodMicros) {
+		NativeHAL::reportTaskPeriod(task.name, intervalMicros, periodMicros);
+	});
+
+	auto WallStart = std::chrono::steady_clock::now();
+
+	setup();
+
+	uint64_t StartMicros = NativeHAL::nowMicros();
+	uint64_t EndMicros = StartMicros + (uint64_t)(SimulatedSeconds * 1000000.0);
+	uint64_t StartDelayed = NativeHAL::getDelayedMicros();
+	uint64_t Iterations = 0;
+	uint64_t MaxLoopMicros = 0;
+
+	while (NativeHAL::nowMicros() < EndMicros) {
+		uint64_t LoopStart = NativeHAL::nowMicros();
+		uint64_t DelayedStart = NativeHAL::getDelayedMicros();
+
+		loop();
+
+		// The wall clock already accounts for the real cost
+		if (!IsRealTime)
+			NativeHAL::advanceMicros(LoopCostMicros);
+
+		// Time spent in delay() is handed back to FreeRTOS, only count the rest
+		uint64_t LoopMicros = NativeHAL::nowMicros() - LoopStart - (NativeHAL::getDelayedMicros() - DelayedStart);
+		if (LoopMicros > MaxLoopMicros)
+			MaxLoopMicros = LoopMicros;
+
+		Iterations++;
+	}
+
+	NativeHAL::stopTasks();
+
+	uint64_t ElapsedMicros = NativeHAL::nowMicros() - StartMicros;
+	uint64_t BusyMicros = ElapsedMicros - (NativeHAL::getDelayedMicros() - StartDelayed);
+
+	double WallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - WallStart).count();
+
+	fprintf(stderr, "\n[native] %llu loop() iterations, %.1f s simulated in %.3f s wall (%.0fx), longest iteration %llu us\n",
+		(unsigned long long)Iterations,
+		NativeHAL::nowMicros() / 1000000.0,
+		WallSeconds,
+		WallSeconds > 0 ? (NativeHAL::nowMicros() / 1000000.0) / WallSeconds : 0.0,
+		(unsigned long long)MaxLoopMicros);
+	fprintf(stderr, "[native] CPU busy %.2f%% of loop() time, the rest was spent in delay()\n",
+		ElapsedMicros > 0 ? BusyMicros * 100.0 / ElapsedMicros : 0.0);
+
+	// Tasks run from loop() are the control loop, none of them may start more than TASK_PERIOD_TOLERANCE past its period while the network stalls
+	int LateTaskCount = 0;
+	for (int i = 0; i < NativeHAL::getTaskPeriodCount(); i++) {
+		const char* Name = NativeHAL::getTaskPeriodName(i);
+		bool IsControlTask = NativeHAL::isTaskPeriodFromLoop(Name);
+		uint64_t Worst = NativeHAL::getWorstTaskPeriod(Name);
+		uint64_t Period = NativeHAL::getWorstTaskDuePeriod(Name);
+		bool IsLate = Worst > Period + TASK_PERIOD_TOLERANCE;
+
+		fprintf(stderr, "[native] worst period of %-12s %8.1f ms, due every %8.1f ms%s%s\n",
+			Name,
+			Worst / 1000.0,
+			Period / 1000.0,
+			IsLate ? ", missed" : "",
+			IsControlTask ? "" : " (network task)");
+
+		if (IsControlTask && IsLate)
+			LateTaskCount++;
+	}
+
+	Server.shutdown();
+	NativeHAL::setWebSocketServer(nullptr);
+
+	if (Server.stallMicros > 0 && LateTaskCount > 0) {
+		fprintf(stderr, "[native] FAIL: %d control task%s started late while the network stalled\n", LateTaskCount, LateTaskCount == 1 ? "" : "s");
+		return 2;
+	}
+
+	return 0;
+}
\ No newline at end of file
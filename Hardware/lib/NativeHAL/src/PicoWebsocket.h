@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+#include <deque>
+#include "Client.h"
+#include "NativeHAL.h"
+
+namespace PicoWebsocket {
+	// Fake WebSocket client, frames are exchanged with NativeHAL::getWebSocketServer() in-process
+	class Client : public ::Client, public NativeHAL::WebSocketConnection {
+		public:
+			Client(::Client& client, const char* path = "/");
+			~Client();
+
+			int connect(const char* host, uint16_t port) override;
+			size_t write(uint8_t c) override;
+			size_t write(const uint8_t* buffer, size_t size) override;
+			int available() override;
+			int read() override;
+			int read(uint8_t* buffer, size_t size) override;
+			int peek() override;
+			void flush() override;
+			void stop() override;
+			uint8_t connected() override;
+			using Print::write;
+
+			// NativeHAL::WebSocketConnection
+			void send(const uint8_t* data, size_t size) override;
+			void close() override;
+			size_t receivePending() override;
+
+		private:
+			::Client& client;
+			NativeHAL::WebSocketServer* server = nullptr;
+			bool isConnected = false;
+			std::deque<uint8_t> receiveBuffer;
+	};
+}
@@ -0,0 +1,91 @@
+#include "Print.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+	size_t written = 0;
+
+	for (size_t i = 0; i < size; i++) {
+		written += this->write(buffer[i]);
+	}
+
+	return written;
+}
+
+size_t Print::write(const char* str) {
+	if (str == nullptr)
+		return 0;
+
+	return this->write((const uint8_t*)str, strlen(str));
+}
+
+size_t Print::write(const char* buffer, size_t size) {
+	return this->write((const uint8_t*)buffer, size);
+}
+
+size_t Print::print(const char* str) { return this->write(str); }
+size_t Print::print(const String& str) { return this->write(str.c_str(), str.length()); }
+size_t Print::print(char c) { return this->write((uint8_t)c); }
+size_t Print::print(unsigned char n, int base) { return this->printNumber(n, base, false); }
+size_t Print::print(int n, int base) { return this->print((long long)n, base); }
+size_t Print::print(unsigned int n, int base) { return this->printNumber(n, base, false); }
+size_t Print::print(long n, int base) { return this->print((long long)n, base); }
+size_t Print::print(unsigned long n, int base) { return this->printNumber(n, base, false); }
+size_t Print::print(unsigned long long n, int base) { return this->printNumber(n, base, false); }
+
+size_t Print::print(long long n, int base) {
+	if (n < 0 && base == 10)
+		return this->printNumber(0ULL - (unsigned long long)n, base, true);
+
+	return this->printNumber((unsigned long long)n, base, false);
+}
+
+size_t Print::print(double n, int digits) {
+	if (isnan(n))
+		return this->print("nan");
+
+	if (isinf(n))
+		return this->print("inf");
+
+	char buffer[48];
+	int length = snprintf(buffer, sizeof(buffer), "%.*f", digits, n);
+
+	return this->write(buffer, length < 0 ? 0 : (size_t)length);
+}
+
+size_t Print::print(const Printable& p) { return p.printTo(*this); }
+
+size_t Print::println() { return this->write("\r\n"); }
+size_t Print::println(const char* str) { return this->print(str) + this->println(); }
+size_t Print::println(const String& str) { return this->print(str) + this->println(); }
+size_t Print::println(char c) { return this->print(c) + this->println(); }
+size_t Print::println(unsigned char n, int base) { return this->print(n, base) + this->println(); }
+size_t Print::println(int n, int base) { return this->print(n, base) + this->println(); }
+size_t Print::println(unsigned int n, int base) { return this->print(n, base) + this->println(); }
+size_t Print::println(long n, int base) { return this->print(n, base) + this->println(); }
+size_t Print::println(unsigned long n, int base) { return this->print(n, base) + this->println(); }
+size_t Print::println(long long n, int base) { return this->print(n, base) + this->println(); }
+size_t Print::println(unsigned long long n, int base) { return this->print(n, base) + this->println(); }
+size_t Print::println(double n, int digits) { return this->print(n, digits) + this->println(); }
+size_t Print::println(const Printable& p) { return this->print(p) + this->println(); }
+
+size_t Print::printNumber(unsigned long long n, int base, bool negative) {
+	if (base < 2)
+		base = 10;
+
+	char buffer[8 * sizeof(n) + 2];
+	char* cursor = &buffer[sizeof(buffer) - 1];
+	*cursor = '\0';
+
+	do {
+		char digit = n % base;
+		n /= base;
+		*--cursor = digit < 10 ? digit + '0' : digit + 'A' - 10;
+	} while (n);
+
+	if (negative)
+		*--cursor = '-';
+
+	return this->write(cursor);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "WString.h"
+
+class Print;
+
+class Printable {
+	public:
+		virtual ~Printable() {}
+		virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+	public:
+		virtual ~Print() {}
+		virtual size_t write(uint8_t c) = 0;
+		virtual size_t write(const uint8_t* buffer, size_t size);
+		virtual void flush() {}
+
+		size_t write(const char* str);
+		size_t write(const char* buffer, size_t size);
+
+		size_t print(const char* str);
+		size_t print(const String& str);
+		size_t print(char c);
+		size_t print(unsigned char n, int base = 10);
+		size_t print(int n, int base = 10);
+		size_t print(unsigned int n, int base = 10);
+		size_t print(long n, int base = 10);
+		size_t print(unsigned long n, int base = 10);
+		size_t print(long long n, int base = 10);
+		size_t print(unsigned long long n, int base = 10);
+		size_t print(double n, int digits = 2);
+		size_t print(const Printable& p);
+
+		size_t println();
+		size_t println(const char* str);
+		size_t println(const String& str);
+		size_t println(char c);
+		size_t println(unsigned char n, int base = 10);
+		size_t println(int n, int base = 10);
+		size_t println(unsigned int n, int base = 10);
+		size_t println(long n, int base = 10);
+		size_t println(unsigned long n, int base = 10);
+		size_t println(long long n, int base = 10);
+		size_t println(unsigned long long n, int base = 10);
+		size_t println(double n, int digits = 2);
+		size_t println(const Printable& p);
+
+	private:
+		size_t printNumber(unsigned long long n, int base, bool negative);
+};
@@ -0,0 +1,51 @@
+#include "Stream.h"
+
+void Stream::setTimeout(unsigned long timeout) {
+	this->timeout = timeout;
+}
+
+unsigned long Stream::getTimeout() {
+	return this->timeout;
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+	size_t count = 0;
+
+	while (count < length) {
+		int c = this->read();
+		if (c < 0)
+			break;
+
+		buffer[count++] = (char)c;
+	}
+
+	return count;
+}
+
+size_t Stream::readBytes(uint8_t* buffer, size_t length) {
+	return this->readBytes((char*)buffer, length);
+}
+
+String Stream::readString() {
+	String result;
+	int c = this->read();
+
+	while (c >= 0) {
+		result += (char)c;
+		c = this->read();
+	}
+
+	return result;
+}
+
+String Stream::readStringUntil(char terminator) {
+	String result;
+	int c = this->read();
+
+	while (c >= 0 && c != terminator) {
+		result += (char)c;
+		c = this->read();
+	}
+
+	return result;
+}
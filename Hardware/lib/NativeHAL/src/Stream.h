@@ -0,0 +1,21 @@
+#pragma once
+#include "Print.h"
+
+class Stream : public Print {
+	public:
+		virtual int available() = 0;
+		virtual int read() = 0;
+		virtual int peek() = 0;
+
+		void setTimeout(unsigned long timeout);
+		unsigned long getTimeout();
+
+		size_t readBytes(char* buffer, size_t length);
+		size_t readBytes(uint8_t* buffer, size_t length);
+		String readString();
+		String readStringUntil(char terminator);
+
+	protected:
+		// The simulated clock never moves while blocked, so a timed read just gives up on an empty stream
+		unsigned long timeout = 1000;
+};
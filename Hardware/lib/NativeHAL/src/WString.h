@@ -0,0 +1,49 @@
+#pragma once
+#include <stddef.h>
+#include <string>
+
+// Arduino String on top of std::string, kept API compatible for ArduinoJson and the firmware
+class String {
+	public:
+		String() {}
+		String(const char* str) { if (str != nullptr) this->buffer = str; }
+		String(const char* str, size_t length) { if (str != nullptr) this->buffer.assign(str, length); }
+		String(const String& other) = default;
+		String(char c) : buffer(1, c) {}
+		explicit String(int value) : buffer(std::to_string(value)) {}
+		explicit String(unsigned int value) : buffer(std::to_string(value)) {}
+		explicit String(long value) : buffer(std::to_string(value)) {}
+		explicit String(unsigned long value) : buffer(std::to_string(value)) {}
+
+		String& operator=(const String& other) = default;
+		String& operator=(const char* str) { if (str == nullptr) this->buffer.clear(); else this->buffer = str; return *this; }
+
+		bool reserve(unsigned int size) { this->buffer.reserve(size); return true; }
+		unsigned int length() const { return this->buffer.length(); }
+		const char* c_str() const { return this->buffer.c_str(); }
+		char charAt(unsigned int index) const { return index < this->buffer.length() ? this->buffer[index] : 0; }
+		char operator[](unsigned int index) const { return this->charAt(index); }
+
+		bool concat(const String& str) { this->buffer += str.buffer; return true; }
+		bool concat(const char* str) { if (str == nullptr) return false; this->buffer += str; return true; }
+		bool concat(const char* str, unsigned int length) { if (str == nullptr) return false; this->buffer.append(str, length); return true; }
+		bool concat(char c) { this->buffer += c; return true; }
+
+		String& operator+=(const String& str) { this->concat(str); return *this; }
+		String& operator+=(const char* str) { this->concat(str); return *this; }
+		String& operator+=(char c) { this->concat(c); return *this; }
+
+		bool equals(const String& other) const { return this->buffer == other.buffer; }
+		bool equals(const char* str) const { return str != nullptr && this->buffer == str; }
+		bool operator==(const String& other) const { return this->equals(other); }
+		bool operator==(const char* str) const { return this->equals(str); }
+		bool operator!=(const String& other) const { return !this->equals(other); }
+		bool operator!=(const char* str) const { return !this->equals(str); }
+
+		int indexOf(char c) const { size_t i = this->buffer.find(c); return i == std::string::npos ? -1 : (int)i; }
+		String substring(unsigned int from) const { return from < this->buffer.length() ? String(this->buffer.substr(from).c_str()) : String(); }
+		String substring(unsigned int from, unsigned int to) const { return from < to && from < this->buffer.length() ? String(this->buffer.substr(from, to - from).c_str()) : String(); }
+
+	private:
+		std::string buffer;
+};
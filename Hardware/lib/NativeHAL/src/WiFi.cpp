@@ -0,0 +1,490 @@
+#include "WiFi.h"
+#include "PicoWebsocket.h"
+#include "NativeHAL.h"
+#include <lwip/sockets.h>
+#include <lwip/dns.h>
+#include <lwip/tcpip.h>
+#include <algorithm>
+
+#define NATIVE_HAL_SOCKET_COUNT 16
+#define NATIVE_HAL_SOCKET_OFFSET 48 // lwIP numbers its sockets after the other file descriptors
+#define NATIVE_HAL_CONNECT_TIMEOUT_MICROS 3000000 // WiFiClient::connect() without a timeout, like WIFI_CLIENT_DEF_CONN_TIMEOUT_MS
+#define NATIVE_HAL_SERVER_ADDRESS 0x0104A8C0 // 192.168.4.1 in network byte order, what every name resolves to
+
+WiFiClass WiFi;
+
+namespace NativeHAL {
+	struct FakeSocket {
+		bool isOpen;
+		bool isConnecting;
+		bool isConnected;
+		uint64_t handshakeMicros; // When the SYN-ACK arrives, if the server listens
+	};
+
+	struct PendingLookup {
+		dns_found_callback found;
+		void* arg;
+		char name[64];
+	};
+
+	bool IsWiFiAvailable = true;
+	uint64_t WiFiConnectDelayMicros = 1500000; // 1.5 seconds
+	uint64_t NetworkDelayMicros = 20000; // 20 ms
+	WebSocketServer* CurrentWebSocketServer = nullptr;
+	FakeSocket Sockets[NATIVE_HAL_SOCKET_COUNT] = {};
+	uint32_t DNSLookupCount = 0;
+	uint32_t TcpConnectCount = 0;
+
+	FakeSocket* FindSocket(int fd) {
+		int Index = fd - NATIVE_HAL_SOCKET_OFFSET;
+		if (Index < 0 || Index >= NATIVE_HAL_SOCKET_COUNT || !Sockets[Index].isOpen)
+			return nullptr;
+
+		return &Sockets[Index];
+	}
+
+	// The handshake is done once the SYN-ACK is in, a server that doesn't listen never sends one
+	bool IsHandshakeDone(FakeSocket* socket) {
+		if (socket->isConnecting && NativeHAL::nowMicros() >= socket->handshakeMicros && CurrentWebSocketServer != nullptr && CurrentWebSocketServer->isListening() && WiFi.status() == WL_CONNECTED) {
+			socket->isConnecting = false;
+			socket->isConnected = true;
+		}
+
+		return socket->isConnected;
+	}
+
+	void DeliverLookup(void* arg) {
+		PendingLookup* Lookup = (PendingLookup*)arg;
+
+		ip_addr_t Address = {};
+		Address.u_addr.ip4.addr = NATIVE_HAL_SERVER_ADDRESS;
+		Lookup->found(Lookup->name, &Address, Lookup->arg);
+
+		delete Lookup;
+	}
+
+	void setWiFiAvailable(bool available) {
+		IsWiFiAvailable = available;
+	}
+
+	void setWiFiConnectDelayMicros(uint64_t micros) {
+		WiFiConnectDelayMicros = micros;
+	}
+
+	void setWebSocketServer(WebSocketServer* server) {
+		CurrentWebSocketServer = server;
+	}
+
+	WebSocketServer* getWebSocketServer() {
+		return CurrentWebSocketServer;
+	}
+
+	void setNetworkDelayMicros(uint64_t micros) {
+		NetworkDelayMicros = micros;
+	}
+
+	uint32_t getDNSLookupCount() {
+		return DNSLookupCount;
+	}
+
+	uint32_t getTcpConnectCount() {
+		return TcpConnectCount;
+	}
+
+	int getOpenSocketCount() {
+		int Count = 0;
+		for (FakeSocket& Socket : Sockets) {
+			if (Socket.isOpen)
+				Count++;
+		}
+
+		return Count;
+	}
+}
+
+#pragma region IPAddress
+
+IPAddress::IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+	this->octets[0] = a;
+	this->octets[1] = b;
+	this->octets[2] = c;
+	this->octets[3] = d;
+}
+
+size_t IPAddress::printTo(Print& p) const {
+	size_t written = 0;
+
+	for (int i = 0; i < 4; i++) {
+		if (i > 0)
+			written += p.print('.');
+
+		written += p.print(this->octets[i], 10);
+	}
+
+	return written;
+}
+
+#pragma endregion
+
+#pragma region WiFiClass
+
+bool WiFiClass::mode(wifi_mode_t mode) {
+	return true;
+}
+
+bool WiFiClass::setAutoConnect(bool autoConnect) {
+	return true;
+}
+
+bool WiFiClass::setAutoReconnect(bool autoReconnect) {
+	return true;
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* password) {
+	this->isBeginCalled = true;
+	this->beginMicros = NativeHAL::nowMicros();
+	return WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect() {
+	this->isBeginCalled = false;
+	return true;
+}
+
+bool WiFiClass::setSleep(wifi_ps_type_t sleepType) {
+	return true;
+}
+
+wl_status_t WiFiClass::status() {
+	if (!this->isBeginCalled)
+		return WL_IDLE_STATUS;
+
+	if (!NativeHAL::IsWiFiAvailable)
+		return WL_DISCONNECTED;
+
+	if (NativeHAL::nowMicros() - this->beginMicros < NativeHAL::WiFiConnectDelayMicros)
+		return WL_DISCONNECTED;
+
+	return WL_CONNECTED;
+}
+
+IPAddress WiFiClass::localIP() {
+	return IPAddress(192, 168, 4, 2);
+}
+
+#pragma endregion
+
+#pragma region WiFiClient
+
+WiFiClient::WiFiClient(int fd) {
+	this->fd = fd;
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+	this->stop();
+
+	if (WiFi.status() != WL_CONNECTED)
+		return 0;
+
+	NativeHAL::DNSLookupCount++;
+	NativeHAL::advanceMicros(NativeHAL::NetworkDelayMicros);
+
+	int Fd = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (Fd < 0)
+		return 0;
+
+	lwip_connect(Fd, nullptr, 0);
+
+	// Whoever called waits for the handshake or the timeout
+	NativeHAL::FakeSocket* Socket = NativeHAL::FindSocket(Fd);
+	NativeHAL::advanceMicros(NativeHAL::NetworkDelayMicros);
+	if (!NativeHAL::IsHandshakeDone(Socket)) {
+		NativeHAL::advanceMicros(NATIVE_HAL_CONNECT_TIMEOUT_MICROS - NativeHAL::NetworkDelayMicros);
+		lwip_close(Fd);
+		return 0;
+	}
+
+	this->fd = Fd;
+	return 1;
+}
+
+size_t WiFiClient::write(uint8_t c) { return 0; }
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) { return 0; }
+int WiFiClient::available() { return 0; }
+int WiFiClient::read() { return -1; }
+int WiFiClient::read(uint8_t* buffer, size_t size) { return -1; }
+int WiFiClient::peek() { return -1; }
+void WiFiClient::flush() {}
+
+void WiFiClient::stop() {
+	if (this->fd >= 0)
+		lwip_close(this->fd);
+
+	this->fd = -1;
+}
+
+uint8_t WiFiClient::connected() {
+	NativeHAL::FakeSocket* Socket = NativeHAL::FindSocket(this->fd);
+	return Socket != nullptr && Socket->isConnected && WiFi.status() == WL_CONNECTED;
+}
+
+int WiFiClient::setNoDelay(bool noDelay) {
+	this->noDelay = noDelay;
+	return 0;
+}
+
+int WiFiClient::setSocketOption(int level, int option, const void* value, size_t length) {
+	return 0;
+}
+
+bool WiFiClient::getNoDelay() {
+	return this->noDelay;
+}
+
+#pragma endregion
+
+#pragma region PicoWebsocket::Client
+
+PicoWebsocket::Client::Client(::Client& client, const char* path) : client(client) {}
+
+PicoWebsocket::Client::~Client() {
+	this->stop();
+}
+
+int PicoWebsocket::Client::connect(const char* host, uint16_t port) {
+	// The session before ends, the TCP client is left to its own connect()
+	if (this->isConnected && this->server != nullptr)
+		this->server->onDisconnect(this);
+
+	this->isConnected = false;
+	this->server = nullptr;
+	this->receiveBuffer.clear();
+
+	NativeHAL::WebSocketServer* server = NativeHAL::getWebSocketServer();
+	if (server == nullptr || WiFi.status() != WL_CONNECTED)
+		return 0;
+
+	// TCP first, a socket that was connected without blocking is taken as it is
+	if (!this->client.connect(host, port))
+		return 0;
+
+	// The upgrade request and its 101 reply, the caller waits for them
+	NativeHAL::advanceMicros(NativeHAL::NetworkDelayMicros);
+
+	this->server = server;
+	this->isConnected = true;
+
+	if (!server->onConnect(this, host, port)) {
+		this->isConnected = false;
+		this->server = nullptr;
+		this->client.stop();
+		return 0;
+	}
+
+	return 1;
+}
+
+size_t PicoWebsocket::Client::write(uint8_t c) {
+	return this->write(&c, 1);
+}
+
+size_t PicoWebsocket::Client::write(const uint8_t* buffer, size_t size) {
+	if (!this->connected())
+		return 0;
+
+	this->server->onMessage(this, buffer, size);
+	return size;
+}
+
+int PicoWebsocket::Client::available() {
+	return this->receiveBuffer.size();
+}
+
+int PicoWebsocket::Client::read() {
+	if (this->receiveBuffer.empty())
+		return -1;
+
+	uint8_t c = this->receiveBuffer.front();
+	this->receiveBuffer.pop_front();
+
+	if (this->server != nullptr)
+		this->server->onRead(this);
+
+	return c;
+}
+
+int PicoWebsocket::Client::read(uint8_t* buffer, size_t size) {
+	if (this->receiveBuffer.empty())
+		return -1;
+
+	size_t Count = size < this->receiveBuffer.size() ? size : this->receiveBuffer.size();
+	std::copy(this->receiveBuffer.begin(), this->receiveBuffer.begin() + Count, buffer);
+	this->receiveBuffer.erase(this->receiveBuffer.begin(), this->receiveBuffer.begin() + Count);
+
+	if (this->server != nullptr)
+		this->server->onRead(this);
+
+	return Count;
+}
+
+int PicoWebsocket::Client::peek() {
+	return this->receiveBuffer.empty() ? -1 : this->receiveBuffer.front();
+}
+
+void PicoWebsocket::Client::flush() {}
+
+void PicoWebsocket::Client::stop() {
+	NativeHAL::WebSocketServer* server = this->server;
+	bool wasConnected = this->isConnected;
+
+	this->isConnected = false;
+	this->server = nullptr;
+	this->receiveBuffer.clear();
+	this->client.stop();
+
+	if (wasConnected && server != nullptr)
+		server->onDisconnect(this);
+}
+
+uint8_t PicoWebsocket::Client::connected() {
+	// Losing WiFi drops the TCP connection as well
+	if (this->isConnected && WiFi.status() != WL_CONNECTED)
+		this->stop();
+
+	return this->isConnected;
+}
+
+void PicoWebsocket::Client::send(const uint8_t* data, size_t size) {
+	if (!this->isConnected)
+		return;
+
+	this->receiveBuffer.insert(this->receiveBuffer.end(), data, data + size);
+}
+
+void PicoWebsocket::Client::close() {
+	// Server side close, already received frames stay readable like on a real socket
+	this->isConnected = false;
+	this->server = nullptr;
+}
+
+size_t PicoWebsocket::Client::receivePending() {
+	return this->receiveBuffer.size();
+}
+
+#pragma endregion
+
+#pragma region lwIP
+
+int lwip_socket(int domain, int type, int protocol) {
+	for (int i = 0; i < NATIVE_HAL_SOCKET_COUNT; i++) {
+		NativeHAL::FakeSocket& Socket = NativeHAL::Sockets[i];
+		if (Socket.isOpen)
+			continue;
+
+		Socket = {};
+		Socket.isOpen = true;
+		return i + NATIVE_HAL_SOCKET_OFFSET;
+	}
+
+	errno = ENFILE;
+	return -1;
+}
+
+int lwip_connect(int s, const struct sockaddr* name, socklen_t namelen) {
+	NativeHAL::FakeSocket* Socket = NativeHAL::FindSocket(s);
+	if (Socket == nullptr) {
+		errno = EBADF;
+		return -1;
+	}
+
+	if (Socket->isConnected || Socket->isConnecting) {
+		errno = Socket->isConnected ? EISCONN : EALREADY;
+		return -1;
+	}
+
+	if (WiFi.status() != WL_CONNECTED) {
+		errno = EHOSTUNREACH;
+		return -1;
+	}
+
+	NativeHAL::TcpConnectCount++;
+	Socket->isConnecting = true;
+	Socket->handshakeMicros = NativeHAL::nowMicros() + NativeHAL::NetworkDelayMicros;
+
+	errno = EINPROGRESS;
+	return -1;
+}
+
+int lwip_select(int maxfdp1, fd_set* readset, fd_set* writeset, fd_set* exceptset, struct timeval* timeout) {
+	int Count = 0;
+
+	for (int Fd = 0; Fd < maxfdp1; Fd++) {
+		// Only a finished handshake is watched for
+		if (readset != nullptr)
+			FD_CLR(Fd, readset);
+
+		if (exceptset != nullptr)
+			FD_CLR(Fd, exceptset);
+
+		if (writeset == nullptr || !FD_ISSET(Fd, writeset))
+			continue;
+
+		NativeHAL::FakeSocket* Socket = NativeHAL::FindSocket(Fd);
+		if (Socket != nullptr && NativeHAL::IsHandshakeDone(Socket))
+			Count++;
+		else
+			FD_CLR(Fd, writeset);
+	}
+
+	return Count;
+}
+
+int lwip_getsockopt(int s, int level, int optname, void* optval, socklen_t* optlen) {
+	if (NativeHAL::FindSocket(s) == nullptr) {
+		errno = EBADF;
+		return -1;
+	}
+
+	// No pending error, a refused handshake isn't modeled
+	if (level == SOL_SOCKET && optname == SO_ERROR && *optlen >= sizeof(int))
+		*(int*)optval = 0;
+
+	return 0;
+}
+
+int lwip_fcntl(int s, int cmd, int val) {
+	return NativeHAL::FindSocket(s) != nullptr ? 0 : -1;
+}
+
+int lwip_close(int s) {
+	NativeHAL::FakeSocket* Socket = NativeHAL::FindSocket(s);
+	if (Socket == nullptr) {
+		errno = EBADF;
+		return -1;
+	}
+
+	*Socket = {};
+	return 0;
+}
+
+err_t dns_gethostbyname(const char* hostname, ip_addr_t* addr, dns_found_callback found, void* callback_arg) {
+	if (WiFi.status() != WL_CONNECTED || hostname == nullptr || strlen(hostname) >= sizeof(NativeHAL::PendingLookup::name))
+		return ERR_ARG;
+
+	NativeHAL::DNSLookupCount++;
+
+	NativeHAL::PendingLookup* Lookup = new NativeHAL::PendingLookup();
+	Lookup->found = found;
+	Lookup->arg = callback_arg;
+	strcpy(Lookup->name, hostname);
+
+	NativeHAL::scheduleCall(NativeHAL::nowMicros() + NativeHAL::NetworkDelayMicros, NativeHAL::DeliverLookup, Lookup);
+	return ERR_INPROGRESS;
+}
+
+err_t tcpip_callback(tcpip_callback_fn function, void* ctx) {
+	function(ctx);
+	return ERR_OK;
+}
+
+#pragma endregion
@@ -0,0 +1,81 @@
+#pragma once
+#include <stdint.h>
+#include "Arduino.h"
+#include "Client.h"
+
+typedef enum {
+	WL_IDLE_STATUS = 0,
+	WL_NO_SSID_AVAIL = 1,
+	WL_CONNECTED = 3,
+	WL_CONNECT_FAILED = 4,
+	WL_CONNECTION_LOST = 5,
+	WL_DISCONNECTED = 6,
+} wl_status_t;
+
+typedef enum {
+	WIFI_OFF = 0,
+	WIFI_STA = 1,
+	WIFI_AP = 2,
+	WIFI_AP_STA = 3,
+} wifi_mode_t;
+
+typedef enum {
+	WIFI_PS_NONE,
+	WIFI_PS_MIN_MODEM,
+	WIFI_PS_MAX_MODEM,
+} wifi_ps_type_t;
+
+class IPAddress : public Printable {
+	public:
+		IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d);
+		size_t printTo(Print& p) const override;
+
+	private:
+		uint8_t octets[4];
+};
+
+class WiFiClass {
+	public:
+		bool mode(wifi_mode_t mode);
+		bool setAutoConnect(bool autoConnect);
+		bool setAutoReconnect(bool autoReconnect);
+		wl_status_t begin(const char* ssid, const char* password);
+		bool disconnect();
+		bool setSleep(wifi_ps_type_t sleepType);
+		wl_status_t status();
+		IPAddress localIP();
+
+	private:
+		bool isBeginCalled = false;
+		uint64_t beginMicros = 0;
+};
+
+// TCP client on a fake lwIP socket, PicoWebsocket::Client talks to the stand-in server directly once it is connected
+class WiFiClient : public Client {
+	public:
+		WiFiClient() {}
+		WiFiClient(int fd); // Takes over a connected socket, like WiFiServer::available() does
+
+		// Blocks like the target: resolves, then waits for the handshake, up to the whole timeout if nobody answers
+		int connect(const char* host, uint16_t port) override;
+		size_t write(uint8_t c) override;
+		size_t write(const uint8_t* buffer, size_t size) override;
+		int available() override;
+		int read() override;
+		int read(uint8_t* buffer, size_t size) override;
+		int peek() override;
+		void flush() override;
+		void stop() override;
+		uint8_t connected() override;
+		using Print::write;
+
+		int setNoDelay(bool noDelay);
+		int setSocketOption(int level, int option, const void* value, size_t length);
+		bool getNoDelay();
+
+	private:
+		bool noDelay = false;
+		int fd = -1;
+};
+
+extern WiFiClass WiFi;
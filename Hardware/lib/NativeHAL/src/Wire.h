@@ -0,0 +1,11 @@
+#pragma once
+#include <stdint.h>
+
+class TwoWire {
+	public:
+		bool begin() { return true; }
+		bool begin(int sda, int scl) { return true; }
+		void setClock(uint32_t frequency) {}
+};
+
+extern TwoWire Wire;
@@ -0,0 +1,9 @@
+#pragma once
+// Host replacement for ESP-IDF esp_err.h, only the codes the firmware and the stand-ins use
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_SIZE 0x104
\ No newline at end of file
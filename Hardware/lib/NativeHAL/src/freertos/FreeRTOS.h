@@ -0,0 +1,15 @@
+#pragma once
+// Host stand-in for the FreeRTOS types the firmware uses
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+
+#define portTICK_PERIOD_MS 1
+#define portMAX_DELAY 0xFFFFFFFF
\ No newline at end of file
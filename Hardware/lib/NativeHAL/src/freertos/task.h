@@ -0,0 +1,12 @@
+#pragma once
+// Tasks run as host threads, which needs NativeHAL::setRealTime(true) since the simulated clock is not shared safely
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void* parameter);
+typedef void* TaskHandle_t;
+
+// Returns pdFAIL on the simulated clock, callers fall back to running the work themselves
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameter, UBaseType_t priority, TaskHandle_t* handle, BaseType_t coreID);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
+BaseType_t xPortGetCoreID();
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+// Host replacement for the lwIP resolver, every name resolves after the network delay
+#include <stdint.h>
+
+typedef int8_t err_t;
+
+#define ERR_OK 0
+#define ERR_MEM -1
+#define ERR_INPROGRESS -5
+#define ERR_ARG -16
+
+typedef struct {
+	uint32_t addr; // Network byte order
+} ip4_addr_t;
+
+typedef struct {
+	union {
+		ip4_addr_t ip4;
+	} u_addr;
+	uint8_t type;
+} ip_addr_t;
+
+#define ip_2_ip4(ipaddr) (&((ipaddr)->u_addr.ip4))
+#define ip4_addr_get_u32(src_ipaddr) ((src_ipaddr)->addr)
+
+typedef void (*dns_found_callback)(const char* name, const ip_addr_t* ipaddr, void* callback_arg);
+
+// ERR_INPROGRESS, found is called once the answer is in. ERR_ARG without WiFi
+err_t dns_gethostbyname(const char* hostname, ip_addr_t* addr, dns_found_callback found, void* callback_arg);
@@ -0,0 +1,14 @@
+#pragma once
+// Host replacement for lwIP sockets, the lwip_ calls reach fake sockets connected to NativeHAL::getWebSocketServer()
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <errno.h>
+
+int lwip_socket(int domain, int type, int protocol);
+int lwip_connect(int s, const struct sockaddr* name, socklen_t namelen); // Never blocks, EINPROGRESS until the handshake is done
+int lwip_select(int maxfdp1, fd_set* readset, fd_set* writeset, fd_set* exceptset, struct timeval* timeout); // Timeout is ignored
+int lwip_getsockopt(int s, int level, int optname, void* optval, socklen_t* optlen);
+int lwip_fcntl(int s, int cmd, int val);
+int lwip_close(int s);
@@ -0,0 +1,8 @@
+#pragma once
+// Host replacement for the lwIP thread entry points, there is no tcpip thread so the function runs right away
+#include <lwip/dns.h>
+
+typedef void (*tcpip_callback_fn)(void* ctx);
+
+// ERR_OK once function has run
+err_t tcpip_callback(tcpip_callback_fn function, void* ctx);
@@ -0,0 +1,2 @@
+#pragma once
+// Host replacement for newlib sys/config.h, nothing from it is used by the firmware
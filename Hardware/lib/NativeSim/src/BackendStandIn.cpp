@@ -0,0 +1,644 @@
+#include "BackendStandIn.h"
+#include <Arduino.h>
+#include "WiFiNetwork.h"
+
+namespace NativeSim {
+	#define REPLY_CACHE_SIZE 16 // Same as index.ts
+
+	static uint32_t ReadUint32(const uint8_t* cursor) {
+		return cursor[0] | (cursor[1] << 8) | (cursor[2] << 16) | ((uint32_t)cursor[3] << 24);
+	}
+
+	BackendStandIn::BackendStandIn(Trace& trace, Random& random, uint64_t roundTripMicros) : trace(trace), random(random) {
+		this->roundTripMicros = roundTripMicros;
+	}
+
+	bool BackendStandIn::onConnect(NativeHAL::WebSocketConnection* connection, const char* host, uint16_t port) {
+		if (!this->isAvailable) {
+			this->trace.event(NativeHAL::nowMicros(), "ws_refused", "%s:%u", host, port);
+			return false;
+		}
+
+		this->connection = connection;
+		this->isLoggedIn = false;
+		this->isBinaryNegotiated = false;
+		this->isPushNegotiated = false;
+		this->isDeltaNegotiated = false;
+		this->isHistoryNegotiated = false;
+		this->lastSequence = -1;
+		this->bytesDelivered = 0;
+		this->inFlight.clear();
+		this->delivered.clear();
+		this->replyCache.clear();
+		this->connectCount++;
+
+		this->trace.event(NativeHAL::nowMicros(), "ws_connect", "%s:%u", host, port);
+		return true;
+	}
+
+	void BackendStandIn::onDisconnect(NativeHAL::WebSocketConnection* connection) {
+		if (connection != this->connection)
+			return;
+
+		this->connection = nullptr;
+		this->inFlight.clear();
+		this->delivered.clear();
+
+		this->trace.event(NativeHAL::nowMicros(), "ws_disconnect");
+	}
+
+	void BackendStandIn::onMessage(NativeHAL::WebSocketConnection* connection, const uint8_t* data, size_t size) {
+		uint64_t Now = NativeHAL::nowMicros();
+
+		// Decoded into the same fields as the JSON request, so both go through handleRequest()
+		if (size > 0 && data[0] == BINARY_PROTOCOL_MAGIC) {
+			std::string Key;
+			JsonDocument request;
+			if (!this->isBinaryNegotiated || !this->decodeBinaryRequest(data, size, Key, request)) {
+				this->trace.event(Now, "ws_protocol_error", "unexpected binary frame");
+				connection->close();
+				this->onDisconnect(connection);
+				return;
+			}
+
+			if (this->loseRequest(Now, Key))
+				return;
+
+			EndpointStats& Stats = this->stats[Key];
+			Stats.requests++;
+			Stats.bytesUp += size;
+
+			this->trace.event(Now, "tx", "%s %zu", Key.c_str(), size);
+
+			uint16_t RequestId = data[BINARY_REQUEST_ID_OFFSET] | (data[BINARY_REQUEST_ID_OFFSET + 1] << 8);
+			if (this->replyFromCache(Now, RequestId, Key))
+				return;
+
+			JsonDocument response;
+			this->handleRequest(Key, request["data"], response);
+			this->sendReply(Now, RequestId, Key, this->encodeBinaryReply(data[1], RequestId, response), true);
+			return;
+		}
+
+		JsonDocument request;
+		DeserializationError error = deserializeJson(request, (const char*)data, size);
+
+		// index.ts closes the socket on anything that isn't a JSON object with a string key
+		if (error || !request["key"].is<const char*>()) {
+			this->trace.event(Now, "ws_protocol_error", "%s", error ? error.c_str() : "missing key");
+			connection->close();
+			this->onDisconnect(connection);
+			return;
+		}
+
+		std::string Key = request["key"].as<const char*>();
+		if (this->loseRequest(Now, Key))
+			return;
+
+		EndpointStats& Stats = this->stats[Key];
+		Stats.requests++;
+		Stats.bytesUp += size;
+
+		this->trace.event(Now, "tx", "%s %zu", Key.c_str(), size);
+
+		int32_t RequestId = request["id"].is<int>() ? request["id"].as<int>() : -1;
+		if (this->replyFromCache(Now, RequestId, Key))
+			return;
+
+		JsonDocument response;
+		this->handleRequest(Key, request["data"], response);
+		response["endpoint"] = Key.c_str();
+		if (RequestId >= 0)
+			response["id"] = RequestId;
+
+		String Encoded;
+		serializeJson(response, Encoded);
+		this->sendReply(Now, RequestId, Key, std::string(Encoded.c_str(), Encoded.length()), false);
+
+		// Like the setImmediate() of login.ts, right behind the reply
+		if (Key == "/login" && response["data"]["schedule"].as<int>() == FEEDING_SCHEDULE_VERSION && request["data"]["schedule_rev"].as<uint32_t>() != this->schedule.revision)
+			this->pushSchedule(Now + this->roundTripMicros);
+	}
+
+	// Gone on the way like a frame in a dropped TCP segment, before the server saw anything of it
+	bool BackendStandIn::loseRequest(uint64_t requestMicros, const std::string& endpoint) {
+		if (this->requestLoss <= 0 || this->random.uniform() >= this->requestLoss)
+			return false;
+
+		this->stats[endpoint].lostRequests++;
+		this->trace.event(requestMicros, "request_lost", "%s", endpoint.c_str());
+		return true;
+	}
+
+	// A retransmitted request is answered with the reply it got the first time, without handling it again
+	bool BackendStandIn::replyFromCache(uint64_t requestMicros, int32_t requestId, const std::string& endpoint) {
+		if (requestId <= 0)
+			return false;
+
+		for (const CachedReply& Cached : this->replyCache) {
+			if (Cached.requestId != requestId)
+				continue;
+
+			this->stats[endpoint].duplicates++;
+			this->trace.event(requestMicros, "duplicate", "%s %d", endpoint.c_str(), requestId);
+			this->queueReply(requestMicros, requestMicros + this->roundTripMicros, endpoint, Cached.payload, Cached.isBinary);
+			return true;
+		}
+
+		return false;
+	}
+
+	void BackendStandIn::sendReply(uint64_t requestMicros, int32_t requestId, const std::string& endpoint, const std::string& payload, bool isBinary) {
+		if (requestId > 0) {
+			this->replyCache.push_back({ (uint16_t)requestId, payload, isBinary });
+			if (this->replyCache.size() > REPLY_CACHE_SIZE)
+				this->replyCache.pop_front();
+		}
+
+		if (this->replyLoss > 0 && this->random.uniform() < this->replyLoss) {
+			this->stats[endpoint].lostReplies++;
+			this->trace.event(requestMicros, "reply_lost", "%s", endpoint.c_str());
+			return;
+		}
+
+		this->queueReply(requestMicros, requestMicros + this->roundTripMicros, endpoint, payload, isBinary);
+	}
+
+	bool BackendStandIn::decodeBinaryRequest(const uint8_t* data, size_t size, std::string& key, JsonDocument& request) {
+		if (size < BINARY_REQUEST_HEADER_SIZE)
+			return false;
+
+		if (data[1] == BINARY_GET_DATA) {
+			key = "/iot/get_data";
+			return true;
+		}
+
+		if (data[1] == BINARY_POST_DELTA)
+			return this->decodeBinaryDelta(data, size, key, request);
+
+		if (data[1] == BINARY_POST_HISTORY)
+			return this->decodeBinaryHistory(data, size, key, request);
+
+		if (data[1] != BINARY_POST_DATA || size < BINARY_POST_DATA_FRAME_SIZE)
+			return false;
+
+		key = "/iot/post_data";
+		const uint8_t* Payload = data + BINARY_REQUEST_HEADER_SIZE;
+		int16_t Temperature = (int16_t)(Payload[0] | (Payload[1] << 8));
+		int16_t Humidity = (int16_t)(Payload[2] | (Payload[3] << 8));
+		int16_t WaterLevel = (int16_t)(Payload[4] | (Payload[5] << 8));
+
+		if (Temperature != BINARY_NULL_VALUE) request["data"]["te"] = Temperature / 100.0f;
+		if (Humidity != BINARY_NULL_VALUE) request["data"]["hu"] = Humidity / 100.0f;
+		if (WaterLevel != BINARY_NULL_VALUE) request["data"]["wa"] = WaterLevel;
+		request["data"]["PuEn"] = ReadUint32(Payload + BINARY_READINGS_SIZE);
+		request["data"]["DiFo"] = ReadUint32(Payload + BINARY_READINGS_SIZE + 4);
+		return true;
+	}
+
+	bool BackendStandIn::decodeBinaryDelta(const uint8_t* data, size_t size, std::string& key, JsonDocument& request) {
+		if (size < BINARY_POST_DELTA_HEADER_SIZE)
+			return false;
+
+		key = "/iot/post_data";
+		const uint8_t* Header = data + BINARY_REQUEST_HEADER_SIZE;
+		uint8_t Fields = Header[2];
+		request["data"]["sq"] = Header[0] | (Header[1] << 8);
+		if (Fields & BINARY_DELTA_KEYFRAME)
+			request["data"]["kf"] = 1;
+
+		size_t Offset = BINARY_POST_DELTA_HEADER_SIZE;
+		const char* Keys[] = { "te", "hu", "wa" };
+		const uint8_t Bits[] = { TELEMETRY_FIELD_TEMPERATURE, TELEMETRY_FIELD_HUMIDITY, TELEMETRY_FIELD_WATER_LEVEL };
+
+		for (int i = 0; i < 3; i++) {
+			if (!(Fields & Bits[i]))
+				continue;
+
+			if (Offset + 2 > size)
+				return false;
+
+			int16_t Value = (int16_t)(data[Offset] | (data[Offset + 1] << 8));
+			Offset += 2;
+
+			if (Value == BINARY_NULL_VALUE)
+				continue;
+
+			if (Bits[i] == TELEMETRY_FIELD_WATER_LEVEL)
+				request["data"][Keys[i]] = Value;
+			else
+				request["data"][Keys[i]] = Value / 100.0f;
+		}
+
+		if (Fields & TELEMETRY_FIELD_PUMP) {
+			if (Offset + 4 > size)
+				return false;
+
+			request["data"]["PuEn"] = ReadUint32(data + Offset);
+			Offset += 4;
+		}
+
+		if (Fields & TELEMETRY_FIELD_FOOD) {
+			if (Offset + 4 > size)
+				return false;
+
+			request["data"]["DiFo"] = ReadUint32(data + Offset);
+		}
+
+		return true;
+	}
+
+	bool BackendStandIn::decodeBinaryHistory(const uint8_t* data, size_t size, std::string& key, JsonDocument& request) {
+		if (size < BINARY_POST_HISTORY_HEADER_SIZE || size < BINARY_POST_HISTORY_HEADER_SIZE + (size_t)data[BINARY_REQUEST_HEADER_SIZE] * BINARY_HISTORY_SAMPLE_SIZE)
+			return false;
+
+		key = "/iot/post_history";
+		JsonArray Rows = request["data"]["s"].to<JsonArray>();
+
+		const uint8_t* Sample = data + BINARY_POST_HISTORY_HEADER_SIZE;
+		for (uint8_t i = 0; i < data[BINARY_REQUEST_HEADER_SIZE]; i++, Sample += BINARY_HISTORY_SAMPLE_SIZE) {
+			JsonArray Row = Rows.add<JsonArray>();
+			Row.add(ReadUint32(Sample));
+
+			int16_t Temperature = (int16_t)(Sample[4] | (Sample[5] << 8));
+			int16_t Humidity = (int16_t)(Sample[6] | (Sample[7] << 8));
+			int16_t WaterLevel = (int16_t)(Sample[8] | (Sample[9] << 8));
+
+			if (Temperature != BINARY_NULL_VALUE) Row.add(Temperature / 100.0f); else Row.add<JsonVariant>();
+			if (Humidity != BINARY_NULL_VALUE) Row.add(Humidity / 100.0f); else Row.add<JsonVariant>();
+			if (WaterLevel != BINARY_NULL_VALUE) Row.add(WaterLevel); else Row.add<JsonVariant>();
+			Row.add(Sample[10]);
+		}
+
+		return true;
+	}
+
+	uint32_t BackendStandIn::unixTime() {
+		return this->unixEpoch + NativeHAL::nowMicros() / 1000000;
+	}
+
+	std::string BackendStandIn::encodeBinaryReply(uint8_t type, uint16_t requestId, JsonDocument& response) {
+		int Code = response["code"].as<int>();
+		std::string Payload;
+
+		if (response["status"] == "error") {
+			Payload = response["error_message"].as<const char*>();
+		}
+		else if (type == BINARY_GET_DATA || type == BINARY_PUSH_COMMAND) {
+			uint32_t Masks[] = { response["data"]["pumps"].as<uint32_t>(), response["data"]["feeders"].as<uint32_t>() };
+			for (uint32_t Mask : Masks) {
+				for (int i = 0; i < 4; i++) {
+					Payload.push_back((char)((Mask >> (i * 8)) & 0xFF));
+				}
+			}
+		}
+
+		if (Payload.size() > BINARY_REPLY_MAX_PAYLOAD)
+			Payload.resize(BINARY_REPLY_MAX_PAYLOAD);
+
+		std::string Reply;
+		Reply.push_back((char)BINARY_PROTOCOL_MAGIC);
+		Reply.push_back((char)type);
+		Reply.push_back((char)(requestId & 0xFF));
+		Reply.push_back((char)(requestId >> 8));
+		Reply.push_back((char)(Code & 0xFF));
+		Reply.push_back((char)(Code >> 8));
+		Reply.push_back((char)Payload.size());
+		return Reply + Payload;
+	}
+
+	void BackendStandIn::handleRequest(const std::string& key, JsonVariantConst data, JsonDocument& response) {
+		if (key == "/login") {
+			if (this->isLoggedIn) {
+				response["status"] = "error";
+				response["code"] = 400;
+				response["error_message"] = "You are already logged in";
+				return;
+			}
+
+			this->isLoggedIn = true;
+			response["status"] = "success";
+			response["code"] = 200;
+			response["data"]["message"] = "Connected as IoT device";
+
+			if (this->acceptsBinary && data["binary"].as<int>() == BINARY_PROTOCOL_VERSION) {
+				this->isBinaryNegotiated = true;
+				response["data"]["binary"] = BINARY_PROTOCOL_VERSION;
+			}
+
+			if (this->acceptsPush && data["push"].as<int>() == COMMAND_PUSH_VERSION) {
+				this->isPushNegotiated = true;
+				response["data"]["push"] = COMMAND_PUSH_VERSION;
+			}
+
+			if (this->acceptsDelta && data["delta"].as<int>() == TELEMETRY_DELTA_VERSION) {
+				this->isDeltaNegotiated = true;
+				response["data"]["delta"] = TELEMETRY_DELTA_VERSION;
+			}
+
+			if (this->acceptsHistory && data["history"].as<int>() == TELEMETRY_JOURNAL_VERSION) {
+				this->isHistoryNegotiated = true;
+				response["data"]["history"] = TELEMETRY_JOURNAL_VERSION;
+				response["data"]["time"] = this->unixTime();
+			}
+
+			if (this->acceptsSchedule && data["schedule"].as<int>() == FEEDING_SCHEDULE_VERSION) {
+				response["data"]["schedule"] = FEEDING_SCHEDULE_VERSION;
+				response["data"]["time"] = this->unixTime();
+			}
+			return;
+		}
+
+		if (!this->isLoggedIn) {
+			response["status"] = "error";
+			response["code"] = 401;
+			response["error_message"] = "You must be authenticated to post data";
+			return;
+		}
+
+		if (key == "/iot/get_data") {
+			response["status"] = "success";
+			response["code"] = 200;
+			response["data"]["shouldEnableWaterPump"] = this->shouldEnableWaterPump;
+			response["data"]["shouldDispenseFood"] = this->shouldDispenseFood;
+			response["data"]["pumps"] = this->shouldEnableWaterPump ? 1 : 0;
+			response["data"]["feeders"] = this->shouldDispenseFood ? 1 : 0;
+
+			// Triggers are reset once handed to the device
+			this->shouldEnableWaterPump = false;
+			this->shouldDispenseFood = false;
+			return;
+		}
+
+		if (key == "/iot/post_data") {
+			// Same check as CheckTelemetrySequence(), a delta has to follow the last accepted report
+			if (!data["sq"].isNull()) {
+				int32_t Sequence = data["sq"].as<int>();
+				bool IsKeyframe = data["kf"].as<int>() == 1;
+
+				if (!this->isDeltaNegotiated) {
+					response["status"] = "error";
+					response["code"] = 400;
+					response["error_message"] = "Telemetry deltas must be negotiated at /login";
+					return;
+				}
+
+				if (!IsKeyframe && (this->lastSequence < 0 || Sequence != ((this->lastSequence + 1) & 0xFFFF))) {
+					this->stats[key].keyframeRequests++;
+					response["status"] = "success";
+					response["code"] = TELEMETRY_KEYFRAME_REQUEST_CODE;
+					response["data"]["message"] = "Telemetry delta out of sequence, send a keyframe";
+					return;
+				}
+
+				this->lastSequence = Sequence;
+			}
+
+			if (!data["wa"].isNull())
+				this->lastWaterLevel = data["wa"].as<int>();
+
+			this->reportTimes.push_back(this->unixTime());
+
+			response["status"] = "success";
+			response["code"] = 200;
+			response["data"]["message"] = "Data received successfully";
+			return;
+		}
+
+		if (key == "/iot/post_history") {
+			if (!this->isHistoryNegotiated) {
+				response["status"] = "error";
+				response["code"] = 400;
+				response["error_message"] = "History upload must be negotiated at /login";
+				return;
+			}
+
+			// Same as HistoryStore.Append(), a sample whose timestamp is stored already is skipped
+			JsonVariantConst Rows = data["s"];
+			for (size_t i = 0; i < Rows.size(); i++) {
+				uint32_t Time = Rows[i][0].as<uint32_t>();
+				if (!this->historyTimes.insert(Time).second) {
+					this->historySkipped++;
+					continue;
+				}
+
+				this->historySamples++;
+				this->reportTimes.push_back(Time);
+			}
+
+			response["status"] = "success";
+			response["code"] = 200;
+			response["data"]["message"] = "History received successfully";
+			return;
+		}
+
+		if (key == "/iot/metrics") {
+			this->metricFrames++;
+
+			for (int i = 0; i < 2; i++) {
+				JsonVariantConst Rows = data[i == 0 ? "p" : "l"];
+				auto& Target = i == 0 ? this->metricProbes : this->metricLateness;
+
+				for (size_t j = 0; j < Rows.size(); j++) {
+					const char* Name = Rows[j][0].as<const char*>();
+					if (Name == nullptr)
+						continue;
+
+					std::vector<uint32_t> Values;
+					for (size_t k = 1; k < 6; k++) {
+						Values.push_back(Rows[j][k].as<uint32_t>());
+					}
+
+					Target[Name] = Values;
+				}
+			}
+
+			response["status"] = "success";
+			response["code"] = 200;
+			response["data"]["message"] = "Metrics received successfully";
+			return;
+		}
+
+		response["status"] = "error";
+		response["code"] = 404;
+		response["error_message"] = "Route not found";
+	}
+
+	void BackendStandIn::queueReply(uint64_t requestMicros, uint64_t deliverMicros, const std::string& endpoint, const std::string& payload, bool isBinary) {
+		Reply reply;
+		reply.requestMicros = requestMicros;
+		reply.deliverMicros = deliverMicros;
+		reply.endOffset = 0;
+		reply.endpoint = endpoint;
+		reply.payload = payload;
+		reply.isBinary = isBinary;
+
+		// A push travels one way, so it may overtake replies to earlier requests
+		auto Position = this->inFlight.end();
+		while (Position != this->inFlight.begin() && (Position - 1)->deliverMicros > deliverMicros)
+			Position--;
+
+		this->inFlight.insert(Position, reply);
+	}
+
+	void BackendStandIn::deliver(uint64_t nowMicros) {
+		while (!this->inFlight.empty() && this->inFlight.front().deliverMicros <= nowMicros) {
+			Reply reply = this->inFlight.front();
+			this->inFlight.pop_front();
+
+			if (this->connection == nullptr)
+				continue;
+
+			// Same framing as index.ts, the JSON frame followed by a "\r" frame, binary frames carry their length
+			size_t Size = reply.payload.size();
+			this->connection->send((const uint8_t*)reply.payload.data(), reply.payload.size());
+			if (!reply.isBinary) {
+				this->connection->send((const uint8_t*)"\r", 1);
+				Size++;
+			}
+
+			this->bytesDelivered += Size;
+			reply.endOffset = this->bytesDelivered;
+
+			EndpointStats& Stats = this->stats[reply.endpoint];
+			Stats.bytesDown += Size;
+
+			this->delivered.push_back(reply);
+		}
+	}
+
+	// Replies count as received once the firmware has read their last byte
+	void BackendStandIn::onRead(NativeHAL::WebSocketConnection* connection) {
+		if (connection != this->connection || this->delivered.empty())
+			return;
+
+		uint64_t nowMicros = NativeHAL::nowMicros();
+
+		uint64_t BytesRead = this->bytesDelivered - this->connection->receivePending();
+
+		while (!this->delivered.empty() && this->delivered.front().endOffset <= BytesRead) {
+			Reply& reply = this->delivered.front();
+			uint64_t RoundTrip = nowMicros - reply.requestMicros;
+
+			EndpointStats& Stats = this->stats[reply.endpoint];
+			Stats.replies++;
+			Stats.roundTripTotalMicros += RoundTrip;
+			if (RoundTrip > Stats.roundTripMaxMicros)
+				Stats.roundTripMaxMicros = RoundTrip;
+
+			this->trace.event(nowMicros, "rx", "%s %.3f", reply.endpoint.c_str(), RoundTrip / 1000.0);
+			this->delivered.pop_front();
+		}
+	}
+
+	uint64_t BackendStandIn::nextEventMicros() {
+		if (this->inFlight.empty())
+			return UINT64_MAX;
+
+		return this->inFlight.front().deliverMicros;
+	}
+
+	void BackendStandIn::triggerDispenseFood() {
+		this->shouldDispenseFood = true;
+		this->pushCommand();
+	}
+
+	void BackendStandIn::triggerWaterPump() {
+		this->shouldEnableWaterPump = true;
+		this->pushCommand();
+	}
+
+	// Like PushActuatorCommand(), the triggers are taken and only travel one way
+	void BackendStandIn::pushCommand() {
+		if (!this->isPushNegotiated || this->connection == nullptr)
+			return;
+
+		uint64_t Now = NativeHAL::nowMicros();
+
+		JsonDocument message;
+		message["status"] = "success";
+		message["code"] = 200;
+		message["data"]["shouldEnableWaterPump"] = this->shouldEnableWaterPump;
+		message["data"]["shouldDispenseFood"] = this->shouldDispenseFood;
+		message["data"]["pumps"] = this->shouldEnableWaterPump ? 1 : 0;
+		message["data"]["feeders"] = this->shouldDispenseFood ? 1 : 0;
+
+		this->shouldEnableWaterPump = false;
+		this->shouldDispenseFood = false;
+
+		std::string Payload;
+		if (this->isBinaryNegotiated) {
+			Payload = this->encodeBinaryReply(BINARY_PUSH_COMMAND, REQUEST_ID_NONE, message);
+		}
+		else {
+			message["endpoint"] = "/iot/push_command";
+
+			String Encoded;
+			serializeJson(message, Encoded);
+			Payload = std::string(Encoded.c_str(), Encoded.length());
+		}
+
+		this->stats["/iot/push_command"].requests++;
+		this->trace.event(Now, "push", "%zu", Payload.size());
+
+		this->queueReply(Now, Now + this->roundTripMicros / 2, "/iot/push_command", Payload, this->isBinaryNegotiated);
+	}
+
+	// Like PushFeedingSchedule(), the whole table as hex in one JSON message
+	void BackendStandIn::pushSchedule(uint64_t deliverMicros) {
+		if (this->connection == nullptr)
+			return;
+
+		std::string Entries;
+		for (uint8_t i = 0; i < this->schedule.entryCount; i++) {
+			const ScheduleEntry& Entry = this->schedule.entries[i];
+			uint8_t Bytes[] = { (uint8_t)(Entry.minute & 0xFF), (uint8_t)(Entry.minute >> 8), Entry.weekdays, Entry.feeder, (uint8_t)(Entry.openMillis & 0xFF), (uint8_t)(Entry.openMillis >> 8) };
+			for (uint8_t Byte : Bytes) {
+				char Hex[3];
+				snprintf(Hex, sizeof(Hex), "%02x", Byte);
+				Entries += Hex;
+			}
+		}
+
+		JsonDocument message;
+		message["status"] = "success";
+		message["code"] = 200;
+		message["endpoint"] = "/iot/push_schedule";
+		message["data"]["rev"] = this->schedule.revision;
+		message["data"]["tz"] = this->schedule.utcOffset;
+		message["data"]["e"] = Entries.c_str();
+
+		String Encoded;
+		serializeJson(message, Encoded);
+
+		this->schedulePushes++;
+		this->stats["/iot/push_schedule"].requests++;
+		this->trace.event(NativeHAL::nowMicros(), "push_schedule", "%u %u", this->schedule.revision, (unsigned)Encoded.length());
+
+		this->queueReply(NativeHAL::nowMicros(), deliverMicros, "/iot/push_schedule", std::string(Encoded.c_str(), Encoded.length()), false);
+	}
+
+	void BackendStandIn::shutdown() {
+		if (this->connection != nullptr)
+			this->connection->close();
+
+		this->connection = nullptr;
+		this->inFlight.clear();
+		this->delivered.clear();
+	}
+
+	void BackendStandIn::setAvailable(bool available) {
+		if (available == this->isAvailable)
+			return;
+
+		this->isAvailable = available;
+		this->trace.event(NativeHAL::nowMicros(), available ? "server_up" : "server_down");
+
+		if (!available)
+			this->shutdown();
+	}
+
+	bool BackendStandIn::isListening() {
+		return this->isAvailable;
+	}
+}
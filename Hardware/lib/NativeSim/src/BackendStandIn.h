@@ -0,0 +1,131 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <deque>
+#include <map>
+#include <vector>
+#include <set>
+#include <ArduinoJson.h>
+#include "NativeHAL.h"
+#include "Trace.h"
+#include "SimRandom.h"
+#include "BinaryProtocol.h"
+#include "FeedingSchedule.h"
+
+namespace NativeSim {
+	struct EndpointStats {
+		uint64_t requests = 0;
+		uint64_t replies = 0;
+		uint64_t bytesUp = 0;
+		uint64_t bytesDown = 0;
+		uint64_t roundTripTotalMicros = 0;
+		uint64_t roundTripMaxMicros = 0;
+		uint64_t duplicates = 0; // Retransmitted requests answered from the reply cache
+		uint64_t lostReplies = 0;
+		uint64_t lostRequests = 0;
+		uint64_t keyframeRequests = 0; // Deltas out of sequence, answered with TELEMETRY_KEYFRAME_REQUEST_CODE
+	};
+
+	// Speaks the /login, /iot/get_data, /iot/post_data, /iot/post_history, /iot/metrics, /iot/push_command and /iot/push_schedule protocol of Backend/src/index.ts with a fixed network RTT
+	class BackendStandIn : public NativeHAL::WebSocketServer {
+		public:
+			BackendStandIn(Trace& trace, Random& random, uint64_t roundTripMicros);
+
+			bool onConnect(NativeHAL::WebSocketConnection* connection, const char* host, uint16_t port) override;
+			void onMessage(NativeHAL::WebSocketConnection* connection, const uint8_t* data, size_t size) override;
+			void onRead(NativeHAL::WebSocketConnection* connection) override;
+			void onDisconnect(NativeHAL::WebSocketConnection* connection) override;
+
+			// Hand replies whose RTT has elapsed to the firmware
+			void deliver(uint64_t nowMicros);
+
+			// Time of the next reply delivery, UINT64_MAX if none is pending
+			uint64_t nextEventMicros();
+
+			// Dashboard actions, same as /client/food_control and /client/pump_control, pushed right away if negotiated
+			void triggerDispenseFood();
+			void triggerWaterPump();
+
+			// Drop the connection without calling back into the firmware, before either side is destroyed
+			void shutdown();
+
+			// Going down resets the open connection and leaves new SYNs unanswered, like a server host that went away
+			void setAvailable(bool available);
+			bool isListening() override;
+
+			bool isAvailable = true;
+			bool acceptsBinary = true; // Accept the binary protocol when /login offers it, like index.ts
+			bool acceptsPush = true; // Push dashboard actions when /login offers it, like actuator_command.ts
+			bool acceptsDelta = true; // Accept change-driven /iot/post_data when /login offers it, like telemetry_delta.ts
+			bool acceptsHistory = true; // Take journaled samples at /iot/post_history when /login offers it, like telemetry_history.ts
+			bool acceptsSchedule = false; // Push the feeding schedule when /login offers it with an older revision, like feeding_schedule.ts
+			double replyLoss = 0.0; // Share of replies that never reach the firmware, the request itself is still handled
+			double requestLoss = 0.0; // Share of requests that never reach the server, the firmware retransmits them
+			int lastWaterLevel = -1;
+			uint64_t connectCount = 0;
+			std::map<std::string, EndpointStats> stats;
+
+			uint32_t unixEpoch = 1760000000; // Server clock at simulated time 0, sent at /login
+			uint64_t historySamples = 0;
+			uint64_t historySkipped = 0; // Stored already, e.g. a batch sent again after a reconnect
+			std::vector<uint32_t> reportTimes; // Server clock of every live report and journaled sample, to find gaps in the history
+
+			// Latest /iot/metrics rows by name, [count, p50, p90, p99, max] like MergeMetrics() of device_metrics.ts
+			std::map<std::string, std::vector<uint32_t>> metricProbes;
+			std::map<std::string, std::vector<uint32_t>> metricLateness;
+			uint64_t metricFrames = 0;
+
+			// What /client/set_schedule stored, revision 0 is none
+			FeedingScheduleTable schedule = {};
+			uint64_t schedulePushes = 0;
+
+		private:
+			struct Reply {
+				uint64_t requestMicros;
+				uint64_t deliverMicros;
+				uint64_t endOffset; // Total bytes sent on this connection once the reply is read
+				std::string endpoint;
+				std::string payload;
+				bool isBinary; // Sent without the "\r" frame
+			};
+
+			void handleRequest(const std::string& key, JsonVariantConst data, JsonDocument& response);
+			void pushCommand();
+			void pushSchedule(uint64_t deliverMicros);
+			void queueReply(uint64_t requestMicros, uint64_t deliverMicros, const std::string& endpoint, const std::string& payload, bool isBinary);
+			void sendReply(uint64_t requestMicros, int32_t requestId, const std::string& endpoint, const std::string& payload, bool isBinary);
+			bool replyFromCache(uint64_t requestMicros, int32_t requestId, const std::string& endpoint);
+			bool loseRequest(uint64_t requestMicros, const std::string& endpoint);
+			bool decodeBinaryRequest(const uint8_t* data, size_t size, std::string& key, JsonDocument& request);
+			bool decodeBinaryDelta(const uint8_t* data, size_t size, std::string& key, JsonDocument& request);
+			bool decodeBinaryHistory(const uint8_t* data, size_t size, std::string& key, JsonDocument& request);
+			uint32_t unixTime();
+			std::string encodeBinaryReply(uint8_t type, uint16_t requestId, JsonDocument& response);
+
+			struct CachedReply {
+				uint16_t requestId;
+				std::string payload;
+				bool isBinary;
+			};
+
+			Trace& trace;
+			Random& random;
+			uint64_t roundTripMicros;
+
+			NativeHAL::WebSocketConnection* connection = nullptr;
+			bool isLoggedIn = false;
+			bool isBinaryNegotiated = false;
+			bool isPushNegotiated = false;
+			bool isDeltaNegotiated = false;
+			bool isHistoryNegotiated = false;
+			std::set<uint32_t> historyTimes; // Kept across connections like the HistoryStore of DeviceData.history
+			int32_t lastSequence = -1; // Of the last accepted /iot/post_data delta, -1 until a keyframe
+			bool shouldDispenseFood = false;
+			bool shouldEnableWaterPump = false;
+
+			uint64_t bytesDelivered = 0;
+			std::deque<Reply> inFlight;
+			std::deque<Reply> delivered;
+			std::deque<CachedReply> replyCache; // Last replies by request ID, like the reply cache of index.ts
+	};
+}
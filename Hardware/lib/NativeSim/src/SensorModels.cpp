@@ -0,0 +1,87 @@
+#include "SensorModels.h"
+#include "NativeHAL.h"
+#include <math.h>
+
+#define MICROS_PER_HOUR 3600000000.0
+
+namespace NativeSim {
+	DHT11Model::DHT11Model(Random& random, double startHour) : random(random) {
+		this->startHour = startHour;
+	}
+
+	void DHT11Model::update(uint64_t nowMicros) {
+		double Hour = fmod(this->startHour + nowMicros / MICROS_PER_HOUR, 24.0);
+
+		// Warmest around 14:00, humidity moves the other way
+		double DayPhase = cos((Hour - 14.0) / 24.0 * 2.0 * M_PI);
+		double Temperature = 27.5 + 3.5 * DayPhase + this->random.gaussian(0.3);
+		double Humidity = 67.0 - 12.0 * DayPhase + this->random.gaussian(1.0);
+
+		this->temperature = (float)round(Temperature);
+		this->humidity = (float)round(Humidity);
+
+		NativeHAL::setDHTReading(this->temperature, this->humidity);
+	}
+
+	WaterTankModel::WaterTankModel(Random& random, double initialLevel) : random(random) {
+		this->level = initialLevel;
+		this->sensedLevel = initialLevel;
+	}
+
+	void WaterTankModel::update(uint64_t nowMicros, bool isPumpOn) {
+		if (nowMicros <= this->lastMicros) {
+			return;
+		}
+
+		double ElapsedSeconds = (nowMicros - this->lastMicros) / 1000000.0;
+		this->lastMicros = nowMicros;
+
+		this->level -= this->evaporationRate * ElapsedSeconds / 3600.0;
+
+		// The pet drinks a few percent roughly every 40 minutes
+		if (nowMicros >= this->nextDrinkMicros) {
+			if (this->nextDrinkMicros != 0)
+				this->level -= 2.0 + this->random.uniform() * 3.0;
+
+			this->nextDrinkMicros = nowMicros + (uint64_t)((20.0 + this->random.uniform() * 40.0) * 60.0 * 1000000.0);
+		}
+
+		if (isPumpOn && !this->wasPumpOn)
+			this->runFillRate = this->pumpFillRate * (1.0 + this->fillRateSpread * (this->random.uniform() * 2.0 - 1.0));
+
+		this->wasPumpOn = isPumpOn;
+
+		// The flow settles exponentially towards what the pump delivers, integrated exactly so long steps don't matter
+		double Target = isPumpOn && !this->isReservoirEmpty ? this->runFillRate : 0.0;
+		double HoseDecay = exp(-ElapsedSeconds / this->hoseSeconds);
+		this->level += Target * ElapsedSeconds + (this->inflow - Target) * this->hoseSeconds * (1.0 - HoseDecay);
+		this->inflow = Target + (this->inflow - Target) * HoseDecay;
+
+		if (this->level < 0.0)
+			this->level = 0.0;
+
+		if (this->level > 100.0)
+			this->level = 100.0;
+
+		this->sensedLevel += (this->level - this->sensedLevel) * (1.0 - exp(-ElapsedSeconds / this->sensorLagSeconds));
+	}
+
+	uint16_t WaterTankModel::readADC() {
+		if (this->isSensorStuck)
+			return this->stuckReading;
+
+		// The sensor saturates early, roughly a square root curve, and the ESP32 ADC adds noise
+		double Raw = 4095.0 * pow(this->sensedLevel / 100.0, 0.6) + this->random.gaussian(35.0);
+
+		if (this->random.uniform() < this->spikeRate)
+			Raw += (this->random.uniform() < 0.5 ? -1.0 : 1.0) * (300.0 + this->random.uniform() * 500.0);
+
+		if (Raw < 0.0)
+			Raw = 0.0;
+
+		if (Raw > 4095.0)
+			Raw = 4095.0;
+
+		return (uint16_t)Raw;
+	}
+}
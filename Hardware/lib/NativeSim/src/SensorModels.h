@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include "SimRandom.h"
+
+namespace NativeSim {
+	// Room climate over the day as seen by a DHT11 (whole degrees and percent)
+	class DHT11Model {
+		public:
+			DHT11Model(Random& random, double startHour);
+			void update(uint64_t nowMicros);
+
+			float temperature = 0.0f;
+			float humidity = 0.0f;
+
+		private:
+			Random& random;
+			double startHour;
+	};
+
+	// Water bowl with a pet drinking from it, evaporation and a pump refilling it
+	class WaterTankModel {
+		public:
+			WaterTankModel(Random& random, double initialLevel);
+			void update(uint64_t nowMicros, bool isPumpOn);
+
+			// Raw 12-bit reading of the resistive level sensor for the current level, noisy on every call
+			uint16_t readADC();
+
+			double level; // 0 - 100 %
+			double sensedLevel; // What the sensor is wet to, lags level
+			double pumpFillRate = 1.1; // % per second
+			double fillRateSpread = 0.2; // Each run fills up to this share faster or slower, reservoir head and hose
+			double hoseSeconds = 1.5; // Time constant the flow ramps up by after the pump starts and drains off by after it stops
+			double sensorLagSeconds = 1.0; // Time constant the sensor follows the surface by, ripples and wicking
+			double evaporationRate = 0.15; // % per hour
+			double spikeRate = 0.01; // Share of readings thrown off by a WiFi transmit burst
+
+			bool isReservoirEmpty = false; // The pump runs dry
+			bool isSensorStuck = false; // Reads stuckReading whatever the level
+			uint16_t stuckReading = 0; // A broken wire reads dry
+
+		private:
+			Random& random;
+			uint64_t lastMicros = 0;
+			uint64_t nextDrinkMicros = 0;
+			bool wasPumpOn = false;
+			double runFillRate = 0.0;
+			double inflow = 0.0; // % per second coming out of the hose
+	};
+}
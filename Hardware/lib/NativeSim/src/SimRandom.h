@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+namespace NativeSim {
+	// xorshift64* so a run is reproducible from its --seed
+	class Random {
+		public:
+			Random(uint64_t seed) : state(seed ? seed : 0x9E3779B97F4A7C15ULL) {}
+
+			uint64_t next() {
+				this->state ^= this->state >> 12;
+				this->state ^= this->state << 25;
+				this->state ^= this->state >> 27;
+				return this->state * 0x2545F4914F6CDD1DULL;
+			}
+
+			// [0, 1)
+			double uniform() {
+				return (this->next() >> 11) * (1.0 / 9007199254740992.0);
+			}
+
+			double gaussian(double sigma) {
+				double u1 = this->uniform();
+				double u2 = this->uniform();
+				if (u1 < 1e-12)
+					u1 = 1e-12;
+
+				return sigma * sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+			}
+
+		private:
+			uint64_t state;
+	};
+}
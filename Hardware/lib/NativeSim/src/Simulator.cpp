@@ -0,0 +1,753 @@
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "config.h"
+#include "ActuatorRegistry.h"
+#include "SimRandom.h"
+#include "SensorModels.h"
+#include "BackendStandIn.h"
+#include "Trace.h"
+#include "Scheduler.h"
+#include "BusinessLogic.h"
+#include "HALHooks.h"
+
+#if ENABLE_DHT == true
+	#include "InputRelated.h"
+
+	extern Input::DHT11Sensor dht1;
+#endif
+
+#if ENABLE_WIFI == true
+	#include "WiFiNetwork.h"
+
+	extern WiFiNetwork wifiNetwork;
+#endif
+
+#if ENABLE_LCD_OUTPUT == true
+	#include "LCDRenderer.h"
+
+	extern LiquidCrystal_I2C lcd;
+	extern LCDRenderer lcdRenderer;
+	extern I2CBus i2cBus;
+#endif
+
+extern Scheduler scheduler;
+extern BusinessLogic businessLogic;
+extern ActuatorRegistry actuators;
+
+void setup();
+void loop();
+
+#define MICROS_PER_HOUR 3600000000ULL
+#define SIM_SCHEDULE_UTC_OFFSET 420 // Minutes, UTC+7
+#define SIM_FULL_FLAG_TOLERANCE 1.0 // % the bowl may trail a threshold when the full flag changes, sensor lag and the moving average
+
+namespace NativeSim {
+	struct Options {
+		double hours = 24.0;
+		double startHour = 6.0; // Time of day the simulation starts at
+		uint64_t roundTripMicros = 40000;
+		uint64_t loopCostMicros = 50;
+		uint64_t seed = 1;
+		const char* tracePath = nullptr;
+		bool verbose = false;
+		bool isJsonOnly = false; // Backend declines the binary protocol, like an older index.ts
+		bool isPollOnly = false; // Backend declines command push, dashboard actions wait for /iot/get_data
+		bool isFullReports = false; // Backend declines telemetry deltas, every /iot/post_data carries every field
+		bool isNoHistory = false; // Backend declines /iot/post_history, samples taken offline are never uploaded
+		const char* flashPath = nullptr; // Keeps the journal partition across runs
+		std::vector<std::pair<double, double>> outages; // WiFi down, hours after the start and for how many hours
+		std::vector<std::pair<double, double>> serverOutages; // Backend down with WiFi still up, same format
+		int requestWindow = WS_REQUEST_WINDOW; // Requests the firmware keeps in flight, up to WS_REQUEST_WINDOW
+		double replyLoss = 0.0;
+		double requestLoss = 0.0;
+		std::vector<double> feedHours = { 7.0, 12.0, 18.0 };
+		bool isOnDeviceSchedule = false; // Feeding times go to the firmware as a schedule once, instead of a dashboard click each
+		int refillBelowLevel = 25; // Dashboard user turns the pump on when the reported level drops below this
+		double dryAfterHours = -1.0; // The pump's reservoir is empty from this many hours in, never if negative
+		double stuckSensorAfterHours = -1.0; // The level sensor reads dry from this many hours in, never if negative
+		uint32_t i2cClockHz = 100000;
+		bool isLCDStress = false; // The display content is lost every second, so every status screen is a full redraw
+	};
+
+	Trace trace;
+	bool isPumpOn = false;
+	uint64_t pumpStarts = 0;
+	WaterTankModel* pTankModel = nullptr;
+
+	// Every reading of the level sensor gets noise of its own, like the ADC sampling the same level several times
+	uint16_t OnAnalogRead(uint8_t pin, uint16_t value) {
+		#if ENABLE_WATER_LEVEL_SENSOR == true
+			if (pin == WATER_LEVEL_SENSOR_PIN && pTankModel != nullptr)
+				return pTankModel->readADC();
+		#endif
+
+		return value;
+	}
+
+	void OnDigitalWrite(uint8_t pin, uint8_t level) {
+		#if ENABLE_WATER_PUMP == true
+			if (pin != WATER_PUMP_PIN)
+				return;
+
+			// The pump relay is active low
+			bool IsOn = level == LOW;
+			if (IsOn == isPumpOn)
+				return;
+
+			isPumpOn = IsOn;
+			if (IsOn)
+				pumpStarts++;
+
+			trace.event(NativeHAL::nowMicros(), IsOn ? "pump_on" : "pump_off");
+		#endif
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options) {
+		for (int i = 1; i < argc; i++) {
+			bool HasValue = i + 1 < argc;
+
+			if (strcmp(argv[i], "--hours") == 0 && HasValue) {
+				options.hours = atof(argv[++i]);
+			}
+			else if (strcmp(argv[i], "--start-hour") == 0 && HasValue) {
+				options.startHour = atof(argv[++i]);
+			}
+			else if (strcmp(argv[i], "--rtt-ms") == 0 && HasValue) {
+				options.roundTripMicros = (uint64_t)(atof(argv[++i]) * 1000.0);
+			}
+			else if (strcmp(argv[i], "--loop-cost-us") == 0 && HasValue) {
+				options.loopCostMicros = strtoull(argv[++i], nullptr, 10);
+			}
+			else if (strcmp(argv[i], "--seed") == 0 && HasValue) {
+				options.seed = strtoull(argv[++i], nullptr, 10);
+			}
+			else if (strcmp(argv[i], "--trace") == 0 && HasValue) {
+				options.tracePath = argv[++i];
+			}
+			else if (strcmp(argv[i], "--feed-hours") == 0 && HasValue) {
+				options.feedHours.clear();
+
+				char* Cursor = argv[++i];
+				while (*Cursor != '\0') {
+					options.feedHours.push_back(strtod(Cursor, &Cursor));
+					if (*Cursor == ',')
+						Cursor++;
+				}
+			}
+			else if (strcmp(argv[i], "--on-device-schedule") == 0) {
+				options.isOnDeviceSchedule = true;
+			}
+			else if (strcmp(argv[i], "--refill-below") == 0 && HasValue) {
+				options.refillBelowLevel = atoi(argv[++i]);
+			}
+			else if (strcmp(argv[i], "--dry-after") == 0 && HasValue) {
+				options.dryAfterHours = atof(argv[++i]);
+			}
+			else if (strcmp(argv[i], "--stuck-sensor-after") == 0 && HasValue) {
+				options.stuckSensorAfterHours = atof(argv[++i]);
+			}
+			else if (strcmp(argv[i], "--i2c-khz") == 0 && HasValue) {
+				options.i2cClockHz = (uint32_t)(atof(argv[++i]) * 1000.0);
+			}
+			else if (strcmp(argv[i], "--lcd-stress") == 0) {
+				options.isLCDStress = true;
+			}
+			else if (strcmp(argv[i], "--verbose") == 0) {
+				options.verbose = true;
+			}
+			else if (strcmp(argv[i], "--json-only") == 0) {
+				options.isJsonOnly = true;
+			}
+			else if (strcmp(argv[i], "--poll-only") == 0) {
+				options.isPollOnly = true;
+			}
+			else if (strcmp(argv[i], "--full-reports") == 0) {
+				options.isFullReports = true;
+			}
+			else if (strcmp(argv[i], "--no-history") == 0) {
+				options.isNoHistory = true;
+			}
+			else if (strcmp(argv[i], "--outage") == 0 && HasValue) {
+				char* Cursor = argv[++i];
+				double Start = strtod(Cursor, &Cursor);
+				double Duration = *Cursor == ',' ? strtod(Cursor + 1, nullptr) : 1.0;
+				options.outages.push_back({ Start, Duration });
+			}
+			else if (strcmp(argv[i], "--server-down") == 0 && HasValue) {
+				char* Cursor = argv[++i];
+				double Start = strtod(Cursor, &Cursor);
+				double Duration = *Cursor == ',' ? strtod(Cursor + 1, nullptr) : 1.0;
+				options.serverOutages.push_back({ Start, Duration });
+			}
+			else if (strcmp(argv[i], "--flash") == 0 && HasValue) {
+				options.flashPath = argv[++i];
+			}
+			else if (strcmp(argv[i], "--window") == 0 && HasValue) {
+				options.requestWindow = atoi(argv[++i]);
+			}
+			else if (strcmp(argv[i], "--reply-loss") == 0 && HasValue) {
+				options.replyLoss = atof(argv[++i]) / 100.0;
+			}
+			else if (strcmp(argv[i], "--request-loss") == 0 && HasValue) {
+				options.requestLoss = atof(argv[++i]) / 100.0;
+			}
+			else {
+				fprintf(stderr,
+					"Usage: %s [--hours N] [--start-hour H] [--rtt-ms N] [--loop-cost-us N] [--seed N]\n"
+					"          [--trace out.csv] [--feed-hours 7,12,18] [--on-device-schedule] [--refill-below PERCENT] [--json-only] [--poll-only]\n"
+					"          [--dry-after HOURS] [--stuck-sensor-after HOURS]\n"
+					"          [--full-reports] [--no-history] [--outage AFTER_HOURS,HOURS] [--server-down AFTER_HOURS,HOURS] [--flash partition.bin]\n"
+					"          [--window N] [--reply-loss PERCENT] [--request-loss PERCENT] [--i2c-khz N] [--lcd-stress] [--verbose]\n",
+					argv[0]);
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Simulated time of the first feeding click at or after nowMicros
+	uint64_t NextFeedMicros(const Options& options, uint64_t nowMicros) {
+		uint64_t Best = UINT64_MAX;
+
+		for (double FeedHour : options.feedHours) {
+			double HoursUntil = fmod(FeedHour - options.startHour + 48.0, 24.0);
+			uint64_t First = (uint64_t)(HoursUntil * MICROS_PER_HOUR);
+			uint64_t Candidate = First;
+
+			if (nowMicros > First)
+				Candidate = First + ((nowMicros - First + 24 * MICROS_PER_HOUR - 1) / (24 * MICROS_PER_HOUR)) * 24 * MICROS_PER_HOUR;
+
+			if (Candidate < Best)
+				Best = Candidate;
+		}
+
+		return Best;
+	}
+
+	// Whether one of the outages covers nowMicros, and when that changes next
+	bool IsOutage(const std::vector<std::pair<double, double>>& outages, uint64_t nowMicros, uint64_t& nextChangeMicros) {
+		bool IsDown = false;
+		nextChangeMicros = UINT64_MAX;
+
+		for (auto& Outage : outages) {
+			uint64_t Start = (uint64_t)(Outage.first * MICROS_PER_HOUR);
+			uint64_t End = Start + (uint64_t)(Outage.second * MICROS_PER_HOUR);
+
+			if (nowMicros >= Start && nowMicros < End) {
+				IsDown = true;
+				if (End < nextChangeMicros) nextChangeMicros = End;
+			}
+			else if (nowMicros < Start && Start < nextChangeMicros) {
+				nextChangeMicros = Start;
+			}
+		}
+
+		return IsDown;
+	}
+
+	int Run(const Options& options) {
+		Random random(options.seed);
+		DHT11Model dhtModel(random, options.startHour);
+		WaterTankModel tankModel(random, 40.0);
+		BackendStandIn backend(trace, random, options.roundTripMicros);
+		backend.acceptsBinary = !options.isJsonOnly;
+		backend.acceptsPush = !options.isPollOnly;
+		backend.acceptsDelta = !options.isFullReports;
+		backend.acceptsHistory = !options.isNoHistory;
+		backend.replyLoss = options.replyLoss;
+		backend.requestLoss = options.requestLoss;
+
+		#if ENABLE_FEEDING_SCHEDULE == true
+			if (options.isOnDeviceSchedule) {
+				// Every day on feeder 0, in a time zone whose midnight lines up with startHour
+				backend.acceptsSchedule = true;
+				backend.schedule.revision = 1;
+				backend.schedule.utcOffset = SIM_SCHEDULE_UTC_OFFSET;
+				backend.unixEpoch = backend.unixEpoch - backend.unixEpoch % 86400 + (uint32_t)(options.startHour * 3600.0) - SIM_SCHEDULE_UTC_OFFSET * 60;
+
+				for (double FeedHour : options.feedHours) {
+					if (backend.schedule.entryCount >= SCHEDULE_MAX_ENTRIES)
+						break;
+
+					ScheduleEntry& Entry = backend.schedule.entries[backend.schedule.entryCount++];
+					Entry.minute = (uint16_t)(lround(FeedHour * 60.0) % SCHEDULE_MINUTES_PER_DAY);
+					Entry.weekdays = SCHEDULE_EVERY_DAY;
+					Entry.feeder = 0;
+					Entry.openMillis = SERVO_OPEN_TIMEOUT;
+				}
+			}
+		#endif
+
+		NativeHAL::setSerialQuiet(!options.verbose);
+		NativeHAL::setWebSocketServer(&backend);
+		NativeHAL::setNetworkDelayMicros(options.roundTripMicros);
+		NativeHAL::setDigitalWriteHook(OnDigitalWrite);
+		NativeHAL::setAnalogReadHook(OnAnalogRead);
+		NativeHAL::setI2CClockHz(options.i2cClockHz);
+		pTankModel = &tankModel;
+		#if ENABLE_DHT == true
+			NativeHAL::setDHTPin(DHT_PIN);
+		#endif
+
+		if (options.flashPath != nullptr && !NativeHAL::setFlashFile(options.flashPath)) {
+			fprintf(stderr, "Unable to open flash file %s\n", options.flashPath);
+			return 1;
+		}
+
+		// The firmware tells when its timers fire next, the loop below jumps the clock there
+		HAL_wakeupHint = [](ulong micros) { NativeHAL::hintWakeup(micros); };
+
+		auto WallStart = std::chrono::steady_clock::now();
+
+		dhtModel.update(0);
+		tankModel.update(0, false);
+		setup();
+
+		#if ENABLE_WIFI == true
+			wifiNetwork.getRequestWindow().setLimit(options.requestWindow);
+		#endif
+
+		uint64_t EndMicros = (uint64_t)(options.hours * MICROS_PER_HOUR);
+		uint64_t NextFeed = NextFeedMicros(options, NativeHAL::nowMicros());
+		uint64_t NextRefillAllowed = 0;
+		uint64_t NextLCDStress = options.isLCDStress ? NativeHAL::nowMicros() : UINT64_MAX;
+		uint64_t Iterations = 0;
+
+		// Click-to-actuation tracking for the food servo
+		std::vector<int> LastServoDegrees(actuators.feeders.count, -1);
+		uint64_t PendingFeedClick = 0;
+		uint64_t FeedCount = 0;
+		uint64_t FeedLatencyTotal = 0;
+		uint64_t FeedLatencyMax = 0;
+		uint64_t FeedsDue = 0;
+		uint64_t OfflineFeedCount = 0;
+
+		uint64_t PumpOnMicros = 0;
+		uint64_t DryPumpMicros = 0; // Pump on with the reservoir empty
+		uint64_t DryAfterMicros = options.dryAfterHours < 0.0 ? UINT64_MAX : (uint64_t)(options.dryAfterHours * MICROS_PER_HOUR);
+		uint64_t StuckAfterMicros = options.stuckSensorAfterHours < 0.0 ? UINT64_MAX : (uint64_t)(options.stuckSensorAfterHours * MICROS_PER_HOUR);
+		uint64_t BusyMicros = 0; // Time inside loop() outside of delay()
+		uint64_t LoopStartMicros = NativeHAL::nowMicros();
+		double MinLevel = tankModel.level;
+		double MaxLevel = tankModel.level;
+
+		// Level the firmware works with against the bowl
+		double LevelErrorTotal = 0.0;
+		double LevelErrorMax = 0.0;
+		uint64_t LevelErrorSamples = 0;
+		uint64_t FullChanges = 0;
+		uint64_t FalseFullChanges = 0; // The flag changed on the wrong side of its threshold, noise or a hysteresis that didn't hold
+		bool WasFull = businessLogic.isWaterFull;
+
+		// Peak of the bowl after each refill against the target, once the hose drained and the surface settled
+		bool WasPumpOn = false;
+		bool IsWatchingPeak = false;
+		uint64_t PumpOffMicros = 0;
+		double PeakLevel = 0.0;
+		uint64_t PeakCount = 0;
+		double OvershootTotal = 0.0;
+		double OvershootMax = -100.0;
+
+		// Journal backlog after the last outage
+		bool IsWiFiDown = false;
+		uint64_t NextOutageChange = UINT64_MAX;
+		uint64_t OutageEndMicros = 0;
+		uint64_t DrainMicros = 0;
+		bool IsDraining = false;
+
+		// From the backend coming back to the next /login
+		bool IsServerDown = false;
+		uint64_t NextServerChange = UINT64_MAX;
+		uint64_t ServerUpMicros = 0;
+		bool IsWaitingForLogin = false;
+		uint32_t LoginsBefore = 0;
+		uint64_t RecoveryCount = 0;
+		uint64_t RecoveryTotal = 0;
+		uint64_t RecoveryMax = 0;
+
+		while (NativeHAL::nowMicros() < EndMicros) {
+			uint64_t Now = NativeHAL::nowMicros();
+
+			tankModel.isReservoirEmpty = Now >= DryAfterMicros;
+			tankModel.isSensorStuck = Now >= StuckAfterMicros;
+			tankModel.update(Now, isPumpOn);
+			dhtModel.update(Now);
+
+			bool IsDown = IsOutage(options.outages, Now, NextOutageChange);
+			if (IsDown != IsWiFiDown) {
+				NativeHAL::setWiFiAvailable(!IsDown);
+				trace.event(Now, IsDown ? "wifi_down" : "wifi_up");
+				IsWiFiDown = IsDown;
+
+				if (!IsDown) {
+					OutageEndMicros = Now;
+					IsDraining = true;
+				}
+			}
+
+			bool IsServerOutage = IsOutage(options.serverOutages, Now, NextServerChange);
+			if (IsServerOutage != IsServerDown) {
+				backend.setAvailable(!IsServerOutage);
+				IsServerDown = IsServerOutage;
+
+				#if ENABLE_WIFI == true
+					if (!IsServerOutage) {
+						ServerUpMicros = Now;
+						IsWaitingForLogin = true;
+						LoginsBefore = wifiNetwork.getLoginCount();
+					}
+				#endif
+			}
+
+			if (tankModel.level < MinLevel) MinLevel = tankModel.level;
+			if (tankModel.level > MaxLevel) MaxLevel = tankModel.level;
+
+			if (Now >= NextFeed) {
+				// The firmware feeds on its own, the time it should is what the latency is taken from
+				if (options.isOnDeviceSchedule) {
+					trace.event(Now, "feed_due");
+				}
+				else {
+					backend.triggerDispenseFood();
+					trace.event(Now, "click_feed");
+				}
+
+				FeedsDue++;
+				PendingFeedClick = Now;
+				NextFeed = NextFeedMicros(options, Now + 1);
+			}
+
+			if (backend.lastWaterLevel >= 0 && backend.lastWaterLevel < options.refillBelowLevel && Now >= NextRefillAllowed && !isPumpOn) {
+				backend.triggerWaterPump();
+				trace.event(Now, "click_pump", "%d", backend.lastWaterLevel);
+				NextRefillAllowed = Now + 10 * 60 * 1000000ULL;
+			}
+
+			backend.deliver(Now);
+
+			#if ENABLE_LCD_OUTPUT == true
+				// Nothing else touches the renderer while loop() isn't running
+				if (Now >= NextLCDStress) {
+					lcdRenderer.invalidate();
+					NextLCDStress = Now + 1000000;
+				}
+			#endif
+
+			NativeHAL::takeWakeup();
+			uint64_t DelayedBefore = NativeHAL::getDelayedMicros();
+			loop();
+			NativeHAL::advanceMicros(options.loopCostMicros);
+			Iterations++;
+
+			uint64_t After = NativeHAL::nowMicros();
+			BusyMicros += (After - Now) - (NativeHAL::getDelayedMicros() - DelayedBefore);
+
+			#if ENABLE_WATER_LEVEL_SENSOR == true
+				double LevelError = fabs(businessLogic.waterLevel - tankModel.level);
+				LevelErrorTotal += LevelError;
+				LevelErrorSamples++;
+				if (LevelError > LevelErrorMax)
+					LevelErrorMax = LevelError;
+
+				if (businessLogic.isWaterFull != WasFull) {
+					FullChanges++;
+					WasFull = businessLogic.isWaterFull;
+
+					// Set at the full level and cleared the hysteresis below it, a stuck sensor reads whatever it reads
+					bool IsOnThreshold = WasFull
+						? tankModel.level >= WATER_LEVEL_FULL_PERCENT - SIM_FULL_FLAG_TOLERANCE
+						: tankModel.level < WATER_LEVEL_FULL_PERCENT - WATER_LEVEL_FULL_HYSTERESIS + SIM_FULL_FLAG_TOLERANCE;
+
+					if (!IsOnThreshold && !tankModel.isSensorStuck) {
+						FalseFullChanges++;
+						trace.event(Now, "false_full_change", "%.1f", tankModel.level);
+					}
+				}
+			#endif
+
+			if (isPumpOn != WasPumpOn) {
+				WasPumpOn = isPumpOn;
+
+				// A dry run never got near the target
+				IsWatchingPeak = !isPumpOn && !tankModel.isReservoirEmpty;
+				PumpOffMicros = After;
+				PeakLevel = tankModel.level;
+			}
+
+			if (IsWatchingPeak) {
+				if (tankModel.level > PeakLevel)
+					PeakLevel = tankModel.level;
+
+				if (After - PumpOffMicros >= 20 * 1000000ULL) {
+					double Overshoot = PeakLevel - WATER_LEVEL_FULL_PERCENT;
+					PeakCount++;
+					OvershootTotal += Overshoot;
+					if (Overshoot > OvershootMax)
+						OvershootMax = Overshoot;
+
+					IsWatchingPeak = false;
+				}
+			}
+
+			#if ENABLE_WIFI == true
+				if (IsWaitingForLogin && wifiNetwork.getLoginCount() != LoginsBefore) {
+					uint64_t Recovery = After - ServerUpMicros;
+					RecoveryCount++;
+					RecoveryTotal += Recovery;
+					if (Recovery > RecoveryMax)
+						RecoveryMax = Recovery;
+
+					IsWaitingForLogin = false;
+				}
+			#endif
+
+			#if ENABLE_TELEMETRY_JOURNAL == true
+				if (IsDraining && wifiNetwork.isLoggedIn() && !wifiNetwork.getJournal().hasPending()) {
+					DrainMicros = After - OutageEndMicros;
+					IsDraining = false;
+				}
+			#endif
+
+			for (size_t i = 0; i < actuators.feeders.count && i < LastServoDegrees.size(); i++) {
+				// Where the servo is driven to, which reaches SERVO_OPEN_ANGLE at the end of the ramp
+				int Degrees = actuators.feeders.positions[i];
+				if (Degrees == LastServoDegrees[i])
+					continue;
+
+				// The loop may have slept after moving the servo, use the time of the pin write
+				uint64_t MovedAt = NativeHAL::getLastWriteMicros(actuators.feeders.pins[i]);
+				if (MovedAt < Now)
+					MovedAt = After;
+
+				trace.event(MovedAt, "servo", "%zu %d", i, Degrees);
+				LastServoDegrees[i] = Degrees;
+
+				if (Degrees == SERVO_OPEN_ANGLE && PendingFeedClick != 0) {
+					uint64_t Latency = MovedAt - PendingFeedClick;
+					FeedCount++;
+					FeedLatencyTotal += Latency;
+					if (Latency > FeedLatencyMax)
+						FeedLatencyMax = Latency;
+					if (IsWiFiDown)
+						OfflineFeedCount++;
+
+					PendingFeedClick = 0;
+				}
+			}
+
+			// Jump straight to the next thing that can happen instead of spinning
+			uint64_t Wakeup = NativeHAL::takeWakeup();
+			uint64_t BackendEvent = backend.nextEventMicros();
+			if (BackendEvent < Wakeup) Wakeup = BackendEvent;
+			if (NextFeed < Wakeup) Wakeup = NextFeed;
+			if (NextOutageChange < Wakeup) Wakeup = NextOutageChange;
+			if (NextServerChange < Wakeup) Wakeup = NextServerChange;
+			if (NextLCDStress < Wakeup) Wakeup = NextLCDStress;
+			if (EndMicros < Wakeup) Wakeup = EndMicros;
+
+			if (isPumpOn) {
+				PumpOnMicros += (Wakeup > After ? Wakeup : After) - Now;
+
+				if (tankModel.isReservoirEmpty)
+					DryPumpMicros += (Wakeup > After ? Wakeup : After) - Now;
+			}
+
+			if (Wakeup > After)
+				NativeHAL::setMicros(Wakeup);
+		}
+
+		backend.shutdown();
+		NativeHAL::setWebSocketServer(nullptr);
+
+		double WallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - WallStart).count();
+		double SimulatedHours = NativeHAL::nowMicros() / (double)MICROS_PER_HOUR;
+
+		fprintf(stderr, "[sim] %.2f h simulated in %.3f s wall (%.0fx), %llu loop() iterations\n",
+			SimulatedHours, WallSeconds, WallSeconds > 0 ? SimulatedHours * 3600.0 / WallSeconds : 0.0,
+			(unsigned long long)Iterations);
+		fprintf(stderr, "[sim] firmware busy %.3f%% of the time after setup(), %.1f s in total\n",
+			BusyMicros * 100.0 / (NativeHAL::nowMicros() - LoopStartMicros), BusyMicros / 1000000.0);
+		fprintf(stderr, "[sim] RTT %.1f ms, WS_RTX_ON %s, %s frames, %s reports, commands %s, %llu WebSocket connection(s)\n",
+			options.roundTripMicros / 1000.0, WS_RTX_ON ? "true" : "false",
+			WS_BINARY_PROTOCOL && !options.isJsonOnly ? "binary" : "JSON",
+			WS_TELEMETRY_DELTA && !options.isFullReports ? "delta" : "full",
+			WS_COMMAND_PUSH && !options.isPollOnly ? "pushed" : "polled",
+			(unsigned long long)backend.connectCount);
+
+		#if ENABLE_WIFI == true
+			RequestWindow& Window = wifiNetwork.getRequestWindow();
+			fprintf(stderr, "[sim] request window %u, %u answered, %u retransmitted\n",
+				Window.getLimit(), Window.getCompletedCount(), Window.getRetransmitCount());
+			// Only with --server-down, otherwise the server never came back from anything
+			std::string Recovery;
+			if (!options.serverOutages.empty()) {
+				Recovery = RecoveryCount == 0
+					? ", never logged in after the server came back"
+					: ", logged in " + std::to_string(RecoveryTotal / RecoveryCount / 1000) + " ms avg " + std::to_string(RecoveryMax / 1000) + " ms max after the server came back";
+			}
+
+			fprintf(stderr, "[sim] reconnect: %u attempts for %u logins, time to ready last %lu ms max %lu ms%s, %u DNS lookups, %u TCP connects, %d socket(s) open at the end\n",
+				wifiNetwork.getConnectAttemptCount(), wifiNetwork.getLoginCount(),
+				(unsigned long)wifiNetwork.getLastTimeToReady(), (unsigned long)wifiNetwork.getMaxTimeToReady(), Recovery.c_str(),
+				NativeHAL::getDNSLookupCount(), NativeHAL::getTcpConnectCount(), NativeHAL::getOpenSocketCount());
+		#endif
+
+		uint64_t TotalFrames = 0;
+		uint64_t TotalBytesUp = 0;
+		uint64_t TotalBytesDown = 0;
+
+		for (auto& Entry : backend.stats) {
+			const EndpointStats& Stats = Entry.second;
+			TotalFrames += Stats.requests;
+			TotalBytesUp += Stats.bytesUp;
+			TotalBytesDown += Stats.bytesDown;
+
+			// Only what happened, a run without losses keeps the line short
+			std::string Losses;
+			if (Stats.duplicates || Stats.lostReplies)
+				Losses += ", " + std::to_string(Stats.lostReplies) + " lost, " + std::to_string(Stats.duplicates) + " duplicate";
+			if (Stats.lostRequests)
+				Losses += ", " + std::to_string(Stats.lostRequests) + " requests lost";
+			if (Stats.keyframeRequests)
+				Losses += ", " + std::to_string(Stats.keyframeRequests) + " keyframes requested";
+
+			fprintf(stderr, "[sim] %-16s %8llu req (%6.2f/min) %10llu B up %10llu B down, round-trip avg %7.1f ms max %7.1f ms%s\n",
+				Entry.first.c_str(),
+				(unsigned long long)Stats.requests,
+				Stats.requests / (SimulatedHours * 60.0),
+				(unsigned long long)Stats.bytesUp,
+				(unsigned long long)Stats.bytesDown,
+				Stats.replies ? Stats.roundTripTotalMicros / 1000.0 / Stats.replies : 0.0,
+				Stats.roundTripMaxMicros / 1000.0,
+				Losses.c_str());
+		}
+
+		double SimulatedSeconds = SimulatedHours * 3600.0;
+		fprintf(stderr, "[sim] all endpoints: %.2f frames/s, %.1f B/s up, %.1f B/s down\n",
+			TotalFrames / SimulatedSeconds, TotalBytesUp / SimulatedSeconds, TotalBytesDown / SimulatedSeconds);
+
+		#if ENABLE_TELEMETRY_JOURNAL == true
+			TelemetryJournal& Journal = wifiNetwork.getJournal();
+			fprintf(stderr, "[sim] journal: %u samples kept offline, %u uploaded, %u dropped, backlog drained %s after the last outage\n",
+				Journal.getAppendedCount(), Journal.getUploadedCount(), Journal.getDroppedCount(),
+				OutageEndMicros == 0 ? "n/a" : IsDraining ? "never" : (std::to_string(DrainMicros / 1000) + " ms").c_str());
+			fprintf(stderr, "[sim] flash: %u sector erases, %u on the most worn sector, %llu B written\n",
+				NativeHAL::getFlashEraseCount(), NativeHAL::getFlashMaxSectorErases(), (unsigned long long)NativeHAL::getFlashBytesWritten());
+		#endif
+
+		// Server side history, live reports and backfilled samples alike
+		std::vector<uint32_t> ReportTimes = backend.reportTimes;
+		std::sort(ReportTimes.begin(), ReportTimes.end());
+
+		uint32_t LongestGap = 0;
+		for (size_t i = 1; i < ReportTimes.size(); i++) {
+			if (ReportTimes[i] - ReportTimes[i - 1] > LongestGap)
+				LongestGap = ReportTimes[i] - ReportTimes[i - 1];
+		}
+
+		fprintf(stderr, "[sim] history: %zu points stored, %llu backfilled, %llu skipped as already stored, longest gap %u s\n",
+			ReportTimes.size(), (unsigned long long)backend.historySamples, (unsigned long long)backend.historySkipped, LongestGap);
+
+		#if ENABLE_DHT == true
+			// A blocking read holds up every task due while it runs
+			ulong DHTMaxDuration = 0;
+			ulong LogicMaxJitter = 0;
+			for (int i = 0; i < scheduler.getTaskCount(); i++) {
+				const SchedulerTask* Task = scheduler.getTask(i);
+				if (strcmp(Task->name, "dht") == 0)
+					DHTMaxDuration = Task->maxDurationMicros;
+				else if (strcmp(Task->name, "logic") == 0)
+					LogicMaxJitter = Task->maxJitterMicros;
+			}
+
+			fprintf(stderr, "[sim] dht: %s, %u reads, %u failed, %u frames sent, task ran %llu us at most, logic started up to %.1f ms late\n",
+				DHT_EDGE_CAPTURE ? "edge capture" : "blocking read",
+				dht1.getReadCount(), dht1.getErrorCount(), NativeHAL::getDHTFrameCount(),
+				(unsigned long long)DHTMaxDuration, LogicMaxJitter / 1000.0);
+		#endif
+
+		#if ENABLE_LCD_OUTPUT == true
+			fprintf(stderr, "[sim] lcd: %u refreshes, %u characters and %u cursor moves sent, %.1f I2C B/s\n",
+				lcdRenderer.getFlushCount(), lcdRenderer.getWrittenCount(), lcdRenderer.getCursorMoveCount(), lcd.getBusBytes() / SimulatedSeconds);
+			fprintf(stderr, "[sim] i2c: %s at %u kHz, %u transactions taking up to %lu us, %u turned away by a full queue, drain ran %lu us at most\n",
+				I2C_ASYNC ? "queued" : "from the caller", options.i2cClockHz / 1000,
+				i2cBus.getCompletedCount(), (unsigned long)i2cBus.getMaxTransactionMicros(), i2cBus.getRejectedCount(), (unsigned long)i2cBus.getMaxDrainMicros());
+		#endif
+
+		// Worst start delay of every control task, what a blocking task costs the ones due while it runs
+		std::string ControlLoop;
+		for (int i = 0; i < scheduler.getTaskCount(); i++) {
+			const SchedulerTask* Task = scheduler.getTask(i);
+			char Text[64];
+			snprintf(Text, sizeof(Text), "%s%s %.2f ms", ControlLoop.empty() ? "" : ", ", Task->name, Task->maxJitterMicros / 1000.0);
+			ControlLoop += Text;
+		}
+
+		fprintf(stderr, "[sim] control loop: started up to %s late\n", ControlLoop.c_str());
+
+		// As the stand-in got them at /iot/metrics, the simulated clock only moves in delays and modeled bus time
+		std::string Metrics;
+		for (int i = 0; i < 2; i++) {
+			for (auto& Row : i == 0 ? backend.metricProbes : backend.metricLateness) {
+				char Text[96];
+				snprintf(Text, sizeof(Text), "%s%s%s p99 %u max %u us", Metrics.empty() ? "" : ", ", i == 0 ? "" : "late ", Row.first.c_str(), Row.second[3], Row.second[4]);
+				Metrics += Text;
+			}
+		}
+
+		fprintf(stderr, "[sim] metrics: %llu /iot/metrics frames, %s\n", (unsigned long long)backend.metricFrames, Metrics.empty() ? "none received" : Metrics.c_str());
+
+		fprintf(stderr, "[sim] feeding: %llu dispensed, %s avg %.1f ms max %.1f ms\n",
+			(unsigned long long)FeedCount, options.isOnDeviceSchedule ? "due-to-open" : "click-to-open",
+			FeedCount ? FeedLatencyTotal / 1000.0 / FeedCount : 0.0,
+			FeedLatencyMax / 1000.0);
+		#if ENABLE_FEEDING_SCHEDULE == true
+			if (options.isOnDeviceSchedule) {
+				FeedingSchedule& Schedule = businessLogic.getFeedingSchedule();
+				fprintf(stderr, "[sim] schedule: revision %u on the device after %llu push(es), %llu of %llu feeds dispensed while WiFi was down, %u skipped as late\n",
+					Schedule.getRevision(), (unsigned long long)backend.schedulePushes,
+					(unsigned long long)OfflineFeedCount, (unsigned long long)FeedsDue, Schedule.getSkippedCount());
+			}
+		#endif
+
+		fprintf(stderr, "[sim] water: pump on %.1f s total in %llu runs, bowl level %.1f%% - %.1f%%, final %.1f%%\n",
+			PumpOnMicros / 1000000.0, (unsigned long long)pumpStarts, MinLevel, MaxLevel, tankModel.level);
+		fprintf(stderr, "[sim] pump control: %s, %llu refills peaked at %+.1f%% on average, %+.1f%% at most against the %d%% target, %.1f s pumped dry\n",
+			WATER_PUMP_CLOSED_LOOP ? "closed loop" : "level threshold", (unsigned long long)PeakCount,
+			PeakCount ? OvershootTotal / PeakCount : 0.0, PeakCount ? OvershootMax : 0.0, WATER_LEVEL_FULL_PERCENT, DryPumpMicros / 1000000.0);
+		#if ENABLE_WATER_LEVEL_SENSOR == true && WATER_PUMP_CLOSED_LOOP == true
+			PumpController& Controller = businessLogic.getPumpController();
+			fprintf(stderr, "[sim] pump controller: last fill rate %.2f%%/s, coast %.1f s, %u early stops, %u dry runs, %u stuck sensor stops\n",
+				Controller.getRate(), Controller.getCoastSeconds(), Controller.getEarlyStopCount(), Controller.getDryRunCount(), Controller.getStuckCount());
+		#endif
+		fprintf(stderr, "[sim] water level reading: off by %.2f%% on average, %.1f%% at most, full flag changed %llu times, %llu of them away from its threshold\n",
+			LevelErrorSamples ? LevelErrorTotal / LevelErrorSamples : 0.0, LevelErrorMax, (unsigned long long)FullChanges, (unsigned long long)FalseFullChanges);
+
+		if (FalseFullChanges > 0) {
+			fprintf(stderr, "[sim] FAIL: the full flag changed %llu times with the bowl more than %.1f%% away from the level that should change it\n",
+				(unsigned long long)FalseFullChanges, SIM_FULL_FLAG_TOLERANCE);
+			return 2;
+		}
+
+		return 0;
+	}
+}
+
+int main(int argc, char** argv) {
+	NativeSim::Options options;
+
+	if (!NativeSim::ParseOptions(argc, argv, options))
+		return 1;
+
+	if (options.tracePath != nullptr && !NativeSim::trace.open(options.tracePath)) {
+		fprintf(stderr, "Unable to open trace file %s\n", options.tracePath);
+		return 1;
+	}
+
+	return NativeSim::Run(options);
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#include "Trace.h"
+#include <stdarg.h>
+
+namespace NativeSim {
+	Trace::~Trace() {
+		if (this->file != nullptr)
+			fclose(this->file);
+	}
+
+	bool Trace::open(const char* path) {
+		this->file = fopen(path, "w");
+		if (this->file == nullptr)
+			return false;
+
+		fprintf(this->file, "time_s,event,detail\n");
+		return true;
+	}
+
+	void Trace::event(uint64_t nowMicros, const char* name) {
+		if (this->file == nullptr)
+			return;
+
+		fprintf(this->file, "%.6f,%s,\n", nowMicros / 1000000.0, name);
+	}
+
+	void Trace::event(uint64_t nowMicros, const char* name, const char* format, ...) {
+		if (this->file == nullptr)
+			return;
+
+		fprintf(this->file, "%.6f,%s,", nowMicros / 1000000.0, name);
+
+		va_list args;
+		va_start(args, format);
+		vfprintf(this->file, format, args);
+		va_end(args);
+
+		fputc('\n', this->file);
+	}
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+
+namespace NativeSim {
+	// CSV event log: simulated seconds, event name, detail
+	class Trace {
+		public:
+			~Trace();
+			bool open(const char* path);
+			void event(uint64_t nowMicros, const char* name);
+			void event(uint64_t nowMicros, const char* name, const char* format, ...) __attribute__((format(printf, 4, 5)));
+
+		private:
+			FILE* file = nullptr;
+	};
+}
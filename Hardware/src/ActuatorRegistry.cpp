@@ -0,0 +1,44 @@
+#include <Arduino.h>
+#include "ActuatorRegistry.h"
+#include "ServoPulse.h"
+
+ActuatorRegistry::ActuatorRegistry() {
+	this->feeders = {};
+	this->pumps = {};
+}
+
+int ActuatorRegistry::addFeeder(gpio_num_t pin, ulong openTimeout) {
+	if (this->feeders.count >= ACTUATOR_MAX_COUNT) {
+		Serial.println("No feeder ID left, raise ACTUATOR_MAX_COUNT.");
+		return -1;
+	}
+
+	uint8_t Id = this->feeders.count++;
+	this->feeders.pins[Id] = pin;
+	this->feeders.degrees[Id] = SERVO_CLOSE_ANGLE;
+	this->feeders.positions[Id] = SERVO_CLOSE_ANGLE;
+	this->feeders.pulses[Id] = ServoPulse_lookup(Id, SERVO_CLOSE_ANGLE);
+	this->feeders.openTimes[Id] = 0;
+	this->feeders.openTimeouts[Id] = openTimeout;
+	this->feeders.openDurations[Id] = openTimeout;
+	this->feeders.openMask &= ~(1UL << Id);
+	this->feeders.movingMask &= ~(1UL << Id);
+	return Id;
+}
+
+int ActuatorRegistry::addPump(gpio_num_t pin, ulong enableTimeout) {
+	if (this->pumps.count >= ACTUATOR_MAX_COUNT) {
+		Serial.println("No pump ID left, raise ACTUATOR_MAX_COUNT.");
+		return -1;
+	}
+
+	uint8_t Id = this->pumps.count++;
+	this->pumps.pins[Id] = pin;
+	this->pumps.enableTimes[Id] = 0;
+	this->pumps.enableTimeouts[Id] = enableTimeout;
+	this->pumps.enabledMask &= ~(1UL << Id);
+
+	pinMode(pin, OUTPUT);
+	digitalWrite(pin, HIGH); // Relay off
+	return Id;
+}
\ No newline at end of file
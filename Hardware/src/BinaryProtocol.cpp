@@ -0,0 +1,165 @@
+#include <math.h>
+#include "BinaryProtocol.h"
+
+// Hundredths as int16, null for anything that can't be represented
+static int16_t BinaryProtocol_centi(float value) {
+	if (!isfinite(value) || fabsf(value) > 327.67f)
+		return BINARY_NULL_VALUE;
+
+	return (int16_t)lroundf(value * 100.0f);
+}
+
+// Clamped so a water level is never read back as null
+static int16_t BinaryProtocol_waterLevel(int value) {
+	if (value <= BINARY_NULL_VALUE)
+		return BINARY_NULL_VALUE + 1;
+
+	if (value > INT16_MAX)
+		return INT16_MAX;
+
+	return (int16_t)value;
+}
+
+static uint8_t BinaryProtocol_flags(const TelemetrySample& sample) {
+	return (sample.pumpMask != 0 ? BINARY_FLAG_PUMP : 0) | (sample.feederMask != 0 ? BINARY_FLAG_FOOD : 0);
+}
+
+static void BinaryProtocol_writeInt16(uint8_t* cursor, int16_t value) {
+	cursor[0] = (uint16_t)value & 0xFF;
+	cursor[1] = (uint16_t)value >> 8;
+}
+
+static void BinaryProtocol_writeUint32(uint8_t* cursor, uint32_t value) {
+	cursor[0] = value & 0xFF;
+	cursor[1] = (value >> 8) & 0xFF;
+	cursor[2] = (value >> 16) & 0xFF;
+	cursor[3] = value >> 24;
+}
+
+static uint32_t BinaryProtocol_readUint32(const uint8_t* cursor) {
+	return cursor[0] | (cursor[1] << 8) | (cursor[2] << 16) | ((uint32_t)cursor[3] << 24);
+}
+
+static void BinaryProtocol_writeReadings(uint8_t* payload, const TelemetrySample& sample) {
+	BinaryProtocol_writeInt16(payload, BinaryProtocol_centi(sample.temperature));
+	BinaryProtocol_writeInt16(payload + 2, BinaryProtocol_centi(sample.humidity));
+	BinaryProtocol_writeInt16(payload + 4, BinaryProtocol_waterLevel(sample.waterLevel));
+}
+
+static void BinaryProtocol_writePayload(uint8_t* payload, const TelemetrySample& sample) {
+	BinaryProtocol_writeReadings(payload, sample);
+	BinaryProtocol_writeUint32(payload + BINARY_READINGS_SIZE, sample.pumpMask);
+	BinaryProtocol_writeUint32(payload + BINARY_READINGS_SIZE + 4, sample.feederMask);
+}
+
+static void BinaryProtocol_writeHeader(uint8_t* buffer, BinaryMessageType type) {
+	buffer[0] = BINARY_PROTOCOL_MAGIC;
+	buffer[1] = type;
+	BinaryProtocol_writeInt16(buffer + BINARY_REQUEST_ID_OFFSET, 0);
+}
+
+size_t BinaryProtocol_encodeTelemetry(const TelemetrySample& sample, uint8_t* buffer, size_t capacity) {
+	if (capacity < BINARY_POST_DATA_FRAME_SIZE)
+		return 0;
+
+	BinaryProtocol_writeHeader(buffer, BINARY_POST_DATA);
+	BinaryProtocol_writePayload(buffer + BINARY_REQUEST_HEADER_SIZE, sample);
+
+	return BINARY_POST_DATA_FRAME_SIZE;
+}
+
+size_t BinaryProtocol_encodeTelemetryDelta(const TelemetrySample& sample, uint8_t fields, uint16_t sequence, bool keyframe, uint8_t* buffer, size_t capacity) {
+	if (capacity < BINARY_POST_DELTA_MAX_FRAME_SIZE)
+		return 0;
+
+	fields &= TELEMETRY_FIELD_ALL;
+
+	BinaryProtocol_writeHeader(buffer, BINARY_POST_DELTA);
+	buffer[BINARY_REQUEST_HEADER_SIZE] = sequence & 0xFF;
+	buffer[BINARY_REQUEST_HEADER_SIZE + 1] = sequence >> 8;
+	buffer[BINARY_REQUEST_HEADER_SIZE + 2] = fields | (keyframe ? BINARY_DELTA_KEYFRAME : 0);
+
+	uint8_t* Cursor = buffer + BINARY_POST_DELTA_HEADER_SIZE;
+
+	if (fields & TELEMETRY_FIELD_TEMPERATURE) {
+		BinaryProtocol_writeInt16(Cursor, BinaryProtocol_centi(sample.temperature));
+		Cursor += 2;
+	}
+
+	if (fields & TELEMETRY_FIELD_HUMIDITY) {
+		BinaryProtocol_writeInt16(Cursor, BinaryProtocol_centi(sample.humidity));
+		Cursor += 2;
+	}
+
+	if (fields & TELEMETRY_FIELD_WATER_LEVEL) {
+		BinaryProtocol_writeInt16(Cursor, BinaryProtocol_waterLevel(sample.waterLevel));
+		Cursor += 2;
+	}
+
+	if (fields & TELEMETRY_FIELD_PUMP) {
+		BinaryProtocol_writeUint32(Cursor, sample.pumpMask);
+		Cursor += 4;
+	}
+
+	if (fields & TELEMETRY_FIELD_FOOD) {
+		BinaryProtocol_writeUint32(Cursor, sample.feederMask);
+		Cursor += 4;
+	}
+
+	return Cursor - buffer;
+}
+
+size_t BinaryProtocol_encodeGetData(uint8_t* buffer, size_t capacity) {
+	if (capacity < BINARY_GET_DATA_FRAME_SIZE)
+		return 0;
+
+	BinaryProtocol_writeHeader(buffer, BINARY_GET_DATA);
+	return BINARY_GET_DATA_FRAME_SIZE;
+}
+
+size_t BinaryProtocol_encodeHistory(const JournalSample* samples, size_t count, size_t& encoded, uint8_t* buffer, size_t capacity) {
+	encoded = 0;
+	if (capacity < BINARY_POST_HISTORY_HEADER_SIZE + BINARY_HISTORY_SAMPLE_SIZE || count == 0)
+		return 0;
+
+	if (count > (capacity - BINARY_POST_HISTORY_HEADER_SIZE) / BINARY_HISTORY_SAMPLE_SIZE)
+		count = (capacity - BINARY_POST_HISTORY_HEADER_SIZE) / BINARY_HISTORY_SAMPLE_SIZE;
+
+	if (count > 255)
+		count = 255;
+
+	BinaryProtocol_writeHeader(buffer, BINARY_POST_HISTORY);
+	buffer[BINARY_REQUEST_HEADER_SIZE] = count;
+
+	uint8_t* Cursor = buffer + BINARY_POST_HISTORY_HEADER_SIZE;
+	for (size_t i = 0; i < count; i++) {
+		BinaryProtocol_writeUint32(Cursor, samples[i].time);
+		BinaryProtocol_writeReadings(Cursor + 4, samples[i].sample);
+		Cursor[4 + BINARY_READINGS_SIZE] = BinaryProtocol_flags(samples[i].sample);
+		Cursor += BINARY_HISTORY_SAMPLE_SIZE;
+	}
+
+	encoded = count;
+	return Cursor - buffer;
+}
+
+bool BinaryProtocol_decodeReplyHeader(const uint8_t* header, BinaryReply& reply) {
+	if (header[0] != BINARY_PROTOCOL_MAGIC)
+		return false;
+
+	reply.type = header[1];
+	reply.requestId = header[2] | (header[3] << 8);
+	reply.code = header[4] | (header[5] << 8);
+	reply.length = header[6];
+	reply.payload = nullptr;
+	return true;
+}
+
+bool BinaryProtocol_decodeActuatorCommand(const BinaryReply& reply, ActuatorCommand& command) {
+	if ((reply.type != BINARY_GET_DATA && reply.type != BINARY_PUSH_COMMAND) || reply.length < BINARY_ACTUATOR_COMMAND_SIZE)
+		return false;
+
+	command.pumpMask = BinaryProtocol_readUint32(reply.payload);
+	command.feederMask = BinaryProtocol_readUint32(reply.payload + 4);
+	return true;
+}
\ No newline at end of file
@@ -1,71 +1,115 @@
 #include <Arduino.h>
 #include "BusinessLogic.h"
+#include "TelemetryEncoder.h"
+#include "BinaryProtocol.h"
+#include "TelemetryDelta.h"
+#include "InboundMessage.h"
+
+#if ENABLE_SERVO == true
+	#include "ServoManager.h"
+#endif
 
 BusinessLogic::BusinessLogic() {
 	this->temperature = 0.0f;
 	this->humidity = 0.0f;
 	this->waterLevel = 0;
-	this->shouldEnableWaterPump = false;
-	this->shouldDispenseFood = false;
-	this->businessLogicTimer = TickTimer(100000); // 0.1 second
-	this->waterPumpEnableTime = 0;
-
-	this->isWaitingForServerActuatorData = false;
-	this->isWaitingForServerReportACK = false;
+	this->filteredWaterLevel = 0.0f;
+	this->isWaterFull = false;
+	this->actuators = nullptr;
+	this->pumpRequestMask = 0;
+	this->feederRequestMask = 0;
 
 	#if ENABLE_WIFI == true
-		this->wsInteractionTimer = TickTimer();
-		#if WS_RTX_ON == true
-			this->wsInteractionTimer.setTickMicros(100000); // 0.1 second
-		# else
-			this->wsInteractionTimer.setTickMicros(3000000); // 3 second
-		#endif
-
 		this->shouldPushOrPull = true; // Default to push mode
+		this->reportedTelemetry = {};
+		this->serverTelemetry = {};
+		this->reportSequence = 0;
+		this->lastKeyframeTime = 0;
+		this->keyframeLoginCount = 0;
+		this->keyframeRequestCount = 0;
+		this->lastJournalTime = 0;
 	#endif
 	
 }
 
 void BusinessLogic::setup() {
 	// Any setup code for business logic can go here
-	this->businessLogicTimer.init();
 }
 
-bool BusinessLogic::should_loop_tick() {
-	return this->businessLogicTimer.shouldTick();
-}
+#if ENABLE_WIFI == true
+void BusinessLogic::interaction_loop() {
+	// Only the newest sample is worth reporting
+	TelemetrySample Sample;
+	while (this->telemetryQueue.pop(Sample)) {
+		this->reportedTelemetry = Sample;
+	}
 
-void BusinessLogic::pre_sensor_read_loop() {
-	if (this->isWaitingForServerActuatorData) {
-		return;
+	// Both may be in flight at once, the order only matters when the window is nearly full
+	if (this->shouldPushOrPull) {
+		this->ReportData();
+		this->RequestActuatorData();
+	}
+	else {
+		this->RequestActuatorData();
+		this->ReportData();
 	}
+}
 
-	#if ENABLE_WIFI == false
-		return;
+ulong BusinessLogic::getInteractionIntervalMicros() {
+	#if WS_RTX_ON == true
+		return 100000; // 0.1 second
+	#else
+		return 3000000; // 3 second
 	#endif
+}
 
-	// If in push mode, do not request data
-	if (this->shouldPushOrPull) return;
+void BusinessLogic::RequestActuatorData() {
+	// Commands are pushed by the server as soon as they are set
+	if (this->wifiNetwork->isCommandPush()) return;
 
-	if (!this->wifiNetwork->isConnected() || !this->wifiNetwork->isServerConnected()) {
-		Serial.println("Not connected to WiFi or WebSocket server, skipping actuator data request.");
+	if (!this->wifiNetwork->isConnected() || !this->wifiNetwork->isServerConnected() || !this->wifiNetwork->isLoggedIn()) return;
+
+	// One poll at a time is enough, its reply has everything that was set until then
+	if (this->wifiNetwork->isRequestPending(INBOUND_ENDPOINT_GET_DATA) || !this->wifiNetwork->canSendRequest()) {
 		return;
 	}
 
-	if (!this->wsInteractionTimer.shouldTick()) return;
-
-	if (this->isWaitingForServerActuatorData) {
-		Serial.println("Already requested server actuator data, skipping request.");
+	// Either way straight into the outbound frame, like the reports
+	char* Frame = this->wifiNetwork->beginFrame(false);
+	if (Frame == nullptr) {
 		return;
 	}
 
-	JsonDocument doc;
-	doc["key"] = "/iot/get_data";
-	this->wifiNetwork->sendJSON(doc);
-	this->isWaitingForServerActuatorData = true;
+	size_t Size = this->wifiNetwork->isBinaryProtocol()
+		? BinaryProtocol_encodeGetData((uint8_t*)Frame, WS_TX_FRAME_SIZE)
+		: TelemetryEncoder_encodeGetData(Frame, WS_TX_FRAME_SIZE);
+
+	if (this->wifiNetwork->commitRequest(Size, INBOUND_ENDPOINT_GET_DATA))
+		this->shouldPushOrPull = true;
+}
+#endif
+
+bool BusinessLogic::postActuatorCommand(const ActuatorCommand& command) {
+	if (!this->commandQueue.push(command)) {
+		Serial.println("Actuator command queue is full, dropping command.");
+		return false;
+	}
+
+	return true;
 }
 
 void BusinessLogic::pre_actuator_loop() {
+	// A request stays pending until the actuator logic below has consumed it
+	ActuatorCommand Command;
+	while (this->commandQueue.pop(Command)) {
+		this->pumpRequestMask |= Command.pumpMask;
+		this->feederRequestMask |= Command.feederMask;
+	}
+
+	#if ENABLE_FEEDING_SCHEDULE == true
+		this->pollFeedingSchedule();
+	#endif
+
 	#if ENABLE_WATER_LEVEL_SENSOR == true
 		this->handleWaterPumpLogic();
 	#endif
@@ -73,12 +117,75 @@ void BusinessLogic::pre_actuator_loop() {
 	#if ENABLE_SERVO == true
 		this->handleServoLogic();
 	#endif
+
+	this->publishTelemetry();
 }
 
-void BusinessLogic::pre_hardware_report_loop() {
-	#if ENABLE_WIFI == true
-		this->ReportData();
-	#endif
+#if ENABLE_FEEDING_SCHEDULE == true
+bool BusinessLogic::postFeedingSchedule(const FeedingScheduleTable& table) {
+	if (!this->scheduleQueue.push(table)) {
+		Serial.println("Feeding schedule queue is full, dropping the table.");
+		return false;
+	}
+
+	return true;
+}
+
+bool BusinessLogic::postScheduleClock(uint32_t unixTime) {
+	ScheduleClock Clock;
+	Clock.unixTime = unixTime;
+	Clock.millis = millis();
+
+	// The next /login brings the clock again
+	return this->clockQueue.push(Clock);
+}
+
+FeedingSchedule& BusinessLogic::getFeedingSchedule() {
+	return this->feedingSchedule;
+}
+
+void BusinessLogic::pollFeedingSchedule() {
+	FeedingScheduleTable Table;
+	bool HasTable = false;
+	while (this->scheduleQueue.pop(Table)) {
+		HasTable = true;
+	}
+
+	if (HasTable)
+		this->feedingSchedule.load(Table);
+
+	ScheduleClock Clock;
+	while (this->clockQueue.pop(Clock)) {
+		this->feedingSchedule.setClock(Clock.unixTime, Clock.millis);
+	}
+
+	// Without the server clock since boot there is no telling when to feed
+	if (!this->feedingSchedule.hasClock()) return;
+
+	uint32_t Due = this->feedingSchedule.poll(this->feedingSchedule.getTime(millis()));
+	if (Due == 0) return;
+
+	// A closed feeder opens for the scheduled portion, an open one just stays open until it closes
+	FeederTable& Feeders = this->actuators->feeders;
+	for (uint8_t i = 0; i < Feeders.count; i++) {
+		if ((Due & (1UL << i)) && Feeders.openTimes[i] == 0)
+			Feeders.openDurations[i] = this->feedingSchedule.getOpenMillis(i);
+	}
+
+	this->feederRequestMask |= Due;
+}
+#endif
+
+void BusinessLogic::publishTelemetry() {
+	TelemetrySample Sample;
+	Sample.temperature = this->temperature;
+	Sample.humidity = this->humidity;
+	Sample.waterLevel = this->waterLevel;
+	Sample.pumpMask = this->actuators->pumps.enabledMask;
+	Sample.feederMask = this->actuators->feeders.openMask;
+
+	// Dropped while the network side is stalled, the next interaction after it catches up
+	this->telemetryQueue.push(Sample);
 }
 
 #if ENABLE_WIFI == true
@@ -87,103 +194,203 @@ void BusinessLogic::setWiFiNetworkInstance(WiFiNetwork* wifiNetwork) {
 }
 #endif
 
-#if ENABLE_SERVO == true
-void BusinessLogic::setServoManagerInstance(ServoManager* pServoManager) {
-	this->pServoManager = pServoManager;
+void BusinessLogic::setActuatorRegistry(ActuatorRegistry* actuators) {
+	this->actuators = actuators;
 }
-#endif
 
 #if ENABLE_WATER_LEVEL_SENSOR == true
 void BusinessLogic::handleWaterPumpLogic() {
-	bool EnableWaterPump = this->waterPumpEnabled;
+	PumpTable& Pumps = this->actuators->pumps;
+	uint32_t Requested = this->pumpRequestMask;
+	this->pumpRequestMask = 0; // Reset the flags
 
-	if (this->shouldEnableWaterPump) {
-		EnableWaterPump = true;
-		this->shouldEnableWaterPump = false; // Reset the flag
-	}
+	#if WATER_PUMP_CLOSED_LOOP == true
+		// Also runs after a stop, that's when it learns how far the level coasts
+		PumpDecision Decision = this->pumpController.update(millis(), this->filteredWaterLevel, Pumps.enabledMask != 0);
 
-	// GUARD CLAUSE: If water level is above threshold, do not trigger on
-	if (EnableWaterPump && waterLevel >= 50) {
-		EnableWaterPump = false;
-		Serial.println("Water overflow detected, water pump will not be enabled.");
-	}
+		if (Requested != 0 && this->pumpController.isLockedOut(millis())) {
+			Requested = 0;
+			Serial.println("Water pump stopped on a fault recently, ignoring the request.");
+		}
+	#endif
+
+	// Nothing running and nothing to start, the usual case
+	if ((Pumps.enabledMask | Requested) == 0)
+		return;
+
+	ulong Now = millis();
+	for (uint8_t i = 0; i < Pumps.count; i++) {
+		uint32_t Bit = 1UL << i;
+		bool EnableWaterPump = ((Pumps.enabledMask | Requested) & Bit) != 0;
 
-	// TIMING CLAUSE: If the water pump has been enabled for too long, disable it
-	if (EnableWaterPump && this->waterPumpEnableTime != 0) {
-		if (millis() - this->waterPumpEnableTime > WATER_PUMP_ENABLE_TIMEOUT) {
+		// GUARD CLAUSE: If water level is above threshold, do not trigger on. The one sensor guards every pump
+		if (EnableWaterPump && this->isWaterFull) {
 			EnableWaterPump = false;
-			this->waterPumpEnableTime = 0;
-			Serial.println("Water pump timeout reached, disabling water pump.");
+			Serial.println("Water overflow detected, water pump will not be enabled.");
 		}
-	}
 
-	digitalWrite(WATER_PUMP_PIN, !EnableWaterPump);
-	
-	this->waterPumpEnabled = !digitalRead(WATER_PUMP_PIN);
-	if (this->waterPumpEnabled && this->waterPumpEnableTime == 0) {
-		this->waterPumpEnableTime = millis();
+		#if WATER_PUMP_CLOSED_LOOP == true
+			// MODEL CLAUSE: Stop ahead of the target, or on a fault the fill rate shows. Only a running pump gets a decision
+			if (EnableWaterPump && Decision != PUMP_KEEP) {
+				EnableWaterPump = false;
+
+				if (Decision == PUMP_STOP_FULL)
+					Serial.println("Water level will reach the target with what is still coming, disabling water pump.");
+				else if (Decision == PUMP_STOP_DRY_RUN)
+					Serial.println("Error: Water level isn't rising, the pump is running dry. Disabling water pump.");
+				else
+					Serial.println("Error: Water level sensor is stuck. Disabling water pump.");
+			}
+		#endif
+
+		// TIMING CLAUSE: If the water pump has been enabled for too long, disable it
+		if (EnableWaterPump && Pumps.enableTimes[i] != 0) {
+			if (Now - Pumps.enableTimes[i] > Pumps.enableTimeouts[i]) {
+				EnableWaterPump = false;
+				Serial.println("Water pump timeout reached, disabling water pump.");
+			}
+		}
+
+		// Relays are active low, only switched when the state changes
+		if (EnableWaterPump != ((Pumps.enabledMask & Bit) != 0)) {
+			digitalWrite(Pumps.pins[i], !EnableWaterPump);
+			Pumps.enabledMask ^= Bit;
+		}
+
+		// Whatever stopped the pump, the next run times out from its own start
+		if (!EnableWaterPump) {
+			Pumps.enableTimes[i] = 0;
+		} else if (Pumps.enableTimes[i] == 0) {
+			Pumps.enableTimes[i] = Now;
+		}
 	}
 }
+
+#if WATER_PUMP_CLOSED_LOOP == true
+PumpController& BusinessLogic::getPumpController() {
+	return this->pumpController;
+}
+#endif
 #endif
 
 #if ENABLE_SERVO == true
 void BusinessLogic::handleServoLogic() {
-	bool ServoShouldOpenFood = pServoManager->getCurrentPosition() < ((SERVO_CLOSE_ANGLE + SERVO_OPEN_ANGLE) / 2);
+	FeederTable& Feeders = this->actuators->feeders;
+	uint32_t Requested = this->feederRequestMask;
+	this->feederRequestMask = 0; // Reset the flags
 
-	if (this->shouldDispenseFood) {
-		ServoShouldOpenFood = true;
-		this->shouldDispenseFood = false; // Reset the flag
-	}
+	// Every feeder closed and none to open
+	if ((Feeders.openMask | Requested) == 0)
+		return;
 
-	// TIMING CLAUSE: If servo is open for too long, close it
-	if (ServoShouldOpenFood && this->servoOpenTime != 0) {
-		if (millis() - this->servoOpenTime > SERVO_OPEN_TIMEOUT) {
-			ServoShouldOpenFood = false;
-			this->servoOpenTime = 0;
-			Serial.println("Servo open timeout reached, closing servo.");
+	ulong Now = millis();
+	for (uint8_t i = 0; i < Feeders.count; i++) {
+		uint32_t Bit = 1UL << i;
+		bool ServoShouldOpenFood = ((Feeders.openMask | Requested) & Bit) != 0;
+
+		// TIMING CLAUSE: If servo is open for too long, close it
+		if (ServoShouldOpenFood && Feeders.openTimes[i] != 0) {
+			if (Now - Feeders.openTimes[i] > Feeders.openDurations[i]) {
+				ServoShouldOpenFood = false;
+				Feeders.openTimes[i] = 0;
+				Feeders.openDurations[i] = Feeders.openTimeouts[i]; // Until the schedule sets a portion again
+				Serial.println("Servo open timeout reached, closing servo.");
+			}
 		}
-	}
 
-	if (ServoShouldOpenFood) {
-		pServoManager->Rotate(SERVO_OPEN_ANGLE); // Open the food servo
-		if (this->servoOpenTime == 0) {
-			this->servoOpenTime = millis();
+		if (ServoShouldOpenFood) {
+			ServoManager_rotate(i, SERVO_OPEN_ANGLE); // Open the food servo
+			Feeders.openMask |= Bit;
+			if (Feeders.openTimes[i] == 0) {
+				Feeders.openTimes[i] = Now;
+			}
+		}
+		else {
+			ServoManager_rotate(i, SERVO_CLOSE_ANGLE); // Close the food servo
+			Feeders.openMask &= ~Bit;
 		}
-	}
-	else {
-		pServoManager->Rotate(SERVO_CLOSE_ANGLE); // Close the food servo
 	}
 }
 #endif
 
 #if ENABLE_WIFI == true
 void BusinessLogic::ReportData() {
-	// If in pull mode, do not send data
-	if (!this->shouldPushOrPull) return;
-
-	if (!this->wifiNetwork->isConnected() || !this->wifiNetwork->isServerConnected() || !this->wifiNetwork->isLoggedIn()) return;
+	if (!this->wifiNetwork->isConnected() || !this->wifiNetwork->isServerConnected() || !this->wifiNetwork->isLoggedIn()) {
+		#if ENABLE_TELEMETRY_JOURNAL == true
+			// Kept in flash until the next /login, one sample per interval is plenty for the history
+			if (millis() - this->lastJournalTime >= JOURNAL_SAMPLE_INTERVAL) {
+				this->wifiNetwork->getJournal().append(this->reportedTelemetry);
+				this->lastJournalTime = millis();
+			}
+		#endif
+		return;
+	}
 
-	if (!this->wsInteractionTimer.shouldTick()) return;
+	this->lastJournalTime = millis();
 
-	if (this->isWaitingForServerReportACK) {
+	if (!this->wifiNetwork->canSendRequest()) {
 		return;
 	}
 
-	JsonDocument doc;
-	doc["key"] = "/iot/post_data";
-	doc["data"]["te"] = this->temperature;
-	doc["data"]["hu"] = this->humidity;
-	doc["data"]["wa"] = this->waterLevel;
-	doc["data"]["PuEn"] = this->waterPumpEnabled ? 1 : 0;
+	bool IsDelta = this->wifiNetwork->isTelemetryDelta();
+	bool IsKeyframe = true;
+	uint8_t Fields = TELEMETRY_FIELD_ALL;
 
-	bool isFoodDispenserOpen = (this->pServoManager->getCurrentPosition() < ((SERVO_CLOSE_ANGLE + SERVO_OPEN_ANGLE) / 2));
-	doc["data"]["DiFo"] = isFoodDispenserOpen ? 1 : 0;
-	
-	if (!this->wifiNetwork->sendJSON(doc)) {
+	if (IsDelta) {
+		// A new connection starts from nothing on the server side, and so does one that missed a delta
+		IsKeyframe = this->keyframeLoginCount != this->wifiNetwork->getLoginCount() || this->keyframeRequestCount != this->wifiNetwork->getKeyframeRequestCount() || millis() - this->lastKeyframeTime >= TELEMETRY_KEYFRAME_INTERVAL;
+
+		if (!IsKeyframe) {
+			Fields = TelemetryDelta_changedFields(this->serverTelemetry, this->reportedTelemetry);
+		}
+
+		// Nothing moved past its deadband
+		if (Fields == 0) {
+			return;
+		}
+	}
+
+	// Fixed schema, encoded straight into the outbound frame without a JsonDocument
+	char* Frame = this->wifiNetwork->beginFrame(false);
+	if (Frame == nullptr) {
 		Serial.println("Failed to send data to server, will retry later.");
 		return;
 	}
 
-	this->isWaitingForServerReportACK = true;
+	size_t Size;
+	if (!IsDelta) {
+		if (this->wifiNetwork->isBinaryProtocol()) {
+			Size = BinaryProtocol_encodeTelemetry(this->reportedTelemetry, (uint8_t*)Frame, WS_TX_FRAME_SIZE);
+		}
+		else {
+			Size = TelemetryEncoder_encode(this->reportedTelemetry, Frame, WS_TX_FRAME_SIZE);
+		}
+	}
+	else if (this->wifiNetwork->isBinaryProtocol()) {
+		Size = BinaryProtocol_encodeTelemetryDelta(this->reportedTelemetry, Fields, this->reportSequence, IsKeyframe, (uint8_t*)Frame, WS_TX_FRAME_SIZE);
+	}
+	else {
+		Size = TelemetryEncoder_encodeDelta(this->reportedTelemetry, Fields, this->reportSequence, IsKeyframe, Frame, WS_TX_FRAME_SIZE);
+	}
+
+	if (!this->wifiNetwork->commitRequest(Size, INBOUND_ENDPOINT_POST_DATA)) {
+		return;
+	}
+
+	this->shouldPushOrPull = false;
+
+	if (!IsDelta) {
+		return;
+	}
+
+	// A frame lost on the way leaves a gap in the sequence, the server then drops the deltas after it and asks for a keyframe
+	TelemetryDelta_apply(this->serverTelemetry, this->reportedTelemetry, Fields);
+	this->reportSequence++;
+
+	if (IsKeyframe) {
+		this->lastKeyframeTime = millis();
+		this->keyframeLoginCount = this->wifiNetwork->getLoginCount();
+		this->keyframeRequestCount = this->wifiNetwork->getKeyframeRequestCount();
+	}
 }
 #endif
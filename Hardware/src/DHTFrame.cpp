@@ -0,0 +1,29 @@
+#include "DHTFrame.h"
+
+DHTFrameStatus DHTFrame_decode(const uint32_t* edges, size_t count, DHTReading& reading) {
+	// Every bit is a rising and a falling edge, plus the final rising one
+	if (count < DHT_FRAME_BITS * 2 + 1)
+		return DHT_FRAME_TOO_FEW_EDGES;
+
+	const uint32_t* Bits = edges + count - (DHT_FRAME_BITS * 2 + 1);
+	uint8_t Bytes[5] = {};
+
+	for (int i = 0; i < DHT_FRAME_BITS; i++) {
+		uint32_t High = Bits[i * 2 + 1] - Bits[i * 2];
+		if (High < DHT_FRAME_MIN_HIGH || High > DHT_FRAME_MAX_HIGH)
+			return DHT_FRAME_BAD_PULSE;
+
+		Bytes[i / 8] = (Bytes[i / 8] << 1) | (High > DHT_FRAME_BIT_THRESHOLD ? 1 : 0);
+	}
+
+	if ((uint8_t)(Bytes[0] + Bytes[1] + Bytes[2] + Bytes[3]) != Bytes[4])
+		return DHT_FRAME_BAD_CHECKSUM;
+
+	// Integral and decimal parts, the top bit of the temperature decimal is the sign
+	reading.humidity = Bytes[0] + Bytes[1] * 0.1f;
+	reading.temperature = Bytes[2] + (Bytes[3] & 0x7F) * 0.1f;
+	if (Bytes[3] & 0x80)
+		reading.temperature = -reading.temperature;
+
+	return DHT_FRAME_OK;
+}
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include <Arduino.h>
+#include <string.h>
+#include <esp_partition.h>
+#include "FeedingSchedule.h"
+
+// One table per sector, the one with the higher sequence is current. A torn write leaves the other one in place
+struct ScheduleRecord {
+	uint32_t sequence;
+	uint8_t format;
+	uint8_t reserved[3];
+	FeedingScheduleTable table;
+	uint32_t checksum; // CRC-32 of the bytes before it
+};
+
+// Reflected polynomial 0xEDB88320, bitwise since it only runs when a table is loaded or saved
+static uint32_t FeedingSchedule_checksum(const ScheduleRecord& record) {
+	const uint8_t* Bytes = (const uint8_t*)&record;
+	uint32_t Crc = 0xFFFFFFFF;
+
+	for (size_t i = 0; i < offsetof(ScheduleRecord, checksum); i++) {
+		Crc ^= Bytes[i];
+		for (int Bit = 0; Bit < 8; Bit++)
+			Crc = (Crc & 1) ? (Crc >> 1) ^ 0xEDB88320 : Crc >> 1;
+	}
+
+	return ~Crc;
+}
+
+static const esp_partition_t* FeedingSchedule_partition() {
+	const esp_partition_t* Partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, SCHEDULE_PARTITION_LABEL);
+	if (Partition == nullptr || Partition->size < (uint32_t)SCHEDULE_SECTOR_OFFSET + 2 * SCHEDULE_SECTOR_SIZE) {
+		Serial.println("Schedule partition not found, the feeding schedule won't survive a reboot.");
+		return nullptr;
+	}
+
+	return Partition;
+}
+
+static bool FeedingSchedule_readRecord(const esp_partition_t* partition, uint32_t sector, ScheduleRecord& record) {
+	if (esp_partition_read(partition, SCHEDULE_SECTOR_OFFSET + sector * SCHEDULE_SECTOR_SIZE, &record, sizeof(record)) != ESP_OK) {
+		Serial.println("Failed to read the feeding schedule.");
+		return false;
+	}
+
+	// Checked before the entries are trusted, e.g. an erased sector
+	return record.format == SCHEDULE_FORMAT_VERSION && record.sequence % 2 == sector && record.table.entryCount <= SCHEDULE_MAX_ENTRIES && record.checksum == FeedingSchedule_checksum(record);
+}
+
+// Sector of the newest valid record, -1 if neither holds one
+static int FeedingSchedule_findNewest(const esp_partition_t* partition, ScheduleRecord& record) {
+	int Newest = -1;
+	uint32_t NewestSequence = 0;
+
+	for (uint32_t Sector = 0; Sector < 2; Sector++) {
+		ScheduleRecord Record;
+		if (!FeedingSchedule_readRecord(partition, Sector, Record) || (Newest >= 0 && Record.sequence < NewestSequence))
+			continue;
+
+		Newest = Sector;
+		NewestSequence = Record.sequence;
+		record = Record;
+	}
+
+	return Newest;
+}
+
+static int FeedingSchedule_hexDigit(char c) {
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+void FeedingSchedule_sort(ScheduleEntry* entries, size_t count) {
+	for (size_t i = 1; i < count; i++) {
+		ScheduleEntry Entry = entries[i];
+		size_t j = i;
+
+		while (j > 0 && (entries[j - 1].minute > Entry.minute || (entries[j - 1].minute == Entry.minute && entries[j - 1].feeder > Entry.feeder))) {
+			entries[j] = entries[j - 1];
+			j--;
+		}
+
+		entries[j] = Entry;
+	}
+}
+
+size_t FeedingSchedule_expand(const ScheduleEntry* entries, size_t count, ScheduleSlot* slots, size_t capacity) {
+	size_t Count = 0;
+
+	// Day by day over entries sorted by minute, so the slots come out sorted without another pass
+	for (uint8_t Day = 0; Day < 7; Day++) {
+		for (size_t i = 0; i < count && Count < capacity; i++) {
+			if (!(entries[i].weekdays & (1 << Day)))
+				continue;
+
+			slots[Count].weekMinute = Day * SCHEDULE_MINUTES_PER_DAY + entries[i].minute;
+			slots[Count].entry = (uint16_t)i;
+			Count++;
+		}
+	}
+
+	return Count;
+}
+
+size_t FeedingSchedule_findNext(const ScheduleSlot* slots, size_t count, uint16_t weekMinute) {
+	size_t Low = 0;
+	size_t High = count;
+
+	while (Low < High) {
+		size_t Middle = Low + (High - Low) / 2;
+		if (slots[Middle].weekMinute <= weekMinute)
+			Low = Middle + 1;
+		else
+			High = Middle;
+	}
+
+	// Nothing left this week, the first slot of the next one
+	return Low == count ? 0 : Low;
+}
+
+uint16_t FeedingSchedule_weekMinute(uint32_t unixTime, int16_t utcOffset) {
+	int64_t Local = (int64_t)unixTime + utcOffset * 60;
+	int64_t Days = Local >= 0 ? Local / 86400 : (Local - 86399) / 86400;
+	int64_t Seconds = Local - Days * 86400;
+
+	// 1970-01-01 was a Thursday
+	uint16_t Weekday = (uint16_t)(((Days + 4) % 7 + 7) % 7);
+	return Weekday * SCHEDULE_MINUTES_PER_DAY + (uint16_t)(Seconds / 60);
+}
+
+int FeedingSchedule_decodeEntries(const char* hex, ScheduleEntry* entries, size_t capacity) {
+	size_t Length = strlen(hex);
+	if (Length % SCHEDULE_ENTRY_HEX_SIZE != 0 || Length / SCHEDULE_ENTRY_HEX_SIZE > capacity) {
+		return -1;
+	}
+
+	size_t Count = Length / SCHEDULE_ENTRY_HEX_SIZE;
+	for (size_t i = 0; i < Count; i++) {
+		uint8_t Bytes[SCHEDULE_ENTRY_HEX_SIZE / 2];
+		for (size_t j = 0; j < sizeof(Bytes); j++) {
+			int High = FeedingSchedule_hexDigit(hex[i * SCHEDULE_ENTRY_HEX_SIZE + j * 2]);
+			int Low = FeedingSchedule_hexDigit(hex[i * SCHEDULE_ENTRY_HEX_SIZE + j * 2 + 1]);
+			if (High < 0 || Low < 0)
+				return -1;
+
+			Bytes[j] = (uint8_t)(High << 4 | Low);
+		}
+
+		ScheduleEntry& Entry = entries[i];
+		Entry.minute = Bytes[0] | (Bytes[1] << 8);
+		Entry.weekdays = Bytes[2];
+		Entry.feeder = Bytes[3];
+		Entry.openMillis = Bytes[4] | (Bytes[5] << 8);
+
+		if (Entry.minute >= SCHEDULE_MINUTES_PER_DAY || Entry.weekdays == 0 || Entry.weekdays > SCHEDULE_EVERY_DAY || Entry.feeder >= ACTUATOR_MAX_COUNT || Entry.openMillis == 0)
+			return -1;
+	}
+
+	return (int)Count;
+}
+
+bool FeedingSchedule_loadTable(FeedingScheduleTable& table) {
+	const esp_partition_t* Partition = FeedingSchedule_partition();
+	if (Partition == nullptr) {
+		return false;
+	}
+
+	ScheduleRecord Record;
+	if (FeedingSchedule_findNewest(Partition, Record) < 0) {
+		return false;
+	}
+
+	table = Record.table;
+	return true;
+}
+
+bool FeedingSchedule_saveTable(const FeedingScheduleTable& table) {
+	const esp_partition_t* Partition = FeedingSchedule_partition();
+	if (Partition == nullptr) {
+		return false;
+	}
+
+	ScheduleRecord Record = {};
+	int Newest = FeedingSchedule_findNewest(Partition, Record);
+	uint32_t Sequence = Newest < 0 ? 0 : Record.sequence + 1;
+	uint32_t Offset = SCHEDULE_SECTOR_OFFSET + (Sequence % 2) * SCHEDULE_SECTOR_SIZE;
+
+	Record = {};
+	Record.sequence = Sequence;
+	Record.format = SCHEDULE_FORMAT_VERSION;
+	Record.table = table;
+	Record.checksum = FeedingSchedule_checksum(Record);
+
+	if (esp_partition_erase_range(Partition, Offset, SCHEDULE_SECTOR_SIZE) != ESP_OK || esp_partition_write(Partition, Offset, &Record, sizeof(Record)) != ESP_OK) {
+		Serial.println("Failed to write the feeding schedule.");
+		return false;
+	}
+
+	return true;
+}
+
+FeedingSchedule::FeedingSchedule() {
+	this->table = {};
+	this->slotCount = 0;
+	this->nextSlot = 0;
+	this->nextTime = 0;
+	this->isAnchored = false;
+	this->isClockSet = false;
+	this->clockUnixTime = 0;
+	this->clockMillis = 0;
+	this->skippedCount = 0;
+
+	for (size_t i = 0; i < ACTUATOR_MAX_COUNT; i++) {
+		this->openMillis[i] = SERVO_OPEN_TIMEOUT;
+	}
+}
+
+void FeedingSchedule::load(const FeedingScheduleTable& table) {
+	this->table = table;
+	if (this->table.entryCount > SCHEDULE_MAX_ENTRIES)
+		this->table.entryCount = SCHEDULE_MAX_ENTRIES;
+
+	FeedingSchedule_sort(this->table.entries, this->table.entryCount);
+	this->slotCount = FeedingSchedule_expand(this->table.entries, this->table.entryCount, this->slots, SCHEDULE_MAX_SLOTS);
+	this->isAnchored = false;
+}
+
+void FeedingSchedule::setClock(uint32_t unixTime, ulong clockMillis) {
+	// A small correction keeps the next feed, a jump looks it up again
+	if (this->isClockSet) {
+		uint32_t Time = this->getTime(clockMillis);
+		if ((Time > unixTime ? Time - unixTime : unixTime - Time) > SCHEDULE_LATE_LIMIT)
+			this->isAnchored = false;
+	}
+
+	this->isClockSet = true;
+	this->clockUnixTime = unixTime;
+	this->clockMillis = clockMillis;
+}
+
+bool FeedingSchedule::hasClock() {
+	return this->isClockSet;
+}
+
+uint32_t FeedingSchedule::getTime(ulong nowMillis) {
+	return this->clockUnixTime + (nowMillis - this->clockMillis) / 1000;
+}
+
+uint32_t FeedingSchedule::poll(uint32_t unixTime) {
+	if (this->slotCount == 0) {
+		return 0;
+	}
+
+	if (!this->isAnchored) {
+		this->anchor(unixTime);
+		return 0;
+	}
+
+	uint32_t Due = 0;
+	while (unixTime >= this->nextTime) {
+		uint32_t Late = unixTime - this->nextTime;
+
+		// Every slot is behind by more than a week, going through them one by one would only skip all of them
+		if (Late >= SCHEDULE_MINUTES_PER_WEEK * 60) {
+			this->skippedCount += this->slotCount;
+			this->anchor(unixTime);
+			break;
+		}
+
+		const ScheduleEntry& Entry = this->table.entries[this->slots[this->nextSlot].entry];
+		if (Late > SCHEDULE_LATE_LIMIT) {
+			this->skippedCount++;
+		}
+		else if (Entry.feeder < ACTUATOR_MAX_COUNT) {
+			Due |= 1UL << Entry.feeder;
+			this->openMillis[Entry.feeder] = Entry.openMillis;
+		}
+
+		// Slots of the same minute follow with no time in between, the last one wraps to the next week
+		size_t Next = this->nextSlot + 1;
+		uint32_t Minutes;
+		if (Next >= this->slotCount) {
+			Next = 0;
+			Minutes = this->slots[0].weekMinute + SCHEDULE_MINUTES_PER_WEEK - this->slots[this->nextSlot].weekMinute;
+		}
+		else {
+			Minutes = this->slots[Next].weekMinute - this->slots[this->nextSlot].weekMinute;
+		}
+
+		this->nextSlot = Next;
+		this->nextTime += Minutes * 60;
+	}
+
+	return Due;
+}
+
+uint16_t FeedingSchedule::getOpenMillis(uint8_t feeder) {
+	return feeder < ACTUATOR_MAX_COUNT ? this->openMillis[feeder] : SERVO_OPEN_TIMEOUT;
+}
+
+uint32_t FeedingSchedule::getRevision() {
+	return this->table.revision;
+}
+
+uint32_t FeedingSchedule::getSkippedCount() {
+	return this->skippedCount;
+}
+
+void FeedingSchedule::anchor(uint32_t unixTime) {
+	uint16_t WeekMinute = FeedingSchedule_weekMinute(unixTime, this->table.utcOffset);
+	this->nextSlot = FeedingSchedule_findNext(this->slots, this->slotCount, WeekMinute);
+
+	uint32_t Minutes = this->slots[this->nextSlot].weekMinute > WeekMinute ? this->slots[this->nextSlot].weekMinute - WeekMinute : this->slots[this->nextSlot].weekMinute + SCHEDULE_MINUTES_PER_WEEK - WeekMinute;
+	this->nextTime = unixTime - unixTime % 60 + Minutes * 60;
+	this->isAnchored = true;
+}
\ No newline at end of file
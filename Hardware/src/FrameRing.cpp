@@ -0,0 +1,111 @@
+#include "FrameRing.h"
+
+#define FRAME_RING_MASK (WS_TX_RING_SLOTS - 1)
+#define FRAME_RING_NO_SLOT WS_TX_RING_SLOTS
+
+FrameRing::FrameRing(FrameRingPolicy policy) : head(0), tail(0), readingSlot(FRAME_RING_NO_SLOT), enqueuedCount(0), sentCount(0), droppedCount(0) {
+	this->policy = policy;
+	this->readingIndex = 0;
+}
+
+char* FrameRing::beginWrite() {
+	uint32_t Tail = this->tail.load(std::memory_order_relaxed);
+	uint32_t Head = this->head.load(std::memory_order_seq_cst);
+
+	if (Tail - Head >= WS_TX_RING_SLOTS - 1) {
+		if (this->policy == FRAME_RING_DROP_NEWEST) {
+			this->droppedCount++;
+			return nullptr;
+		}
+
+		// The frame on the wire can't be taken back, drop the new one instead
+		if (this->readingSlot.load(std::memory_order_seq_cst) == (Head & FRAME_RING_MASK)) {
+			this->droppedCount++;
+			return nullptr;
+		}
+
+		// Fails only if the consumer released it first, which frees the slot just the same
+		if (this->head.compare_exchange_strong(Head, Head + 1, std::memory_order_seq_cst))
+			this->droppedCount++;
+	}
+
+	// The consumer may still be sending a frame that was overwritten under it
+	if (this->readingSlot.load(std::memory_order_seq_cst) == (Tail & FRAME_RING_MASK)) {
+		this->droppedCount++;
+		return nullptr;
+	}
+
+	return this->slots[Tail & FRAME_RING_MASK].data;
+}
+
+void FrameRing::commitWrite(size_t size) {
+	uint32_t Tail = this->tail.load(std::memory_order_relaxed);
+
+	this->slots[Tail & FRAME_RING_MASK].size = size;
+	this->tail.store(Tail + 1, std::memory_order_release); // Publish the frame after it is written
+	this->enqueuedCount++;
+}
+
+void FrameRing::abortWrite() {
+	this->droppedCount++;
+}
+
+const char* FrameRing::peek(size_t& size) {
+	while (true) {
+		uint32_t Head = this->head.load(std::memory_order_seq_cst);
+		if (Head == this->tail.load(std::memory_order_acquire))
+			return nullptr;
+
+		// Claim the slot, then make sure the producer didn't overwrite it in between
+		this->readingSlot.store(Head & FRAME_RING_MASK, std::memory_order_seq_cst);
+		if (this->head.load(std::memory_order_seq_cst) != Head)
+			continue;
+
+		this->readingIndex = Head;
+		size = this->slots[Head & FRAME_RING_MASK].size;
+		return this->slots[Head & FRAME_RING_MASK].data;
+	}
+}
+
+void FrameRing::release(bool wasSent) {
+	uint32_t Head = this->readingIndex;
+
+	// The producer already counted it as dropped if it overwrote the frame while it was being sent
+	bool WasOverwritten = !this->head.compare_exchange_strong(Head, this->readingIndex + 1, std::memory_order_seq_cst);
+	this->readingSlot.store(FRAME_RING_NO_SLOT, std::memory_order_seq_cst);
+
+	if (WasOverwritten && wasSent) {
+		this->droppedCount--;
+	}
+
+	if (wasSent) {
+		this->sentCount++;
+	}
+	else if (!WasOverwritten) {
+		this->droppedCount++;
+	}
+}
+
+void FrameRing::clear() {
+	size_t Size;
+	while (this->peek(Size) != nullptr) {
+		this->release(false);
+	}
+}
+
+size_t FrameRing::size() {
+	uint32_t Head = this->head.load(std::memory_order_acquire);
+	return this->tail.load(std::memory_order_acquire) - Head;
+}
+
+uint32_t FrameRing::getEnqueuedCount() {
+	return this->enqueuedCount.load(std::memory_order_relaxed);
+}
+
+uint32_t FrameRing::getSentCount() {
+	return this->sentCount.load(std::memory_order_relaxed);
+}
+
+uint32_t FrameRing::getDroppedCount() {
+	return this->droppedCount.load(std::memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,3 @@
+#include "HALHooks.h"
+
+HALWakeupHint HAL_wakeupHint = nullptr;
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "I2CBus.h"
+#include <Arduino.h>
+#include <string.h>
+
+I2CBus::I2CBus() {
+	this->submittedCount = 0;
+	this->rejectedCount = 0;
+	this->completedCount = 0;
+	this->maxDrainMicros = 0;
+	this->maxTransactionMicros = 0;
+}
+
+bool I2CBus::submit(void (*run)(void* context, const uint8_t* data, uint8_t size), void* context, const uint8_t* data, uint8_t size) {
+	if (size > I2C_TRANSACTION_MAX_DATA)
+		return false;
+
+	#if I2C_ASYNC == false
+		I2CTransaction Transaction;
+		Transaction.run = run;
+		Transaction.context = context;
+		Transaction.size = size;
+
+		if (size > 0)
+			memcpy(Transaction.data, data, size);
+
+		this->submittedCount++;
+		this->runTransaction(Transaction);
+		return true;
+	#else
+		I2CTransaction Transaction;
+		Transaction.run = run;
+		Transaction.context = context;
+		Transaction.size = size;
+
+		if (size > 0)
+			memcpy(Transaction.data, data, size);
+
+		if (!this->queue.push(Transaction)) {
+			this->rejectedCount++;
+			return false;
+		}
+
+		this->submittedCount++;
+		return true;
+	#endif
+}
+
+size_t I2CBus::getQueuedCount() {
+	return this->queue.size();
+}
+
+ulong I2CBus::drain(ulong budgetMicros) {
+	ulong Start = micros();
+	ulong Elapsed = 0;
+	I2CTransaction Transaction;
+
+	while (Elapsed + this->maxTransactionMicros <= budgetMicros && this->queue.pop(Transaction)) {
+		this->runTransaction(Transaction);
+		Elapsed = micros() - Start;
+	}
+
+	if (Elapsed > this->maxDrainMicros)
+		this->maxDrainMicros = Elapsed;
+
+	return Elapsed;
+}
+
+void I2CBus::drainAll() {
+	I2CTransaction Transaction;
+
+	while (this->queue.pop(Transaction)) {
+		this->runTransaction(Transaction);
+	}
+}
+
+uint32_t I2CBus::getSubmittedCount() {
+	return this->submittedCount;
+}
+
+uint32_t I2CBus::getRejectedCount() {
+	return this->rejectedCount;
+}
+
+uint32_t I2CBus::getCompletedCount() {
+	return this->completedCount;
+}
+
+ulong I2CBus::getMaxDrainMicros() {
+	return this->maxDrainMicros;
+}
+
+ulong I2CBus::getMaxTransactionMicros() {
+	return this->maxTransactionMicros;
+}
+
+void I2CBus::runTransaction(I2CTransaction& transaction) {
+	ulong Start = micros();
+	transaction.run(transaction.context, transaction.data, transaction.size);
+	this->completedCount++;
+
+	ulong Duration = micros() - Start;
+	if (Duration > this->maxTransactionMicros)
+		this->maxTransactionMicros = Duration;
+}
\ No newline at end of file
@@ -0,0 +1,365 @@
+#include <string.h>
+#include "InboundMessage.h"
+
+#define INBOUND_HASH_OFFSET 2166136261u
+#define INBOUND_HASH_PRIME 16777619u
+
+constexpr uint32_t INBOUND_KEY_STATUS = InboundMessage_hash("status");
+constexpr uint32_t INBOUND_KEY_CODE = InboundMessage_hash("code");
+constexpr uint32_t INBOUND_KEY_ENDPOINT = InboundMessage_hash("endpoint");
+constexpr uint32_t INBOUND_KEY_ERROR_MESSAGE = InboundMessage_hash("error_message");
+constexpr uint32_t INBOUND_KEY_DATA = InboundMessage_hash("data");
+constexpr uint32_t INBOUND_KEY_ID = InboundMessage_hash("id");
+
+// Single pass over the text, unescaped strings are written back over their own escapes
+struct InboundParser {
+	char* cursor;
+	char* end;
+
+	void skipSpace() {
+		while (this->cursor < this->end && (*this->cursor == ' ' || *this->cursor == '\t' || *this->cursor == '\n' || *this->cursor == '\r'))
+			this->cursor++;
+	}
+
+	bool expect(char c) {
+		this->skipSpace();
+		if (this->cursor >= this->end || *this->cursor != c)
+			return false;
+
+		this->cursor++;
+		return true;
+	}
+
+	static int hexDigit(char c) {
+		if (c >= '0' && c <= '9') return c - '0';
+		if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+		if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+		return -1;
+	}
+
+	// Leaves the unescaped string NUL terminated in place, hashed on the way
+	bool string(const char*& value, uint32_t& hash) {
+		if (!this->expect('"'))
+			return false;
+
+		char* Output = this->cursor;
+		value = Output;
+		hash = INBOUND_HASH_OFFSET;
+
+		while (this->cursor < this->end && *this->cursor != '"') {
+			char c = *this->cursor++;
+
+			if (c == '\\') {
+				if (this->cursor >= this->end)
+					return false;
+
+				char Escape = *this->cursor++;
+				switch (Escape) {
+					case 'n': c = '\n'; break;
+					case 't': c = '\t'; break;
+					case 'r': c = '\r'; break;
+					case 'b': c = '\b'; break;
+					case 'f': c = '\f'; break;
+					case 'u': {
+						if (this->end - this->cursor < 4)
+							return false;
+
+						uint32_t CodePoint = 0;
+						for (int i = 0; i < 4; i++) {
+							int Digit = hexDigit(*this->cursor++);
+							if (Digit < 0)
+								return false;
+
+							CodePoint = (CodePoint << 4) | Digit;
+						}
+
+						// UTF-8 is never longer than the 6 characters of the escape
+						char Encoded[3];
+						int Length = 0;
+						if (CodePoint < 0x80) {
+							Encoded[Length++] = CodePoint;
+						}
+						else if (CodePoint < 0x800) {
+							Encoded[Length++] = 0xC0 | (CodePoint >> 6);
+							Encoded[Length++] = 0x80 | (CodePoint & 0x3F);
+						}
+						else {
+							Encoded[Length++] = 0xE0 | (CodePoint >> 12);
+							Encoded[Length++] = 0x80 | ((CodePoint >> 6) & 0x3F);
+							Encoded[Length++] = 0x80 | (CodePoint & 0x3F);
+						}
+
+						for (int i = 0; i < Length; i++) {
+							*Output++ = Encoded[i];
+							hash = (hash ^ (uint8_t)Encoded[i]) * INBOUND_HASH_PRIME;
+						}
+						continue;
+					}
+					default: c = Escape; break; // \" \\ \/
+				}
+			}
+
+			*Output++ = c;
+			hash = (hash ^ (uint8_t)c) * INBOUND_HASH_PRIME;
+		}
+
+		if (this->cursor >= this->end)
+			return false;
+
+		this->cursor++; // Closing quote, at or after Output
+		*Output = '\0';
+		return true;
+	}
+
+	// Digits, fraction and exponent by hand, strtod() may allocate on newlib
+	bool number(float& value, uint32_t& integer) {
+		bool IsNegative = false;
+		if (this->cursor < this->end && *this->cursor == '-') {
+			IsNegative = true;
+			this->cursor++;
+		}
+
+		if (this->cursor >= this->end || *this->cursor < '0' || *this->cursor > '9')
+			return false;
+
+		double Result = 0;
+		while (this->cursor < this->end && *this->cursor >= '0' && *this->cursor <= '9')
+			Result = Result * 10 + (*this->cursor++ - '0');
+
+		if (this->cursor < this->end && *this->cursor == '.') {
+			this->cursor++;
+			double Scale = 0.1;
+			while (this->cursor < this->end && *this->cursor >= '0' && *this->cursor <= '9') {
+				Result += (*this->cursor++ - '0') * Scale;
+				Scale *= 0.1;
+			}
+		}
+
+		if (this->cursor < this->end && (*this->cursor == 'e' || *this->cursor == 'E')) {
+			this->cursor++;
+			bool IsExponentNegative = false;
+			if (this->cursor < this->end && (*this->cursor == '+' || *this->cursor == '-'))
+				IsExponentNegative = *this->cursor++ == '-';
+
+			int Exponent = 0;
+			while (this->cursor < this->end && *this->cursor >= '0' && *this->cursor <= '9' && Exponent < 100)
+				Exponent = Exponent * 10 + (*this->cursor++ - '0');
+
+			while (Exponent-- > 0)
+				Result = IsExponentNegative ? Result / 10 : Result * 10;
+		}
+
+		value = IsNegative ? -Result : Result;
+		integer = !IsNegative && Result <= UINT32_MAX && Result == (double)(uint32_t)Result ? (uint32_t)Result : 0;
+		return true;
+	}
+
+	bool literal(const char* text, size_t length) {
+		if ((size_t)(this->end - this->cursor) < length || memcmp(this->cursor, text, length) != 0)
+			return false;
+
+		this->cursor += length;
+		return true;
+	}
+
+	// Objects and arrays only need their brackets balanced, strings are stepped over
+	bool skipNested() {
+		int Depth = 0;
+
+		do {
+			if (this->cursor >= this->end)
+				return false;
+
+			char c = *this->cursor++;
+			if (c == '{' || c == '[') {
+				Depth++;
+			}
+			else if (c == '}' || c == ']') {
+				Depth--;
+			}
+			else if (c == '"') {
+				while (this->cursor < this->end && *this->cursor != '"') {
+					if (*this->cursor == '\\')
+						this->cursor++;
+
+					this->cursor++;
+				}
+
+				if (this->cursor >= this->end)
+					return false;
+
+				this->cursor++;
+			}
+		} while (Depth > 0);
+
+		return true;
+	}
+
+	bool value(InboundField& field) {
+		this->skipSpace();
+		if (this->cursor >= this->end)
+			return false;
+
+		field.string = nullptr;
+		field.stringHash = 0;
+		field.boolean = false;
+		field.number = 0;
+		field.integer = 0;
+
+		switch (*this->cursor) {
+			case '"':
+				field.type = INBOUND_STRING;
+				return this->string(field.string, field.stringHash);
+			case 't':
+				field.type = INBOUND_BOOL;
+				field.boolean = true;
+				return this->literal("true", 4);
+			case 'f':
+				field.type = INBOUND_BOOL;
+				return this->literal("false", 5);
+			case 'n':
+				field.type = INBOUND_NULL;
+				return this->literal("null", 4);
+			case '{':
+			case '[':
+				field.type = INBOUND_NESTED;
+				return this->skipNested();
+			default:
+				field.type = INBOUND_NUMBER;
+				return this->number(field.number, field.integer);
+		}
+	}
+
+	// Calls member(keyHash) for each member, which has to consume the value
+	template <typename Function>
+	bool object(Function member) {
+		if (!this->expect('{'))
+			return false;
+
+		this->skipSpace();
+		if (this->cursor < this->end && *this->cursor == '}') {
+			this->cursor++;
+			return true;
+		}
+
+		while (true) {
+			const char* Key;
+			uint32_t KeyHash;
+			if (!this->string(Key, KeyHash) || !this->expect(':') || !member(KeyHash))
+				return false;
+
+			this->skipSpace();
+			if (this->cursor >= this->end)
+				return false;
+
+			char c = *this->cursor++;
+			if (c == '}')
+				return true;
+
+			if (c != ',')
+				return false;
+		}
+	}
+};
+
+bool InboundMessage_parse(char* text, size_t size, InboundMessage& message) {
+	text[size] = '\0';
+
+	message.statusHash = 0;
+	message.code = 0;
+	message.endpointHash = 0;
+	message.endpoint = nullptr;
+	message.errorMessage = nullptr;
+	message.requestId = 0;
+	message.hasData = false;
+	message.fieldCount = 0;
+
+	InboundParser Parser = { text, text + size };
+
+	bool IsValid = Parser.object([&](uint32_t keyHash) {
+		InboundField Field;
+
+		if (keyHash == INBOUND_KEY_DATA) {
+			Parser.skipSpace();
+			if (Parser.cursor >= Parser.end || *Parser.cursor != '{')
+				return Parser.value(Field);
+
+			message.hasData = true;
+			return Parser.object([&](uint32_t dataKeyHash) {
+				if (!Parser.value(Field))
+					return false;
+
+				if (message.fieldCount < INBOUND_MAX_DATA_FIELDS) {
+					Field.keyHash = dataKeyHash;
+					message.fields[message.fieldCount++] = Field;
+				}
+
+				return true;
+			});
+		}
+
+		if (!Parser.value(Field))
+			return false;
+
+		if (keyHash == INBOUND_KEY_STATUS && Field.type == INBOUND_STRING) {
+			message.statusHash = Field.stringHash;
+		}
+		else if (keyHash == INBOUND_KEY_CODE && Field.type == INBOUND_NUMBER) {
+			message.code = (int)Field.number;
+		}
+		else if (keyHash == INBOUND_KEY_ENDPOINT && Field.type == INBOUND_STRING) {
+			message.endpoint = Field.string;
+			message.endpointHash = Field.stringHash;
+		}
+		else if (keyHash == INBOUND_KEY_ERROR_MESSAGE && Field.type == INBOUND_STRING) {
+			message.errorMessage = Field.string;
+		}
+		else if (keyHash == INBOUND_KEY_ID && Field.type == INBOUND_NUMBER && Field.number >= 0 && Field.number <= UINT16_MAX) {
+			message.requestId = (uint16_t)Field.number;
+		}
+
+		return true;
+	});
+
+	if (!IsValid)
+		return false;
+
+	Parser.skipSpace();
+	return Parser.cursor == Parser.end;
+}
+
+const InboundField* InboundMessage::find(uint32_t keyHash) const {
+	for (uint8_t i = 0; i < this->fieldCount; i++) {
+		if (this->fields[i].keyHash == keyHash)
+			return &this->fields[i];
+	}
+
+	return nullptr;
+}
+
+bool InboundMessage::getBool(uint32_t keyHash) const {
+	const InboundField* Field = this->find(keyHash);
+	if (Field == nullptr)
+		return false;
+
+	if (Field->type == INBOUND_BOOL)
+		return Field->boolean;
+
+	return Field->type == INBOUND_NUMBER && Field->number != 0;
+}
+
+int InboundMessage::getInt(uint32_t keyHash) const {
+	const InboundField* Field = this->find(keyHash);
+	if (Field == nullptr || Field->type != INBOUND_NUMBER)
+		return 0;
+
+	return (int)Field->number;
+}
+
+uint32_t InboundMessage::getUnsigned(uint32_t keyHash) const {
+	const InboundField* Field = this->find(keyHash);
+	if (Field == nullptr || Field->type != INBOUND_NUMBER)
+		return 0;
+
+	return Field->integer;
+}
\ No newline at end of file
@@ -1,61 +1,153 @@
 #include "InputRelated.h"
 #include "config.h"
 #include <Arduino.h>
-#include "TickTimer.h"
 
 #if ENABLE_DHT == true
 
-#include <Adafruit_Sensor.h>
-#include <DHT.h>
-#include <DHT_U.h>
-
 Input::DHT11Sensor::DHT11Sensor(gpio_num_t pin) {
 	this->pin = pin;
-	this->dht = new DHT_Unified(pin, DHT11);
 	this->temperature = 0.0f;
 	this->humidity = 0.0f;
-	this->dhtTimer = TickTimer(5000000); // 5 seconds
+	this->readCount = 0;
+	this->errorCount = 0;
+
+	#if DHT_EDGE_CAPTURE == true
+		this->state = IDLE;
+		this->stateMicros = 0;
+		this->edgeCount = 0;
+	#else
+		this->dht = new DHT_Unified(pin, DHT11);
+	#endif
 }
 
 void Input::DHT11Sensor::setup() {
-	this->dht->begin();
+	#if DHT_EDGE_CAPTURE == true
+		pinMode(this->pin, INPUT_PULLUP);
+	#else
+		this->dht->begin();
+	#endif
 }
 
 float Input::DHT11Sensor::readTemperature() {
-	this->readSensor();
 	return this->temperature;
 }
 
 float Input::DHT11Sensor::readHumidity() {
-	this->readSensor();
 	return this->humidity;
 }
 
-void Input::DHT11Sensor::readSensor() {
-	if (!this->dhtTimer.shouldTick())
-		return;
+uint32_t Input::DHT11Sensor::getReadCount() {
+	return this->readCount;
+}
+
+uint32_t Input::DHT11Sensor::getErrorCount() {
+	return this->errorCount;
+}
+
+#if DHT_EDGE_CAPTURE == true
+
+void IRAM_ATTR Input::DHT11Sensor::onEdge(void* arg) {
+	DHT11Sensor* Sensor = (DHT11Sensor*)arg;
+	uint8_t Count = Sensor->edgeCount;
+
+	if (Count < DHT_FRAME_MAX_EDGES) {
+		Sensor->edges[Count] = micros();
+		Sensor->edgeCount = Count + 1;
+	}
+}
+
+ulong Input::DHT11Sensor::update() {
+	ulong Now = micros();
+	ulong Elapsed = Now - this->stateMicros;
+
+	switch (this->state) {
+		case IDLE:
+			// The line is open drain with a pull-up, holding it low for 18 ms or more wakes the sensor up
+			pinMode(this->pin, OUTPUT);
+			digitalWrite(this->pin, LOW);
+			this->state = START_SIGNAL;
+			this->stateMicros = Now;
+			return DHT_START_SIGNAL_MICROS;
+
+		case START_SIGNAL:
+			// A task that fell behind is dispatched early to catch up
+			if (Elapsed < DHT_START_SIGNAL_MICROS)
+				return DHT_START_SIGNAL_MICROS - Elapsed;
+
+			// The sensor answers within 40 us of the release, the interrupt has to be in place before
+			this->edgeCount = 0;
+			attachInterruptArg(this->pin, onEdge, this, CHANGE);
+			pinMode(this->pin, INPUT_PULLUP);
+			this->state = CAPTURING;
+			this->stateMicros = Now;
+			return DHT_CAPTURE_MICROS;
+
+		case CAPTURING: {
+			if (Elapsed < DHT_CAPTURE_MICROS)
+				return DHT_CAPTURE_MICROS - Elapsed;
+
+			detachInterrupt(this->pin);
+			this->state = IDLE;
+			this->readCount++;
+
+			uint32_t Edges[DHT_FRAME_MAX_EDGES];
+			size_t Count = this->edgeCount;
+			for (size_t i = 0; i < Count; i++) {
+				Edges[i] = this->edges[i];
+			}
+
+			DHTReading Reading;
+			DHTFrameStatus Status = DHTFrame_decode(Edges, Count, Reading);
+			if (Status == DHT_FRAME_OK) {
+				this->temperature = Reading.temperature;
+				this->humidity = Reading.humidity;
+			}
+			else {
+				this->errorCount++;
+				Serial.print("DHT11 read failed, status ");
+				Serial.println(Status);
+			}
+
+			// Next read about a whole interval after this one started
+			return DHT_READ_INTERVAL - DHT_START_SIGNAL_MICROS - DHT_CAPTURE_MICROS;
+		}
+	}
+
+	return 0;
+}
+
+#else
 
+ulong Input::DHT11Sensor::update() {
+	// Blocks for the whole frame, with interrupts off while the bits come in
 	sensors_event_t event;
 	this->dht->temperature().getEvent(&event);
+	this->readCount++;
 
 	if (!isnan(event.temperature)) {
 		this->temperature = event.temperature;
 	}
+	else {
+		this->errorCount++;
+	}
 
 	this->dht->humidity().getEvent(&event);
 	if (!isnan(event.relative_humidity)) {
 		this->humidity = event.relative_humidity;
 	}
+
+	return 0;
 }
 
 #endif
 
+#endif
+
 #if ENABLE_WATER_LEVEL_SENSOR == true
 
 Input::WaterLevel::WaterLevel(gpio_num_t pin) {
 	this->pin = pin;
-	this->waterLevelSensorTimer = TickTimer(1000000); // 1 second
-	this->waterLevelSensorTimer.init();
+	this->rejectedCount = 0;
 }
 
 void Input::WaterLevel::setup() {
@@ -63,21 +155,35 @@ void Input::WaterLevel::setup() {
 }
 
 ushort Input::WaterLevel::readPercent() {
-	this->readSensor();
+	return round(this->filter.getPercent());
+}
+
+float Input::WaterLevel::readFilteredPercent() {
+	return this->filter.getPercent();
+}
 
-	return round((this->rawValue / 4095.0f) * 100.0f);
+bool Input::WaterLevel::isFull() {
+	return this->filter.isFull();
 }
 
-void Input::WaterLevel::readSensor() {
-	if (!this->waterLevelSensorTimer.shouldTick())
-		return;
+uint32_t Input::WaterLevel::getRejectedCount() {
+	return this->rejectedCount;
+}
+
+void Input::WaterLevel::update() {
+	for (int i = 0; i < WATER_LEVEL_BURST; i++) {
+		uint16_t RawValue = analogRead(this->pin); // 0 - 4095
 
-	this->rawValue = analogRead(this->pin); // 0 - 4095
+		if (RawValue > 4095) {
+			this->rejectedCount++;
+			Serial.println("Error: Water level sensor reading out of range.");
+			continue;
+		}
 
-	if (this->rawValue < 0 || this->rawValue > 4095) {
-		Serial.println("Error: Water level sensor reading out of range.");
-		return;
+		this->filter.push(RawValue);
 	}
+
+	this->filter.update();
 }
 
 #endif
\ No newline at end of file
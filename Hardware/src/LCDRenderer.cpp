@@ -0,0 +1,182 @@
+#include "LCDRenderer.h"
+#include <string.h>
+
+// Unchanged cells between two changed ones are written again when that is no dearer than moving the cursor past them
+#define LCD_RENDERER_MAX_GAP 1
+
+// A write transaction is the column, the row and the characters, so a long run is split over several
+#define LCD_RENDERER_CHUNK_SIZE (I2C_TRANSACTION_MAX_DATA - 2)
+#define LCD_RENDERER_CONTINUE 0xFF // Column of a chunk that carries on where the one before ended
+
+LCDRenderer::LCDRenderer(LiquidCrystal_I2C& lcd, I2CBus& bus) : isPresentedPending(false), isOverlayPending(false) {
+	this->lcd = &lcd;
+	this->bus = &bus;
+	this->presentedOverlayRow = LCD_ROWS_SIZE;
+	this->overlayRow = LCD_ROWS_SIZE;
+	this->isShownValid = false;
+	this->flushCount = 0;
+	this->writtenCount = 0;
+	this->cursorMoveCount = 0;
+	memset(this->frame, ' ', sizeof(this->frame));
+	memset(this->presented, ' ', sizeof(this->presented));
+	memset(this->target, ' ', sizeof(this->target));
+	memset(this->shown, ' ', sizeof(this->shown));
+	memset(this->presentedOverlay, ' ', sizeof(this->presentedOverlay));
+	memset(this->overlay, ' ', sizeof(this->overlay));
+}
+
+void LCDRenderer::clear() {
+	memset(this->frame, ' ', sizeof(this->frame));
+}
+
+void LCDRenderer::print(uint8_t column, uint8_t row, const char* text) {
+	if (row >= LCD_ROWS_SIZE)
+		return;
+
+	for (uint8_t i = column; i < LCD_COLUMNS_SIZE && *text != '\0'; i++) {
+		this->frame[row][i] = *text++;
+	}
+}
+
+void LCDRenderer::printRight(uint8_t row, const char* text) {
+	size_t Length = strlen(text);
+	this->print(Length < LCD_COLUMNS_SIZE ? LCD_COLUMNS_SIZE - Length : 0, row, text);
+}
+
+void LCDRenderer::present() {
+	if (!this->isPresentedPending.load(std::memory_order_acquire)) {
+		memcpy(this->presented, this->frame, sizeof(this->presented));
+		this->isPresentedPending.store(true, std::memory_order_release); // Publish the copy after it is written
+	}
+
+	#if I2C_ASYNC == false
+		this->flush();
+	#endif
+}
+
+bool LCDRenderer::setOverlay(uint8_t row, const char* text) {
+	if (this->isOverlayPending.load(std::memory_order_acquire))
+		return false;
+
+	memset(this->presentedOverlay, ' ', sizeof(this->presentedOverlay));
+	for (uint8_t i = 0; i < LCD_COLUMNS_SIZE && text[i] != '\0'; i++) {
+		this->presentedOverlay[i] = text[i];
+	}
+
+	this->presentedOverlayRow = row < LCD_ROWS_SIZE ? row : LCD_ROWS_SIZE;
+	this->isOverlayPending.store(true, std::memory_order_release);
+	return true;
+}
+
+bool LCDRenderer::clearOverlay() {
+	if (this->isOverlayPending.load(std::memory_order_acquire))
+		return false;
+
+	this->presentedOverlayRow = LCD_ROWS_SIZE;
+	this->isOverlayPending.store(true, std::memory_order_release);
+	return true;
+}
+
+size_t LCDRenderer::flush() {
+	if (this->isPresentedPending.load(std::memory_order_acquire)) {
+		this->flushCount++;
+		memcpy(this->target, this->presented, sizeof(this->target));
+		this->isPresentedPending.store(false, std::memory_order_release); // Hand the copy back after it is read
+	}
+
+	if (this->isOverlayPending.load(std::memory_order_acquire)) {
+		memcpy(this->overlay, this->presentedOverlay, sizeof(this->overlay));
+		this->overlayRow = this->presentedOverlayRow;
+		this->isOverlayPending.store(false, std::memory_order_release);
+	}
+
+	if (!this->isShownValid) {
+		if (!this->bus->submit(RunClear, this, nullptr, 0))
+			return 0;
+
+		memset(this->shown, ' ', sizeof(this->shown));
+		this->isShownValid = true;
+	}
+
+	size_t Written = 0;
+
+	for (uint8_t row = 0; row < LCD_ROWS_SIZE; row++) {
+		const char* Target = row == this->overlayRow ? this->overlay : this->target[row];
+		uint8_t Column = 0;
+
+		while (Column < LCD_COLUMNS_SIZE) {
+			if (Target[Column] == this->shown[row][Column]) {
+				Column++;
+				continue;
+			}
+
+			// Extend the run over changed cells and short gaps of unchanged ones
+			uint8_t Start = Column;
+			uint8_t End = Column + 1;
+			uint8_t Gap = 0;
+
+			for (uint8_t i = End; i < LCD_COLUMNS_SIZE && Gap <= LCD_RENDERER_MAX_GAP; i++) {
+				if (Target[i] != this->shown[row][i]) {
+					End = i + 1;
+					Gap = 0;
+				}
+				else {
+					Gap++;
+				}
+			}
+
+			// The display only counts as updated for the chunks the bus took
+			uint8_t Chunk[I2C_TRANSACTION_MAX_DATA];
+
+			for (uint8_t i = Start; i < End; i += LCD_RENDERER_CHUNK_SIZE) {
+				uint8_t Length = End - i < LCD_RENDERER_CHUNK_SIZE ? End - i : LCD_RENDERER_CHUNK_SIZE;
+				Chunk[0] = i == Start ? Start : LCD_RENDERER_CONTINUE;
+				Chunk[1] = row;
+				memcpy(&Chunk[2], &Target[i], Length);
+
+				if (!this->bus->submit(RunWrite, this, Chunk, Length + 2)) {
+					this->writtenCount += Written;
+					return Written;
+				}
+
+				memcpy(&this->shown[row][i], &Target[i], Length);
+				Written += Length;
+			}
+
+			this->cursorMoveCount++;
+			Column = End;
+		}
+	}
+
+	this->writtenCount += Written;
+	return Written;
+}
+
+void LCDRenderer::invalidate() {
+	this->isShownValid = false;
+}
+
+uint32_t LCDRenderer::getFlushCount() {
+	return this->flushCount;
+}
+
+uint32_t LCDRenderer::getWrittenCount() {
+	return this->writtenCount;
+}
+
+uint32_t LCDRenderer::getCursorMoveCount() {
+	return this->cursorMoveCount;
+}
+
+void LCDRenderer::RunClear(void* context, const uint8_t* data, uint8_t size) {
+	((LCDRenderer*)context)->lcd->clear();
+}
+
+void LCDRenderer::RunWrite(void* context, const uint8_t* data, uint8_t size) {
+	LiquidCrystal_I2C* LCD = ((LCDRenderer*)context)->lcd;
+
+	if (data[0] != LCD_RENDERER_CONTINUE)
+		LCD->setCursor(data[0], data[1]);
+
+	LCD->write(&data[2], size - 2);
+}
\ No newline at end of file
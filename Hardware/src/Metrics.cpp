@@ -0,0 +1,196 @@
+#include "Metrics.h"
+#include <string.h>
+#include <stdio.h>
+#include "Scheduler.h"
+
+#if ENABLE_METRICS == true
+
+LatencyHistogram Metrics_histograms[METRICS_PROBE_COUNT];
+uint32_t Metrics_cyclesPerMicro = 240;
+
+static const char* const ProbeNames[METRICS_PROBE_COUNT] = { "loop", "network", "websocket", "servo_pwm" };
+
+LatencyHistogram::LatencyHistogram() {
+	this->sequence = 0;
+	this->reset();
+}
+
+void LatencyHistogram::reset() {
+	this->beginWrite();
+	for (uint16_t i = 0; i < METRICS_BUCKET_COUNT; i++) {
+		__atomic_store_n(&this->counts[i], 0, __ATOMIC_RELAXED);
+	}
+
+	__atomic_store_n(&this->count, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&this->max, 0, __ATOMIC_RELAXED);
+	this->endWrite();
+}
+
+void LatencyHistogram::snapshotTo(LatencyHistogram& snapshot) const {
+	while (true) {
+		uint32_t Sequence = __atomic_load_n(&this->sequence, __ATOMIC_ACQUIRE);
+
+		if ((Sequence & 1) == 0) {
+			for (uint16_t i = 0; i < METRICS_BUCKET_COUNT; i++) {
+				snapshot.counts[i] = __atomic_load_n(&this->counts[i], __ATOMIC_RELAXED);
+			}
+
+			snapshot.count = __atomic_load_n(&this->count, __ATOMIC_RELAXED);
+			snapshot.max = __atomic_load_n(&this->max, __ATOMIC_RELAXED);
+
+			// No record began while copying
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if (__atomic_load_n(&this->sequence, __ATOMIC_RELAXED) == Sequence)
+				return;
+		}
+
+		// The owner may be on this core, mid record
+		yield();
+	}
+}
+
+uint32_t LatencyHistogram::getCount() const {
+	return this->count;
+}
+
+uint32_t LatencyHistogram::getMax() const {
+	return this->max;
+}
+
+uint32_t LatencyHistogram::getPercentile(uint8_t percentile) const {
+	if (this->count == 0)
+		return 0;
+
+	// Rank of the value, rounded up so p100 is the last one
+	uint32_t Rank = ((uint64_t)this->count * percentile + 99) / 100;
+	if (Rank == 0)
+		Rank = 1;
+
+	uint32_t Seen = 0;
+	for (uint16_t i = 0; i < METRICS_BUCKET_COUNT; i++) {
+		Seen += this->counts[i];
+		if (Seen >= Rank) {
+			uint32_t Highest = highestOf(i);
+			return Highest < this->max ? Highest : this->max;
+		}
+	}
+
+	return this->max;
+}
+
+uint32_t LatencyHistogram::highestOf(uint16_t bucket) {
+	if (bucket < 2 * METRICS_SUB_BUCKETS)
+		return bucket;
+
+	int Shift = bucket / METRICS_SUB_BUCKETS - 1;
+	uint32_t SubBucket = bucket % METRICS_SUB_BUCKETS + METRICS_SUB_BUCKETS;
+	return ((SubBucket + 1) << Shift) - 1;
+}
+
+void Metrics_setup() {
+	Metrics_cyclesPerMicro = ESP.getCpuFreqMHz();
+	if (Metrics_cyclesPerMicro == 0)
+		Metrics_cyclesPerMicro = 1;
+}
+
+const char* Metrics_probeName(MetricsProbe probe) {
+	return probe < METRICS_PROBE_COUNT ? ProbeNames[probe] : "";
+}
+
+void Metrics_print() {
+	static LatencyHistogram Histogram;
+
+	for (int i = 0; i < METRICS_PROBE_COUNT; i++) {
+		Metrics_histograms[i].snapshotTo(Histogram);
+
+		Serial.print("  ");
+		Serial.print(ProbeNames[i]);
+		Serial.print(": ");
+		Serial.print(Histogram.getCount());
+		Serial.print(" runs, p50 ");
+		Serial.print(Histogram.getPercentile(50));
+		Serial.print(" us, p99 ");
+		Serial.print(Histogram.getPercentile(99));
+		Serial.print(" us, max ");
+		Serial.print(Histogram.getMax());
+		Serial.println(" us");
+	}
+}
+
+int Metrics_getRowCount(Scheduler* const* schedulers, int schedulerCount) {
+	int Count = METRICS_PROBE_COUNT;
+	for (int i = 0; i < schedulerCount; i++) {
+		Count += schedulers[i]->getTaskCount();
+	}
+
+	return Count;
+}
+
+size_t Metrics_encodeReport(Scheduler* const* schedulers, int schedulerCount, int& cursor, char* buffer, size_t capacity) {
+	int Length = snprintf(buffer, capacity, METRICS_FRAME_PREFIX "%lu", (unsigned long)(millis() / 1000));
+	if (Length < 0 || (size_t)Length >= capacity)
+		return 0;
+
+	// Rows are encoded from a copy, the control core keeps recording into the histograms of its tasks
+	static LatencyHistogram Histogram;
+
+	size_t Size = Length;
+	int RowCount = Metrics_getRowCount(schedulers, schedulerCount);
+	int Written = 0;
+	bool IsLatenessOpen = false;
+
+	while (cursor < RowCount) {
+		const char* Name;
+
+		if (cursor < METRICS_PROBE_COUNT) {
+			Name = ProbeNames[cursor];
+			Metrics_histograms[cursor].snapshotTo(Histogram);
+		}
+		else {
+			int Index = cursor - METRICS_PROBE_COUNT;
+			int SchedulerIndex = 0;
+			while (Index >= schedulers[SchedulerIndex]->getTaskCount()) {
+				Index -= schedulers[SchedulerIndex++]->getTaskCount();
+			}
+
+			const SchedulerTask* Task = schedulers[SchedulerIndex]->getTask(Index);
+			Name = Task->name;
+			Task->lateness.snapshotTo(Histogram);
+		}
+
+		// Nothing recorded, e.g. a probe this build doesn't reach, says nothing the backend needs
+		if (Histogram.getCount() == 0) {
+			cursor++;
+			continue;
+		}
+
+		// The array the row goes in is opened in front of its first row
+		const char* Opening = ",";
+		if (Written == 0)
+			Opening = cursor < METRICS_PROBE_COUNT ? ",\"p\":[" : ",\"l\":[";
+		else if (cursor >= METRICS_PROBE_COUNT && !IsLatenessOpen)
+			Opening = "],\"l\":[";
+
+		char Row[96];
+		int RowLength = snprintf(Row, sizeof(Row), "%s[\"%s\",%lu,%lu,%lu,%lu,%lu]", Opening, Name,
+			(unsigned long)Histogram.getCount(), (unsigned long)Histogram.getPercentile(50), (unsigned long)Histogram.getPercentile(90),
+			(unsigned long)Histogram.getPercentile(99), (unsigned long)Histogram.getMax());
+
+		if (RowLength < 0 || (size_t)RowLength >= sizeof(Row) || Size + RowLength + sizeof(METRICS_FRAME_SUFFIX) > capacity)
+			break;
+
+		memcpy(buffer + Size, Row, RowLength);
+		Size += RowLength;
+		IsLatenessOpen = cursor >= METRICS_PROBE_COUNT;
+		Written++;
+		cursor++;
+	}
+
+	if (Written == 0)
+		return 0;
+
+	memcpy(buffer + Size, METRICS_FRAME_SUFFIX, sizeof(METRICS_FRAME_SUFFIX) - 1);
+	return Size + sizeof(METRICS_FRAME_SUFFIX) - 1;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include "PumpController.h"
+
+PumpController::PumpController() {
+	this->isRunning = false;
+	this->startMillis = 0;
+	this->sampleHead = 0;
+	this->sampleCount = 0;
+	this->lastSampleMillis = 0;
+	this->rate = 0.0f;
+	this->spread = 0.0f;
+	this->coastSeconds = WATER_PUMP_COAST_INITIAL;
+	this->isSettling = false;
+	this->stopMillis = 0;
+	this->stopLevel = 0.0f;
+	this->stopRate = 0.0f;
+	this->peakLevel = 0.0f;
+	this->isHoldingOff = false;
+	this->holdoffMillis = 0;
+	this->isStuck = false;
+	this->stuckLevel = 0.0f;
+	this->earlyStopCount = 0;
+	this->dryRunCount = 0;
+	this->stuckCount = 0;
+}
+
+PumpDecision PumpController::update(ulong nowMillis, float level, bool isRunning) {
+	// Any change at all means the sensor is alive again
+	if (this->isStuck && level != this->stuckLevel)
+		this->isStuck = false;
+
+	if (isRunning != this->isRunning) {
+		this->isRunning = isRunning;
+
+		if (isRunning) {
+			this->startMillis = nowMillis;
+			this->sampleHead = 0;
+			this->sampleCount = 0;
+			this->rate = 0.0f;
+			this->isSettling = false;
+		} else if (this->rate >= WATER_PUMP_MIN_RATE) {
+			// Only a stop with a fitted rate tells how far the level coasts
+			this->isSettling = true;
+			this->stopMillis = nowMillis;
+			this->stopLevel = level;
+			this->stopRate = this->rate;
+			this->peakLevel = level;
+		}
+	}
+
+	if (this->isSettling)
+		this->learnCoast(nowMillis, level);
+
+	if (!this->isRunning)
+		return PUMP_KEEP;
+
+	// The hose is still filling and the sensor catching up, the level doesn't tell anything yet
+	if (nowMillis - this->startMillis < WATER_PUMP_DEAD_TIME)
+		return PUMP_KEEP;
+
+	if (this->sampleCount == 0 || nowMillis - this->lastSampleMillis >= WATER_PUMP_RATE_SAMPLE_INTERVAL) {
+		this->sampleMillis[this->sampleHead] = nowMillis - this->startMillis;
+		this->sampleLevels[this->sampleHead] = level;
+		this->sampleHead = (this->sampleHead + 1) % WATER_PUMP_RATE_SAMPLES;
+		this->lastSampleMillis = nowMillis;
+
+		if (this->sampleCount < WATER_PUMP_RATE_SAMPLES)
+			this->sampleCount++;
+
+		if (!this->fitRate())
+			return PUMP_KEEP;
+
+		// A real sensor is never this still, the filter passes some of the ADC noise
+		if (this->spread == 0.0f) {
+			this->stuckCount++;
+			this->isStuck = true;
+			this->stuckLevel = level;
+			return PUMP_STOP_SENSOR_STUCK;
+		}
+
+		if (this->rate < WATER_PUMP_MIN_RATE) {
+			this->dryRunCount++;
+			this->isHoldingOff = true;
+			this->holdoffMillis = nowMillis;
+			return PUMP_STOP_DRY_RUN;
+		}
+	}
+
+	if (this->rate > 0.0f && level + this->rate * this->coastSeconds >= WATER_LEVEL_FULL_PERCENT) {
+		this->earlyStopCount++;
+		return PUMP_STOP_FULL;
+	}
+
+	return PUMP_KEEP;
+}
+
+bool PumpController::isLockedOut(ulong nowMillis) {
+	if (this->isHoldingOff && nowMillis - this->holdoffMillis >= WATER_PUMP_FAULT_HOLDOFF)
+		this->isHoldingOff = false;
+
+	return this->isHoldingOff || this->isStuck;
+}
+
+float PumpController::getRate() {
+	return this->rate;
+}
+
+float PumpController::getCoastSeconds() {
+	return this->coastSeconds;
+}
+
+uint32_t PumpController::getEarlyStopCount() {
+	return this->earlyStopCount;
+}
+
+uint32_t PumpController::getDryRunCount() {
+	return this->dryRunCount;
+}
+
+uint32_t PumpController::getStuckCount() {
+	return this->stuckCount;
+}
+
+void PumpController::learnCoast(ulong nowMillis, float level) {
+	if (level > this->peakLevel)
+		this->peakLevel = level;
+
+	if (nowMillis - this->stopMillis < WATER_PUMP_SETTLE_TIME)
+		return;
+
+	this->isSettling = false;
+
+	float Coast = (this->peakLevel - this->stopLevel) / this->stopRate;
+	if (Coast < 0.0f)
+		Coast = 0.0f;
+
+	if (Coast > WATER_PUMP_COAST_MAX)
+		Coast = WATER_PUMP_COAST_MAX;
+
+	// Half way to the latest stop, a drink while settling throws one off
+	this->coastSeconds += (Coast - this->coastSeconds) * 0.5f;
+}
+
+bool PumpController::fitRate() {
+	if (this->sampleCount < WATER_PUMP_RATE_SAMPLES)
+		return false;
+
+	// Times relative to the oldest sample keep the sums small enough for floats
+	uint8_t Oldest = this->sampleHead; // The ring is full, the head is the oldest
+	ulong Origin = this->sampleMillis[Oldest];
+
+	float SumT = 0.0f;
+	float SumL = 0.0f;
+	float SumTT = 0.0f;
+	float SumTL = 0.0f;
+	float Lowest = this->sampleLevels[0];
+	float Highest = this->sampleLevels[0];
+
+	for (uint8_t i = 0; i < WATER_PUMP_RATE_SAMPLES; i++) {
+		float T = (this->sampleMillis[i] - Origin) / 1000.0f;
+		float L = this->sampleLevels[i];
+
+		SumT += T;
+		SumL += L;
+		SumTT += T * T;
+		SumTL += T * L;
+
+		if (L < Lowest) Lowest = L;
+		if (L > Highest) Highest = L;
+	}
+
+	float N = WATER_PUMP_RATE_SAMPLES;
+	float Denominator = N * SumTT - SumT * SumT;
+	if (Denominator <= 0.0f)
+		return false;
+
+	this->rate = (N * SumTL - SumT * SumL) / Denominator;
+	this->spread = Highest - Lowest;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include <string.h>
+#include "RequestWindow.h"
+
+RequestWindow::RequestWindow() {
+	this->limit = WS_REQUEST_WINDOW;
+	this->count = 0;
+	this->lastId = REQUEST_ID_NONE;
+	this->nextOrder = 0;
+	this->completedCount = 0;
+	this->retransmitCount = 0;
+
+	for (uint8_t i = 0; i < WS_REQUEST_WINDOW; i++) {
+		this->slots[i].isUsed = false;
+	}
+}
+
+void RequestWindow::setLimit(uint8_t limit) {
+	if (limit < 1)
+		limit = 1;
+	else if (limit > WS_REQUEST_WINDOW)
+		limit = WS_REQUEST_WINDOW;
+
+	this->limit = limit;
+}
+
+uint8_t RequestWindow::getLimit() {
+	return this->limit;
+}
+
+uint8_t RequestWindow::size() {
+	return this->count;
+}
+
+bool RequestWindow::isFull() {
+	return this->count >= this->limit;
+}
+
+bool RequestWindow::isPending(uint32_t endpointHash) {
+	for (uint8_t i = 0; i < WS_REQUEST_WINDOW; i++) {
+		if (this->slots[i].isUsed && this->slots[i].endpointHash == endpointHash)
+			return true;
+	}
+
+	return false;
+}
+
+uint16_t RequestWindow::nextId() {
+	this->lastId++;
+	if (this->lastId == REQUEST_ID_NONE)
+		this->lastId++;
+
+	return this->lastId;
+}
+
+bool RequestWindow::add(uint16_t id, uint32_t endpointHash, const char* frame, size_t size, ulong now) {
+	if (this->isFull() || size > WS_TX_FRAME_SIZE)
+		return false;
+
+	for (uint8_t i = 0; i < WS_REQUEST_WINDOW; i++) {
+		RequestSlot& Slot = this->slots[i];
+		if (Slot.isUsed)
+			continue;
+
+		Slot.isUsed = true;
+		Slot.id = id;
+		Slot.endpointHash = endpointHash;
+		Slot.order = this->nextOrder++;
+		Slot.sentTime = now;
+		Slot.retransmits = 0;
+		Slot.size = size;
+		memcpy(Slot.frame, frame, size);
+
+		this->count++;
+		return true;
+	}
+
+	return false;
+}
+
+bool RequestWindow::complete(uint16_t id, uint32_t endpointHash) {
+	RequestSlot* Match = nullptr;
+
+	for (uint8_t i = 0; i < WS_REQUEST_WINDOW; i++) {
+		RequestSlot& Slot = this->slots[i];
+		if (!Slot.isUsed || Slot.endpointHash != endpointHash)
+			continue;
+
+		if (id != REQUEST_ID_NONE) {
+			if (Slot.id == id) {
+				Match = &Slot;
+				break;
+			}
+			continue;
+		}
+
+		if (Match == nullptr || (int32_t)(Slot.order - Match->order) < 0)
+			Match = &Slot;
+	}
+
+	if (Match == nullptr)
+		return false;
+
+	Match->isUsed = false;
+	this->count--;
+	this->completedCount++;
+	return true;
+}
+
+RequestSlot* RequestWindow::nextExpired(ulong now) {
+	RequestSlot* Oldest = nullptr;
+
+	for (uint8_t i = 0; i < WS_REQUEST_WINDOW; i++) {
+		RequestSlot& Slot = this->slots[i];
+		if (!Slot.isUsed || now - Slot.sentTime < WS_REQUEST_TIMEOUT)
+			continue;
+
+		if (Oldest == nullptr || (int32_t)(Slot.order - Oldest->order) < 0)
+			Oldest = &Slot;
+	}
+
+	return Oldest;
+}
+
+void RequestWindow::markRetransmitted(RequestSlot* slot, ulong now) {
+	slot->sentTime = now;
+	slot->retransmits++;
+	this->retransmitCount++;
+}
+
+void RequestWindow::clear() {
+	for (uint8_t i = 0; i < WS_REQUEST_WINDOW; i++) {
+		this->slots[i].isUsed = false;
+	}
+
+	this->count = 0;
+}
+
+uint32_t RequestWindow::getCompletedCount() {
+	return this->completedCount;
+}
+
+uint32_t RequestWindow::getRetransmitCount() {
+	return this->retransmitCount;
+}
\ No newline at end of file
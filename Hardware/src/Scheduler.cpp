@@ -0,0 +1,272 @@
+#include <Arduino.h>
+#include "Scheduler.h"
+#include "HALHooks.h"
+
+SchedulerPeriodObserver Scheduler::periodObserver = nullptr;
+
+Scheduler::Scheduler() {
+	this->taskCount = 0;
+	this->runningTask = -1;
+	this->startMicros = 0;
+	this->busyMicros = 0;
+}
+
+int Scheduler::addTask(const char* name, SchedulerCallback callback, ulong periodMicros) {
+	if (this->taskCount >= SCHEDULER_MAX_TASKS) {
+		Serial.print("Scheduler is full, unable to add task ");
+		Serial.println(name);
+		return -1;
+	}
+
+	ulong Now = micros();
+	if (this->taskCount == 0) {
+		this->startMicros = Now;
+	}
+
+	int id = this->taskCount++;
+	SchedulerTask& task = this->tasks[id];
+	task = {};
+	task.name = name;
+	task.callback = callback;
+	task.sequence = id;
+	task.timer = TickTimer(periodMicros);
+
+	// First deadline is now
+	task.timer.setLastTickMicros(Now - periodMicros);
+
+	this->heap[id] = id;
+	this->siftUp(id);
+	return id;
+}
+
+void Scheduler::setTaskPeriod(int id, ulong periodMicros) {
+	if (id < 0 || id >= this->taskCount)
+		return;
+
+	this->tasks[id].timer.setTickMicros(periodMicros);
+	this->resift(id);
+}
+
+void Scheduler::wakeTask(int id, ulong periodMicros) {
+	if (id < 0 || id >= this->taskCount)
+		return;
+
+	// Due now rather than at a deadline long gone, so the wait isn't counted as lateness
+	this->tasks[id].timer.setLastTickMicros(micros() - periodMicros);
+	this->setTaskPeriod(id, periodMicros);
+}
+
+ulong Scheduler::run() {
+	if (this->taskCount == 0)
+		return 0;
+
+	// Each task is dispatched at most once per call so a late task can't starve the caller
+	for (int i = 0; i < this->taskCount; i++) {
+		int id = this->heap[0];
+		SchedulerTask& task = this->tasks[id];
+
+		ulong Deadline = this->getDeadline(id);
+		ulong Start = micros();
+
+		// Nothing is due yet, the root is the earliest deadline
+		if ((long)(Deadline - Start) > 0)
+			break;
+
+		ulong Jitter = Start - Deadline;
+		ulong DuePeriod = task.timer.getTickMicros();
+		this->runningTask = id;
+		ulong NewPeriod = task.callback();
+		this->runningTask = -1;
+		ulong End = micros();
+		ulong Duration = End - Start;
+
+		// The task asked for a different period, like TickTimer::setTickMicros()
+		if (NewPeriod != 0)
+			task.timer.setTickMicros(NewPeriod);
+
+		ulong Period = task.timer.getTickMicros();
+
+		if (task.runs > 0 && Start - task.lastStartMicros > task.maxPeriodMicros)
+			task.maxPeriodMicros = Start - task.lastStartMicros;
+
+		if (task.runs > 0 && Scheduler::periodObserver != nullptr)
+			Scheduler::periodObserver(this, task, Start - task.lastStartMicros, DuePeriod);
+
+		this->busyMicros += Duration;
+		task.lastStartMicros = Start;
+		task.runs++;
+		task.lastJitterMicros = Jitter;
+		if (Jitter > task.maxJitterMicros)
+			task.maxJitterMicros = Jitter;
+
+		#if ENABLE_METRICS == true
+			task.lateness.record(Jitter);
+		#endif
+
+		if (Duration > task.maxDurationMicros)
+			task.maxDurationMicros = Duration;
+		if (Jitter >= Period || Duration > Period)
+			task.overruns++;
+
+		ulong Next = Deadline + Period;
+
+		// Fell a whole period behind, skip the missed ticks instead of bursting but stay in phase
+		if ((long)(Next - End) <= 0 && Period > 0)
+			Next += ((End - Next) / Period + 1) * Period;
+
+		task.timer.setLastTickMicros(Next - Period);
+
+		// The callback may have woken a task that took the root
+		if (this->heap[0] == id)
+			this->siftDown(0);
+		else
+			this->resift(id);
+	}
+
+	ulong Deadline = this->getDeadline(this->heap[0]);
+	ulong Now = micros();
+
+	HAL_hintWakeup(Deadline);
+
+	return (long)(Deadline - Now) > 0 ? Deadline - Now : 0;
+}
+
+ulong Scheduler::getSlackMicros() {
+	ulong Now = micros();
+	ulong Slack = (ulong)-1;
+
+	for (int id = 0; id < this->taskCount; id++) {
+		if (id == this->runningTask)
+			continue;
+
+		long Left = (long)(this->getDeadline(id) - Now);
+		if (Left <= 0)
+			return 0;
+
+		if ((ulong)Left < Slack)
+			Slack = Left;
+	}
+
+	return Slack;
+}
+
+int Scheduler::getTaskCount() {
+	return this->taskCount;
+}
+
+const SchedulerTask* Scheduler::getTask(int id) {
+	if (id < 0 || id >= this->taskCount)
+		return nullptr;
+
+	return &this->tasks[id];
+}
+
+ulong Scheduler::getBusyMicros() {
+	return this->busyMicros;
+}
+
+ulong Scheduler::getElapsedMicros() {
+	return micros() - this->startMicros;
+}
+
+void Scheduler::setPeriodObserver(SchedulerPeriodObserver observer) {
+	Scheduler::periodObserver = observer;
+}
+
+void Scheduler::printStats() {
+	ulong Elapsed = this->getElapsedMicros();
+
+	Serial.print("Scheduler busy: ");
+	Serial.print(Elapsed > 0 ? (this->busyMicros * 100.0) / Elapsed : 0.0);
+	Serial.println(" %");
+
+	for (int i = 0; i < this->taskCount; i++) {
+		SchedulerTask& task = this->tasks[i];
+
+		Serial.print("  ");
+		Serial.print(task.name);
+		Serial.print(": period ");
+		Serial.print(task.timer.getTickMicros());
+		Serial.print(" us (worst ");
+		Serial.print(task.maxPeriodMicros);
+		Serial.print(" us), runs ");
+		Serial.print(task.runs);
+		Serial.print(", overruns ");
+		Serial.print(task.overruns);
+		Serial.print(", jitter max ");
+		Serial.print(task.maxJitterMicros);
+		Serial.print(" us, duration max ");
+		Serial.print(task.maxDurationMicros);
+
+		#if ENABLE_METRICS == true
+			// The network scheduler's tasks are printed from the control loop
+			static LatencyHistogram Lateness;
+			task.lateness.snapshotTo(Lateness);
+
+			Serial.print(" us, late p50 ");
+			Serial.print(Lateness.getPercentile(50));
+			Serial.print(" us p99 ");
+			Serial.print(Lateness.getPercentile(99));
+		#endif
+
+		Serial.println(" us");
+	}
+}
+
+bool Scheduler::isBefore(int a, int b) {
+	long Difference = (long)(this->getDeadline(a) - this->getDeadline(b));
+
+	if (Difference != 0)
+		return Difference < 0;
+
+	return this->tasks[a].sequence < this->tasks[b].sequence;
+}
+
+void Scheduler::siftUp(int index) {
+	while (index > 0) {
+		int Parent = (index - 1) / 2;
+		if (!this->isBefore(this->heap[index], this->heap[Parent]))
+			break;
+
+		int Swap = this->heap[index];
+		this->heap[index] = this->heap[Parent];
+		this->heap[Parent] = Swap;
+		index = Parent;
+	}
+}
+
+void Scheduler::siftDown(int index) {
+	while (true) {
+		int Smallest = index;
+		int Left = index * 2 + 1;
+		int Right = index * 2 + 2;
+
+		if (Left < this->taskCount && this->isBefore(this->heap[Left], this->heap[Smallest]))
+			Smallest = Left;
+		if (Right < this->taskCount && this->isBefore(this->heap[Right], this->heap[Smallest]))
+			Smallest = Right;
+
+		if (Smallest == index)
+			break;
+
+		int Swap = this->heap[index];
+		this->heap[index] = this->heap[Smallest];
+		this->heap[Smallest] = Swap;
+		index = Smallest;
+	}
+}
+
+void Scheduler::resift(int id) {
+	for (int i = 0; i < this->taskCount; i++) {
+		if (this->heap[i] != id)
+			continue;
+
+		this->siftUp(i);
+		this->siftDown(i);
+		break;
+	}
+}
+
+ulong Scheduler::getDeadline(int id) {
+	return this->tasks[id].timer.getNextTickMicros();
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include <Arduino.h>
+#include "ServoBackend.h"
+#include "ServoManager.h"
+
+#define LEDC_CHANNEL_COUNT 16
+#define SERVO_PWM_PERIOD_MICROS (1000000UL / SERVO_PWM_FREQUENCY)
+#define SERVO_PWM_MAX_DUTY ((1UL << SERVO_PWM_RESOLUTION) - 1)
+
+ServoBackend* ServoBackend_getDefault() {
+	#if SERVO_HARDWARE_PWM == true
+		static ServoLEDCBackend backend;
+	#else
+		static ServoBitBangBackend backend;
+	#endif
+
+	return &backend;
+}
+
+#pragma region LEDC Backend
+
+void ServoLEDCBackend::attach(const FeederTable& feeders, uint8_t id) {
+	if (id >= LEDC_CHANNEL_COUNT) {
+		Serial.print("No LEDC channel left for servo on pin ");
+		Serial.println(feeders.pins[id]);
+		return;
+	}
+
+	ledcSetup(id, SERVO_PWM_FREQUENCY, SERVO_PWM_RESOLUTION);
+	ledcAttachPin(feeders.pins[id], id);
+	this->write(feeders, id);
+}
+
+void ServoLEDCBackend::write(const FeederTable& feeders, uint8_t id) {
+	if (id >= LEDC_CHANNEL_COUNT)
+		return;
+
+	uint32_t Duty = ((ulong)feeders.pulses[id] * SERVO_PWM_MAX_DUTY) / SERVO_PWM_PERIOD_MICROS;
+
+	ledcWrite(id, Duty);
+
+	#if SERVO_SERIAL_DEBUG == true
+		Serial.print("Servo on pin ");
+		Serial.print(feeders.pins[id]);
+		Serial.print(" set to ");
+		Serial.print(feeders.positions[id]);
+		Serial.print(" degrees (duty ");
+		Serial.print(Duty);
+		Serial.println(")");
+	#endif
+}
+
+void ServoLEDCBackend::refresh(const FeederTable& feeders, uint8_t id) {
+	// The LEDC timer keeps repeating the last written duty
+	this->write(feeders, id);
+}
+
+bool ServoLEDCBackend::needsRefresh() {
+	return false;
+}
+
+#pragma endregion
+
+#pragma region Bit-Bang Backend
+
+void ServoBitBangBackend::attach(const FeederTable& feeders, uint8_t id) {
+	pinMode(feeders.pins[id], OUTPUT);
+}
+
+void ServoBitBangBackend::write(const FeederTable& feeders, uint8_t id) {
+	// Position is picked up on the next refresh
+}
+
+void ServoBitBangBackend::refresh(const FeederTable& feeders, uint8_t id) {
+	digitalWrite(feeders.pins[id], HIGH);
+	delayMicroseconds(feeders.pulses[id]);
+	digitalWrite(feeders.pins[id], LOW);
+
+	#if SERVO_SERIAL_DEBUG == true
+		Serial.print("Servo on pin ");
+		Serial.print(feeders.pins[id]);
+		Serial.print(" set to ");
+		Serial.print(feeders.positions[id]);
+		Serial.print(" degrees (");
+		Serial.print(feeders.pulses[id]);
+		Serial.println(" microseconds)");
+	#endif
+}
+
+bool ServoBitBangBackend::needsRefresh() {
+	return true;
+}
+
+#pragma endregion
\ No newline at end of file
@@ -1,79 +1,122 @@
 #include <Arduino.h>
 #include "ServoManager.h"
-#include "TickTimer.h"
+#include "ServoPulse.h"
 
-TickTimer servoTickTimer(20000); // 20 ms (50 Hz)
+#if ENABLE_METRICS == true
+	#include "Metrics.h"
+#endif
 
-#define MANUAL_TICK_GEAR_RATIO 20
-
-#include <vector>
-std::vector<ServoTarget*> pServoTargets;
+FeederTable* pFeeders = nullptr;
 ulong LastTickMicros = 0;
+ServoBackend* pServoBackend = ServoBackend_getDefault();
 
-ServoManager::ServoManager() {}
+#if SERVO_VELOCITY > 0
+	static void ServoManager_step(ulong elapsedMicros); // Moves every ramping servo closer to its target
+#endif
 
-ServoManager::ServoManager(gpio_num_t pin) {
-	this->target = {};
-	this->target.degrees = 0;
-	this->target.pin = pin;
+static void ServoManager_WritePWM();
 
-	// Add the ServoTarget to the vector
-	pServoTargets.push_back(&this->target);
+void ServoManager_setup(FeederTable* feeders) {
+	pFeeders = feeders;
 
-	Serial.print("ServoManager initialized with pin: ");
-	Serial.print(pin);
-	Serial.print(", size of pServoTargets: ");
-	Serial.println(pServoTargets.size());
-}
+	Serial.print("ServoManager initialized with feeders: ");
+	Serial.println(pFeeders->count);
 
-void ServoManager::setup() {
-	pinMode(this->target.pin, OUTPUT);
+	for (uint8_t i = 0; i < pFeeders->count; i++) {
+		pServoBackend->attach(*pFeeders, i);
+	}
 }
 
-void ServoManager::Rotate(int degrees) {
-	this->target.degrees = degrees;
+void ServoManager_setBackend(ServoBackend* backend) {
+	pServoBackend = backend;
+
+	if (pFeeders == nullptr)
+		return;
+
+	for (uint8_t i = 0; i < pFeeders->count; i++) {
+		pServoBackend->attach(*pFeeders, i);
+	}
 }
 
-int ServoManager::getCurrentPosition() {
-	return this->target.degrees;
+void ServoManager_rotate(uint8_t id, int degrees) {
+	if (pFeeders->degrees[id] == degrees)
+		return;
+
+	pFeeders->degrees[id] = degrees;
+
+	#if SERVO_VELOCITY > 0
+		// The first step is a tick's worth, not everything since the servos came to rest
+		if (pFeeders->movingMask == 0)
+			LastTickMicros = micros() - SERVO_TICK_INTERVAL;
+
+		pFeeders->movingMask |= 1UL << id; // Ramped by ServoManager_loop()
+	#else
+		pFeeders->positions[id] = degrees;
+		pFeeders->pulses[id] = ServoPulse_lookup(id, degrees);
+		pServoBackend->write(*pFeeders, id);
+	#endif
 }
 
 void ServoManager_loop() {
-	// If 20 ms have passed
-	if (!servoTickTimer.shouldTick())
+	#if SERVO_VELOCITY > 0
+		ulong Now = micros();
+		ulong Elapsed = Now - LastTickMicros;
+		LastTickMicros = Now;
+
+		if (pFeeders != nullptr && pFeeders->movingMask != 0)
+			ServoManager_step(Elapsed);
+	#endif
+
+	// Hardware backends keep generating pulses on their own
+	if (!pServoBackend->needsRefresh())
 		return;
 
 	ServoManager_WritePWM();
 }
 
-static void ServoManager_WritePWM() {
-	// DOCS: Range is 470-2572 microseconds
+#if SERVO_VELOCITY > 0
+static void ServoManager_step(ulong elapsedMicros) {
+	// At least a degree per tick, and never more than the whole range after a long gap
+	uint64_t Degrees = ((uint64_t)SERVO_VELOCITY * elapsedMicros + 500000) / 1000000;
+	int Step = Degrees < 1 ? 1 : Degrees > SERVO_MAX_DEGREES ? SERVO_MAX_DEGREES : (int)Degrees;
+
+	uint32_t Moving = pFeeders->movingMask;
+	while (Moving != 0) {
+		uint8_t i = __builtin_ctz(Moving);
+		uint32_t Bit = 1UL << i;
+		Moving &= ~Bit;
+
+		int Target = pFeeders->degrees[i];
+		int Position = pFeeders->positions[i];
+		Position += Target - Position > Step ? Step : Target - Position < -Step ? -Step : Target - Position;
+		pFeeders->positions[i] = Position;
+
+		if (Position == Target)
+			pFeeders->movingMask &= ~Bit;
+
+		// The servo wouldn't follow a step inside its deadband, it goes out with a later one
+		uint16_t Pulse = ServoPulse_lookup(i, Position);
+		int Change = (int)Pulse - pFeeders->pulses[i];
+		if (Position != Target && Change < ServoPulse_getCalibration(i).deadbandMicros && -Change < ServoPulse_getCalibration(i).deadbandMicros)
+			continue;
+
+		pFeeders->pulses[i] = Pulse;
+		pServoBackend->write(*pFeeders, i);
+	}
+}
+#endif
 
-	// For each ServoTargetDegrees
-	int ArrayCount = pServoTargets.size();
+static void ServoManager_WritePWM() {
+	#if ENABLE_METRICS == true
+		MetricsTimer Timer(METRICS_SERVO_PWM);
+	#endif
 
-	if (ArrayCount == 0) {
-		Serial.println("No ServoTargets to process.");
+	if (pFeeders == nullptr || pFeeders->count == 0) {
+		Serial.println("No feeders to process.");
 		return;
 	}
 
-	for (int i = 0; i < ArrayCount; i++) {
-		ServoTarget* Target = pServoTargets[i];
-
-		float TargetuS = 470.0f + (Target->degrees * 11.5f);
-
-		digitalWrite(Target->pin, HIGH);
-		delayMicroseconds((uint32_t)TargetuS);
-		digitalWrite(Target->pin, LOW);
-
-		#if SERVO_SERIAL_DEBUG == true
-			Serial.print("Servo on pin ");
-			Serial.print(Target->pin);
-			Serial.print(" set to ");
-			Serial.print(Target->degrees);
-			Serial.print(" degrees (");
-			Serial.print(TargetuS);
-			Serial.println(" microseconds)");
-		#endif
+	for (uint8_t i = 0; i < pFeeders->count; i++) {
+		pServoBackend->refresh(*pFeeders, i);
 	}
 }
\ No newline at end of file
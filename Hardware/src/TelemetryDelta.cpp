@@ -0,0 +1,52 @@
+#include <math.h>
+#include <stdlib.h>
+#include "TelemetryDelta.h"
+
+// A reading that appears or goes away always counts as a change
+static bool TelemetryDelta_exceeds(float reported, float value, float deadband) {
+	if (isfinite(reported) != isfinite(value))
+		return true;
+
+	if (!isfinite(value))
+		return false;
+
+	return fabsf(value - reported) >= deadband;
+}
+
+uint8_t TelemetryDelta_changedFields(const TelemetrySample& reported, const TelemetrySample& sample) {
+	uint8_t Fields = 0;
+
+	if (TelemetryDelta_exceeds(reported.temperature, sample.temperature, TELEMETRY_TEMPERATURE_DEADBAND))
+		Fields |= TELEMETRY_FIELD_TEMPERATURE;
+
+	if (TelemetryDelta_exceeds(reported.humidity, sample.humidity, TELEMETRY_HUMIDITY_DEADBAND))
+		Fields |= TELEMETRY_FIELD_HUMIDITY;
+
+	if (abs(sample.waterLevel - reported.waterLevel) >= TELEMETRY_WATER_LEVEL_DEADBAND)
+		Fields |= TELEMETRY_FIELD_WATER_LEVEL;
+
+	if (sample.pumpMask != reported.pumpMask)
+		Fields |= TELEMETRY_FIELD_PUMP;
+
+	if (sample.feederMask != reported.feederMask)
+		Fields |= TELEMETRY_FIELD_FOOD;
+
+	return Fields;
+}
+
+void TelemetryDelta_apply(TelemetrySample& reported, const TelemetrySample& sample, uint8_t fields) {
+	if (fields & TELEMETRY_FIELD_TEMPERATURE)
+		reported.temperature = sample.temperature;
+
+	if (fields & TELEMETRY_FIELD_HUMIDITY)
+		reported.humidity = sample.humidity;
+
+	if (fields & TELEMETRY_FIELD_WATER_LEVEL)
+		reported.waterLevel = sample.waterLevel;
+
+	if (fields & TELEMETRY_FIELD_PUMP)
+		reported.pumpMask = sample.pumpMask;
+
+	if (fields & TELEMETRY_FIELD_FOOD)
+		reported.feederMask = sample.feederMask;
+}
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include <math.h>
+#include <string.h>
+#include "TelemetryEncoder.h"
+
+// Appends to a caller buffer, the length check is done once up front against TELEMETRY_FRAME_MAX_SIZE
+struct TelemetryWriter {
+	char* cursor;
+
+	template <size_t N>
+	void literal(const char (&text)[N]) {
+		memcpy(this->cursor, text, N - 1); // Length is a compile time constant
+		this->cursor += N - 1;
+	}
+
+	void integer(long value) {
+		if (value < 0)
+			*this->cursor++ = '-';
+
+		this->unsignedInteger(value < 0 ? 0UL - (unsigned long)value : (unsigned long)value);
+	}
+
+	void unsignedInteger(unsigned long value) {
+		unsigned long Magnitude = value;
+		char Digits[TELEMETRY_INT_MAX_LENGTH];
+		int Count = 0;
+		do {
+			Digits[Count++] = '0' + Magnitude % 10;
+			Magnitude /= 10;
+		} while (Magnitude > 0);
+
+		while (Count > 0) {
+			*this->cursor++ = Digits[--Count];
+		}
+	}
+
+	void decimal(float value) {
+		if (!isfinite(value) || fabsf(value) > 999999.99f) {
+			this->literal("null");
+			return;
+		}
+
+		long Hundredths = lroundf(value * 100.0f);
+		if (Hundredths < 0) {
+			*this->cursor++ = '-';
+			Hundredths = -Hundredths;
+		}
+
+		this->integer(Hundredths / 100);
+
+		int Fraction = Hundredths % 100;
+		if (Fraction == 0)
+			return;
+
+		*this->cursor++ = '.';
+		*this->cursor++ = '0' + Fraction / 10;
+		if (Fraction % 10 != 0)
+			*this->cursor++ = '0' + Fraction % 10;
+	}
+};
+
+size_t TelemetryEncoder_encode(const TelemetrySample& sample, char* buffer, size_t capacity) {
+	if (capacity < TELEMETRY_FRAME_MAX_SIZE)
+		return 0;
+
+	TelemetryWriter Writer = { buffer };
+
+	Writer.literal(TELEMETRY_FRAME_PREFIX);
+	Writer.decimal(sample.temperature);
+	Writer.literal(TELEMETRY_FRAME_HUMIDITY);
+	Writer.decimal(sample.humidity);
+	Writer.literal(TELEMETRY_FRAME_WATER_LEVEL);
+	Writer.integer(sample.waterLevel);
+	Writer.literal(TELEMETRY_FRAME_PUMP);
+	Writer.unsignedInteger(sample.pumpMask);
+	Writer.literal(TELEMETRY_FRAME_FOOD);
+	Writer.unsignedInteger(sample.feederMask);
+	Writer.literal(TELEMETRY_FRAME_SUFFIX);
+
+	return Writer.cursor - buffer;
+}
+
+size_t TelemetryEncoder_encodeGetData(char* buffer, size_t capacity) {
+	if (capacity < sizeof(GET_DATA_FRAME) - 1)
+		return 0;
+
+	TelemetryWriter Writer = { buffer };
+	Writer.literal(GET_DATA_FRAME);
+	return Writer.cursor - buffer;
+}
+
+size_t TelemetryEncoder_encodeDelta(const TelemetrySample& sample, uint8_t fields, uint16_t sequence, bool keyframe, char* buffer, size_t capacity) {
+	if (capacity < TELEMETRY_DELTA_FRAME_MAX_SIZE)
+		return 0;
+
+	TelemetryWriter Writer = { buffer };
+
+	Writer.literal(TELEMETRY_DELTA_FRAME_PREFIX);
+	Writer.integer(sequence);
+
+	if (keyframe)
+		Writer.literal(TELEMETRY_DELTA_FRAME_KEYFRAME);
+
+	if (fields & TELEMETRY_FIELD_TEMPERATURE) {
+		Writer.literal(TELEMETRY_DELTA_FRAME_TEMPERATURE);
+		Writer.decimal(sample.temperature);
+	}
+
+	if (fields & TELEMETRY_FIELD_HUMIDITY) {
+		Writer.literal(TELEMETRY_FRAME_HUMIDITY);
+		Writer.decimal(sample.humidity);
+	}
+
+	if (fields & TELEMETRY_FIELD_WATER_LEVEL) {
+		Writer.literal(TELEMETRY_FRAME_WATER_LEVEL);
+		Writer.integer(sample.waterLevel);
+	}
+
+	if (fields & TELEMETRY_FIELD_PUMP) {
+		Writer.literal(TELEMETRY_FRAME_PUMP);
+		Writer.unsignedInteger(sample.pumpMask);
+	}
+
+	if (fields & TELEMETRY_FIELD_FOOD) {
+		Writer.literal(TELEMETRY_FRAME_FOOD);
+		Writer.unsignedInteger(sample.feederMask);
+	}
+
+	Writer.literal(TELEMETRY_FRAME_SUFFIX);
+
+	return Writer.cursor - buffer;
+}
+
+size_t TelemetryEncoder_encodeHistory(const JournalSample* samples, size_t count, size_t& encoded, char* buffer, size_t capacity) {
+	encoded = 0;
+
+	TelemetryWriter Writer = { buffer };
+	char* End = buffer + capacity;
+
+	if (capacity < sizeof(TELEMETRY_HISTORY_FRAME_PREFIX) - 1 + TELEMETRY_HISTORY_ROW_MAX_SIZE + sizeof(TELEMETRY_HISTORY_FRAME_SUFFIX) - 1 || count == 0)
+		return 0;
+
+	Writer.literal(TELEMETRY_HISTORY_FRAME_PREFIX);
+
+	// Rows are checked against their longest form, the suffix always has room
+	while (encoded < count && (size_t)(End - Writer.cursor) >= TELEMETRY_HISTORY_ROW_MAX_SIZE + sizeof(TELEMETRY_HISTORY_FRAME_SUFFIX) - 1) {
+		const JournalSample& Sample = samples[encoded];
+
+		if (encoded > 0)
+			*Writer.cursor++ = ',';
+
+		*Writer.cursor++ = '[';
+		Writer.unsignedInteger(Sample.time);
+		*Writer.cursor++ = ',';
+		Writer.decimal(Sample.sample.temperature);
+		*Writer.cursor++ = ',';
+		Writer.decimal(Sample.sample.humidity);
+		*Writer.cursor++ = ',';
+		Writer.integer(Sample.sample.waterLevel);
+		*Writer.cursor++ = ',';
+		*Writer.cursor++ = '0' + (Sample.sample.pumpMask != 0 ? 1 : 0) + (Sample.sample.feederMask != 0 ? 2 : 0);
+		*Writer.cursor++ = ']';
+
+		encoded++;
+	}
+
+	Writer.literal(TELEMETRY_HISTORY_FRAME_SUFFIX);
+
+	return Writer.cursor - buffer;
+}
\ No newline at end of file
@@ -0,0 +1,369 @@
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+#include "TelemetryJournal.h"
+
+// Polynomial 0x07, bitwise since a record is only 15 bytes
+static uint8_t TelemetryJournal_checksum(const JournalRecord& record) {
+	const uint8_t* Bytes = (const uint8_t*)&record;
+	uint8_t Crc = 0;
+
+	for (size_t i = 0; i < offsetof(JournalRecord, checksum); i++) {
+		Crc ^= Bytes[i];
+		for (int Bit = 0; Bit < 8; Bit++)
+			Crc = (Crc & 0x80) ? (Crc << 1) ^ 0x07 : Crc << 1;
+	}
+
+	return Crc;
+}
+
+static bool TelemetryJournal_isValid(const JournalRecord& record) {
+	return record.type != JOURNAL_RECORD_EMPTY && record.format == JOURNAL_FORMAT_VERSION && record.checksum == TelemetryJournal_checksum(record);
+}
+
+static bool TelemetryJournal_isErased(const JournalRecord& record) {
+	const uint8_t* Bytes = (const uint8_t*)&record;
+	for (size_t i = 0; i < sizeof(JournalRecord); i++) {
+		if (Bytes[i] != 0xFF)
+			return false;
+	}
+
+	return true;
+}
+
+static int16_t TelemetryJournal_centi(float value) {
+	if (!isfinite(value) || fabsf(value) > 327.67f)
+		return JOURNAL_NULL_VALUE;
+
+	return (int16_t)lroundf(value * 100.0f);
+}
+
+static float TelemetryJournal_fromCenti(int16_t value) {
+	return value == JOURNAL_NULL_VALUE ? NAN : value / 100.0f;
+}
+
+TelemetryJournal::TelemetryJournal() {
+	this->partition = nullptr;
+	this->hasMounted = false;
+	this->writePosition = { 0, 1 };
+	this->readPosition = { 0, 1 };
+	this->bootPosition = { 0, 1 };
+	this->oldestSequence = 0;
+	this->isClockSet = false;
+	this->clockUnixTime = 0;
+	this->clockMillis = 0;
+	this->appendedCount = 0;
+	this->uploadedCount = 0;
+	this->droppedCount = 0;
+	this->eraseCount = 0;
+}
+
+bool TelemetryJournal::begin() {
+	this->partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, JOURNAL_PARTITION_LABEL);
+	if (this->partition == nullptr) {
+		Serial.println("Journal partition not found, samples taken offline will be lost.");
+		return false;
+	}
+
+	if (this->partition->size < (uint32_t)JOURNAL_SECTOR_COUNT * JOURNAL_SECTOR_SIZE) {
+		Serial.println("Journal partition is smaller than JOURNAL_SECTOR_COUNT sectors.");
+		return false;
+	}
+
+	// A sector's sequence number also tells where it has to be, anything else is left over from something else
+	uint32_t Sequences[JOURNAL_SECTOR_COUNT];
+	bool IsValid[JOURNAL_SECTOR_COUNT];
+	bool HasNewest = false;
+	uint32_t Newest = 0;
+
+	for (uint32_t i = 0; i < JOURNAL_SECTOR_COUNT; i++) {
+		JournalRecord Header;
+		IsValid[i] = this->readRecord({ i, 0 }, Header) && TelemetryJournal_isValid(Header) && Header.type == JOURNAL_RECORD_HEADER && Header.value % JOURNAL_SECTOR_COUNT == i;
+		Sequences[i] = Header.value;
+
+		if (IsValid[i] && (!HasNewest || Header.value > Newest)) {
+			HasNewest = true;
+			Newest = Header.value;
+		}
+	}
+
+	this->hasMounted = true;
+
+	if (!HasNewest) {
+		Serial.println("No journal found, formatting.");
+		this->oldestSequence = 0;
+		this->readPosition = { 0, 1 };
+		if (!this->startSector(0)) {
+			return false;
+		}
+
+		this->bootPosition = this->writePosition;
+		return true;
+	}
+
+	// Sectors before the newest one in ring order, as far as they follow without a gap
+	uint32_t Oldest = Newest;
+	while (Oldest > 0 && Newest - (Oldest - 1) < JOURNAL_SECTOR_COUNT) {
+		uint32_t Index = (Oldest - 1) % JOURNAL_SECTOR_COUNT;
+		if (!IsValid[Index] || Sequences[Index] != Oldest - 1)
+			break;
+
+		Oldest--;
+	}
+
+	this->oldestSequence = Oldest;
+
+	// A torn record isn't erased either, appending goes on after it
+	this->writePosition = { Newest, JOURNAL_SLOTS_PER_SECTOR };
+	for (uint16_t Slot = 1; Slot < JOURNAL_SLOTS_PER_SECTOR; Slot++) {
+		JournalRecord Record;
+		if (this->readRecord({ Newest, Slot }, Record) && TelemetryJournal_isErased(Record)) {
+			this->writePosition = { Newest, Slot };
+			break;
+		}
+	}
+
+	// The newest cursor says how far the server has the samples, without one it has none of them
+	this->readPosition = { Oldest, 1 };
+	JournalPosition Position = this->writePosition;
+	while (Position.sequence > Oldest || Position.slot > 1) {
+		if (Position.slot > 1) {
+			Position.slot--;
+		}
+		else {
+			Position.sequence--;
+			Position.slot = JOURNAL_SLOTS_PER_SECTOR - 1;
+		}
+
+		JournalRecord Record;
+		if (!this->readRecord(Position, Record) || !TelemetryJournal_isValid(Record) || Record.type != JOURNAL_RECORD_CURSOR)
+			continue;
+
+		JournalPosition Cursor = { Record.value, Record.slot };
+		if (!isBefore(Cursor, this->readPosition))
+			this->readPosition = Cursor;
+
+		break;
+	}
+
+	this->bootPosition = this->writePosition;
+	return true;
+}
+
+bool TelemetryJournal::isMounted() {
+	return this->hasMounted;
+}
+
+void TelemetryJournal::setClock(uint32_t unixTime) {
+	this->isClockSet = true;
+	this->clockUnixTime = unixTime;
+	this->clockMillis = millis();
+}
+
+bool TelemetryJournal::hasClock() {
+	return this->isClockSet;
+}
+
+bool TelemetryJournal::append(const TelemetrySample& sample) {
+	JournalRecord Record = {};
+	Record.type = JOURNAL_RECORD_SAMPLE;
+	Record.flags = (sample.pumpMask != 0 ? JOURNAL_FLAG_PUMP : 0) | (sample.feederMask != 0 ? JOURNAL_FLAG_FOOD : 0); // Any pump, any feeder
+	Record.temperature = TelemetryJournal_centi(sample.temperature);
+	Record.humidity = TelemetryJournal_centi(sample.humidity);
+	Record.waterLevel = sample.waterLevel < INT16_MIN + 1 ? INT16_MIN + 1 : sample.waterLevel > INT16_MAX ? INT16_MAX : sample.waterLevel;
+
+	if (this->isClockSet) {
+		Record.value = this->clockUnixTime + (millis() - this->clockMillis) / 1000;
+	}
+	else {
+		Record.value = millis() / 1000;
+		Record.flags |= JOURNAL_FLAG_UPTIME;
+	}
+
+	if (!this->appendRecord(Record)) {
+		return false;
+	}
+
+	this->appendedCount++;
+	return true;
+}
+
+bool TelemetryJournal::hasPending() {
+	return this->hasMounted && isBefore(this->readPosition, this->writePosition);
+}
+
+size_t TelemetryJournal::read(JournalSample* samples, size_t count) {
+	size_t Count = 0;
+	JournalPosition Position = this->readPosition;
+
+	while (Count < count && this->hasMounted && isBefore(Position, this->writePosition)) {
+		JournalPosition RecordPosition = Position;
+		JournalRecord Record;
+		if (!this->readRecord(RecordPosition, Record)) {
+			break;
+		}
+
+		this->advance(Position);
+
+		// Headers and cursors in front of the samples don't have to be read again
+		if (!TelemetryJournal_isValid(Record) || Record.type != JOURNAL_RECORD_SAMPLE) {
+			if (Count == 0)
+				this->readPosition = Position;
+
+			continue;
+		}
+
+		uint32_t Time = Record.value;
+		if (Record.flags & JOURNAL_FLAG_UPTIME) {
+			// Only a sample of this boot can be put on the server clock
+			if (isBefore(RecordPosition, this->bootPosition) || !this->isClockSet) {
+				if (Count > 0)
+					break;
+
+				this->readPosition = Position;
+				this->droppedCount++;
+				continue;
+			}
+
+			Time = this->clockUnixTime - (this->clockMillis / 1000 - Record.value);
+		}
+
+		JournalSample& Sample = samples[Count++];
+		Sample.time = Time;
+		Sample.sample.temperature = TelemetryJournal_fromCenti(Record.temperature);
+		Sample.sample.humidity = TelemetryJournal_fromCenti(Record.humidity);
+		Sample.sample.waterLevel = Record.waterLevel;
+		Sample.sample.pumpMask = (Record.flags & JOURNAL_FLAG_PUMP) ? 1 : 0;
+		Sample.sample.feederMask = (Record.flags & JOURNAL_FLAG_FOOD) ? 1 : 0;
+		Sample.end = Position;
+	}
+
+	return Count;
+}
+
+bool TelemetryJournal::commit(const JournalPosition& end, size_t count) {
+	if (!this->hasMounted) {
+		return false;
+	}
+
+	// The oldest sector may have been erased meanwhile
+	if (isBefore(this->readPosition, end))
+		this->readPosition = end;
+
+	this->uploadedCount += count;
+
+	JournalRecord Cursor = {};
+	Cursor.type = JOURNAL_RECORD_CURSOR;
+	Cursor.value = this->readPosition.sequence;
+	Cursor.slot = this->readPosition.slot;
+	return this->appendRecord(Cursor);
+}
+
+uint32_t TelemetryJournal::getAppendedCount() {
+	return this->appendedCount;
+}
+
+uint32_t TelemetryJournal::getUploadedCount() {
+	return this->uploadedCount;
+}
+
+uint32_t TelemetryJournal::getDroppedCount() {
+	return this->droppedCount;
+}
+
+uint32_t TelemetryJournal::getEraseCount() {
+	return this->eraseCount;
+}
+
+bool TelemetryJournal::readRecord(const JournalPosition& position, JournalRecord& record) {
+	size_t Offset = (size_t)(position.sequence % JOURNAL_SECTOR_COUNT) * JOURNAL_SECTOR_SIZE + (size_t)position.slot * JOURNAL_RECORD_SIZE;
+	if (esp_partition_read(this->partition, Offset, &record, sizeof(record)) != ESP_OK) {
+		Serial.println("Failed to read the journal.");
+		return false;
+	}
+
+	return true;
+}
+
+bool TelemetryJournal::appendRecord(JournalRecord& record) {
+	if (!this->hasMounted) {
+		return false;
+	}
+
+	if (this->writePosition.slot >= JOURNAL_SLOTS_PER_SECTOR) {
+		uint32_t Next = this->writePosition.sequence + 1;
+
+		// The ring is full, the oldest sector makes room
+		if (Next - this->oldestSequence >= JOURNAL_SECTOR_COUNT) {
+			this->dropSector(this->oldestSequence);
+			this->oldestSequence++;
+		}
+
+		if (!this->startSector(Next)) {
+			return false;
+		}
+	}
+
+	record.format = JOURNAL_FORMAT_VERSION;
+	record.checksum = TelemetryJournal_checksum(record);
+
+	size_t Offset = (size_t)(this->writePosition.sequence % JOURNAL_SECTOR_COUNT) * JOURNAL_SECTOR_SIZE + (size_t)this->writePosition.slot * JOURNAL_RECORD_SIZE;
+
+	// The slot is used up even if the write fails halfway
+	this->writePosition.slot++;
+
+	if (esp_partition_write(this->partition, Offset, &record, sizeof(record)) != ESP_OK) {
+		Serial.println("Failed to write the journal.");
+		return false;
+	}
+
+	return true;
+}
+
+bool TelemetryJournal::startSector(uint32_t sequence) {
+	size_t Offset = (size_t)(sequence % JOURNAL_SECTOR_COUNT) * JOURNAL_SECTOR_SIZE;
+
+	// Stalls flash access for tens of milliseconds, once every JOURNAL_SLOTS_PER_SECTOR records
+	if (esp_partition_erase_range(this->partition, Offset, JOURNAL_SECTOR_SIZE) != ESP_OK) {
+		Serial.println("Failed to erase a journal sector, disabling the journal.");
+		this->hasMounted = false;
+		return false;
+	}
+
+	this->eraseCount++;
+	this->writePosition = { sequence, 0 };
+
+	JournalRecord Header = {};
+	Header.type = JOURNAL_RECORD_HEADER;
+	Header.value = sequence;
+	return this->appendRecord(Header);
+}
+
+void TelemetryJournal::dropSector(uint32_t sequence) {
+	if (this->readPosition.sequence > sequence) {
+		return;
+	}
+
+	JournalPosition Position = this->readPosition;
+	while (Position.sequence == sequence) {
+		JournalRecord Record;
+		if (this->readRecord(Position, Record) && TelemetryJournal_isValid(Record) && Record.type == JOURNAL_RECORD_SAMPLE)
+			this->droppedCount++;
+
+		this->advance(Position);
+	}
+
+	this->readPosition = Position;
+}
+
+void TelemetryJournal::advance(JournalPosition& position) {
+	position.slot++;
+	if (position.slot >= JOURNAL_SLOTS_PER_SECTOR) {
+		position.sequence++;
+		position.slot = 1;
+	}
+}
+
+bool TelemetryJournal::isBefore(const JournalPosition& a, const JournalPosition& b) {
+	return a.sequence < b.sequence || (a.sequence == b.sequence && a.slot < b.slot);
+}
\ No newline at end of file
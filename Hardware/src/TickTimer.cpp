@@ -1,11 +1,14 @@
 #include <TickTimer.h>
 #include <Arduino.h>
+#include "HALHooks.h"
 
 TickTimer::TickTimer() {
 	this->lastMicros = 0;
+	this->targetTickMicros = 0;
 }
 
 TickTimer::TickTimer(ulong tick_micros) {
+	this->lastMicros = 0;
 	this->targetTickMicros = tick_micros;
 }
 
@@ -26,13 +29,28 @@ bool TickTimer::shouldTick() {
 
 	if (this->lastMicros == 0) {
 		this->lastMicros = currentMicros;
+		HAL_hintWakeup(this->lastMicros + this->targetTickMicros);
 		return true; // First tick
 	}
 
 	if (currentMicros - this->lastMicros >= this->targetTickMicros) {
 		this->lastMicros = currentMicros;
+		HAL_hintWakeup(this->lastMicros + this->targetTickMicros);
 		return true;
 	}
-	
+
+	HAL_hintWakeup(this->lastMicros + this->targetTickMicros);
 	return false;
+}
+
+ulong TickTimer::getLastTickMicros() {
+	return this->lastMicros;
+}
+
+void TickTimer::setLastTickMicros(ulong last_micros) {
+	this->lastMicros = last_micros;
+}
+
+ulong TickTimer::getNextTickMicros() {
+	return this->lastMicros + this->targetTickMicros;
 }
\ No newline at end of file
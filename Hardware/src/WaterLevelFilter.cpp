@@ -0,0 +1,87 @@
+#include "WaterLevelFilter.h"
+
+static const uint16_t Calibration[] = WATER_LEVEL_CALIBRATION;
+
+#define CALIBRATION_POINTS (sizeof(Calibration) / sizeof(Calibration[0]))
+
+WaterLevelFilter::WaterLevelFilter() {
+	this->head = 0;
+	this->count = 0;
+	this->filtered = 0.0f;
+	this->hasFiltered = false;
+	this->percent = 0.0f;
+	this->full = false;
+}
+
+void WaterLevelFilter::push(uint16_t raw) {
+	this->window[this->head] = raw;
+	this->head = (this->head + 1) % WATER_LEVEL_WINDOW;
+
+	if (this->count < WATER_LEVEL_WINDOW)
+		this->count++;
+}
+
+void WaterLevelFilter::update() {
+	if (this->count == 0)
+		return;
+
+	// Insertion sort of a copy, the ring keeps arrival order
+	uint16_t Sorted[WATER_LEVEL_WINDOW];
+	for (uint8_t i = 0; i < this->count; i++) {
+		uint16_t Value = this->window[i];
+		int j = i;
+
+		while (j > 0 && Sorted[j - 1] > Value) {
+			Sorted[j] = Sorted[j - 1];
+			j--;
+		}
+
+		Sorted[j] = Value;
+	}
+
+	float Median = this->count % 2
+		? Sorted[this->count / 2]
+		: (Sorted[this->count / 2 - 1] + Sorted[this->count / 2]) / 2.0f;
+
+	// The first median starts the average instead of pulling it up from 0
+	if (this->hasFiltered) {
+		this->filtered += (Median - this->filtered) * WATER_LEVEL_EMA_ALPHA;
+	}
+	else {
+		this->filtered = Median;
+		this->hasFiltered = true;
+	}
+
+	this->percent = toPercent(this->filtered);
+
+	if (this->percent >= WATER_LEVEL_FULL_PERCENT)
+		this->full = true;
+	else if (this->percent < WATER_LEVEL_FULL_PERCENT - WATER_LEVEL_FULL_HYSTERESIS)
+		this->full = false;
+}
+
+float WaterLevelFilter::getFiltered() {
+	return this->filtered;
+}
+
+float WaterLevelFilter::getPercent() {
+	return this->percent;
+}
+
+bool WaterLevelFilter::isFull() {
+	return this->full;
+}
+
+float WaterLevelFilter::toPercent(float raw) {
+	float Step = 100.0f / (CALIBRATION_POINTS - 1);
+
+	if (raw <= Calibration[0])
+		return 0.0f;
+
+	for (size_t i = 1; i < CALIBRATION_POINTS; i++) {
+		if (raw <= Calibration[i])
+			return Step * (i - 1 + (raw - Calibration[i - 1]) / (Calibration[i] - Calibration[i - 1]));
+	}
+
+	return 100.0f;
+}
\ No newline at end of file
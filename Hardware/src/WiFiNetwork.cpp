@@ -1,20 +1,84 @@
 #include "WiFiNetwork.h"
-#include "TickTimer.h"
+#include "TelemetryEncoder.h"
 #include <lwip/sockets.h>
+#include <lwip/tcpip.h>
+#include <errno.h>
+#include <fcntl.h>
 
-TickTimer logicTimer(3000000); // 3 seconds initial delay
-TickTimer DisconnectedAnimationTimer(200000); // 200 ms
+#define DISCONNECTED_ANIMATION_INTERVAL 200000 // 200 ms
+#define CONNECTED_TICK_INTERVAL 200000 // 200 ms
+
+#define RESOLVE_PENDING 0
+#define RESOLVE_DONE 1
+#define RESOLVE_FAILED 2
 bool isWiFiBeginCalled = false;
 bool isWiFiConnectedLastStatus = false;
 
-WiFiNetwork::WiFiNetwork(const char* ssid, const char* password) : ws(wifiClient) {
+AdoptedClient::AdoptedClient() {
+	this->isAdopted = false;
+}
+
+void AdoptedClient::adopt(int fd) {
+	WiFiClient::operator=(WiFiClient(fd));
+	this->isAdopted = true;
+}
+
+int AdoptedClient::connect(const char* host, uint16_t port) {
+	// A blocking connect is what the state machine is there to avoid
+	if (!this->isAdopted)
+		return 0;
+
+	this->isAdopted = false;
+	return this->connected();
+}
+
+WiFiNetwork::WiFiNetwork(const char* ssid, const char* password) : outboundRing(WS_TX_OVERWRITE_OLDEST ? FRAME_RING_OVERWRITE_OLDEST : FRAME_RING_DROP_NEWEST), ws(wifiClient) {
 	this->ssid = ssid;
 	this->password = password;
-	this->wifiClient = WiFiClient();
 	this->messageCallback = nullptr;
-	this->writeBuffer = nullptr;
-	this->hasLoggedIn = false;
+	this->binaryMessageCallback = nullptr;
+	this->writingFrame = nullptr;
+	this->state = CONNECTION_BACKOFF; // With no delay, the first tick starts right away
+	this->stateMillis = 0;
+	this->backoffMillis = 0;
+	this->failureCount = 0;
+	this->socketFd = -1;
+	this->hasServerAddress = false;
+	this->serverAddress = 0;
+	this->resolvedMillis = 0;
+	this->resolveResult.store(RESOLVE_PENDING, std::memory_order_relaxed);
+	this->resolvedAddress.store(0, std::memory_order_relaxed);
+	this->isReconnecting = false;
+	this->lostMillis = 0;
+	this->lastTimeToReady.store(0, std::memory_order_relaxed);
+	this->maxTimeToReady.store(0, std::memory_order_relaxed);
+	this->connectAttemptCount.store(0, std::memory_order_relaxed);
+	this->publishedWiFiConnected.store(false, std::memory_order_relaxed);
+	this->publishedServerConnected.store(false, std::memory_order_relaxed);
 	this->hasSentLoginRequest = false;
+	this->useBinaryProtocol = false;
+	this->useCommandPush = false;
+	this->useTelemetryDelta = false;
+	this->useHistoryUpload = false;
+	this->loginCount = 0;
+	this->keyframeRequestCount = 0;
+	this->feederCount = 1;
+	this->pumpCount = 1;
+	this->scheduleRevision = 0;
+	this->rxLength = 0;
+	this->tickIntervalMicros = CONNECTED_TICK_INTERVAL;
+	this->connectAnimationFrame = 0;
+
+	#if ENABLE_LCD_OUTPUT == true
+		this->lcdRenderer = nullptr;
+		this->isOverlayShown = false;
+	#endif
+
+	#if ENABLE_TELEMETRY_JOURNAL == true
+		this->backfillEnd = { 0, 0 };
+		this->backfillCount = 0;
+		this->lastBackfillTime = 0;
+	#endif
 }
 
 void WiFiNetwork::setup() {
@@ -23,6 +87,11 @@ void WiFiNetwork::setup() {
 	}
 
 	isWiFiBeginCalled = true;
+
+	#if ENABLE_TELEMETRY_JOURNAL == true
+		this->journal.begin();
+	#endif
+
 	WiFi.mode(WIFI_STA);
 	WiFi.setAutoConnect(false);
 	WiFi.setAutoReconnect(true);
@@ -30,13 +99,15 @@ void WiFiNetwork::setup() {
 	WiFi.setSleep(WIFI_PS_NONE); // Disable WiFi power save mode
 }
 
-void WiFiNetwork::loop() {
+ulong WiFiNetwork::loop() {
 	if (WiFi.status() == WL_CONNECTED) {
-		if (!isWiFiConnectedLastStatus) {
-			#if ENABLE_LCD_OUTPUT == true
-				lcd.clear();
-			#endif
+		// The status screen shows through again, tried on every tick until the renderer took it
+		#if ENABLE_LCD_OUTPUT == true
+			if (this->isOverlayShown && this->lcdRenderer->clearOverlay())
+				this->isOverlayShown = false;
+		#endif
 
+		if (!isWiFiConnectedLastStatus) {
 			digitalWrite(2, LOW); // Turn off the LED_BUILTIN
 			Serial.println();
 			Serial.println("Connected to WiFi");
@@ -45,36 +116,26 @@ void WiFiNetwork::loop() {
 		}
 		isWiFiConnectedLastStatus = true;
 
-		if (logicTimer.shouldTick()) {
-			tick();
-		}
-
-		return;
+		tick();
+		this->publishStatus(true);
+		return this->tickIntervalMicros;
 	}
 
-	if (!DisconnectedAnimationTimer.shouldTick())
-		return;
-
-	#if ENABLE_LCD_OUTPUT == true
-		this->lcd.clear();
-		this->lcd.setCursor(0, 0);
-	#endif
-
-	int WIFI_CONNECT_DOT_ANIM = 0;
+	this->publishStatus(false);
 
 	// Construct the WiFi connection text with dots before printing
 	char wifiConnectText[LCD_COLUMNS_SIZE + 1];
 
 	// Generate repeated dots string
 	char dots[WIFI_CONNECT_DOT_MAX + 1];
-	for (int i = 0; i < WIFI_CONNECT_DOT_ANIM; ++i) {
+	for (int i = 0; i < this->connectAnimationFrame; ++i) {
 		dots[i] = '.';
 	}
 	// Fill the rest with spaces
-	for (int i = WIFI_CONNECT_DOT_ANIM; i < WIFI_CONNECT_DOT_MAX; ++i) {
+	for (int i = this->connectAnimationFrame; i < WIFI_CONNECT_DOT_MAX; ++i) {
 		dots[i] = ' ';
 	}
-	dots[WIFI_CONNECT_DOT_MAX + 1] = '\0';
+	dots[WIFI_CONNECT_DOT_MAX] = '\0';
 
 	snprintf(
 		wifiConnectText, 
@@ -83,9 +144,10 @@ void WiFiNetwork::loop() {
 		WIFI_CONNECT_TEXT,
 		dots);
 
+	// Only the dot that changed goes to the display, a frame the renderer hasn't taken yet is caught up by the next one
 	#if ENABLE_LCD_OUTPUT == true
-		this->lcd.setCursor(0, 0);
-		this->lcd.print(wifiConnectText);
+		if (this->lcdRenderer != nullptr && this->lcdRenderer->setOverlay(0, wifiConnectText))
+			this->isOverlayShown = true;
 	#endif
 
 	Serial.print("\r");
@@ -93,165 +155,672 @@ void WiFiNetwork::loop() {
 	Serial.flush();
 
 	digitalWrite(2, !digitalRead(2)); // D2 is LED_BUILTIN on ESP32
-	delay(200);
 
-	WIFI_CONNECT_DOT_ANIM++;
+	this->connectAnimationFrame++;
 
-	if (WIFI_CONNECT_DOT_ANIM > WIFI_CONNECT_DOT_MAX) {
-		WIFI_CONNECT_DOT_ANIM = 0;
+	if (this->connectAnimationFrame > WIFI_CONNECT_DOT_MAX) {
+		this->connectAnimationFrame = 0;
 	}
+
+	return DISCONNECTED_ANIMATION_INTERVAL;
 }
 
 void WiFiNetwork::tick() {
-	if (!this->ws.connected()) {
-		logicTimer.setTickMicros(5000000); // 5 seconds
-		if (this->hasLoggedIn) {
-			Serial.println("WebSocket disconnected, attempting to reconnect...");
-			this->hasLoggedIn = false;
-			this->hasSentLoginRequest = false;
-			this->ws.stop();
-			this->ws.~Client(); // Explicitly call the destructor to clean up the old instance
-			new (&this->ws) PicoWebsocket::Client(wifiClient);
-			return;
+	// Lost after the upgrade, e.g. closed by the server or by a request that timed out too often
+	if (this->state == CONNECTION_LOGIN || this->state == CONNECTION_READY) {
+		if (!this->ws.connected()) {
+			this->dropConnection();
 		}
-		
-		Serial.println("Connecting to WebSocket server...");
-
-		if (!ws.connect(WS_SERVER_ADDRESS, WS_SERVER_PORT)) {
-			Serial.println("Failed to connect WebSocket.");
-			return;
+		else if (this->state == CONNECTION_LOGIN && this->hasSentLoginRequest && millis() - this->stateMillis >= WS_LOGIN_TIMEOUT) {
+			// /login isn't retransmitted, a lost reply would wait forever
+			this->closeSession();
+			this->failAttempt("No reply to /login");
 		}
-		
-		#if WS_RTX_ON == true
-			this->wifiClient.setNoDelay(true); // Disable Nagle's algorithm for low latency
-			int keepAlive = 1;
-			this->wifiClient.setSocketOption(SOL_SOCKET, SO_KEEPALIVE, &keepAlive, sizeof(keepAlive)); // Enable TCP keepalive
-		#endif
+	}
+
+	switch (this->state) {
+		case CONNECTION_BACKOFF:
+			if (millis() - this->stateMillis >= this->backoffMillis)
+				this->startAttempt();
+			break;
+
+		case CONNECTION_RESOLVE:
+			this->pollResolve();
+			break;
+
+		case CONNECTION_CONNECT:
+			this->pollConnect();
+			break;
+
+		case CONNECTION_UPGRADE:
+			this->upgrade();
+			break;
+
+		default:
+			break;
+	}
+
+	if (this->state == CONNECTION_BACKOFF) {
+		ulong Elapsed = millis() - this->stateMillis;
+		ulong Remaining = Elapsed < this->backoffMillis ? this->backoffMillis - Elapsed : 1;
+		this->tickIntervalMicros = Remaining * 1000UL;
+		return;
+	}
+
+	if (this->state != CONNECTION_LOGIN && this->state != CONNECTION_READY) {
+		this->tickIntervalMicros = WS_CONNECT_POLL_INTERVAL;
 		return;
 	}
 
-	logicTimer.setTickMicros(200000); // Reset to 200 ms
+	this->tickIntervalMicros = CONNECTED_TICK_INTERVAL;
 	handleWebSocket();
 }
 
+void WiFiNetwork::startAttempt() {
+	this->connectAttemptCount.fetch_add(1, std::memory_order_relaxed);
+
+	if (!this->isReconnecting) {
+		this->isReconnecting = true;
+		this->lostMillis = millis();
+	}
+
+	Serial.println("Connecting to WebSocket server...");
+
+	if (this->hasServerAddress && millis() - this->resolvedMillis < WS_DNS_CACHE_TIME) {
+		this->beginConnect();
+		return;
+	}
+
+	this->hasServerAddress = false;
+	this->resolveResult.store(RESOLVE_PENDING, std::memory_order_relaxed);
+
+	// Posted to the lwIP thread, the answer comes back through onServerResolved() either way
+	if (tcpip_callback(WiFiNetwork::startResolve, this) != ERR_OK) {
+		this->failAttempt("DNS lookup failed");
+		return;
+	}
+
+	this->enterState(CONNECTION_RESOLVE);
+	this->pollResolve();
+}
+
+void WiFiNetwork::startResolve(void* arg) {
+	// Answered right away from the lwIP cache or for an address literal, otherwise later by onServerResolved()
+	ip_addr_t Address;
+	err_t Result = dns_gethostbyname(WS_SERVER_ADDRESS, &Address, WiFiNetwork::onServerResolved, arg);
+	if (Result == ERR_OK)
+		WiFiNetwork::onServerResolved(WS_SERVER_ADDRESS, &Address, arg);
+	else if (Result != ERR_INPROGRESS)
+		WiFiNetwork::onServerResolved(WS_SERVER_ADDRESS, nullptr, arg);
+}
+
+void WiFiNetwork::onServerResolved(const char* name, const ip_addr_t* address, void* arg) {
+	WiFiNetwork* Network = (WiFiNetwork*)arg;
+
+	// Only flags the answer, the network task takes it on its next tick. A late answer is still for the same name
+	if (address == nullptr) {
+		Network->resolveResult.store(RESOLVE_FAILED, std::memory_order_release);
+		return;
+	}
+
+	Network->resolvedAddress.store(ip4_addr_get_u32(ip_2_ip4(address)), std::memory_order_relaxed);
+	Network->resolveResult.store(RESOLVE_DONE, std::memory_order_release); // The address is visible once this is
+}
+
+void WiFiNetwork::pollResolve() {
+	uint8_t Result = this->resolveResult.load(std::memory_order_acquire);
+	if (Result == RESOLVE_DONE) {
+		this->serverAddress = this->resolvedAddress.load(std::memory_order_relaxed);
+		this->hasServerAddress = true;
+		this->resolvedMillis = millis();
+		this->beginConnect();
+		return;
+	}
+
+	if (Result == RESOLVE_FAILED) {
+		this->failAttempt("DNS lookup failed");
+		return;
+	}
+
+	if (millis() - this->stateMillis >= WS_RESOLVE_TIMEOUT) {
+		this->failAttempt("DNS lookup timed out");
+	}
+}
+
+void WiFiNetwork::beginConnect() {
+	int Fd = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (Fd < 0) {
+		this->failAttempt("No socket left");
+		return;
+	}
+
+	this->socketFd = Fd;
+	lwip_fcntl(Fd, F_SETFL, O_NONBLOCK);
+
+	struct sockaddr_in Address;
+	memset(&Address, 0, sizeof(Address));
+	Address.sin_family = AF_INET;
+	Address.sin_port = htons(WS_SERVER_PORT);
+	Address.sin_addr.s_addr = this->serverAddress;
+
+	if (lwip_connect(Fd, (struct sockaddr*)&Address, sizeof(Address)) < 0 && errno != EINPROGRESS) {
+		this->failAttempt("TCP connect failed");
+		return;
+	}
+
+	this->enterState(CONNECTION_CONNECT);
+}
+
+void WiFiNetwork::pollConnect() {
+	fd_set WriteSet;
+	FD_ZERO(&WriteSet);
+	FD_SET(this->socketFd, &WriteSet);
+	struct timeval NoWait = { 0, 0 };
+
+	// Writable once the handshake is over, either way
+	int Ready = lwip_select(this->socketFd + 1, nullptr, &WriteSet, nullptr, &NoWait);
+	if (Ready == 0) {
+		if (millis() - this->stateMillis >= WS_CONNECT_TIMEOUT) {
+			this->failAttempt("TCP connect timed out");
+		}
+		return;
+	}
+
+	int Error = 0;
+	socklen_t Length = sizeof(Error);
+	if (Ready < 0 || lwip_getsockopt(this->socketFd, SOL_SOCKET, SO_ERROR, &Error, &Length) < 0 || Error != 0) {
+		this->failAttempt("TCP connect failed");
+		return;
+	}
+
+	// Blocking again, like WiFiClient::connect() leaves its sockets
+	lwip_fcntl(this->socketFd, F_SETFL, lwip_fcntl(this->socketFd, F_GETFL, 0) & ~O_NONBLOCK);
+	this->wifiClient.adopt(this->socketFd);
+	this->socketFd = -1;
+	this->enterState(CONNECTION_UPGRADE);
+}
+
+void WiFiNetwork::upgrade() {
+	// One request and its reply on a connected socket, bounded by the read timeout
+	this->wifiClient.Stream::setTimeout(WS_UPGRADE_TIMEOUT);
+	if (!this->ws.connect(WS_SERVER_ADDRESS, WS_SERVER_PORT)) {
+		this->wifiClient.stop();
+		this->failAttempt("WebSocket upgrade failed");
+		return;
+	}
+
+	#if WS_RTX_ON == true
+		this->wifiClient.setNoDelay(true); // Disable Nagle's algorithm for low latency
+		int keepAlive = 1;
+		this->wifiClient.setSocketOption(SOL_SOCKET, SO_KEEPALIVE, &keepAlive, sizeof(keepAlive)); // Enable TCP keepalive
+	#endif
+
+	this->enterState(CONNECTION_LOGIN); // handleWebSocket() sends /login on this tick
+}
+
+void WiFiNetwork::failAttempt(const char* reason) {
+	if (this->socketFd >= 0) {
+		lwip_close(this->socketFd);
+		this->socketFd = -1;
+	}
+
+	if (this->failureCount < 255)
+		this->failureCount++;
+
+	this->startBackoff();
+
+	Serial.print(reason);
+	Serial.print(", retrying in ");
+	Serial.print(this->backoffMillis);
+	Serial.println(" ms.");
+}
+
+void WiFiNetwork::dropConnection() {
+	Serial.println("WebSocket disconnected, attempting to reconnect...");
+	this->closeSession();
+
+	// The server was fine a moment ago, retry soon but not all devices at once
+	this->failureCount = 0;
+	this->isReconnecting = true;
+	this->lostMillis = millis();
+	this->startBackoff();
+}
+
+void WiFiNetwork::closeSession() {
+	this->ws.stop();
+	this->hasSentLoginRequest = false;
+	this->useBinaryProtocol = false; // Negotiated again at /login
+	this->useCommandPush = false;
+	this->useTelemetryDelta = false;
+	this->useHistoryUpload = false;
+	this->rxLength = 0;
+	this->outboundRing.clear(); // The server expects /login first on the new connection
+	this->requestWindow.clear();
+}
+
+void WiFiNetwork::startBackoff() {
+	// WS_BACKOFF_MIN for the first failure, doubled for every one after it
+	uint8_t Doublings = this->failureCount > 0 ? this->failureCount - 1 : 0;
+	ulong Delay = WS_BACKOFF_MAX;
+	if (Doublings < 16 && ((ulong)WS_BACKOFF_MIN << Doublings) < WS_BACKOFF_MAX)
+		Delay = (ulong)WS_BACKOFF_MIN << Doublings;
+
+	Delay -= random(Delay * WS_BACKOFF_JITTER / 100 + 1);
+
+	this->backoffMillis = Delay;
+	this->enterState(CONNECTION_BACKOFF);
+}
+
+void WiFiNetwork::enterState(ConnectionState state) {
+	this->state = state;
+	this->stateMillis = millis();
+}
+
 void WiFiNetwork::handleWebSocket() {
-	while (this->ws.available()) {
-		String message = this->ws.readStringUntil('\r');
+	#if ENABLE_METRICS == true
+		MetricsTimer Timer(METRICS_WEBSOCKET);
+	#endif
+
+	while (true) {
+		this->receiveAvailable();
 
-		if (message.length() == 0) {
+		size_t Consumed = 0;
+		if (!this->handleInboundMessage(Consumed)) {
+			this->rxLength = 0; // The connection was dropped
+			return;
+		}
+
+		if (Consumed == 0) {
 			break;
 		}
 
-		digitalWrite(2, LOW); // LED_BUILTIN on ESP32
+		// Usually nothing is left, a reply that arrived together with the next one is moved to the front
+		this->rxLength -= Consumed;
+		memmove(this->rxBuffer, this->rxBuffer + Consumed, this->rxLength);
+	}
 
-		// Parse JSON
+	// If we haven't logged in yet, send the login message
+	if (this->state == CONNECTION_LOGIN && !this->hasSentLoginRequest) {
 		JsonDocument doc;
-		DeserializationError error = deserializeJson(doc, message);
-		if (error) {
-			Serial.print("Failed to parse JSON: ");
-			Serial.println(error.c_str());
-			this->ws.stop();
-			return;
+		doc["key"] = "/login";
+		doc["data"]["kind"] = "iot";
+		doc["data"]["iot_hwid"] = WS_SERVER_HW_ID;
+		doc["data"]["feeders"] = this->feederCount;
+		doc["data"]["pumps"] = this->pumpCount;
+
+		#if WS_BINARY_PROTOCOL == true
+			doc["data"]["binary"] = BINARY_PROTOCOL_VERSION;
+		#endif
+
+		#if WS_COMMAND_PUSH == true
+			doc["data"]["push"] = COMMAND_PUSH_VERSION;
+		#endif
+
+		#if WS_TELEMETRY_DELTA == true
+			doc["data"]["delta"] = TELEMETRY_DELTA_VERSION;
+		#endif
+
+		#if ENABLE_TELEMETRY_JOURNAL == true
+			doc["data"]["history"] = TELEMETRY_JOURNAL_VERSION;
+		#endif
+
+		#if ENABLE_FEEDING_SCHEDULE == true
+			doc["data"]["schedule"] = FEEDING_SCHEDULE_VERSION;
+			doc["data"]["schedule_rev"] = this->scheduleRevision;
+		#endif
+		
+		// Bypass login check to send login request, retried next tick if the ring is full
+		if (this->sendJSON(doc, true)) {
+			this->hasSentLoginRequest = true;
+			this->stateMillis = millis(); // WS_LOGIN_TIMEOUT counts from here
 		}
+	}
 
-		if (doc["status"].isNull() || doc["code"].isNull() || doc["endpoint"].isNull()) {
-			Serial.println("Received message without status, code, or endpoint fields.");
-			this->ws.stop();
-			return;
+	if (!this->retransmitExpired()) {
+		return;
+	}
+
+	#if ENABLE_TELEMETRY_JOURNAL == true
+		this->backfillJournal();
+	#endif
+
+	// Send everything queued since the last tick, one WebSocket frame each
+	const char* Frame;
+	size_t FrameSize;
+	while ((Frame = this->outboundRing.peek(FrameSize)) != nullptr) {
+		size_t bytesWritten = this->ws.write((const uint8_t*)Frame, FrameSize);
+		this->outboundRing.release(bytesWritten > 0);
+
+		if (bytesWritten == 0) {
+			Serial.println("Failed to send JSON data to WebSocket server.");
+			break;
 		}
+	}
+}
 
-		const char* status = doc["status"].as<const char*>();
-		int code = doc["code"].as<int>();
-		const char* endpoint = doc["endpoint"].as<const char*>();
-
-		if (strcmp(status, "error") == 0) {
-			Serial.print("Error (code ");
-			Serial.print(code);
-			Serial.print("): ");
-			if (!doc["error_message"].isNull()) {
-				Serial.print(doc["error_message"].as<String>());
-			}
-			Serial.println();
+void WiFiNetwork::receiveAvailable() {
+	// Never blocks, a reply split across ticks is completed on a later one
+	while (this->rxLength < WS_RX_BUFFER_SIZE && this->ws.available() > 0) {
+		int Count = this->ws.read((uint8_t*)this->rxBuffer + this->rxLength, WS_RX_BUFFER_SIZE - this->rxLength);
+		if (Count <= 0) {
+			break;
+		}
+
+		this->rxLength += Count;
+	}
+}
+
+bool WiFiNetwork::retransmitExpired() {
+	ulong Now = millis();
 
+	RequestSlot* Slot;
+	while ((Slot = this->requestWindow.nextExpired(Now)) != nullptr) {
+		// The server is gone even if the socket doesn't know yet, start over with a new connection
+		if (Slot->retransmits >= WS_REQUEST_RETRIES) {
+			Serial.println("Request timed out too often, dropping the connection.");
 			this->ws.stop();
-			return;
+			return false;
 		}
 
-		// If status isn't "success", something is wrong on the server side
-		if (strcmp(status, "success") != 0) {
-			Serial.print("Unexpected status received: ");
-			Serial.println(status);
-			this->ws.stop();
-			return;
+		// Same bytes and request ID, the server answers a copy it has seen from its reply cache
+		char* Frame = this->outboundRing.beginWrite();
+		if (Frame == nullptr) {
+			break;
 		}
 
-		// If code is not on the 2xx range, treat it as an error
-		if (code < 200 || code >= 300) {
-			Serial.print("Unsupported code received: ");
-			Serial.println(code);
-			this->ws.stop();
-			return;
+		memcpy(Frame, Slot->frame, Slot->size);
+		this->outboundRing.commitWrite(Slot->size);
+		this->requestWindow.markRetransmitted(Slot, Now);
+	}
+
+	return true;
+}
+
+#if ENABLE_TELEMETRY_JOURNAL == true
+void WiFiNetwork::backfillJournal() {
+	if (!this->useHistoryUpload || !this->journal.hasPending() || this->requestWindow.isPending(INBOUND_ENDPOINT_POST_HISTORY)) {
+		return;
+	}
+
+	// Live requests go first, a batch only takes the last free slot of the window if nothing else is in flight
+	if (millis() - this->lastBackfillTime < JOURNAL_BACKFILL_INTERVAL || (this->requestWindow.size() > 0 && this->requestWindow.size() + 1 >= this->requestWindow.getLimit())) {
+		return;
+	}
+
+	JournalSample Samples[BINARY_POST_HISTORY_MAX_SAMPLES];
+	size_t Count = this->journal.read(Samples, BINARY_POST_HISTORY_MAX_SAMPLES);
+	if (Count == 0) {
+		return;
+	}
+
+	char* Frame = this->beginFrame(false);
+	if (Frame == nullptr) {
+		return;
+	}
+
+	// JSON fits fewer, the rest goes with the next batch
+	size_t Encoded;
+	size_t Size;
+	if (this->useBinaryProtocol) {
+		Size = BinaryProtocol_encodeHistory(Samples, Count, Encoded, (uint8_t*)Frame, WS_TX_FRAME_SIZE);
+	}
+	else {
+		Size = TelemetryEncoder_encodeHistory(Samples, Count, Encoded, Frame, REQUEST_JSON_CAPACITY);
+	}
+
+	if (Size == 0) {
+		this->abortFrame();
+		return;
+	}
+
+	if (!this->commitRequest(Size, INBOUND_ENDPOINT_POST_HISTORY)) {
+		return;
+	}
+
+	this->backfillEnd = Samples[Encoded - 1].end;
+	this->backfillCount = Encoded;
+	this->lastBackfillTime = millis();
+}
+#endif
+
+bool WiFiNetwork::matchReply(uint16_t requestId, uint32_t endpointHash) {
+	// Anything without ID that no request waits for was pushed by the server
+	if (requestId == REQUEST_ID_NONE && !this->requestWindow.isPending(endpointHash)) {
+		return true;
+	}
+
+	return this->requestWindow.complete(requestId, endpointHash);
+}
+
+bool WiFiNetwork::handleInboundMessage(size_t& consumed) {
+	consumed = 0;
+
+	if (this->rxLength == 0) {
+		return true;
+	}
+
+	// Binary replies carry their length
+	if ((uint8_t)this->rxBuffer[0] == BINARY_PROTOCOL_MAGIC) {
+		BinaryReply Reply;
+		if (this->rxLength < BINARY_REPLY_HEADER_SIZE) {
+			return true;
 		}
-		
-		// Check if doc["data"] exists
-		if (!doc["data"].is<JsonObject>()) {
-			Serial.println("No data field in the message.");
-			return;
+
+		BinaryProtocol_decodeReplyHeader((const uint8_t*)this->rxBuffer, Reply);
+		if (this->rxLength < (size_t)(BINARY_REPLY_HEADER_SIZE + Reply.length)) {
+			return true;
 		}
 
-		// If this is a login reply, set hasLoggedIn to true
-		if (strcmp(endpoint, "/login") == 0) {
-			this->hasLoggedIn = true;
-			Serial.println("Logged in successfully.");
-			return;
+		Reply.payload = (const uint8_t*)this->rxBuffer + BINARY_REPLY_HEADER_SIZE;
+		consumed = BINARY_REPLY_HEADER_SIZE + Reply.length;
+		return this->handleBinaryReply(Reply);
+	}
+
+	// JSON replies are terminated by a "\r" frame
+	char* Terminator = (char*)memchr(this->rxBuffer, '\r', this->rxLength);
+	if (Terminator == nullptr) {
+		if (this->rxLength < WS_RX_BUFFER_SIZE) {
+			return true;
 		}
 
-		// If this isn't a login reply but we haven't logged in yet
-		if (!this->hasLoggedIn) {
-			Serial.println("Received message before logging in");
-			this->ws.stop();
-			return;
+		Serial.println("Received a message larger than WS_RX_BUFFER_SIZE.");
+		this->ws.stop();
+		return false;
+	}
+
+	consumed = Terminator - this->rxBuffer + 1;
+
+	// A "\r" on its own carries nothing
+	if (consumed == 1) {
+		return true;
+	}
+
+	return this->handleJsonReply(this->rxBuffer, consumed - 1);
+}
+
+bool WiFiNetwork::handleJsonReply(char* text, size_t size) {
+	digitalWrite(2, LOW); // LED_BUILTIN on ESP32
+
+	// Parsed in place, the strings point into rxBuffer until the next message
+	InboundMessage message;
+	if (!InboundMessage_parse(text, size, message)) {
+		Serial.println("Failed to parse JSON.");
+		this->ws.stop();
+		return false;
+	}
+
+	if (message.statusHash == 0 || message.code == 0 || message.endpoint == nullptr) {
+		Serial.println("Received message without status, code, or endpoint fields.");
+		this->ws.stop();
+		return false;
+	}
+
+	if (message.statusHash == INBOUND_STATUS_ERROR) {
+		Serial.print("Error (code ");
+		Serial.print(message.code);
+		Serial.print("): ");
+		if (message.errorMessage != nullptr) {
+			Serial.print(message.errorMessage);
 		}
+		Serial.println();
 
-		// If a message callback is set, call it with the received JSON document
-		if (this->messageCallback == nullptr) {
-			Serial.println("No message callback set, ignoring message.");
-			return;
+		this->ws.stop();
+		return false;
+	}
+
+	// If status isn't "success", something is wrong on the server side
+	if (message.statusHash != INBOUND_STATUS_SUCCESS) {
+		Serial.println("Unexpected status received.");
+		this->ws.stop();
+		return false;
+	}
+
+	// If code is not on the 2xx range, treat it as an error
+	if (message.code < 200 || message.code >= 300) {
+		Serial.print("Unsupported code received: ");
+		Serial.println(message.code);
+		this->ws.stop();
+		return false;
+	}
+
+	if (!message.hasData) {
+		Serial.println("No data field in the message.");
+		return true;
+	}
+
+	// If this is a login reply, the connection is ready
+	if (message.endpointHash == INBOUND_ENDPOINT_LOGIN) {
+		this->enterState(CONNECTION_READY);
+		this->failureCount = 0;
+
+		if (this->isReconnecting) {
+			this->isReconnecting = false;
+			ulong TimeToReady = millis() - this->lostMillis;
+			this->lastTimeToReady.store(TimeToReady, std::memory_order_relaxed);
+			if (TimeToReady > this->maxTimeToReady.load(std::memory_order_relaxed))
+				this->maxTimeToReady.store(TimeToReady, std::memory_order_relaxed);
 		}
 
-		this->messageCallback(doc);
+		#if WS_BINARY_PROTOCOL == true
+			// An older server ignores the offer and keeps talking JSON
+			this->useBinaryProtocol = message.getInt(INBOUND_KEY_BINARY) == BINARY_PROTOCOL_VERSION;
+		#endif
+
+		#if WS_COMMAND_PUSH == true
+			this->useCommandPush = message.getInt(INBOUND_KEY_PUSH) == COMMAND_PUSH_VERSION;
+		#endif
+
+		#if WS_TELEMETRY_DELTA == true
+			this->useTelemetryDelta = message.getInt(INBOUND_KEY_DELTA) == TELEMETRY_DELTA_VERSION;
+		#endif
+
+		#if ENABLE_TELEMETRY_JOURNAL == true
+			// Journaled samples need the server clock, taken before this they only know the time since boot
+			this->useHistoryUpload = message.getInt(INBOUND_KEY_HISTORY) == TELEMETRY_JOURNAL_VERSION;
+			if (message.getUnsigned(INBOUND_KEY_TIME) != 0)
+				this->journal.setClock(message.getUnsigned(INBOUND_KEY_TIME));
+		#endif
+
+		this->loginCount++;
+
+		Serial.println(this->useBinaryProtocol ? "Logged in successfully, using binary frames." : "Logged in successfully.");
+
+		// Passed on as well, e.g. for the server clock
+		if (this->messageCallback != nullptr)
+			this->messageCallback(message);
+
+		return true;
 	}
 
-	// If we haven't logged in yet, send the login message
-	if (!this->hasLoggedIn && !this->hasSentLoginRequest) {
-		JsonDocument doc;
-		doc["key"] = "/login";
-		doc["data"]["kind"] = "iot";
-		doc["data"]["iot_hwid"] = WS_SERVER_HW_ID;
-		
-		this->sendJSON(doc, true); // Bypass login check to send login request
-		this->hasSentLoginRequest = true;
+	// If this isn't a login reply but we haven't logged in yet
+	if (this->state != CONNECTION_READY) {
+		Serial.println("Received message before logging in");
+		this->ws.stop();
+		return false;
 	}
 
-	// Copy the writeBuffer so we can empty it immediately
-	char* bufferToSend = this->writeBuffer;
-	size_t bufferToSendSize = this->writeBufferSize;
-	if (bufferToSend == nullptr) {
-		return;
+	if (!this->matchReply(message.requestId, message.endpointHash)) {
+		return true;
 	}
 
-	this->writeBuffer = nullptr; // Clear the writeBuffer to prevent re-sending
-	this->writeBufferSize = 0;
+	// The server missed a delta before this one, the connection is fine
+	if (message.endpointHash == INBOUND_ENDPOINT_POST_DATA && message.code == TELEMETRY_KEYFRAME_REQUEST_CODE) {
+		this->keyframeRequestCount++;
+	}
 
-	size_t bytesWritten = this->ws.write((const uint8_t*)bufferToSend, bufferToSendSize);
-	if (bytesWritten > 0) {
-		// Serial.println("Sent JSON data to WebSocket server.");
+	#if ENABLE_TELEMETRY_JOURNAL == true
+		// Only one batch is in flight, its samples are on the server now
+		if (message.endpointHash == INBOUND_ENDPOINT_POST_HISTORY) {
+			this->journal.commit(this->backfillEnd, this->backfillCount);
+			return true;
+		}
+	#endif
+
+	// If a message callback is set, call it with the received message
+	if (this->messageCallback == nullptr) {
+		Serial.println("No message callback set, ignoring message.");
+		return true;
 	}
-	else {
-		Serial.println("Failed to send JSON data to WebSocket server.");
+
+	this->messageCallback(message);
+	return true;
+}
+
+bool WiFiNetwork::handleBinaryReply(const BinaryReply& reply) {
+	digitalWrite(2, LOW); // LED_BUILTIN on ESP32
+
+	// Same handling as a JSON error reply, the payload is the error message
+	if (reply.code < 200 || reply.code >= 300) {
+		Serial.print("Error (code ");
+		Serial.print(reply.code);
+		Serial.print("): ");
+		Serial.write(reply.payload, reply.length);
+		Serial.println();
+
+		this->ws.stop();
+		return false;
 	}
 
-	delete[] bufferToSend;
+	// Binary frames are only negotiated at /login
+	if (this->state != CONNECTION_READY || !this->useBinaryProtocol) {
+		Serial.println("Received a binary reply that wasn't negotiated");
+		this->ws.stop();
+		return false;
+	}
+
+	uint32_t EndpointHash = INBOUND_ENDPOINT_POST_DATA;
+	if (reply.type == BINARY_GET_DATA) {
+		EndpointHash = INBOUND_ENDPOINT_GET_DATA;
+	}
+	else if (reply.type == BINARY_PUSH_COMMAND) {
+		EndpointHash = INBOUND_ENDPOINT_PUSH_COMMAND;
+	}
+	else if (reply.type == BINARY_POST_HISTORY) {
+		EndpointHash = INBOUND_ENDPOINT_POST_HISTORY;
+	}
+
+	if (!this->matchReply(reply.requestId, EndpointHash)) {
+		return true;
+	}
+
+	if (EndpointHash == INBOUND_ENDPOINT_POST_DATA && reply.code == TELEMETRY_KEYFRAME_REQUEST_CODE) {
+		this->keyframeRequestCount++;
+	}
+
+	#if ENABLE_TELEMETRY_JOURNAL == true
+		if (EndpointHash == INBOUND_ENDPOINT_POST_HISTORY) {
+			this->journal.commit(this->backfillEnd, this->backfillCount);
+			return true;
+		}
+	#endif
+
+	if (this->binaryMessageCallback == nullptr) {
+		Serial.println("No binary message callback set, ignoring message.");
+		return true;
+	}
+
+	this->binaryMessageCallback(reply);
+	return true;
 }
 
 bool WiFiNetwork::isConnected() {
@@ -262,8 +831,62 @@ bool WiFiNetwork::isServerConnected() {
 	return ws.connected();
 }
 
+bool WiFiNetwork::wasConnected() {
+	return this->publishedWiFiConnected.load(std::memory_order_relaxed);
+}
+
+bool WiFiNetwork::wasServerConnected() {
+	return this->publishedServerConnected.load(std::memory_order_relaxed);
+}
+
+// Only the network task touches the client, everyone else gets the flags
+void WiFiNetwork::publishStatus(bool isWiFiConnected) {
+	this->publishedWiFiConnected.store(isWiFiConnected, std::memory_order_relaxed);
+	this->publishedServerConnected.store(ws.connected(), std::memory_order_relaxed);
+}
+
 bool WiFiNetwork::isLoggedIn() {
-	return this->hasLoggedIn;
+	return this->state == CONNECTION_READY;
+}
+
+bool WiFiNetwork::isBinaryProtocol() {
+	return this->useBinaryProtocol;
+}
+
+bool WiFiNetwork::isCommandPush() {
+	return this->useCommandPush;
+}
+
+bool WiFiNetwork::isTelemetryDelta() {
+	return this->useTelemetryDelta;
+}
+
+bool WiFiNetwork::isHistoryUpload() {
+	return this->useHistoryUpload;
+}
+
+uint32_t WiFiNetwork::getLoginCount() {
+	return this->loginCount;
+}
+
+uint32_t WiFiNetwork::getKeyframeRequestCount() {
+	return this->keyframeRequestCount;
+}
+
+ConnectionState WiFiNetwork::getConnectionState() {
+	return this->state;
+}
+
+uint32_t WiFiNetwork::getConnectAttemptCount() {
+	return this->connectAttemptCount.load(std::memory_order_relaxed);
+}
+
+ulong WiFiNetwork::getLastTimeToReady() {
+	return this->lastTimeToReady.load(std::memory_order_relaxed);
+}
+
+ulong WiFiNetwork::getMaxTimeToReady() {
+	return this->maxTimeToReady.load(std::memory_order_relaxed);
 }
 
 bool WiFiNetwork::sendJSON(JsonDocument& doc) {
@@ -271,33 +894,140 @@ bool WiFiNetwork::sendJSON(JsonDocument& doc) {
 }
 
 bool WiFiNetwork::sendJSON(JsonDocument& doc, bool bypass_login_check) {
-	if (!this->isServerConnected()) {
-		Serial.println("WebSocket is not connected, cannot send JSON.");
+	char* Frame = this->beginFrame(bypass_login_check);
+	if (Frame == nullptr) {
 		return false;
 	}
 
-	// If we aren't logged in yet, we cannot send JSON
-	if (!this->hasLoggedIn && !bypass_login_check) {
+	// Serialize straight into the slot, a frame that filled it completely may have been cut off
+	size_t Size = serializeJson(doc, Frame, WS_TX_FRAME_SIZE);
+	if (Size >= WS_TX_FRAME_SIZE - 1 && measureJson(doc) >= WS_TX_FRAME_SIZE) {
+		this->abortFrame();
+		Serial.println("JSON is larger than WS_TX_FRAME_SIZE, dropping it.");
 		return false;
 	}
 
-	// If writeBuffer is not yet clear, wait
-	if (this->writeBuffer != nullptr) {
-		Serial.println("Write buffer is not empty, unable to send new JSON yet.");
-		return false;
+	this->commitFrame(Size);
+	return true;
+}
+
+char* WiFiNetwork::beginFrame(bool bypass_login_check) {
+	if (!this->isServerConnected()) {
+		Serial.println("WebSocket is not connected, cannot send JSON.");
+		return nullptr;
+	}
+
+	// If we aren't logged in yet, we cannot send JSON
+	if (this->state != CONNECTION_READY && !bypass_login_check) {
+		return nullptr;
 	}
 
-	String jsonString;
-	serializeJson(doc, jsonString);
+	char* Frame = this->outboundRing.beginWrite();
+	if (Frame == nullptr) {
+		Serial.println("Outbound frame ring is full, dropping JSON.");
+		return nullptr;
+	}
 
-	this->writeBuffer = new char[jsonString.length() + 1];
-	strcpy(this->writeBuffer, jsonString.c_str());
-	this->writeBufferSize = jsonString.length();
+	this->writingFrame = Frame;
+	return Frame;
+}
 
+void WiFiNetwork::commitFrame(size_t size) {
+	this->outboundRing.commitWrite(size);
 	digitalWrite(2, HIGH); // LED_BUILTIN on ESP32
+}
+
+void WiFiNetwork::abortFrame() {
+	this->outboundRing.abortWrite();
+}
+
+bool WiFiNetwork::canSendRequest() {
+	return !this->requestWindow.isFull();
+}
+
+bool WiFiNetwork::isRequestPending(uint32_t endpointHash) {
+	return this->requestWindow.isPending(endpointHash);
+}
+
+bool WiFiNetwork::commitRequest(size_t size, uint32_t endpointHash) {
+	char* Frame = this->writingFrame;
+	uint16_t Id = this->requestWindow.nextId();
+
+	if (size >= BINARY_REQUEST_HEADER_SIZE && (uint8_t)Frame[0] == BINARY_PROTOCOL_MAGIC) {
+		Frame[BINARY_REQUEST_ID_OFFSET] = Id & 0xFF;
+		Frame[BINARY_REQUEST_ID_OFFSET + 1] = Id >> 8;
+	}
+	else {
+		// JSON gets "id" as its last member, written over the closing brace
+		if (size == 0 || Frame[size - 1] != '}' || size - 1 + sizeof(REQUEST_ID_JSON_SUFFIX) - 1 + REQUEST_ID_MAX_LENGTH + 1 > WS_TX_FRAME_SIZE) {
+			this->abortFrame();
+			Serial.println("Request has no room for its ID, dropping it.");
+			return false;
+		}
+
+		char* Cursor = Frame + size - 1;
+		memcpy(Cursor, REQUEST_ID_JSON_SUFFIX, sizeof(REQUEST_ID_JSON_SUFFIX) - 1);
+		Cursor += sizeof(REQUEST_ID_JSON_SUFFIX) - 1;
+
+		char Digits[REQUEST_ID_MAX_LENGTH];
+		int Count = 0;
+		uint16_t Value = Id;
+		do {
+			Digits[Count++] = '0' + Value % 10;
+			Value /= 10;
+		} while (Value > 0);
+
+		while (Count > 0) {
+			*Cursor++ = Digits[--Count];
+		}
+
+		*Cursor++ = '}';
+		size = Cursor - Frame;
+	}
+
+	if (!this->requestWindow.add(Id, endpointHash, Frame, size, millis())) {
+		this->abortFrame();
+		Serial.println("Request window is full, dropping request.");
+		return false;
+	}
+
+	this->commitFrame(size);
 	return true;
 }
 
-void WiFiNetwork::setOnMessageCallback(void (*callback)(const JsonDocument& doc)) {
+void WiFiNetwork::setOnMessageCallback(void (*callback)(const InboundMessage& message)) {
 	this->messageCallback = callback;
-}
\ No newline at end of file
+}
+
+void WiFiNetwork::setOnBinaryMessageCallback(void (*callback)(const BinaryReply& reply)) {
+	this->binaryMessageCallback = callback;
+}
+
+void WiFiNetwork::setActuatorCounts(uint8_t feeders, uint8_t pumps) {
+	this->feederCount = feeders;
+	this->pumpCount = pumps;
+}
+
+void WiFiNetwork::setScheduleRevision(uint32_t revision) {
+	this->scheduleRevision = revision;
+}
+
+FrameRing& WiFiNetwork::getOutboundRing() {
+	return this->outboundRing;
+}
+
+RequestWindow& WiFiNetwork::getRequestWindow() {
+	return this->requestWindow;
+}
+
+#if ENABLE_TELEMETRY_JOURNAL == true
+TelemetryJournal& WiFiNetwork::getJournal() {
+	return this->journal;
+}
+#endif
+
+#if ENABLE_LCD_OUTPUT == true
+void WiFiNetwork::setLCDRenderer(LCDRenderer* lcdRenderer) {
+	this->lcdRenderer = lcdRenderer;
+}
+#endif
\ No newline at end of file
@@ -1,25 +1,54 @@
 #include <Arduino.h>
-#include "TickTimer.h"
+#include "Scheduler.h"
 #include "InputRelated.h"
 #include "config.h"
 #include "BusinessLogic.h"
+#include "ActuatorRegistry.h"
 
 BusinessLogic businessLogic;
+ActuatorRegistry actuators;
+Scheduler scheduler;
+
+#if ENABLE_WIFI == true && ENABLE_DUAL_CORE == true
+	Scheduler networkScheduler; // Run by the network task, or from loop() if it couldn't be created
+	TaskHandle_t networkTaskHandle = nullptr;
+	void NetworkTask(void* parameter);
+#else
+	Scheduler& networkScheduler = scheduler;
+#endif
 
-TickTimer HardwareReportingTimer(1000000); // 1 second
 void Serial_StatusReport();
 
 #if ENABLE_WIFI == true
 	#include "WiFiNetwork.h"
 
 	WiFiNetwork wifiNetwork(WIFI_SSID, WIFI_PASSWORD);
-	void OnWebSocketMessage(const JsonDocument& doc);
+	void OnWebSocketMessage(const InboundMessage& message);
+	void OnWebSocketBinaryMessage(const BinaryReply& reply);
+
+	#if ENABLE_FEEDING_SCHEDULE == true
+		void OnFeedingSchedule(const InboundMessage& message);
+	#endif
+#endif
+
+#if ENABLE_METRICS == true
+	#include "Metrics.h"
+#endif
+
+#if ENABLE_WIFI == true && ENABLE_METRICS == true
+	// Where the next /iot/metrics frame carries on, 0 between reports
+	int metricsCursor = 0;
 #endif
 
 #if ENABLE_LCD_OUTPUT == true
 	#include <Wire.h>
 	#include <LiquidCrystal_I2C.h>
+	#include "I2CBus.h"
+	#include "LCDRenderer.h"
 
+	I2CBus i2cBus;
+	LiquidCrystal_I2C lcd(PCF8574_ADDR_A21_A11_A01, 4, 5, 6, 16, 11, 12, 13, 14, POSITIVE);
+	LCDRenderer lcdRenderer(lcd, i2cBus);
 	bool isLCDInitialized = false;
 	void LCD_StatusReport();
 #endif
@@ -28,8 +57,6 @@ void Serial_StatusReport();
 
 #if ENABLE_SERVO == true
 	#include <ServoManager.h>
-
-	ServoManager* pServoManager;
 #endif
 
 #pragma endregion
@@ -52,31 +79,153 @@ void ReadSensors() {
 
 	#if ENABLE_WATER_LEVEL_SENSOR == true
 		businessLogic.waterLevel = waterLevel1.readPercent();
+		businessLogic.filteredWaterLevel = waterLevel1.readFilteredPercent();
+		businessLogic.isWaterFull = waterLevel1.isFull();
 	#endif
 }
 
 #pragma endregion
 
-#if ENABLE_LCD_OUTPUT == true
-	LiquidCrystal_I2C lcd(PCF8574_ADDR_A21_A11_A01, 4, 5, 6, 16, 11, 12, 13, 14, POSITIVE);
+#pragma region Scheduler Tasks
+
+#if ENABLE_WIFI == true
+	ulong Task_Network() {
+		#if ENABLE_METRICS == true
+			MetricsTimer Timer(METRICS_NETWORK);
+		#endif
+
+		return wifiNetwork.loop();
+	}
+
+	#if ENABLE_METRICS == true
+		// One frame per run, a report spreads over a few seconds instead of taking the request window
+		ulong Task_Metrics() {
+			if (!wifiNetwork.isLoggedIn() || !wifiNetwork.canSendRequest())
+				return 1000000;
+
+			// Without ENABLE_DUAL_CORE both are the same scheduler
+			Scheduler* Schedulers[] = { &scheduler, &networkScheduler };
+			int SchedulerCount = &networkScheduler == &scheduler ? 1 : 2;
+
+			char* Frame = wifiNetwork.beginFrame(false);
+			if (Frame == nullptr)
+				return 1000000;
+
+			size_t Size = Metrics_encodeReport(Schedulers, SchedulerCount, metricsCursor, Frame, REQUEST_JSON_CAPACITY);
+			if (Size == 0) {
+				wifiNetwork.abortFrame();
+				metricsCursor = 0;
+				return METRICS_REPORT_INTERVAL;
+			}
+
+			wifiNetwork.commitRequest(Size, INBOUND_ENDPOINT_METRICS);
+
+			if (metricsCursor < Metrics_getRowCount(Schedulers, SchedulerCount))
+				return 1000000;
+
+			metricsCursor = 0;
+			return METRICS_REPORT_INTERVAL;
+		}
+	#endif
+
+	ulong Task_Interaction() {
+		businessLogic.interaction_loop();
+		return 0;
+	}
 #endif
 
+#if ENABLE_DHT == true
+	ulong Task_DHT() {
+		return dht1.update();
+	}
+#endif
+
+#if ENABLE_WATER_LEVEL_SENSOR == true
+	ulong Task_WaterLevel() {
+		waterLevel1.update();
+		return 0;
+	}
+#endif
+
+#if ENABLE_SERVO == true
+	int servoTaskId = -1;
+	bool isServoTaskAsleep = false;
+
+	ulong Task_Servo() {
+		ServoManager_loop();
+
+		// Nothing to do while no servo ramps and the backend keeps up the pulses, Task_BusinessLogic wakes it for the next ramp
+		isServoTaskAsleep = !pServoBackend->needsRefresh() && actuators.feeders.movingMask == 0;
+		return isServoTaskAsleep ? 1000000 : SERVO_TICK_INTERVAL;
+	}
+#endif
+
+#if ENABLE_LCD_OUTPUT == true && I2C_ASYNC == true
+	// Owns the bus, screens presented by other tasks go out a slice of bus time at a time
+	ulong Task_I2C() {
+		if (isLCDInitialized)
+			lcdRenderer.flush();
+
+		// A control task itself, no more than the time before the next one is due either
+		ulong Budget = I2C_DRAIN_BUDGET > i2cBus.getMaxTransactionMicros() ? I2C_DRAIN_BUDGET : i2cBus.getMaxTransactionMicros();
+		if (scheduler.getSlackMicros() < Budget)
+			Budget = scheduler.getSlackMicros();
+
+		i2cBus.drain(Budget);
+		return i2cBus.getQueuedCount() > 0 ? I2C_DRAIN_INTERVAL : I2C_IDLE_INTERVAL;
+	}
+#endif
+
+ulong Task_BusinessLogic() {
+	ReadSensors();
+	businessLogic.pre_actuator_loop();
+
+	#if ENABLE_SERVO == true && SERVO_VELOCITY > 0
+		if (isServoTaskAsleep && actuators.feeders.movingMask != 0) {
+			scheduler.wakeTask(servoTaskId, SERVO_TICK_INTERVAL);
+			isServoTaskAsleep = false;
+		}
+	#endif
+
+	return 0;
+}
+
+ulong Task_HardwareReport() {
+	Serial_StatusReport();
+
+	#if ENABLE_LCD_OUTPUT == true
+		LCD_StatusReport();
+	#endif
+
+	return 0;
+}
+
+#pragma endregion
+
 void setup() {
 	Serial.begin(115200);
 
 	pinMode(2, OUTPUT); // D2 is LED_BUILTIN on ESP32
 
+	#if ENABLE_METRICS == true
+		Metrics_setup();
+	#endif
+
 	#if ENABLE_WATER_PUMP == true
-		pinMode(WATER_PUMP_PIN, OUTPUT);
-		digitalWrite(WATER_PUMP_PIN, HIGH); // Ensure the pump is off at startup
+		// Ensure the pumps are off at startup
+		const gpio_num_t PumpPins[] = WATER_PUMP_PINS;
+		for (size_t i = 0; i < sizeof(PumpPins) / sizeof(PumpPins[0]); i++) {
+			actuators.addPump(PumpPins[i], WATER_PUMP_ENABLE_TIMEOUT);
+		}
 	#endif
 
+	businessLogic.setActuatorRegistry(&actuators);
+
 	#if ENABLE_LCD_OUTPUT == true
 		if (lcd.begin(LCD_COLUMNS_SIZE, LCD_ROWS_SIZE, LCD_5x8DOTS) == 1) // columns, rows, characters size
 			isLCDInitialized = true;
 
 		if (isLCDInitialized) {
-			lcd.clear();
 			char firstLine[17];
 			snprintf(
 				firstLine,
@@ -85,8 +234,7 @@ void setup() {
 				ESP.getFreeHeap() / 1024
 			);
 
-			lcd.setCursor(0, 0);
-			lcd.print(firstLine);
+			lcdRenderer.print(0, 0, firstLine);
 
 			char secondLine[17];
 
@@ -98,12 +246,18 @@ void setup() {
 					"CPU    : %d MHz",
 					ESP.getCpuFreqMHz()
 				);
-				lcd.setCursor(0, 1);
-				lcd.print(secondLine);
+				lcdRenderer.print(0, 1, secondLine);
+				lcdRenderer.present();
+
+				#if I2C_ASYNC == true
+					lcdRenderer.flush();
+					i2cBus.drainAll(); // Nothing else runs yet
+				#endif
+
 				delay(100);
 			}
 
-			lcd.clear();
+			lcdRenderer.clear(); // Blanked by the next flush, as far as the next screen doesn't cover it
 		}
 	#endif
 
@@ -116,69 +270,205 @@ void setup() {
 	#endif
 
 	#if ENABLE_SERVO == true
-		pServoManager = new ServoManager(SERVO1_PIN);
-		pServoManager->setup();
-		pServoManager->Rotate(SERVO_CLOSE_ANGLE);
+		// Registered closed
+		const gpio_num_t FeederPins[] = FEEDER_PINS;
+		for (size_t i = 0; i < sizeof(FeederPins) / sizeof(FeederPins[0]); i++) {
+			actuators.addFeeder(FeederPins[i], SERVO_OPEN_TIMEOUT);
+		}
+
+		ServoManager_setup(&actuators.feeders);
 	#endif
 
 	#if ENABLE_WIFI == true
 		wifiNetwork.setOnMessageCallback(OnWebSocketMessage);
+		wifiNetwork.setOnBinaryMessageCallback(OnWebSocketBinaryMessage);
+
+		#if ENABLE_LCD_OUTPUT == true
+			if (isLCDInitialized)
+				wifiNetwork.setLCDRenderer(&lcdRenderer);
+		#endif
+
+		wifiNetwork.setActuatorCounts(actuators.feeders.count, actuators.pumps.count);
 		wifiNetwork.setup();
 		businessLogic.setWiFiNetworkInstance(&wifiNetwork);
-		businessLogic.setServoManagerInstance(pServoManager);
+	#endif
+
+	#if ENABLE_FEEDING_SCHEDULE == true
+		// Feeds from the table kept in flash as soon as a /login brings the clock, with or without the server after that
+		FeedingScheduleTable ScheduleTable;
+		if (FeedingSchedule_loadTable(ScheduleTable)) {
+			businessLogic.postFeedingSchedule(ScheduleTable);
+
+			#if ENABLE_WIFI == true
+				wifiNetwork.setScheduleRevision(ScheduleTable.revision);
+			#endif
+		}
+	#endif
+
+	// Registration order breaks ties between tasks due at the same time
+	#if ENABLE_WIFI == true
+		networkScheduler.addTask("network", Task_Network, 200000); // Period is decided by WiFiNetwork::loop()
+	#endif
+
+	#if ENABLE_DHT == true
+		scheduler.addTask("dht", Task_DHT, DHT_READ_INTERVAL);
+	#endif
+
+	#if ENABLE_WATER_LEVEL_SENSOR == true
+		scheduler.addTask("water_level", Task_WaterLevel, WATER_LEVEL_SAMPLE_INTERVAL);
+	#endif
+
+	scheduler.addTask("logic", Task_BusinessLogic, 100000); // 0.1 second
+
+	#if ENABLE_WIFI == true
+		networkScheduler.addTask("interaction", Task_Interaction, businessLogic.getInteractionIntervalMicros());
+	#endif
+
+	#if ENABLE_SERVO == true
+		if (pServoBackend->needsRefresh() || SERVO_VELOCITY > 0)
+			servoTaskId = scheduler.addTask("servo", Task_Servo, SERVO_TICK_INTERVAL); // Also the ramp step
+	#endif
+
+	scheduler.addTask("report", Task_HardwareReport, 1000000); // 1 second
+
+	#if ENABLE_WIFI == true && ENABLE_METRICS == true
+		networkScheduler.addTask("metrics", Task_Metrics, METRICS_REPORT_INTERVAL);
+	#endif
+
+	#if ENABLE_LCD_OUTPUT == true && I2C_ASYNC == true
+		scheduler.addTask("i2c", Task_I2C, I2C_IDLE_INTERVAL); // With the control tasks, so the display keeps up while the network stalls
+	#endif
+
+	#if ENABLE_WIFI == true && ENABLE_DUAL_CORE == true
+		// loop() stays on the application core as the control loop
+		if (xTaskCreatePinnedToCore(NetworkTask, "network", NETWORK_TASK_STACK_SIZE, nullptr, NETWORK_TASK_PRIORITY, &networkTaskHandle, NETWORK_TASK_CORE) != pdPASS) {
+			networkTaskHandle = nullptr;
+			Serial.println("Failed to create the network task, running it from loop() instead. A WebSocket upgrade holds the control tasks up while it waits.");
+		}
 	#endif
 
 	Serial.println("Setup complete.");
 }
 
 void loop() {
-	#if ENABLE_WIFI == true
-		wifiNetwork.loop();
+	#if ENABLE_METRICS == true
+		MetricsTimer Timer(METRICS_LOOP);
+	#endif
+
+	// Network first, so commands it receives are applied by the control tasks due at the same time
+	#if ENABLE_WIFI == true && ENABLE_DUAL_CORE == true
+		ulong NetworkIdleMicros = networkTaskHandle == nullptr ? networkScheduler.run() : (ulong)-1;
 	#endif
 
-	bool ShouldBusinessLogicTick = businessLogic.should_loop_tick();
+	ulong IdleMicros = scheduler.run();
 
-	if (ShouldBusinessLogicTick) {
-		businessLogic.pre_sensor_read_loop();
-	}
+	#if ENABLE_WIFI == true && ENABLE_DUAL_CORE == true
+		if (NetworkIdleMicros < IdleMicros)
+			IdleMicros = NetworkIdleMicros;
+	#endif
 
-	ReadSensors();
+	#if ENABLE_METRICS == true
+		Timer.stop();
+	#endif
 
-	if (ShouldBusinessLogicTick) {
-		businessLogic.pre_actuator_loop();
+	// Hand the time until the next deadline to FreeRTOS instead of spinning
+	if (IdleMicros >= 1000) {
+		delay(IdleMicros / 1000);
 	}
+}
 
-	#if ENABLE_SERVO == true
-		ServoManager_loop();
-	#endif
+#if ENABLE_WIFI == true && ENABLE_DUAL_CORE == true
+void NetworkTask(void* parameter) {
+	for (;;) {
+		ulong IdleMicros = networkScheduler.run();
 
-	if (ShouldBusinessLogicTick) {
-		businessLogic.pre_hardware_report_loop();
+		// Always block for at least a tick so the idle task of this core can feed the watchdog
+		delay(IdleMicros >= 1000 ? IdleMicros / 1000 : 1);
 	}
+}
+#endif
 
-	if (HardwareReportingTimer.shouldTick()) {
-		Serial_StatusReport();
+#if ENABLE_WIFI == true
+void OnWebSocketMessage(const InboundMessage& message) {
+	// Handle incoming WebSocket messages, the endpoint was hashed while parsing
+	// WiFiNetwork already matched replies to their requests, a /iot/post_data reply carries nothing else
+	switch (message.endpointHash) {
+		case INBOUND_ENDPOINT_GET_DATA:
+		case INBOUND_ENDPOINT_PUSH_COMMAND: {
+			// A server without per-actuator IDs only sends the booleans, they stand for actuator 0
+			ActuatorCommand Command;
+			Command.pumpMask = message.getBool(INBOUND_KEY_SHOULD_ENABLE_WATER_PUMP) ? 1 : 0;
+			Command.feederMask = message.getBool(INBOUND_KEY_SHOULD_DISPENSE_FOOD) ? 1 : 0;
+
+			if (message.find(INBOUND_KEY_PUMPS) != nullptr)
+				Command.pumpMask = message.getUnsigned(INBOUND_KEY_PUMPS);
+
+			if (message.find(INBOUND_KEY_FEEDERS) != nullptr)
+				Command.feederMask = message.getUnsigned(INBOUND_KEY_FEEDERS);
+
+			businessLogic.postActuatorCommand(Command);
+			break;
+		}
 
-		#if ENABLE_LCD_OUTPUT == true
-			LCD_StatusReport();
+		#if ENABLE_FEEDING_SCHEDULE == true
+			case INBOUND_ENDPOINT_LOGIN:
+				// The schedule runs on the server clock, and keeps going on it while offline
+				if (message.getUnsigned(INBOUND_KEY_TIME) != 0)
+					businessLogic.postScheduleClock(message.getUnsigned(INBOUND_KEY_TIME));
+				break;
+
+			case INBOUND_ENDPOINT_PUSH_SCHEDULE:
+				OnFeedingSchedule(message);
+				break;
 		#endif
 	}
 }
 
-#if ENABLE_WIFI == true
-void OnWebSocketMessage(const JsonDocument& doc) {
-	// Handle incoming WebSocket messages
-
-	if (doc["endpoint"] == "/iot/get_data") {
-		// Foreach
-		businessLogic.shouldEnableWaterPump = doc["data"]["shouldEnableWaterPump"].as<bool>();
-		businessLogic.shouldDispenseFood = doc["data"]["shouldDispenseFood"].as<bool>();
-		businessLogic.isWaitingForServerActuatorData = false;
-		businessLogic.shouldPushOrPull = true; // Switch to push mode after receiving data
+#if ENABLE_FEEDING_SCHEDULE == true
+// Pushed whole after /login if the revision offered there is out of date, and whenever the dashboard changes it
+void OnFeedingSchedule(const InboundMessage& message) {
+	const InboundField* Entries = message.find(INBOUND_KEY_ENTRIES);
+	if (Entries == nullptr || Entries->type != INBOUND_STRING) {
+		Serial.println("Received a feeding schedule without entries.");
+		return;
+	}
+
+	FeedingScheduleTable Table = {};
+	Table.revision = message.getUnsigned(INBOUND_KEY_REVISION);
+	Table.utcOffset = (int16_t)message.getInt(INBOUND_KEY_UTC_OFFSET);
+
+	int Count = FeedingSchedule_decodeEntries(Entries->string, Table.entries, SCHEDULE_MAX_ENTRIES);
+	if (Count < 0 || Table.utcOffset < -720 || Table.utcOffset > 840) {
+		Serial.println("Received a malformed feeding schedule.");
+		return;
 	}
-	else if (doc["endpoint"] == "/iot/post_data") {
-		businessLogic.isWaitingForServerReportACK = false;
-		businessLogic.shouldPushOrPull = false; // Switch to pull mode after receiving data
+
+	Table.entryCount = (uint8_t)Count;
+
+	// The feeders are registered in setup(), before the network runs
+	for (int i = 0; i < Count; i++) {
+		if (Table.entries[i].feeder >= actuators.feeders.count) {
+			Serial.println("Received a feeding schedule for a feeder this device doesn't have.");
+			return;
+		}
+	}
+
+	// Kept even if flash fails, only a reboot would lose it
+	FeedingSchedule_saveTable(Table);
+	wifiNetwork.setScheduleRevision(Table.revision);
+	businessLogic.postFeedingSchedule(Table);
+}
+#endif
+
+void OnWebSocketBinaryMessage(const BinaryReply& reply) {
+	if (reply.type == BINARY_GET_DATA || reply.type == BINARY_PUSH_COMMAND) {
+		ActuatorCommand Command;
+		if (!BinaryProtocol_decodeActuatorCommand(reply, Command)) {
+			Serial.println("Received a malformed binary actuator command.");
+			return;
+		}
+
+		businessLogic.postActuatorCommand(Command);
 	}
 }
 #endif
@@ -198,18 +488,51 @@ void Serial_StatusReport() {
 
 	#if ENABLE_WIFI == true
 		Serial.print("WiFi Status: ");
-		Serial.println(wifiNetwork.isConnected() ? "Connected" : "Disconnected");
+		Serial.println(wifiNetwork.wasConnected() ? "Connected" : "Disconnected");
 
 		Serial.print("WebSocket Status: ");
 		#if WS_RTX_ON == true
-			Serial.println(wifiNetwork.isServerConnected() ? "Connected (RTX)" : "Disconnected");
+			Serial.println(wifiNetwork.wasServerConnected() ? "Connected (RTX)" : "Disconnected");
 		#else
-			Serial.println(wifiNetwork.isServerConnected() ? "Connected (Normal)" : "Disconnected");
+			Serial.println(wifiNetwork.wasServerConnected() ? "Connected (Normal)" : "Disconnected");
+		#endif
+
+		Serial.print("Time to Ready: ");
+		Serial.print(wifiNetwork.getLastTimeToReady());
+		Serial.print(" ms (max ");
+		Serial.print(wifiNetwork.getMaxTimeToReady());
+		Serial.print(" ms, ");
+		Serial.print(wifiNetwork.getConnectAttemptCount());
+		Serial.println(" attempts)");
+	#endif
+
+	if (actuators.pumps.count <= 1) {
+		Serial.print("Water Pump: ");
+		Serial.println(actuators.pumps.enabledMask != 0 ? "ON" : "OFF");
+	}
+	else {
+		Serial.print("Water Pumps ON:");
+		for (uint8_t i = 0; i < actuators.pumps.count; i++) {
+			if (actuators.pumps.enabledMask & (1UL << i)) {
+				Serial.print(" ");
+				Serial.print(i);
+			}
+		}
+		Serial.println();
+	}
+
+	#if SCHEDULER_SERIAL_STATS == true
+		scheduler.printStats();
+
+		#if ENABLE_WIFI == true && ENABLE_DUAL_CORE == true
+			networkScheduler.printStats();
 		#endif
 	#endif
 
-	Serial.print("Water Pump: ");
-	Serial.println(businessLogic.waterPumpEnabled ? "ON" : "OFF");
+	#if ENABLE_METRICS == true && METRICS_SERIAL_STATS == true
+		Serial.println("Latency:");
+		Metrics_print();
+	#endif
 }
 
 #if ENABLE_LCD_OUTPUT == true
@@ -218,49 +541,20 @@ void LCD_StatusReport() {
 	if (!isLCDInitialized)
 		return;
 
-	int TemperatureStrlen = snprintf(nullptr, 0, LCD_TEMP_FORMAT, businessLogic.temperature);
-	char TemperatureStr[TemperatureStrlen + 1];
-	snprintf(TemperatureStr, sizeof(TemperatureStr), LCD_TEMP_FORMAT, businessLogic.temperature);
-
-	int HumidityStrlen = snprintf(nullptr, 0, LCD_HUMIDITY_FORMAT, int(businessLogic.humidity));
-	char HumidityStr[HumidityStrlen + 1];
-	snprintf(HumidityStr, sizeof(HumidityStr), LCD_HUMIDITY_FORMAT, int(businessLogic.humidity));
+	char Text[LCD_COLUMNS_SIZE + 1];
+	lcdRenderer.clear();
 
-	int WaterLevelStrlen = snprintf(nullptr, 0, LCD_WATER_LEVEL_FORMAT, businessLogic.waterLevel);
-	char WaterLevelStr[WaterLevelStrlen + 1];
-	snprintf(WaterLevelStr, sizeof(WaterLevelStr), LCD_WATER_LEVEL_FORMAT, businessLogic.waterLevel);
+	// Temperature on the left of the first line, humidity on the right
+	snprintf(Text, sizeof(Text), LCD_TEMP_FORMAT, businessLogic.temperature);
+	lcdRenderer.print(0, 0, Text);
 
-	char firstLine[17];
+	snprintf(Text, sizeof(Text), LCD_HUMIDITY_FORMAT, int(businessLogic.humidity));
+	lcdRenderer.printRight(0, Text);
 
-	int MiddleBorder = (LCD_COLUMNS_SIZE - TemperatureStrlen - HumidityStrlen);
-
-	// Put temperature on first line
-	snprintf(firstLine, sizeof(firstLine), "%s", TemperatureStr);
-
-	// Fill the middle with spaces
-	for (int i = 0; i < MiddleBorder; i++) {
-		firstLine[TemperatureStrlen + i] = ' ';
-	}
-
-	// Put humidity after temperature on first line
-	strncpy(firstLine + TemperatureStrlen + MiddleBorder, HumidityStr, HumidityStrlen);
-
-	lcd.setCursor(0, 0);
-	lcd.print(firstLine);
-
-	char secondLine[17];
-
-	// Put water level
-	snprintf(secondLine, sizeof(secondLine), "%s", WaterLevelStr);
-
-	// Fill the rest of the line with spaces
-	for (int i = WaterLevelStrlen; i < LCD_COLUMNS_SIZE; i++) {
-		secondLine[i] = ' ';
-	}
-	secondLine[LCD_COLUMNS_SIZE] = '\0'; // Ensure null termination
+	snprintf(Text, sizeof(Text), LCD_WATER_LEVEL_FORMAT, businessLogic.waterLevel);
+	lcdRenderer.print(0, 1, Text);
 
-	lcd.setCursor(0, 1);
-	lcd.print(secondLine);
+	lcdRenderer.present();
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include <unity.h>
+#include "DHTFrame.h"
+
+// DHT11 answers as the edge interrupt timestamps them, with the datasheet pulse widths: 0 is 26-28 us high, 1 is 70 us
+struct DHTWaveform {
+	const char* name;
+	uint8_t bytes[5];
+	uint32_t startMicros; // Of the release of the start signal
+	uint32_t zeroHighMicros;
+	uint32_t oneHighMicros;
+	uint32_t jitterMicros; // Added to or taken from every pulse in turn
+	int missedEdge; // Index of an edge the interrupt didn't see, -1 for none
+	size_t edgeLimit; // Capture window closed after this many edges
+	DHTFrameStatus status;
+	float temperature;
+	float humidity;
+};
+
+static const DHTWaveform DHTWaveforms[] = {
+	{ "typical", { 60, 0, 27, 0, 87 }, 1000000, 27, 70, 0, -1, DHT_FRAME_MAX_EDGES, DHT_FRAME_OK, 27.0f, 60.0f },
+	{ "slow sensor", { 45, 0, 23, 4, 72 }, 5000000, 28, 74, 3, -1, DHT_FRAME_MAX_EDGES, DHT_FRAME_OK, 23.4f, 45.0f },
+	{ "below zero", { 31, 0, 5, 0x83, 0xA7 }, 9000000, 26, 68, 2, -1, DHT_FRAME_MAX_EDGES, DHT_FRAME_OK, -5.3f, 31.0f },
+	{ "micros() wraps", { 72, 0, 30, 1, 103 }, 0xFFFFFE00, 27, 70, 1, -1, DHT_FRAME_MAX_EDGES, DHT_FRAME_OK, 30.1f, 72.0f },
+	{ "bad checksum", { 60, 0, 27, 0, 88 }, 1000000, 27, 70, 0, -1, DHT_FRAME_MAX_EDGES, DHT_FRAME_BAD_CHECKSUM, 0.0f, 0.0f },
+	{ "missed edge", { 60, 0, 27, 0, 87 }, 1000000, 27, 70, 0, 40, DHT_FRAME_MAX_EDGES, DHT_FRAME_BAD_CHECKSUM, 0.0f, 0.0f },
+	{ "truncated", { 60, 0, 27, 0, 87 }, 1000000, 27, 70, 0, -1, 60, DHT_FRAME_TOO_FEW_EDGES, 0.0f, 0.0f },
+	{ "stretched pulse", { 60, 0, 27, 0, 87 }, 1000000, 27, 120, 0, -1, DHT_FRAME_MAX_EDGES, DHT_FRAME_BAD_PULSE, 0.0f, 0.0f }
+};
+
+#define DHT_WAVEFORM_COUNT (sizeof(DHTWaveforms) / sizeof(DHTWaveforms[0]))
+
+// Release, response, 40 bits and the end of the frame, the way DHT11Sensor::onEdge() stores them
+static size_t BuildDHTEdges(const DHTWaveform& waveform, uint32_t* edges) {
+	uint32_t Times[DHT_FRAME_MAX_EDGES];
+	size_t Count = 0;
+	uint32_t Time = waveform.startMicros;
+	int Jitter = waveform.jitterMicros;
+
+	Times[Count++] = Time;
+	Time += 30;
+	Times[Count++] = Time;
+	Time += 80;
+	Times[Count++] = Time;
+	Time += 80;
+	Times[Count++] = Time;
+
+	for (int i = 0; i < DHT_FRAME_BITS; i++) {
+		bool Bit = waveform.bytes[i / 8] & (0x80 >> (i % 8));
+		Jitter = -Jitter;
+		Time += 50 + Jitter;
+		Times[Count++] = Time;
+		Time += (Bit ? waveform.oneHighMicros : waveform.zeroHighMicros) - Jitter;
+		Times[Count++] = Time;
+	}
+
+	Time += 50;
+	Times[Count++] = Time;
+
+	size_t Stored = 0;
+	for (size_t i = 0; i < Count && Stored < waveform.edgeLimit; i++) {
+		if ((int)i != waveform.missedEdge)
+			edges[Stored++] = Times[i];
+	}
+
+	return Stored;
+}
+
+static DHTFrameStatus Decode(const DHTWaveform& waveform, DHTReading& reading) {
+	uint32_t Edges[DHT_FRAME_MAX_EDGES];
+	size_t Count = BuildDHTEdges(waveform, Edges);
+	return DHTFrame_decode(Edges, Count, reading);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// Every waveform comes out with its status, and the good ones with their temperature and humidity
+void test_waveforms_decode_as_expected() {
+	for (const DHTWaveform& Waveform : DHTWaveforms) {
+		DHTReading Reading = {};
+		TEST_ASSERT_EQUAL_INT_MESSAGE(Waveform.status, Decode(Waveform, Reading), Waveform.name);
+
+		if (Waveform.status != DHT_FRAME_OK)
+			continue;
+
+		TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.05f, Waveform.temperature, Reading.temperature, Waveform.name);
+		TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.05f, Waveform.humidity, Reading.humidity, Waveform.name);
+	}
+}
+
+// A frame that fails leaves the previous reading alone, so the sensor keeps its last good values
+void test_failed_frame_keeps_reading() {
+	for (const DHTWaveform& Waveform : DHTWaveforms) {
+		if (Waveform.status == DHT_FRAME_OK)
+			continue;
+
+		DHTReading Reading = { 21.5f, 40.0f };
+		Decode(Waveform, Reading);
+		TEST_ASSERT_EQUAL_FLOAT_MESSAGE(21.5f, Reading.temperature, Waveform.name);
+		TEST_ASSERT_EQUAL_FLOAT_MESSAGE(40.0f, Reading.humidity, Waveform.name);
+	}
+}
+
+// Edges of the start signal before the answer don't shift the bits, only the last 81 count
+void test_leading_edges_ignored() {
+	uint32_t Edges[DHT_FRAME_MAX_EDGES];
+	size_t Count = BuildDHTEdges(DHTWaveforms[0], Edges + 6);
+	for (int i = 0; i < 6; i++) {
+		Edges[i] = DHTWaveforms[0].startMicros - 1000 + i * 3;
+	}
+
+	DHTReading Reading = {};
+	TEST_ASSERT_EQUAL_INT(DHT_FRAME_OK, DHTFrame_decode(Edges, Count + 6, Reading));
+	TEST_ASSERT_FLOAT_WITHIN(0.05f, 27.0f, Reading.temperature);
+	TEST_ASSERT_FLOAT_WITHIN(0.05f, 60.0f, Reading.humidity);
+}
+
+int main(int argc, char** argv) {
+	NativeHAL::setSerialQuiet(true);
+
+	UNITY_BEGIN();
+	RUN_TEST(test_waveforms_decode_as_expected);
+	RUN_TEST(test_failed_frame_keeps_reading);
+	RUN_TEST(test_leading_edges_ignored);
+	return UNITY_END();
+}
\ No newline at end of file
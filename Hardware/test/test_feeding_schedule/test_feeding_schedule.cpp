@@ -0,0 +1,332 @@
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include <unity.h>
+#include "config.h"
+#include "FeedingSchedule.h"
+
+#define SUNDAY_MIDNIGHT_UTC 1760227200 // 2025-10-12 00:00 UTC, a Sunday
+#define SCAN_ENTRIES 4000
+#define POLL_STEP 7 // Seconds between polls, so polls land on every second of the minute over time
+
+static const int16_t Offsets[] = { 0, 420, -300, 345, -720, 840 };
+
+// Same numbers on every run
+static uint32_t RandomState = 1;
+static float Uniform() {
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 17;
+	RandomState ^= RandomState << 5;
+	return (RandomState >> 8) / 16777216.0f;
+}
+
+static ScheduleEntry RandomEntry() {
+	ScheduleEntry Entry;
+	Entry.minute = (uint16_t)(Uniform() * SCHEDULE_MINUTES_PER_DAY);
+	Entry.weekdays = 1 + (uint8_t)(Uniform() * SCHEDULE_EVERY_DAY);
+	Entry.feeder = (uint8_t)(Uniform() * ACTUATOR_MAX_COUNT);
+	Entry.openMillis = 100 + (uint16_t)(Uniform() * 900);
+	return Entry;
+}
+
+// Feeders of every entry due at a minute boundary, the way a person would read the table
+static uint32_t Reference(const FeedingScheduleTable& table, uint32_t unixTime) {
+	uint16_t WeekMinute = FeedingSchedule_weekMinute(unixTime, table.utcOffset);
+	uint32_t Due = 0;
+
+	for (uint8_t i = 0; i < table.entryCount; i++) {
+		const ScheduleEntry& Entry = table.entries[i];
+		if (Entry.minute == WeekMinute % SCHEDULE_MINUTES_PER_DAY && (Entry.weekdays & (1 << (WeekMinute / SCHEDULE_MINUTES_PER_DAY))))
+			Due |= 1UL << Entry.feeder;
+	}
+
+	return Due;
+}
+
+// A full table of random entries, with some right at the day boundaries and two feeders at the same minute
+static FeedingScheduleTable RandomTable(int16_t utcOffset) {
+	FeedingScheduleTable Table = {};
+	Table.revision = 1;
+	Table.utcOffset = utcOffset;
+	Table.entryCount = SCHEDULE_MAX_ENTRIES;
+	for (uint8_t i = 0; i < SCHEDULE_MAX_ENTRIES; i++) {
+		Table.entries[i] = RandomEntry();
+	}
+
+	Table.entries[0].minute = 0;
+	Table.entries[1].minute = SCHEDULE_MINUTES_PER_DAY - 1;
+	Table.entries[2].minute = Table.entries[3].minute;
+	Table.entries[2].weekdays = Table.entries[3].weekdays = SCHEDULE_EVERY_DAY;
+	Table.entries[3].feeder = (Table.entries[2].feeder + 1) % ACTUATOR_MAX_COUNT;
+	return Table;
+}
+
+// One entry every day at that local minute, feeder 0
+static FeedingScheduleTable DailyTable(uint16_t minute, int16_t utcOffset) {
+	FeedingScheduleTable Table = {};
+	Table.revision = 1;
+	Table.utcOffset = utcOffset;
+	Table.entryCount = 1;
+	Table.entries[0] = { minute, SCHEDULE_EVERY_DAY, 0, 500 };
+	return Table;
+}
+
+// Unix time of a local time on the Sunday of SUNDAY_MIDNIGHT_UTC
+static uint32_t LocalTime(int16_t utcOffset, uint16_t minute, uint8_t second) {
+	return SUNDAY_MIDNIGHT_UTC - utcOffset * 60 + minute * 60 + second;
+}
+
+static FeedingSchedule Schedule;
+
+void setUp() {
+	Schedule = FeedingSchedule();
+}
+
+void tearDown() {}
+
+// Sorted by minute of the day, one slot per weekday, in order of minute of the week
+void test_sort_and_expand() {
+	static ScheduleEntry Entries[SCAN_ENTRIES];
+	static ScheduleSlot Slots[SCAN_ENTRIES * 7];
+	size_t Expected = 0;
+
+	for (size_t i = 0; i < SCAN_ENTRIES; i++) {
+		Entries[i] = RandomEntry();
+		Expected += __builtin_popcount(Entries[i].weekdays);
+	}
+
+	FeedingSchedule_sort(Entries, SCAN_ENTRIES);
+	for (size_t i = 1; i < SCAN_ENTRIES; i++) {
+		TEST_ASSERT_LESS_OR_EQUAL(Entries[i].minute, Entries[i - 1].minute);
+	}
+
+	size_t SlotCount = FeedingSchedule_expand(Entries, SCAN_ENTRIES, Slots, SCAN_ENTRIES * 7);
+	TEST_ASSERT_EQUAL_UINT32(Expected, SlotCount);
+	for (size_t i = 1; i < SlotCount; i++) {
+		TEST_ASSERT_LESS_OR_EQUAL(Slots[i].weekMinute, Slots[i - 1].weekMinute);
+	}
+
+	// Only as many as fit
+	TEST_ASSERT_EQUAL_UINT32(10, FeedingSchedule_expand(Entries, SCAN_ENTRIES, Slots, 10));
+}
+
+// The binary search finds the slot a linear scan does for every minute of the week
+void test_find_next_matches_scan() {
+	static ScheduleEntry Entries[SCAN_ENTRIES];
+	static ScheduleSlot Slots[SCAN_ENTRIES * 7];
+
+	for (size_t i = 0; i < SCAN_ENTRIES; i++) {
+		Entries[i] = RandomEntry();
+	}
+
+	FeedingSchedule_sort(Entries, SCAN_ENTRIES);
+	size_t SlotCount = FeedingSchedule_expand(Entries, SCAN_ENTRIES, Slots, SCAN_ENTRIES * 7);
+
+	for (uint16_t WeekMinute = 0; WeekMinute < SCHEDULE_MINUTES_PER_WEEK; WeekMinute++) {
+		size_t Scan = 0;
+		while (Scan < SlotCount && Slots[Scan].weekMinute <= WeekMinute)
+			Scan++;
+
+		if (Scan == SlotCount)
+			Scan = 0;
+
+		TEST_ASSERT_EQUAL_UINT32(Scan, FeedingSchedule_findNext(Slots, SlotCount, WeekMinute));
+	}
+
+	TEST_ASSERT_EQUAL_UINT32(0, FeedingSchedule_findNext(Slots, 0, 100));
+}
+
+// Polled every few seconds for 8 days from late on a Saturday, in six time zones: every feed comes in its minute and only then
+void test_week_in_time_zones() {
+	for (int16_t Offset : Offsets) {
+		FeedingScheduleTable Table = RandomTable(Offset);
+		Schedule = FeedingSchedule();
+		Schedule.load(Table);
+
+		uint32_t Start = LocalTime(Offset, 0, 0) - 10 * 60; // Saturday 23:50 local
+		uint32_t Time = Start;
+		Schedule.poll(Time);
+
+		uint32_t Fed = 0;
+		while (Time < Start + 8 * 86400) {
+			uint32_t Previous = Time;
+			Time += POLL_STEP;
+
+			uint32_t Due = Schedule.poll(Time);
+			uint32_t Expected = Time / 60 != Previous / 60 ? Reference(Table, Time - Time % 60) : 0;
+			if (Due != Expected) {
+				char Message[64];
+				snprintf(Message, sizeof(Message), "utc%+d at %u", Offset, Time);
+				TEST_ASSERT_EQUAL_HEX32_MESSAGE(Expected, Due, Message);
+			}
+
+			Fed += __builtin_popcount(Due);
+		}
+
+		TEST_ASSERT_GREATER_THAN(7 * 2, Fed);
+		TEST_ASSERT_EQUAL_UINT32(0, Schedule.getSkippedCount());
+	}
+}
+
+// A slot at the minute the schedule is anchored in already passed, it is skipped until its next day; the minute after isn't
+void test_slot_on_current_minute_skipped() {
+	for (int16_t Offset : Offsets) {
+		FeedingScheduleTable Table = DailyTable(12 * 60, Offset);
+		Table.entryCount = 2;
+		Table.entries[1] = { 12 * 60 + 1, SCHEDULE_EVERY_DAY, 1, 500 };
+
+		Schedule = FeedingSchedule();
+		Schedule.load(Table);
+
+		uint32_t Anchor = LocalTime(Offset, 12 * 60, 0); // 12:00:00 sharp
+		TEST_ASSERT_EQUAL_HEX32(0, Schedule.poll(Anchor));
+
+		uint32_t Fed = 0;
+		for (uint32_t Time = Anchor + 1; Time < Anchor + 86400 + 60; Time++) {
+			uint32_t Due = Schedule.poll(Time);
+			if (Due == 0)
+				continue;
+
+			Fed++;
+			if (Time == Anchor + 60)
+				TEST_ASSERT_EQUAL_HEX32(0x2, Due); // 12:01 of the same day
+			else if (Time == Anchor + 86400)
+				TEST_ASSERT_EQUAL_HEX32(0x1, Due); // 12:00 of the next day
+			else
+				TEST_FAIL_MESSAGE("Fed outside the minutes of the table");
+		}
+
+		TEST_ASSERT_EQUAL_UINT32(2, Fed);
+		TEST_ASSERT_EQUAL_UINT32(0, Schedule.getSkippedCount());
+	}
+}
+
+// A feed polled up to SCHEDULE_LATE_LIMIT seconds late is still fed, a poll one second later skips it
+void test_late_limit_boundary() {
+	FeedingScheduleTable Table = DailyTable(8 * 60, 0);
+	uint32_t Feed = LocalTime(0, 8 * 60, 0);
+
+	Schedule.load(Table);
+	Schedule.poll(Feed - 300);
+	TEST_ASSERT_EQUAL_HEX32(0x1, Schedule.poll(Feed + SCHEDULE_LATE_LIMIT));
+	TEST_ASSERT_EQUAL_UINT16(500, Schedule.getOpenMillis(0));
+
+	Schedule = FeedingSchedule();
+	Schedule.load(Table);
+	Schedule.poll(Feed - 300);
+	TEST_ASSERT_EQUAL_HEX32(0, Schedule.poll(Feed + SCHEDULE_LATE_LIMIT + 1));
+	TEST_ASSERT_EQUAL_UINT32(1, Schedule.getSkippedCount());
+
+	// The next day is fed as usual
+	TEST_ASSERT_EQUAL_HEX32(0x1, Schedule.poll(Feed + 86400));
+}
+
+// The server clock jumps forward past SCHEDULE_LATE_LIMIT over a feed: it is not fed late, the schedule carries on from the new time
+void test_clock_jump_past_late_limit() {
+	FeedingScheduleTable Table = DailyTable(8 * 60, 0);
+	Table.entryCount = 2;
+	Table.entries[1] = { 9 * 60, SCHEDULE_EVERY_DAY, 1, 500 };
+	Schedule.load(Table);
+
+	uint32_t Before = LocalTime(0, 7 * 60 + 58, 0);
+	Schedule.setClock(Before, 0);
+	Schedule.poll(Schedule.getTime(0));
+
+	// 10 minutes ahead after a minute, the 08:00 feed is jumped over
+	ulong Millis = 60000;
+	Schedule.setClock(Before + 60 + SCHEDULE_LATE_LIMIT + 600, Millis);
+	TEST_ASSERT_EQUAL_HEX32(0, Schedule.poll(Schedule.getTime(Millis)));
+
+	uint32_t Fed = 0;
+	for (; Schedule.getTime(Millis) < LocalTime(0, 9 * 60, 30); Millis += 1000) {
+		uint32_t Due = Schedule.poll(Schedule.getTime(Millis));
+		if (Due != 0)
+			TEST_ASSERT_EQUAL_HEX32_MESSAGE(0x2, Due, "Jumped over feed came late");
+
+		Fed |= Due;
+	}
+
+	TEST_ASSERT_EQUAL_HEX32(0x2, Fed);
+}
+
+// A clock correction within SCHEDULE_LATE_LIMIT keeps the next feed where it was
+void test_small_correction_keeps_feed() {
+	FeedingScheduleTable Table = DailyTable(8 * 60, 0);
+	Schedule.load(Table);
+
+	uint32_t Before = LocalTime(0, 7 * 60 + 59, 0);
+	Schedule.setClock(Before, 0);
+	Schedule.poll(Schedule.getTime(0));
+
+	// 30 s ahead, the feed comes 30 s sooner by the device clock and not twice
+	Schedule.setClock(Before + 10 + 30, 10000);
+	uint32_t Fed = 0;
+	for (ulong Millis = 10000; Millis < 200000; Millis += 1000) {
+		Fed += __builtin_popcount(Schedule.poll(Schedule.getTime(Millis)));
+	}
+
+	TEST_ASSERT_EQUAL_UINT32(1, Fed);
+	TEST_ASSERT_EQUAL_UINT32(0, Schedule.getSkippedCount());
+}
+
+// Five hours without a poll in every time zone: only the feeds within SCHEDULE_LATE_LIMIT of the resume are fed, the rest are counted skipped
+void test_stall_skips_late_feeds() {
+	for (int16_t Offset : Offsets) {
+		FeedingScheduleTable Table = RandomTable(Offset);
+		Schedule = FeedingSchedule();
+		Schedule.load(Table);
+
+		uint32_t Time = LocalTime(Offset, 3 * 60, 0);
+		Schedule.poll(Time);
+
+		uint32_t Resume = Time + 5 * 3600 + 17;
+		uint32_t Expected = 0;
+		uint32_t Passed = 0;
+		for (uint32_t Minute = Time + 60; Minute <= Resume; Minute += 60) {
+			for (uint8_t i = 0; i < Table.entryCount; i++) {
+				FeedingScheduleTable Single = Table;
+				Single.entryCount = 1;
+				Single.entries[0] = Table.entries[i];
+				Passed += Reference(Single, Minute) != 0;
+			}
+
+			if (Resume - Minute <= SCHEDULE_LATE_LIMIT)
+				Expected |= Reference(Table, Minute);
+		}
+
+		uint32_t Due = Schedule.poll(Resume);
+		TEST_ASSERT_EQUAL_HEX32(Expected, Due);
+		TEST_ASSERT_EQUAL_UINT32(Passed - __builtin_popcount(Expected), Schedule.getSkippedCount());
+	}
+}
+
+// The newer of the two sectors wins, a table comes back as it was saved
+void test_flash_round_trip() {
+	FeedingScheduleTable Saved = {};
+	FeedingScheduleTable Loaded = {};
+
+	for (uint32_t Revision = 1; Revision <= 3; Revision++) {
+		Saved = RandomTable(-300);
+		Saved.revision = Revision;
+		TEST_ASSERT_TRUE(FeedingSchedule_saveTable(Saved));
+	}
+
+	TEST_ASSERT_TRUE(FeedingSchedule_loadTable(Loaded));
+	TEST_ASSERT_EQUAL_UINT32(3, Loaded.revision);
+	TEST_ASSERT_EQUAL_MEMORY(&Saved, &Loaded, sizeof(Saved));
+}
+
+int main(int argc, char** argv) {
+	NativeHAL::setSerialQuiet(true);
+
+	UNITY_BEGIN();
+	RUN_TEST(test_sort_and_expand);
+	RUN_TEST(test_find_next_matches_scan);
+	RUN_TEST(test_week_in_time_zones);
+	RUN_TEST(test_slot_on_current_minute_skipped);
+	RUN_TEST(test_late_limit_boundary);
+	RUN_TEST(test_clock_jump_past_late_limit);
+	RUN_TEST(test_small_correction_keeps_feed);
+	RUN_TEST(test_stall_skips_late_feeds);
+	RUN_TEST(test_flash_round_trip);
+	return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include <unity.h>
+#include "config.h"
+#include "I2CBus.h"
+
+#if ENABLE_LCD_OUTPUT == true
+	#include "LCDRenderer.h"
+
+	extern I2CBus i2cBus;
+	extern LCDRenderer lcdRenderer;
+#endif
+
+void setup();
+void loop();
+
+// Holds the bus for as many microseconds as its first byte says, times 10
+static void RunTimed(void* context, const uint8_t* data, uint8_t size) {
+	NativeHAL::advanceMicros(data[0] * 10);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// Transactions of mixed lengths, a full queue of them drained one budget at a time
+void test_drain_stays_within_budget() {
+	I2CBus Bus;
+
+	// Learns the longest transaction like setup() does
+	uint8_t Longest = 200;
+	Bus.submit(RunTimed, nullptr, &Longest, 1);
+	Bus.drainAll();
+
+	for (int Round = 0; Round < 20; Round++) {
+		for (int i = 0; i < I2C_QUEUE_SIZE; i++) {
+			uint8_t Length = 20 + (i * 37 + Round * 11) % 180;
+			if (!Bus.submit(RunTimed, nullptr, &Length, 1))
+				break;
+		}
+
+		while (Bus.getQueuedCount() > 0) {
+			ulong Took = Bus.drain(I2C_DRAIN_BUDGET);
+			TEST_ASSERT_LESS_OR_EQUAL_UINT32(I2C_DRAIN_BUDGET, Took);
+			TEST_ASSERT_GREATER_THAN_UINT32(0, Took);
+		}
+	}
+
+	TEST_ASSERT_LESS_OR_EQUAL_UINT32(I2C_DRAIN_BUDGET, Bus.getMaxDrainMicros());
+	TEST_ASSERT_EQUAL_UINT32(Bus.getSubmittedCount(), Bus.getCompletedCount());
+}
+
+// A budget shorter than the longest transaction runs nothing rather than overrunning it
+void test_drain_short_budget_runs_nothing() {
+	I2CBus Bus;
+	uint8_t Length = 100;
+	Bus.submit(RunTimed, nullptr, &Length, 1);
+	Bus.drainAll();
+
+	Bus.submit(RunTimed, nullptr, &Length, 1);
+	TEST_ASSERT_EQUAL_UINT32(0, Bus.drain(Length * 10 - 1));
+	TEST_ASSERT_EQUAL(1, Bus.getQueuedCount());
+	TEST_ASSERT_EQUAL_UINT32(Length * 10, Bus.drain(Length * 10));
+}
+
+// The firmware on one core, the LCD redrawn every second at a slow bus clock: no run of the i2c task drains longer than I2C_DRAIN_BUDGET
+void test_firmware_drain_within_budget() {
+	#if ENABLE_LCD_OUTPUT == true && I2C_ASYNC == true
+		NativeHAL::setI2CClockHz(50000);
+		setup();
+
+		uint64_t EndMicros = NativeHAL::nowMicros() + 30000000ULL;
+		uint64_t NextRedraw = 0;
+		uint32_t CompletedBefore = i2cBus.getCompletedCount();
+
+		while (NativeHAL::nowMicros() < EndMicros) {
+			if (NativeHAL::nowMicros() >= NextRedraw) {
+				lcdRenderer.invalidate();
+				NextRedraw = NativeHAL::nowMicros() + 1000000;
+			}
+
+			loop();
+			NativeHAL::advanceMicros(50);
+		}
+
+		TEST_ASSERT_GREATER_THAN_UINT32(CompletedBefore + 100, i2cBus.getCompletedCount());
+		TEST_ASSERT_LESS_OR_EQUAL_UINT32(I2C_DRAIN_BUDGET, i2cBus.getMaxDrainMicros());
+	#else
+		TEST_MESSAGE("The LCD doesn't go through the I2C queue in this configuration");
+	#endif
+}
+
+int main(int argc, char** argv) {
+	NativeHAL::setSerialQuiet(true);
+
+	UNITY_BEGIN();
+	RUN_TEST(test_drain_stays_within_budget);
+	RUN_TEST(test_drain_short_budget_runs_nothing);
+	RUN_TEST(test_firmware_drain_within_budget);
+	return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include <unity.h>
+#include "config.h"
+#include "InboundMessage.h"
+
+// Replies as recorded from Backend/src/index.ts, with the endpoint each one has to dispatch to
+struct RecordedReply {
+	const char* text;
+	uint32_t endpointHash;
+	uint32_t statusHash;
+	int code;
+};
+
+static const RecordedReply RecordedReplies[] = {
+	{ "{\"status\":\"success\",\"code\":200,\"data\":{\"message\":\"Connected as IoT device with HWID: petfeeder-esp32dev-example\"},\"endpoint\":\"/login\"}", INBOUND_ENDPOINT_LOGIN, INBOUND_STATUS_SUCCESS, 200 },
+	{ "{\"status\":\"success\",\"code\":200,\"data\":{\"shouldEnableWaterPump\":false,\"shouldDispenseFood\":true,\"pumps\":0,\"feeders\":1},\"endpoint\":\"/iot/get_data\"}", INBOUND_ENDPOINT_GET_DATA, INBOUND_STATUS_SUCCESS, 200 },
+	{ "{\"code\":200,\"status\":\"success\",\"data\":{\"message\":\"Data received successfully\"},\"endpoint\":\"/iot/post_data\"}", INBOUND_ENDPOINT_POST_DATA, INBOUND_STATUS_SUCCESS, 200 },
+	{ "{\"status\":\"error\",\"code\":404,\"error_message\":\"Route \\\"/iot/nope\\\" not found\",\"endpoint\":\"/iot/nope\"}", InboundMessage_hash("/iot/nope"), INBOUND_STATUS_ERROR, 404 }
+};
+
+#define RECORDED_REPLY_COUNT (sizeof(RecordedReplies) / sizeof(RecordedReplies[0]))
+
+// Parsing writes over the text, so every reply is copied into a receive buffer first
+static char Buffer[WS_RX_BUFFER_SIZE + 1];
+
+static bool Parse(const char* text, InboundMessage& message) {
+	size_t Length = strlen(text);
+	TEST_ASSERT_LESS_OR_EQUAL(WS_RX_BUFFER_SIZE, Length);
+
+	memcpy(Buffer, text, Length);
+	return InboundMessage_parse(Buffer, Length, message);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// Every recorded reply parses and dispatches to its endpoint with its status and code
+void test_recorded_replies_dispatch() {
+	for (size_t i = 0; i < RECORDED_REPLY_COUNT; i++) {
+		InboundMessage Message;
+		TEST_ASSERT_TRUE_MESSAGE(Parse(RecordedReplies[i].text, Message), RecordedReplies[i].text);
+		TEST_ASSERT_EQUAL_HEX32_MESSAGE(RecordedReplies[i].endpointHash, Message.endpointHash, RecordedReplies[i].text);
+		TEST_ASSERT_EQUAL_HEX32_MESSAGE(RecordedReplies[i].statusHash, Message.statusHash, RecordedReplies[i].text);
+		TEST_ASSERT_EQUAL_INT_MESSAGE(RecordedReplies[i].code, Message.code, RecordedReplies[i].text);
+	}
+}
+
+// The /iot/get_data reply carries the booleans and masks BusinessLogic reads
+void test_get_data_fields() {
+	InboundMessage Message;
+	TEST_ASSERT_TRUE(Parse(RecordedReplies[1].text, Message));
+	TEST_ASSERT_TRUE(Message.hasData);
+	TEST_ASSERT_EQUAL_UINT8(4, Message.fieldCount);
+	TEST_ASSERT_FALSE(Message.getBool(INBOUND_KEY_SHOULD_ENABLE_WATER_PUMP));
+	TEST_ASSERT_TRUE(Message.getBool(INBOUND_KEY_SHOULD_DISPENSE_FOOD));
+	TEST_ASSERT_EQUAL_UINT32(0, Message.getUnsigned(INBOUND_KEY_PUMPS));
+	TEST_ASSERT_EQUAL_UINT32(1, Message.getUnsigned(INBOUND_KEY_FEEDERS));
+	TEST_ASSERT_NULL(Message.find(INBOUND_KEY_SCHEDULE));
+	TEST_ASSERT_EQUAL_UINT16(0, Message.requestId);
+}
+
+// Error replies keep their message unescaped in place, and the endpoint string points into the buffer
+void test_error_reply_message() {
+	InboundMessage Message;
+	TEST_ASSERT_TRUE(Parse(RecordedReplies[3].text, Message));
+	TEST_ASSERT_FALSE(Message.hasData);
+	TEST_ASSERT_EQUAL_STRING("Route \"/iot/nope\" not found", Message.errorMessage);
+	TEST_ASSERT_EQUAL_STRING("/iot/nope", Message.endpoint);
+}
+
+// The request ID echoed by the server, and masks above the 24 bits a float keeps
+void test_request_id_and_wide_masks() {
+	InboundMessage Message;
+	TEST_ASSERT_TRUE(Parse("{\"status\":\"success\",\"code\":200,\"id\":65535,\"data\":{\"pumps\":4294967295,\"feeders\":16777217},\"endpoint\":\"/iot/get_data\"}", Message));
+	TEST_ASSERT_EQUAL_UINT16(65535, Message.requestId);
+	TEST_ASSERT_EQUAL_UINT32(4294967295u, Message.getUnsigned(INBOUND_KEY_PUMPS));
+	TEST_ASSERT_EQUAL_UINT32(16777217u, Message.getUnsigned(INBOUND_KEY_FEEDERS));
+
+	// Out of range IDs are left at 0 rather than wrapped onto another request
+	TEST_ASSERT_TRUE(Parse("{\"id\":70000,\"endpoint\":\"/iot/get_data\"}", Message));
+	TEST_ASSERT_EQUAL_UINT16(0, Message.requestId);
+}
+
+// Anything but one whole JSON object is turned down
+void test_rejects_malformed() {
+	static const char* Malformed[] = {
+		"",
+		"[]",
+		"{\"status\":\"success\"",
+		"{\"status\":\"success\"} trailing",
+		"{\"status\":success}",
+		"{\"data\":{\"pumps\":}}"
+	};
+
+	for (const char* Text : Malformed) {
+		InboundMessage Message;
+		TEST_ASSERT_FALSE_MESSAGE(Parse(Text, Message), Text);
+	}
+}
+
+int main(int argc, char** argv) {
+	NativeHAL::setSerialQuiet(true);
+
+	UNITY_BEGIN();
+	RUN_TEST(test_recorded_replies_dispatch);
+	RUN_TEST(test_get_data_fields);
+	RUN_TEST(test_error_reply_message);
+	RUN_TEST(test_request_id_and_wide_masks);
+	RUN_TEST(test_rejects_malformed);
+	return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include "config.h"
+#include "Metrics.h"
+
+#define RECORD_COUNT 2000000 // Pairs of a short and a long value
+#define SHORT_VALUE 1
+#define LONG_VALUE 1000000 // highestOf() its bucket is past it, so a percentile in that bucket is the max
+#define SNAPSHOT_LIMIT 200000 // Copies taken while the writer runs at most
+
+void setUp() {}
+
+void tearDown() {}
+
+// Values up to 2 * METRICS_SUB_BUCKETS are exact, past them a percentile is the end of its bucket
+void test_percentiles_within_bucket() {
+	LatencyHistogram Histogram;
+	LatencyHistogram Snapshot;
+
+	for (uint32_t Value = 1; Value <= 1000; Value++) {
+		Histogram.record(Value);
+	}
+
+	Histogram.snapshotTo(Snapshot);
+	TEST_ASSERT_EQUAL_UINT32(1000, Snapshot.getCount());
+	TEST_ASSERT_EQUAL_UINT32(1000, Snapshot.getMax());
+	TEST_ASSERT_EQUAL_UINT32(LatencyHistogram::highestOf(LatencyHistogram::bucketOf(500)), Snapshot.getPercentile(50));
+	TEST_ASSERT_EQUAL_UINT32(1000, Snapshot.getPercentile(100));
+
+	Histogram.reset();
+	Histogram.snapshotTo(Snapshot);
+	TEST_ASSERT_EQUAL_UINT32(0, Snapshot.getCount());
+	TEST_ASSERT_EQUAL_UINT32(0, Snapshot.getPercentile(99));
+}
+
+// Copies taken from another thread while the owner records a short and a long value in turn are whole: the short ones
+// are never fewer than the long ones, so the median stays short, and a copy with both has the long one as its max
+void test_snapshot_consistent_while_recording() {
+	static LatencyHistogram Histogram;
+	LatencyHistogram Snapshot;
+	std::atomic<bool> IsDone(false);
+
+	std::thread Writer([&]() {
+		for (uint32_t i = 0; i < RECORD_COUNT; i++) {
+			Histogram.record(SHORT_VALUE);
+			Histogram.record(LONG_VALUE);
+		}
+
+		IsDone = true;
+	});
+
+	int Snapshots = 0;
+	int Torn = 0;
+	uint32_t LastCount = 0;
+
+	while (!IsDone && Snapshots < SNAPSHOT_LIMIT) {
+		Histogram.snapshotTo(Snapshot);
+		Snapshots++;
+
+		uint32_t Count = Snapshot.getCount();
+		TEST_ASSERT_GREATER_OR_EQUAL_UINT32(LastCount, Count);
+		LastCount = Count;
+
+		if (Count < 2)
+			continue;
+
+		if (Snapshot.getPercentile(50) != SHORT_VALUE || Snapshot.getMax() != LONG_VALUE || Snapshot.getPercentile(100) != LONG_VALUE)
+			Torn++;
+	}
+
+	Writer.join();
+
+	char Message[64];
+	snprintf(Message, sizeof(Message), "%d of %d snapshots torn", Torn, Snapshots);
+	TEST_ASSERT_EQUAL_INT_MESSAGE(0, Torn, Message);
+	TEST_ASSERT_GREATER_THAN_INT_MESSAGE(10, Snapshots, "The writer finished before the snapshots overlapped it");
+
+	Histogram.snapshotTo(Snapshot);
+	TEST_ASSERT_EQUAL_UINT32(RECORD_COUNT * 2, Snapshot.getCount());
+}
+
+int main(int argc, char** argv) {
+	NativeHAL::setSerialQuiet(true);
+
+	UNITY_BEGIN();
+	RUN_TEST(test_percentiles_within_bucket);
+	RUN_TEST(test_snapshot_consistent_while_recording);
+	return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include <unity.h>
+#include <mutex>
+#include <string>
+#include "config.h"
+#include "Scheduler.h"
+
+#define STALL_MICROS 500000 // Every request blocks the network task this long, like a stalled TCP send
+#define RUN_MICROS 4000000ULL // Of wall clock after setup()
+#define PERIOD_TOLERANCE 20000 // What the host may add to a start on top of one period, threads and sleeps aren't exact
+
+#if ENABLE_WIFI == true && ENABLE_DUAL_CORE == true
+	extern TaskHandle_t networkTaskHandle;
+#endif
+
+void setup();
+void loop();
+
+// Answers every request with an empty success reply after blocking the sender
+class StallingServer : public NativeHAL::WebSocketServer {
+	public:
+		bool onConnect(NativeHAL::WebSocketConnection* connection, const char* host, uint16_t port) override {
+			return true;
+		}
+
+		void onMessage(NativeHAL::WebSocketConnection* connection, const uint8_t* data, size_t size) override {
+			delayMicroseconds(STALL_MICROS);
+
+			std::string Request((const char*)data, size);
+			std::string Endpoint;
+
+			size_t KeyStart = Request.find("\"key\":\"");
+			if (KeyStart != std::string::npos) {
+				KeyStart += 7;
+				Endpoint = Request.substr(KeyStart, Request.find('"', KeyStart) - KeyStart);
+			}
+
+			std::string Reply = "{\"status\":\"success\",\"code\":200,\"endpoint\":\"" + Endpoint + "\",\"data\":{}}";
+			connection->send((const uint8_t*)Reply.data(), Reply.size());
+			connection->send((const uint8_t*)"\r", 1);
+		}
+};
+
+static StallingServer Server;
+
+// Tasks that wait on the server, every other one keeps the device going and is a control task wherever it is scheduled
+static const char* NetworkTasks[] = { "network", "interaction", "metrics" };
+
+// Worst start-to-start interval, past its period for the control tasks
+static const char* WorstControlTask = nullptr;
+static int32_t WorstControlOverrun = INT32_MIN;
+static ulong WorstNetworkInterval = 0;
+static std::mutex WorstMutex;
+
+static bool IsNetworkTask(const char* name) {
+	for (const char* NetworkTask : NetworkTasks) {
+		if (strcmp(name, NetworkTask) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+// Called from loop() and from the network task
+static void OnTaskPeriod(const Scheduler* scheduler, const SchedulerTask& task, ulong intervalMicros, ulong periodMicros) {
+	#if ENABLE_WIFI == true && ENABLE_DUAL_CORE == true
+		std::lock_guard<std::mutex> Lock(WorstMutex);
+
+		if (IsNetworkTask(task.name)) {
+			if (intervalMicros > WorstNetworkInterval)
+				WorstNetworkInterval = intervalMicros;
+			return;
+		}
+
+		int32_t Overrun = (int32_t)(intervalMicros - periodMicros);
+		if (Overrun > WorstControlOverrun) {
+			WorstControlOverrun = Overrun;
+			WorstControlTask = task.name;
+		}
+	#endif
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// The network task stalls half a second on every request, no control task starts more than PERIOD_TOLERANCE later than one period after its last start
+void test_control_tasks_keep_period_while_network_stalls() {
+	#if ENABLE_WIFI == true && ENABLE_DUAL_CORE == true
+		// FreeRTOS tasks only run as threads against the wall clock
+		NativeHAL::setRealTime(true);
+		NativeHAL::setWebSocketServer(&Server);
+		Scheduler::setPeriodObserver(OnTaskPeriod);
+
+		setup();
+		TEST_ASSERT_NOT_NULL_MESSAGE(networkTaskHandle, "The network task wasn't created");
+
+		uint64_t EndMicros = NativeHAL::nowMicros() + RUN_MICROS;
+		while (NativeHAL::nowMicros() < EndMicros)
+			loop();
+
+		NativeHAL::stopTasks();
+		Scheduler::setPeriodObserver(nullptr);
+
+		// Otherwise nothing was held up and the test proves nothing
+		TEST_ASSERT_GREATER_OR_EQUAL_UINT32_MESSAGE(STALL_MICROS, WorstNetworkInterval, "The network task never stalled");
+		TEST_ASSERT_NOT_NULL(WorstControlTask);
+
+		char Message[64];
+		snprintf(Message, sizeof(Message), "%s started %ld us past its period", WorstControlTask, (long)WorstControlOverrun);
+		TEST_ASSERT_LESS_OR_EQUAL_INT32_MESSAGE(PERIOD_TOLERANCE, WorstControlOverrun, Message);
+	#else
+		TEST_MESSAGE("The network doesn't run in a task of its own in this configuration");
+	#endif
+}
+
+int main(int argc, char** argv) {
+	NativeHAL::setSerialQuiet(true);
+
+	UNITY_BEGIN();
+	RUN_TEST(test_control_tasks_keep_period_while_network_stalls);
+	return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include <unity.h>
+#include "config.h"
+#include "PumpController.h"
+#include "ActuatorRegistry.h"
+#include "BusinessLogic.h"
+
+#define CONTROL_LOOP_INTERVAL 100 // ms, like the control loop
+#define DECISION_TIMEOUT 120000
+
+// Same numbers on every run
+static uint32_t RandomState = 1;
+static float Uniform() {
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 17;
+	RandomState ^= RandomState << 5;
+	return (RandomState >> 8) / 16777216.0f;
+}
+
+static float Gaussian(float deviation) {
+	return deviation * sqrtf(-2.0f * logf(Uniform() + 1e-7f)) * cosf(2.0f * (float)M_PI * Uniform());
+}
+
+// Runs the controller once per control loop on a level made up from the time, until it decides something
+static PumpDecision PumpUntilDecision(PumpController& controller, ulong& nowMillis, float startLevel, float rate, float noise) {
+	ulong StartMillis = nowMillis;
+
+	while (nowMillis - StartMillis < DECISION_TIMEOUT) {
+		float Level = startLevel + rate * (nowMillis - StartMillis) / 1000.0f + Gaussian(noise);
+		PumpDecision Decision = controller.update(nowMillis, Level, true);
+		if (Decision != PUMP_KEEP)
+			return Decision;
+
+		nowMillis += CONTROL_LOOP_INTERVAL;
+	}
+
+	return PUMP_KEEP;
+}
+
+void setUp() {
+	RandomState = 1;
+}
+
+void tearDown() {}
+
+// Clean fills at several rates stop a coast of the fitted rate ahead of the full level, within half a percent
+void test_fill_stops_at_fitted_rate() {
+	static const float Rates[] = { 0.3f, 1.0f, 2.0f, 4.0f };
+
+	for (float Rate : Rates) {
+		PumpController Controller;
+		ulong Now = 1000;
+		float Start = WATER_LEVEL_FULL_PERCENT - 30.0f;
+
+		TEST_ASSERT_EQUAL_INT(PUMP_STOP_FULL, PumpUntilDecision(Controller, Now, Start, Rate, 0.02f));
+
+		float Level = Start + Rate * (Now - 1000) / 1000.0f;
+		TEST_ASSERT_FLOAT_WITHIN(Rate * 0.05f, Rate, Controller.getRate());
+		TEST_ASSERT_FLOAT_WITHIN(0.5f, WATER_LEVEL_FULL_PERCENT - Rate * WATER_PUMP_COAST_INITIAL, Level);
+		TEST_ASSERT_EQUAL_UINT32(1, Controller.getEarlyStopCount());
+		TEST_ASSERT_FALSE(Controller.isLockedOut(Now));
+	}
+}
+
+// After a stop the level coasts 3 % further, the coast moves half way towards the 3 s that took
+void test_coast_learned_after_stop() {
+	PumpController Controller;
+	ulong Now = 1000;
+
+	TEST_ASSERT_EQUAL_INT(PUMP_STOP_FULL, PumpUntilDecision(Controller, Now, 20.0f, 1.0f, 0.02f));
+	float StopLevel = 20.0f + (Now - 1000) / 1000.0f;
+
+	for (ulong Settle = 0; Settle <= WATER_PUMP_SETTLE_TIME; Settle += CONTROL_LOOP_INTERVAL) {
+		float Coasted = StopLevel + 3.0f * (1.0f - expf(-(float)Settle / 1000.0f));
+		Controller.update(Now + Settle, Coasted, false);
+	}
+
+	float Coasted = 3.0f * (1.0f - expf(-WATER_PUMP_SETTLE_TIME / 1000.0f));
+	TEST_ASSERT_FLOAT_WITHIN(0.1f, WATER_PUMP_COAST_INITIAL + (Coasted - WATER_PUMP_COAST_INITIAL) * 0.5f, Controller.getCoastSeconds());
+}
+
+// A level that only moves by noise is a dry run, and requests are held off for WATER_PUMP_FAULT_HOLDOFF after it
+void test_dry_run_detected() {
+	PumpController Controller;
+	ulong Now = 1000;
+
+	TEST_ASSERT_EQUAL_INT(PUMP_STOP_DRY_RUN, PumpUntilDecision(Controller, Now, 30.0f, 0.0f, 0.05f));
+	TEST_ASSERT_LESS_OR_EQUAL_UINT32(1000 + WATER_PUMP_DEAD_TIME + WATER_PUMP_RATE_SAMPLES * WATER_PUMP_RATE_SAMPLE_INTERVAL * 2, Now);
+	TEST_ASSERT_EQUAL_UINT32(1, Controller.getDryRunCount());
+
+	Controller.update(Now, 30.0f, false);
+	TEST_ASSERT_TRUE(Controller.isLockedOut(Now));
+	TEST_ASSERT_TRUE(Controller.isLockedOut(Now + WATER_PUMP_FAULT_HOLDOFF - 1));
+	TEST_ASSERT_FALSE(Controller.isLockedOut(Now + WATER_PUMP_FAULT_HOLDOFF));
+
+	// A fill slower than needed but above WATER_PUMP_MIN_RATE is not one
+	PumpController Slow;
+	Now = 1000;
+	TEST_ASSERT_EQUAL_INT(PUMP_STOP_FULL, PumpUntilDecision(Slow, Now, WATER_LEVEL_FULL_PERCENT - 20.0f, WATER_PUMP_MIN_RATE * 1.5f, 0.02f));
+	TEST_ASSERT_EQUAL_UINT32(0, Slow.getDryRunCount());
+}
+
+// A reading that doesn't move at all is a stuck sensor, locked out past the holdoff until the reading moves
+void test_stuck_sensor_detected() {
+	PumpController Controller;
+	ulong Now = 1000;
+
+	TEST_ASSERT_EQUAL_INT(PUMP_STOP_SENSOR_STUCK, PumpUntilDecision(Controller, Now, 0.0f, 0.0f, 0.0f));
+	TEST_ASSERT_EQUAL_UINT32(1, Controller.getStuckCount());
+	TEST_ASSERT_EQUAL_UINT32(0, Controller.getDryRunCount());
+
+	Controller.update(Now, 0.0f, false);
+	TEST_ASSERT_TRUE(Controller.isLockedOut(Now + WATER_PUMP_FAULT_HOLDOFF * 2));
+
+	Controller.update(Now + WATER_PUMP_FAULT_HOLDOFF * 2, 0.5f, false);
+	TEST_ASSERT_FALSE(Controller.isLockedOut(Now + WATER_PUMP_FAULT_HOLDOFF * 2));
+}
+
+// The pumps share one reservoir and its sensor, so a dry run with two running stops both and holds either one off
+void test_pumps_share_reservoir() {
+	#if ENABLE_WATER_PUMP == true && ENABLE_WATER_LEVEL_SENSOR == true && WATER_PUMP_CLOSED_LOOP == true
+		static ActuatorRegistry Registry;
+		static BusinessLogic Logic;
+		Registry.addPump(GPIO_NUM_18, DECISION_TIMEOUT);
+		Registry.addPump(GPIO_NUM_19, DECISION_TIMEOUT);
+		Logic.setActuatorRegistry(&Registry);
+
+		ActuatorCommand Command = { 0b11, 0 };
+		Logic.postActuatorCommand(Command);
+
+		// A level that only moves by noise while both run
+		ulong StartMillis = millis();
+		Logic.filteredWaterLevel = 30.0f;
+		Logic.pre_actuator_loop();
+		TEST_ASSERT_EQUAL_UINT32(0b11, Registry.pumps.enabledMask);
+
+		while (Registry.pumps.enabledMask != 0 && millis() - StartMillis < DECISION_TIMEOUT) {
+			// Both stop on the same decision, never one by itself
+			TEST_ASSERT_EQUAL_UINT32(0b11, Registry.pumps.enabledMask);
+
+			NativeHAL::advanceMicros(CONTROL_LOOP_INTERVAL * 1000);
+			Logic.filteredWaterLevel = 30.0f + Gaussian(0.05f);
+			Logic.pre_actuator_loop();
+		}
+
+		TEST_ASSERT_EQUAL_UINT32(0, Registry.pumps.enabledMask);
+		TEST_ASSERT_EQUAL_UINT32(1, Logic.getPumpController().getDryRunCount());
+
+		// The holdoff is of the reservoir, the other pump isn't started either
+		for (uint32_t Mask : { 0b01, 0b10 }) {
+			Command = { Mask, 0 };
+			Logic.postActuatorCommand(Command);
+			NativeHAL::advanceMicros(CONTROL_LOOP_INTERVAL * 1000);
+			Logic.pre_actuator_loop();
+			TEST_ASSERT_EQUAL_UINT32(0, Registry.pumps.enabledMask);
+		}
+	#endif
+}
+
+int main(int argc, char** argv) {
+	NativeHAL::setSerialQuiet(true);
+
+	UNITY_BEGIN();
+	RUN_TEST(test_fill_stops_at_fitted_rate);
+	RUN_TEST(test_coast_learned_after_stop);
+	RUN_TEST(test_dry_run_detected);
+	RUN_TEST(test_stuck_sensor_detected);
+	RUN_TEST(test_pumps_share_reservoir);
+	return UNITY_END();
+}
\ No newline at end of file
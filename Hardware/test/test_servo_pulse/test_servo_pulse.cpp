@@ -0,0 +1,135 @@
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include <unity.h>
+#include "config.h"
+#include "ActuatorRegistry.h"
+#include "ServoManager.h"
+#include "ServoPulse.h"
+
+// Calibrations the tables are built for at compile time, reversed and backwards ones included
+constexpr ServoCalibration Calibrations[] = {
+	{ 470, 2540, 4, false }, { 470, 2540, 4, true }, { 500, 2500, 0, false }, { 1000, 2000, 8, true }, { 2400, 600, 0, false }
+};
+
+constexpr ServoPulseTable PulseTables[] = {
+	ServoPulse_makeTable(Calibrations[0]), ServoPulse_makeTable(Calibrations[1]), ServoPulse_makeTable(Calibrations[2]),
+	ServoPulse_makeTable(Calibrations[3]), ServoPulse_makeTable(Calibrations[4])
+};
+
+static_assert(PulseTables[0].micros[90] == 1505 && PulseTables[1].micros[0] == 2540, "Pulse tables aren't built at compile time");
+
+#define CALIBRATION_COUNT (sizeof(Calibrations) / sizeof(Calibrations[0]))
+#define RAMP_TICK_LIMIT 1000
+
+static ActuatorRegistry Registry;
+
+// How ServoBackend_DegreesToMicros() turned an angle into a pulse before the tables
+static ulong FloatPulseMicros(int degrees) {
+	float TargetuS = 470.0f + (degrees * 11.5f);
+	return (ulong)TargetuS;
+}
+
+// The same line in double precision
+static uint16_t ReferenceMicros(const ServoCalibration& calibration, int degrees) {
+	int Along = calibration.isReversed ? SERVO_MAX_DEGREES - degrees : degrees;
+	return (uint16_t)(calibration.minMicros + trunc(((double)calibration.maxMicros - calibration.minMicros) * Along / SERVO_MAX_DEGREES));
+}
+
+// Ticks the servo task until the feeder stops ramping, every step at most a tick's worth of SERVO_VELOCITY, returns the ticks
+static int RampTo(uint8_t id, int degrees) {
+	int MaxStep = (SERVO_VELOCITY * SERVO_TICK_INTERVAL + 999999) / 1000000;
+	int Position = Registry.feeders.positions[id];
+	int Ticks = 0;
+
+	ServoManager_rotate(id, degrees);
+	while (Registry.feeders.movingMask != 0 && Ticks < RAMP_TICK_LIMIT) {
+		// The servo task is woken right after the rotate, then runs every tick
+		if (Ticks > 0)
+			NativeHAL::advanceMicros(SERVO_TICK_INTERVAL);
+
+		ServoManager_loop();
+		Ticks++;
+
+		int Step = abs(Registry.feeders.positions[id] - Position);
+		TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(1, Step, "Ramp stood still for a tick");
+		TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(MaxStep, Step, "Ramp stepped further than SERVO_VELOCITY");
+		Position = Registry.feeders.positions[id];
+	}
+
+	TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, Registry.feeders.movingMask, "Ramp didn't end");
+	return Ticks;
+}
+
+void setUp() {
+	Registry = ActuatorRegistry();
+	Registry.addFeeder(GPIO_NUM_2, SERVO_OPEN_TIMEOUT);
+	ServoManager_setBackend(ServoBackend_getDefault());
+	ServoManager_setup(&Registry.feeders);
+}
+
+void tearDown() {}
+
+// Every degree of every table is the line between the calibrated pulses in double precision, rounded down
+void test_tables_match_reference() {
+	for (size_t c = 0; c < CALIBRATION_COUNT; c++) {
+		for (int Degrees = 0; Degrees <= SERVO_MAX_DEGREES; Degrees++) {
+			char Message[48];
+			snprintf(Message, sizeof(Message), "calibration %zu at %d degrees", c, Degrees);
+			TEST_ASSERT_EQUAL_UINT16_MESSAGE(ReferenceMicros(Calibrations[c], Degrees), PulseTables[c].micros[Degrees], Message);
+		}
+	}
+}
+
+// The calibration the float formula had baked in gives the same pulses, and so does the firmware's table for every feeder ID
+void test_tables_match_float_formula() {
+	for (int Degrees = 0; Degrees <= SERVO_MAX_DEGREES; Degrees++) {
+		TEST_ASSERT_EQUAL_UINT32(FloatPulseMicros(Degrees), PulseTables[0].micros[Degrees]);
+
+		for (uint8_t Id = 0; Id <= SERVO_CALIBRATION_COUNT; Id++) {
+			TEST_ASSERT_EQUAL_UINT16(ReferenceMicros(ServoPulse_getCalibration(Id), Degrees), ServoPulse_lookup(Id, Degrees));
+		}
+	}
+}
+
+// Angles out of range get the pulse of the end they are past
+void test_out_of_range_clamped() {
+	for (uint8_t Id = 0; Id <= SERVO_CALIBRATION_COUNT; Id++) {
+		TEST_ASSERT_EQUAL_UINT16(ServoPulse_lookup(Id, 0), ServoPulse_lookup(Id, -10));
+		TEST_ASSERT_EQUAL_UINT16(ServoPulse_lookup(Id, SERVO_MAX_DEGREES), ServoPulse_lookup(Id, SERVO_MAX_DEGREES + 10));
+		TEST_ASSERT_EQUAL_UINT16(ServoPulse_lookup(Id, SERVO_MAX_DEGREES), ServoPulse_lookup(Id, INT32_MAX));
+	}
+
+	TEST_ASSERT_EQUAL_UINT16(ServoPulse_micros(Calibrations[4], 0), ServoPulse_micros(Calibrations[4], -1));
+	TEST_ASSERT_EQUAL_UINT16(ServoPulse_micros(Calibrations[1], SERVO_MAX_DEGREES), ServoPulse_micros(Calibrations[1], 500));
+}
+
+// From closed to open and back, never more than a tick's worth of SERVO_VELOCITY a tick, ending on the pulse of the target
+void test_ramp_steps_within_velocity() {
+	#if SERVO_VELOCITY > 0
+		int Range = SERVO_OPEN_ANGLE - Registry.feeders.positions[0];
+		int Ticks = RampTo(0, SERVO_OPEN_ANGLE);
+		TEST_ASSERT_GREATER_OR_EQUAL(abs(Range) * 1000000 / SERVO_VELOCITY / SERVO_TICK_INTERVAL, Ticks);
+		TEST_ASSERT_EQUAL_INT(SERVO_OPEN_ANGLE, Registry.feeders.positions[0]);
+		TEST_ASSERT_EQUAL_UINT16(ServoPulse_lookup(0, SERVO_OPEN_ANGLE), Registry.feeders.pulses[0]);
+
+		NativeHAL::advanceMicros(SERVO_TICK_INTERVAL * 10);
+		RampTo(0, SERVO_CLOSE_ANGLE);
+		TEST_ASSERT_EQUAL_INT(SERVO_CLOSE_ANGLE, Registry.feeders.positions[0]);
+		TEST_ASSERT_EQUAL_UINT16(ServoPulse_lookup(0, SERVO_CLOSE_ANGLE), Registry.feeders.pulses[0]);
+	#else
+		ServoManager_rotate(0, SERVO_OPEN_ANGLE);
+		TEST_ASSERT_EQUAL_INT(SERVO_OPEN_ANGLE, Registry.feeders.positions[0]);
+		TEST_ASSERT_EQUAL_UINT16(ServoPulse_lookup(0, SERVO_OPEN_ANGLE), Registry.feeders.pulses[0]);
+	#endif
+}
+
+int main(int argc, char** argv) {
+	NativeHAL::setSerialQuiet(true);
+
+	UNITY_BEGIN();
+	RUN_TEST(test_tables_match_reference);
+	RUN_TEST(test_tables_match_float_formula);
+	RUN_TEST(test_out_of_range_clamped);
+	RUN_TEST(test_ramp_steps_within_velocity);
+	return UNITY_END();
+}
\ No newline at end of file
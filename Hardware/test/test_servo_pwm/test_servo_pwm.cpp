@@ -0,0 +1,113 @@
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include <unity.h>
+#include "config.h"
+#include "ActuatorRegistry.h"
+#include "ServoManager.h"
+#include "ServoPulse.h"
+
+// Not used by the firmware, one per LEDC channel
+static const gpio_num_t FreePins[] = {
+	GPIO_NUM_2, GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_12, GPIO_NUM_13, GPIO_NUM_14, GPIO_NUM_15, GPIO_NUM_16,
+	GPIO_NUM_17, GPIO_NUM_21, GPIO_NUM_22, GPIO_NUM_25, GPIO_NUM_26, GPIO_NUM_27, GPIO_NUM_32, GPIO_NUM_33
+};
+
+#define FREE_PIN_COUNT (sizeof(FreePins) / sizeof(FreePins[0]))
+#define IDLE_TICKS 50
+
+static ActuatorRegistry Registry;
+
+struct LoopCost {
+	uint64_t micros; // Simulated time ServoManager_loop() held the caller up, per tick
+	uint32_t writes; // ledcWrite() calls, per tick
+};
+
+// Opens that many feeders on the backend and waits for the ramps to end, then what a servo tick costs while they hold
+static LoopCost MeasureIdleTick(ServoBackend* backend, size_t count) {
+	Registry = ActuatorRegistry();
+	for (size_t i = 0; i < count; i++) {
+		Registry.addFeeder(FreePins[i], SERVO_OPEN_TIMEOUT);
+	}
+
+	ServoManager_setBackend(backend);
+	ServoManager_setup(&Registry.feeders);
+
+	for (size_t i = 0; i < count; i++) {
+		ServoManager_rotate(i, SERVO_OPEN_ANGLE);
+	}
+
+	for (int Tick = 0; Tick < 1000 && Registry.feeders.movingMask != 0; Tick++) {
+		ServoManager_loop();
+		NativeHAL::advanceMicros(SERVO_TICK_INTERVAL);
+	}
+
+	TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, Registry.feeders.movingMask, "Ramp didn't end");
+
+	uint64_t Held = 0;
+	uint32_t WritesBefore = NativeHAL::getLEDCWriteCount();
+	for (int Tick = 0; Tick < IDLE_TICKS; Tick++) {
+		uint64_t Start = NativeHAL::nowMicros();
+		ServoManager_loop();
+		Held += NativeHAL::nowMicros() - Start;
+		NativeHAL::advanceMicros(SERVO_TICK_INTERVAL);
+	}
+
+	LoopCost Cost;
+	Cost.micros = Held / IDLE_TICKS;
+	Cost.writes = (NativeHAL::getLEDCWriteCount() - WritesBefore) / IDLE_TICKS;
+	return Cost;
+}
+
+void setUp() {}
+
+void tearDown() {
+	ServoManager_setBackend(ServoBackend_getDefault());
+}
+
+// The LEDC timer repeats the pulses, so a servo tick costs the same for 1 servo as for every channel
+void test_ledc_tick_cost_is_flat() {
+	static ServoLEDCBackend LEDC;
+	LoopCost Single = MeasureIdleTick(&LEDC, 1);
+
+	for (size_t Count = 2; Count <= FREE_PIN_COUNT; Count *= 2) {
+		LoopCost Cost = MeasureIdleTick(&LEDC, Count);
+		TEST_ASSERT_EQUAL_UINT64_MESSAGE(Single.micros, Cost.micros, "Held up longer with more servos");
+		TEST_ASSERT_EQUAL_UINT32_MESSAGE(Single.writes, Cost.writes, "More duty writes with more servos");
+	}
+
+	TEST_ASSERT_EQUAL_UINT64(0, Single.micros);
+	TEST_ASSERT_EQUAL_UINT32(0, Single.writes);
+}
+
+// Every channel keeps generating the pulse of the angle it was left at, on the pin of its feeder
+void test_ledc_channels_hold_pulses() {
+	static ServoLEDCBackend LEDC;
+	MeasureIdleTick(&LEDC, FREE_PIN_COUNT);
+
+	for (uint8_t Id = 0; Id < FREE_PIN_COUNT; Id++) {
+		TEST_ASSERT_EQUAL_INT(FreePins[Id], NativeHAL::getLEDCPin(Id));
+
+		// The duty is rounded down to a step of 20 ms / 65535, 0.3 us
+		TEST_ASSERT_FLOAT_WITHIN(1.0f, ServoPulse_lookup(Id, SERVO_OPEN_ANGLE), NativeHAL::getLEDCPulseMicros(Id));
+	}
+}
+
+// The same measure sees the bit-bang backend hold the loop up for every pulse it writes
+void test_bitbang_tick_cost_grows() {
+	static ServoBitBangBackend BitBang;
+	LoopCost Single = MeasureIdleTick(&BitBang, 1);
+	LoopCost All = MeasureIdleTick(&BitBang, FREE_PIN_COUNT);
+
+	TEST_ASSERT_EQUAL_UINT64(ServoPulse_lookup(0, SERVO_OPEN_ANGLE), Single.micros);
+	TEST_ASSERT_GREATER_OR_EQUAL(Single.micros * FREE_PIN_COUNT, All.micros);
+}
+
+int main(int argc, char** argv) {
+	NativeHAL::setSerialQuiet(true);
+
+	UNITY_BEGIN();
+	RUN_TEST(test_ledc_tick_cost_is_flat);
+	RUN_TEST(test_ledc_channels_hold_pulses);
+	RUN_TEST(test_bitbang_tick_cost_grows);
+	return UNITY_END();
+}
\ No newline at end of file
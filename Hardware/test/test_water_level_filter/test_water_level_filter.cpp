@@ -0,0 +1,141 @@
+#include <Arduino.h>
+#include <NativeHAL.h>
+#include <unity.h>
+#include "config.h"
+#include "WaterLevelFilter.h"
+
+static const uint16_t Calibration[] = WATER_LEVEL_CALIBRATION;
+
+#define CALIBRATION_POINTS (sizeof(Calibration) / sizeof(Calibration[0]))
+#define SETTLE_BURSTS 40 // Enough for the moving average to forget where it started
+
+// Raw reading of the sensor at that level, through the calibration the other way
+static uint16_t ToRaw(float percent) {
+	float Step = 100.0f / (CALIBRATION_POINTS - 1);
+	size_t i = (size_t)(percent / Step);
+	if (i >= CALIBRATION_POINTS - 1)
+		return Calibration[CALIBRATION_POINTS - 1];
+
+	float Fraction = percent / Step - i;
+	return (uint16_t)roundf(Calibration[i] + (Calibration[i + 1] - Calibration[i]) * Fraction);
+}
+
+// One burst at that level, with spikes readings of the burst replaced by spike
+static void PushBurst(WaterLevelFilter& filter, float percent, int spikes, uint16_t spike) {
+	for (int i = 0; i < WATER_LEVEL_BURST; i++) {
+		filter.push(i < spikes ? spike : ToRaw(percent));
+	}
+
+	filter.update();
+}
+
+static void Settle(WaterLevelFilter& filter, float percent) {
+	for (int Burst = 0; Burst < SETTLE_BURSTS; Burst++) {
+		PushBurst(filter, percent, 0, 0);
+	}
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// Every calibration point maps to its tenth, and the ends clamp
+void test_calibration_points() {
+	for (size_t i = 0; i < CALIBRATION_POINTS; i++) {
+		TEST_ASSERT_FLOAT_WITHIN(0.01f, i * 10.0f, WaterLevelFilter::toPercent(Calibration[i]));
+	}
+
+	TEST_ASSERT_EQUAL_FLOAT(0.0f, WaterLevelFilter::toPercent(-5.0f));
+	TEST_ASSERT_EQUAL_FLOAT(100.0f, WaterLevelFilter::toPercent(5000.0f));
+}
+
+// Spikes to the top of the scale just under the cut-off never make the bowl full, and spikes to 0 just over it never empty it
+void test_spikes_do_not_toggle_full() {
+	for (int Spikes = 1; Spikes <= 2; Spikes++) {
+		WaterLevelFilter Low;
+		Settle(Low, WATER_LEVEL_FULL_PERCENT - 1.0f);
+		TEST_ASSERT_FALSE(Low.isFull());
+
+		for (int Burst = 0; Burst < 1000; Burst++) {
+			PushBurst(Low, WATER_LEVEL_FULL_PERCENT - 1.0f, Spikes, 4095);
+			TEST_ASSERT_FALSE_MESSAGE(Low.isFull(), "A spike made the bowl full");
+		}
+
+		WaterLevelFilter High;
+		Settle(High, WATER_LEVEL_FULL_PERCENT + 1.0f);
+		TEST_ASSERT_TRUE(High.isFull());
+
+		for (int Burst = 0; Burst < 1000; Burst++) {
+			PushBurst(High, WATER_LEVEL_FULL_PERCENT + 1.0f, Spikes, 0);
+			TEST_ASSERT_TRUE_MESSAGE(High.isFull(), "A spike emptied the bowl");
+		}
+	}
+}
+
+// A whole burst thrown off, the WiFi transmitting through it, doesn't move the level a percent
+void test_spiked_burst_barely_moves_level() {
+	WaterLevelFilter Filter;
+	Settle(Filter, WATER_LEVEL_FULL_PERCENT - 3.0f);
+
+	PushBurst(Filter, WATER_LEVEL_FULL_PERCENT - 3.0f, WATER_LEVEL_BURST, 4095);
+	TEST_ASSERT_FLOAT_WITHIN(1.0f, WATER_LEVEL_FULL_PERCENT - 3.0f, Filter.getPercent());
+	TEST_ASSERT_FALSE(Filter.isFull());
+}
+
+// Rising, the flag sets at the full level; falling, it holds until the level is the hysteresis below
+void test_hysteresis_thresholds() {
+	WaterLevelFilter Filter;
+	Settle(Filter, 40.0f);
+	TEST_ASSERT_FALSE(Filter.isFull());
+
+	for (float Percent = 40.0f; Percent <= 60.0f; Percent += 0.05f) {
+		PushBurst(Filter, Percent, 0, 0);
+		TEST_ASSERT_EQUAL_MESSAGE(Filter.getPercent() >= WATER_LEVEL_FULL_PERCENT, Filter.isFull(), "Full set away from the full level");
+	}
+
+	for (float Percent = 60.0f; Percent >= 30.0f; Percent -= 0.05f) {
+		bool WasFull = Filter.isFull();
+		PushBurst(Filter, Percent, 0, 0);
+
+		bool ShouldBeFull = WasFull
+			? Filter.getPercent() >= WATER_LEVEL_FULL_PERCENT - WATER_LEVEL_FULL_HYSTERESIS
+			: Filter.getPercent() >= WATER_LEVEL_FULL_PERCENT;
+		TEST_ASSERT_EQUAL_MESSAGE(ShouldBeFull, Filter.isFull(), "Full cleared away from the hysteresis");
+	}
+
+	TEST_ASSERT_FALSE(Filter.isFull());
+}
+
+// Ripples inside the hysteresis band leave the flag as it was, whichever side the level came from
+void test_band_holds_flag() {
+	static const float Ripples[] = { -1.5f, 2.0f, -2.0f, 1.0f, 0.0f };
+	float Middle = WATER_LEVEL_FULL_PERCENT - WATER_LEVEL_FULL_HYSTERESIS / 2.0f;
+
+	WaterLevelFilter Filled;
+	Settle(Filled, WATER_LEVEL_FULL_PERCENT + 2.0f);
+	WaterLevelFilter Drained;
+	Settle(Drained, WATER_LEVEL_FULL_PERCENT - WATER_LEVEL_FULL_HYSTERESIS - 5.0f);
+
+	for (int Burst = 0; Burst < 500; Burst++) {
+		float Percent = Middle + Ripples[Burst % 5];
+		PushBurst(Filled, Percent, 0, 0);
+		PushBurst(Drained, Percent, 0, 0);
+
+		if (Burst >= SETTLE_BURSTS) {
+			TEST_ASSERT_TRUE(Filled.isFull());
+			TEST_ASSERT_FALSE(Drained.isFull());
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	NativeHAL::setSerialQuiet(true);
+
+	UNITY_BEGIN();
+	RUN_TEST(test_calibration_points);
+	RUN_TEST(test_spikes_do_not_toggle_full);
+	RUN_TEST(test_spiked_burst_barely_moves_level);
+	RUN_TEST(test_hysteresis_thresholds);
+	RUN_TEST(test_band_holds_flag);
+	return UNITY_END();
+}
\ No newline at end of file